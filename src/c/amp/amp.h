@@ -83,8 +83,13 @@
 #include <amp/amp_return_code.h>
 #include <amp/amp_memory.h>
 #include <amp/amp_platform.h>
+#include <amp/amp_numa_allocator.h>
+#include <amp/amp_pool_allocator.h>
+#include <amp/amp_thread_cache_allocator.h>
+#include <amp/amp_arena_allocator.h>
 #include <amp/amp_thread.h>
 #include <amp/amp_thread_array.h>
+#include <amp/amp_thread_pool.h>
 #include <amp/amp_thread_local_slot.h>
 #include <amp/amp_semaphore.h>
 #include <amp/amp_mutex.h>
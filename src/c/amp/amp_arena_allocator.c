@@ -0,0 +1,527 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implements the arena allocator.
+ *
+ * An arena is a stack of chunks, the newest chunk on top serves 
+ * allocations. In shared mode the allocator owns a single arena guarded by
+ * its mutex. In per-thread mode each thread creates its arena on first use 
+ * and links it into a registry guarded by the same mutex, so reset, 
+ * release, and destroy can reach the arenas of all threads.
+ */
+
+#include "amp_arena_allocator.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "amp_stddef.h"
+#include "amp_return_code.h"
+#include "amp_memory.h"
+#include "amp_mutex.h"
+#include "amp_raw_mutex.h"
+#include "amp_thread_local_slot.h"
+
+
+
+#define AMP_INTERNAL_ARENA_ROUND_TO_ALIGNMENT(size) ((((size) + AMP_ARENA_ALLOCATOR_ALIGNMENT - 1) / AMP_ARENA_ALLOCATOR_ALIGNMENT) * AMP_ARENA_ALLOCATOR_ALIGNMENT)
+#define AMP_INTERNAL_ARENA_ROUND_TO_CACHE_LINE(size) ((((size) + AMP_CACHE_LINE_SIZE - 1) / AMP_CACHE_LINE_SIZE) * AMP_CACHE_LINE_SIZE)
+
+
+struct amp_internal_arena_chunk_fields_s {
+    union amp_internal_arena_chunk_u* previous;
+    size_t capacity;
+    size_t used;
+};
+
+/*
+ * Chunk header, padded to keep the memory following it aligned.
+ */
+union amp_internal_arena_chunk_u {
+    struct amp_internal_arena_chunk_fields_s fields;
+    amp_byte_t padding[AMP_INTERNAL_ARENA_ROUND_TO_ALIGNMENT(sizeof(struct amp_internal_arena_chunk_fields_s))];
+};
+
+
+struct amp_internal_arena_fields_s {
+    union amp_internal_arena_chunk_u* current;
+    union amp_internal_arena_u* next;
+};
+
+/*
+ * Arena padded to whole cache lines. Per-thread arenas are allocated cache
+ * line aligned so no other thread's data shares their lines.
+ */
+union amp_internal_arena_u {
+    struct amp_internal_arena_fields_s fields;
+    amp_byte_t padding[AMP_INTERNAL_ARENA_ROUND_TO_CACHE_LINE(sizeof(struct amp_internal_arena_fields_s))];
+};
+
+
+struct amp_internal_arena_allocator_s {
+    union amp_internal_arena_u shared_arena;
+    struct amp_raw_mutex_s mutex;
+    union amp_internal_arena_u* thread_arenas;
+    amp_thread_local_slot_key_t thread_arena_key;
+    amp_allocator_t source_allocator;
+    size_t initial_chunk_size;
+    amp_arena_allocator_mode_t mode;
+};
+
+
+
+/**
+ * Bumps the pointer of the current chunk of arena by bytes_to_allocate, 
+ * adds a chunk if the current one is too small. Returns NULL if no chunk 
+ * can be added.
+ */
+static void* amp_internal_arena_alloc(struct amp_internal_arena_allocator_s* arena_allocator,
+                                      union amp_internal_arena_u* arena,
+                                      size_t bytes_to_allocate);
+
+static void* amp_internal_arena_alloc(struct amp_internal_arena_allocator_s* arena_allocator,
+                                      union amp_internal_arena_u* arena,
+                                      size_t bytes_to_allocate)
+{
+    union amp_internal_arena_chunk_u* chunk = arena->fields.current;
+    size_t capacity = 0;
+    void* memory = NULL;
+    
+    /* Zero sized allocations still get a unique address. */
+    if (0 == bytes_to_allocate) {
+        bytes_to_allocate = 1;
+    }
+    
+    if (bytes_to_allocate > ((size_t)-1) - sizeof(*chunk) - AMP_ARENA_ALLOCATOR_ALIGNMENT) {
+        return NULL;
+    }
+    bytes_to_allocate = AMP_INTERNAL_ARENA_ROUND_TO_ALIGNMENT(bytes_to_allocate);
+    
+    if ((NULL == chunk) 
+        || (bytes_to_allocate > chunk->fields.capacity - chunk->fields.used)) {
+        
+        if (NULL == chunk) {
+            capacity = arena_allocator->initial_chunk_size;
+        } else if (chunk->fields.capacity <= (((size_t)-1) - sizeof(*chunk)) / 2) {
+            capacity = 2 * chunk->fields.capacity;
+        } else {
+            capacity = chunk->fields.capacity;
+        }
+        if (capacity < bytes_to_allocate) {
+            capacity = bytes_to_allocate;
+        }
+        
+        chunk = (union amp_internal_arena_chunk_u*)AMP_ALLOC(arena_allocator->source_allocator,
+                                                             sizeof(*chunk) + capacity);
+        if (NULL == chunk) {
+            return NULL;
+        }
+        
+        chunk->fields.previous = arena->fields.current;
+        chunk->fields.capacity = capacity;
+        chunk->fields.used = 0;
+        arena->fields.current = chunk;
+    }
+    
+    memory = ((amp_byte_t*)(chunk + 1)) + chunk->fields.used;
+    chunk->fields.used += bytes_to_allocate;
+    
+    return memory;
+}
+
+
+
+/**
+ * Returns all chunks of arena to the source allocator, except the current
+ * one if keep_current is non-zero. The kept chunk is the largest one.
+ */
+static int amp_internal_arena_clear(struct amp_internal_arena_allocator_s* arena_allocator,
+                                    union amp_internal_arena_u* arena,
+                                    int keep_current);
+
+static int amp_internal_arena_clear(struct amp_internal_arena_allocator_s* arena_allocator,
+                                    union amp_internal_arena_u* arena,
+                                    int keep_current)
+{
+    union amp_internal_arena_chunk_u* chunk = arena->fields.current;
+    int retval = AMP_SUCCESS;
+    
+    if (NULL == chunk) {
+        return AMP_SUCCESS;
+    }
+    
+    if (keep_current) {
+        chunk->fields.used = 0;
+        chunk = chunk->fields.previous;
+        arena->fields.current->fields.previous = NULL;
+    } else {
+        arena->fields.current = NULL;
+    }
+    
+    while (NULL != chunk) {
+        union amp_internal_arena_chunk_u* previous = chunk->fields.previous;
+        
+        retval = AMP_DEALLOC(arena_allocator->source_allocator, chunk);
+        if (AMP_SUCCESS != retval) {
+            return retval;
+        }
+        
+        chunk = previous;
+    }
+    
+    return AMP_SUCCESS;
+}
+
+
+
+/**
+ * Clears the shared arena or the arenas of all threads depending on the 
+ * mode.
+ */
+static int amp_internal_arena_clear_all(struct amp_internal_arena_allocator_s* arena_allocator,
+                                        int keep_current);
+
+static int amp_internal_arena_clear_all(struct amp_internal_arena_allocator_s* arena_allocator,
+                                        int keep_current)
+{
+    union amp_internal_arena_u* arena = NULL;
+    int retval = AMP_UNSUPPORTED;
+    int rc = AMP_UNSUPPORTED;
+    
+    retval = amp_mutex_lock(&arena_allocator->mutex);
+    assert(AMP_SUCCESS == retval);
+    
+    retval = amp_internal_arena_clear(arena_allocator,
+                                      &arena_allocator->shared_arena,
+                                      keep_current);
+    
+    for (arena = arena_allocator->thread_arenas; 
+         (NULL != arena) && (AMP_SUCCESS == retval); 
+         arena = arena->fields.next) {
+        retval = amp_internal_arena_clear(arena_allocator,
+                                          arena,
+                                          keep_current);
+    }
+    
+    rc = amp_mutex_unlock(&arena_allocator->mutex);
+    assert(AMP_SUCCESS == rc);
+    (void)rc;
+    
+    return retval;
+}
+
+
+
+/**
+ * Returns the arena of the calling thread, creates it if the thread has 
+ * none yet. Returns NULL if the arena can't be created.
+ */
+static union amp_internal_arena_u* amp_internal_arena_get_thread_arena(struct amp_internal_arena_allocator_s* arena_allocator);
+
+static union amp_internal_arena_u* amp_internal_arena_get_thread_arena(struct amp_internal_arena_allocator_s* arena_allocator)
+{
+    union amp_internal_arena_u* arena = NULL;
+    int retval = AMP_UNSUPPORTED;
+    
+    arena = (union amp_internal_arena_u*)amp_thread_local_slot_value(arena_allocator->thread_arena_key);
+    if (NULL != arena) {
+        return arena;
+    }
+    
+    arena = (union amp_internal_arena_u*)AMP_ALIGNED_ALLOC(arena_allocator->source_allocator,
+                                                           AMP_CACHE_LINE_SIZE,
+                                                           sizeof(*arena));
+    if (NULL == arena) {
+        return NULL;
+    }
+    
+    arena->fields.current = NULL;
+    
+    retval = amp_thread_local_slot_set_value(arena_allocator->thread_arena_key,
+                                             arena);
+    if (AMP_SUCCESS != retval) {
+        int const rv = AMP_ALIGNED_DEALLOC(arena_allocator->source_allocator, 
+                                           arena);
+        assert(AMP_SUCCESS == rv);
+        (void)rv;
+        
+        return NULL;
+    }
+    
+    retval = amp_mutex_lock(&arena_allocator->mutex);
+    assert(AMP_SUCCESS == retval);
+    
+    arena->fields.next = arena_allocator->thread_arenas;
+    arena_allocator->thread_arenas = arena;
+    
+    retval = amp_mutex_unlock(&arena_allocator->mutex);
+    assert(AMP_SUCCESS == retval);
+    (void)retval;
+    
+    return arena;
+}
+
+
+
+int amp_arena_allocator_create(amp_allocator_t* arena_allocator,
+                               amp_allocator_t source_allocator,
+                               size_t initial_chunk_size,
+                               amp_arena_allocator_mode_t mode)
+{
+    struct amp_internal_arena_allocator_s* tmp = NULL;
+    int retval = AMP_UNSUPPORTED;
+    int rc = AMP_UNSUPPORTED;
+    
+    assert(NULL != arena_allocator);
+    assert(NULL != source_allocator);
+    assert((amp_arena_allocator_mode_shared == mode) 
+           || (amp_arena_allocator_mode_per_thread == mode));
+    
+    if (0 == initial_chunk_size) {
+        initial_chunk_size = AMP_ARENA_ALLOCATOR_DEFAULT_CHUNK_SIZE;
+    }
+    
+    tmp = (struct amp_internal_arena_allocator_s*)AMP_ALLOC(source_allocator,
+                                                            sizeof(*tmp));
+    if (NULL == tmp) {
+        return AMP_NOMEM;
+    }
+    
+    tmp->shared_arena.fields.current = NULL;
+    tmp->shared_arena.fields.next = NULL;
+    tmp->thread_arenas = NULL;
+    tmp->thread_arena_key = AMP_THREAD_LOCAL_SLOT_UNINITIALIZED;
+    tmp->source_allocator = source_allocator;
+    tmp->initial_chunk_size = initial_chunk_size;
+    tmp->mode = mode;
+    
+    retval = amp_raw_mutex_init(&tmp->mutex);
+    if (AMP_SUCCESS != retval) {
+        rc = AMP_DEALLOC(source_allocator, tmp);
+        assert(AMP_SUCCESS == rc);
+        
+        return retval;
+    }
+    
+    if (amp_arena_allocator_mode_per_thread == mode) {
+        retval = amp_thread_local_slot_create(&tmp->thread_arena_key,
+                                              source_allocator);
+        if (AMP_SUCCESS != retval) {
+            rc = amp_raw_mutex_finalize(&tmp->mutex);
+            assert(AMP_SUCCESS == rc);
+            rc = AMP_DEALLOC(source_allocator, tmp);
+            assert(AMP_SUCCESS == rc);
+            
+            return retval;
+        }
+    }
+    
+    retval = amp_allocator_create(arena_allocator,
+                                  source_allocator,
+                                  tmp,
+                                  amp_arena_alloc,
+                                  amp_arena_calloc,
+                                  amp_arena_dealloc);
+    if (AMP_SUCCESS != retval) {
+        if (amp_arena_allocator_mode_per_thread == mode) {
+            rc = amp_thread_local_slot_destroy(&tmp->thread_arena_key,
+                                               source_allocator);
+            assert(AMP_SUCCESS == rc);
+        }
+        rc = amp_raw_mutex_finalize(&tmp->mutex);
+        assert(AMP_SUCCESS == rc);
+        rc = AMP_DEALLOC(source_allocator, tmp);
+        assert(AMP_SUCCESS == rc);
+        (void)rc;
+    }
+    
+    return retval;
+}
+
+
+
+int amp_arena_allocator_destroy(amp_allocator_t* arena_allocator,
+                                amp_allocator_t source_allocator)
+{
+    struct amp_internal_arena_allocator_s* tmp = NULL;
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != arena_allocator);
+    assert(NULL != *arena_allocator);
+    assert(NULL != source_allocator);
+    
+    tmp = (struct amp_internal_arena_allocator_s*)(*arena_allocator)->allocator_context;
+    
+    retval = amp_internal_arena_clear_all(tmp, 0);
+    if (AMP_SUCCESS != retval) {
+        return retval;
+    }
+    
+    if (amp_arena_allocator_mode_per_thread == tmp->mode) {
+        retval = amp_thread_local_slot_destroy(&tmp->thread_arena_key,
+                                               source_allocator);
+        if (AMP_SUCCESS != retval) {
+            return retval;
+        }
+        
+        while (NULL != tmp->thread_arenas) {
+            union amp_internal_arena_u* arena = tmp->thread_arenas;
+            tmp->thread_arenas = arena->fields.next;
+            
+            retval = AMP_ALIGNED_DEALLOC(tmp->source_allocator, arena);
+            if (AMP_SUCCESS != retval) {
+                return retval;
+            }
+        }
+    }
+    
+    retval = amp_raw_mutex_finalize(&tmp->mutex);
+    if (AMP_SUCCESS != retval) {
+        return retval;
+    }
+    
+    retval = amp_allocator_destroy(arena_allocator, source_allocator);
+    if (AMP_SUCCESS == retval) {
+        retval = AMP_DEALLOC(source_allocator, tmp);
+    }
+    
+    return retval;
+}
+
+
+
+int amp_arena_allocator_reset(amp_allocator_t arena_allocator)
+{
+    assert(NULL != arena_allocator);
+    
+    return amp_internal_arena_clear_all((struct amp_internal_arena_allocator_s*)arena_allocator->allocator_context,
+                                        1);
+}
+
+
+
+int amp_arena_allocator_release(amp_allocator_t arena_allocator)
+{
+    assert(NULL != arena_allocator);
+    
+    return amp_internal_arena_clear_all((struct amp_internal_arena_allocator_s*)arena_allocator->allocator_context,
+                                        0);
+}
+
+
+
+void* amp_arena_alloc(void* arena_allocator_context,
+                      size_t bytes_to_allocate,
+                      char const* filename,
+                      int line)
+{
+    struct amp_internal_arena_allocator_s* tmp = (struct amp_internal_arena_allocator_s*)arena_allocator_context;
+    union amp_internal_arena_u* arena = NULL;
+    void* memory = NULL;
+    int retval = AMP_UNSUPPORTED;
+    
+    (void)filename;
+    (void)line;
+    
+    assert(NULL != tmp);
+    
+    if (amp_arena_allocator_mode_per_thread == tmp->mode) {
+        arena = amp_internal_arena_get_thread_arena(tmp);
+        if (NULL == arena) {
+            return NULL;
+        }
+        
+        return amp_internal_arena_alloc(tmp, arena, bytes_to_allocate);
+    }
+    
+    retval = amp_mutex_lock(&tmp->mutex);
+    assert(AMP_SUCCESS == retval);
+    
+    memory = amp_internal_arena_alloc(tmp, 
+                                      &tmp->shared_arena, 
+                                      bytes_to_allocate);
+    
+    retval = amp_mutex_unlock(&tmp->mutex);
+    assert(AMP_SUCCESS == retval);
+    (void)retval;
+    
+    return memory;
+}
+
+
+
+void* amp_arena_calloc(void* arena_allocator_context,
+                       size_t elem_count,
+                       size_t bytes_per_elem,
+                       char const* filename,
+                       int line)
+{
+    void* memory = NULL;
+    
+    if ((0 != bytes_per_elem) && (elem_count > ((size_t)-1) / bytes_per_elem)) {
+        return NULL;
+    }
+    
+    /* Chunks are reused after a reset, their memory isn't zero. */
+    memory = amp_arena_alloc(arena_allocator_context,
+                             elem_count * bytes_per_elem,
+                             filename,
+                             line);
+    if (NULL != memory) {
+        memset(memory, 0, elem_count * bytes_per_elem);
+    }
+    
+    return memory;
+}
+
+
+
+int amp_arena_dealloc(void* arena_allocator_context,
+                      void* pointer,
+                      char const* filename,
+                      int line)
+{
+    (void)arena_allocator_context;
+    (void)pointer;
+    (void)filename;
+    (void)line;
+    
+    assert(NULL != arena_allocator_context);
+    
+    return AMP_SUCCESS;
+}
+
+
@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Arena allocator handing out memory by bumping a pointer through large 
+ * chunks drawn from a source allocator. Deallocating via an arena 
+ * allocator does nothing, all memory is reclaimed at once by 
+ * amp_arena_allocator_reset or amp_arena_allocator_release. Use it for 
+ * data with a common lifetime, e.g. everything allocated while processing
+ * a request or a frame:
+ * @code
+ * amp_allocator_t arena = AMP_ALLOCATOR_UNINITIALIZED;
+ * amp_arena_allocator_create(&arena, 
+ *                            AMP_DEFAULT_ALLOCATOR, 
+ *                            0,
+ *                            amp_arena_allocator_mode_shared);
+ * while (next_frame()) {
+ *     struct particle_s* particles = AMP_ALLOC(arena, count * sizeof(*particles));
+ *     ...
+ *     amp_arena_allocator_reset(arena);
+ * }
+ * amp_arena_allocator_destroy(&arena, AMP_DEFAULT_ALLOCATOR);
+ * @endcode
+ *
+ * Whenever the current chunk can't serve an allocation a new chunk twice 
+ * as large as the previous one (or large enough for the allocation) is 
+ * added, so the number of chunks grows logarithmically with the memory in
+ * use. Resetting keeps the largest chunk for reuse.
+ *
+ * In amp_arena_allocator_mode_shared all threads allocate from the same 
+ * chunks guarded by a mutex. In amp_arena_allocator_mode_per_thread every
+ * thread gets its own chunks, found via an amp_thread_local_slot, and 
+ * allocates without locking. Memory can be passed to and used by other 
+ * threads in both modes.
+ *
+ * All allocations are aligned to AMP_ARENA_ALLOCATOR_ALIGNMENT bytes if 
+ * the source allocator returns memory aligned to at least that boundary.
+ */
+
+#ifndef AMP_amp_arena_allocator_H
+#define AMP_amp_arena_allocator_H
+
+#include <stddef.h>
+
+#include <amp/amp_memory.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+    
+    
+    /**
+     * Alignment of all allocations and granularity the bump pointer moves 
+     * in.
+     */
+#define AMP_ARENA_ALLOCATOR_ALIGNMENT ((size_t)16)
+    
+    /**
+     * Size of the first chunk of an arena if 0 is passed to 
+     * amp_arena_allocator_create.
+     */
+#define AMP_ARENA_ALLOCATOR_DEFAULT_CHUNK_SIZE ((size_t)65536)
+    
+    
+    enum amp_arena_allocator_mode {
+        amp_arena_allocator_mode_shared = 0,
+        amp_arena_allocator_mode_per_thread
+    };
+    typedef enum amp_arena_allocator_mode amp_arena_allocator_mode_t;
+    
+    
+    /**
+     * Creates an arena allocator drawing its chunks from source_allocator,
+     * the first chunk of each arena holds initial_chunk_size bytes (or 
+     * AMP_ARENA_ALLOCATOR_DEFAULT_CHUNK_SIZE if 0 is passed). No chunk is 
+     * allocated before the first allocation. The arena allocator itself is
+     * allocated via source_allocator, too.
+     *
+     * source_allocator must be thread-safe if mode is 
+     * amp_arena_allocator_mode_per_thread and must stay valid until the 
+     * arena allocator has been destroyed.
+     *
+     * @return AMP_SUCCESS on successful creation.
+     *         AMP_NOMEM if not enough memory is available.
+     *         AMP_ERROR if no mutex or thread-local slot can be created.
+     */
+    int amp_arena_allocator_create(amp_allocator_t* arena_allocator,
+                                   amp_allocator_t source_allocator,
+                                   size_t initial_chunk_size,
+                                   amp_arena_allocator_mode_t mode);
+    
+    /**
+     * Releases all memory of arena_allocator and destroys it. 
+     * source_allocator is used to deallocate the arena allocator itself and
+     * must be the allocator passed to amp_arena_allocator_create. No thread
+     * may use arena_allocator or memory allocated via it concurrently or 
+     * afterwards.
+     *
+     * @return AMP_SUCCESS on successful destruction.
+     *         AMP_ERROR might be returned if an error is detected.
+     */
+    int amp_arena_allocator_destroy(amp_allocator_t* arena_allocator,
+                                    amp_allocator_t source_allocator);
+    
+    /**
+     * Invalidates all memory allocated via arena_allocator. Each arena 
+     * keeps its largest chunk and returns the others to the source 
+     * allocator. In amp_arena_allocator_mode_per_thread the arenas of all
+     * threads are reset.
+     *
+     * Mustn't be called while other threads allocate via arena_allocator.
+     *
+     * @return AMP_SUCCESS on success.
+     *         Error codes of the source allocator if a chunk can't be 
+     *         deallocated.
+     */
+    int amp_arena_allocator_reset(amp_allocator_t arena_allocator);
+    
+    /**
+     * Invalidates all memory allocated via arena_allocator and returns all 
+     * chunks to the source allocator. arena_allocator stays usable, the 
+     * next allocation starts with a chunk of the initial size again.
+     *
+     * Mustn't be called while other threads allocate via arena_allocator.
+     *
+     * @return AMP_SUCCESS on success.
+     *         Error codes of the source allocator if a chunk can't be 
+     *         deallocated.
+     */
+    int amp_arena_allocator_release(amp_allocator_t arena_allocator);
+    
+    
+    /**
+     * Allocation function of allocators created by 
+     * amp_arena_allocator_create. Returns NULL if no chunk large enough can
+     * be allocated.
+     *
+     * Thread-safe.
+     */
+    void* amp_arena_alloc(void* arena_allocator_context,
+                          size_t bytes_to_allocate,
+                          char const* filename,
+                          int line);
+    
+    /**
+     * Zeroing array allocation function of allocators created by 
+     * amp_arena_allocator_create. Returns NULL on overflow of 
+     * elem_count * bytes_per_elem or if no chunk large enough can be 
+     * allocated.
+     *
+     * Thread-safe.
+     */
+    void* amp_arena_calloc(void* arena_allocator_context,
+                           size_t elem_count,
+                           size_t bytes_per_elem,
+                           char const* filename,
+                           int line);
+    
+    /**
+     * Deallocation function of allocators created by 
+     * amp_arena_allocator_create. Does nothing, the memory stays valid 
+     * until the arena allocator is reset or released.
+     *
+     * Thread-safe.
+     *
+     * @return AMP_SUCCESS.
+     */
+    int amp_arena_dealloc(void* arena_allocator_context,
+                          void* pointer,
+                          char const* filename,
+                          int line);
+    
+    
+    
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* AMP_amp_arena_allocator_H */
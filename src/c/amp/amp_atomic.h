@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Atomic load, store, exchange, compare-and-exchange and fetch-and-add 
+ * operations on int, size_t and pointer values with explicit memory ordering,
+ * plus memory fences and a processor hint for spin-waiting.
+ *
+ * The operations follow the C11 and C++11 memory model. They are defined as
+ * static inline functions in amp_raw_atomic.h so they compile down to the 
+ * plain processor instructions - atomic operations called through a function 
+ * pointer or library call would cost more than they save. Therefore this is 
+ * the one non-raw @em amp header that includes its raw header.
+ *
+ * Select the backend by defining one of the following preprocessor symbols:
+ * - AMP_USE_GNUC_ATOMICS for the GCC (and Clang) __atomic builtins. This is 
+ *   the default if no backend is selected and the compiler is GCC compatible.
+ * - AMP_USE_C11_ATOMICS for C11 stdatomic.h. C++ translation units can't 
+ *   include stdatomic.h and use the __atomic builtins instead which operate 
+ *   on the same memory representation with GCC and Clang.
+ *
+ * Only access atomic variables through the amp_atomic functions. Initialize 
+ * them with a relaxed store before sharing them with other threads.
+ *
+ * Error handling is left out on purpose - memory orders not allowed for an
+ * operation are programming errors and result in undefined behavior.
+ */
+
+#ifndef AMP_amp_atomic_H
+#define AMP_amp_atomic_H
+
+#include <stddef.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+    
+    /**
+     * Memory ordering constraints of atomic operations. See the C11 
+     * memory_order enumeration for their meaning.
+     *
+     * Loads mustn't use amp_memory_order_release or amp_memory_order_acq_rel,
+     * stores mustn't use amp_memory_order_acquire or 
+     * amp_memory_order_acq_rel.
+     */
+    enum amp_memory_order {
+        amp_memory_order_relaxed = 0,
+        amp_memory_order_acquire,
+        amp_memory_order_release,
+        amp_memory_order_acq_rel,
+        amp_memory_order_seq_cst
+    };
+    typedef enum amp_memory_order amp_memory_order_t;
+    
+    
+    /**
+     * Atomic int, size_t and pointer variables. Their layout depends on the 
+     * backend, treat them as opaque.
+     */
+    typedef struct amp_atomic_int_s amp_atomic_int_t;
+    typedef struct amp_atomic_size_s amp_atomic_size_t;
+    typedef struct amp_atomic_ptr_s amp_atomic_ptr_t;
+    
+    
+    
+    /**
+     * Returns the value of @a atomic.
+     */
+    static inline int amp_atomic_int_load(amp_atomic_int_t* atomic,
+                                          amp_memory_order_t order);
+    
+    /**
+     * Sets @a atomic to @a value.
+     */
+    static inline void amp_atomic_int_store(amp_atomic_int_t* atomic,
+                                            int value,
+                                            amp_memory_order_t order);
+    
+    /**
+     * Sets @a atomic to @a value and returns its previous value.
+     */
+    static inline int amp_atomic_int_exchange(amp_atomic_int_t* atomic,
+                                              int value,
+                                              amp_memory_order_t order);
+    
+    /**
+     * Sets @a atomic to @a desired if it equals the value pointed to by 
+     * @a expected and returns non-zero. Otherwise stores the current value
+     * of @a atomic in @a expected and returns 0. Never fails spuriously.
+     *
+     * @a failure_order describes the ordering of the load if the exchange 
+     * fails. It is weakened automatically if it isn't valid for a load or 
+     * stronger than @a success_order.
+     */
+    static inline int amp_atomic_int_compare_exchange(amp_atomic_int_t* atomic,
+                                                      int* expected,
+                                                      int desired,
+                                                      amp_memory_order_t success_order,
+                                                      amp_memory_order_t failure_order);
+    
+    /**
+     * Adds @a value to @a atomic and returns its previous value.
+     * Overflow wraps around like unsigned arithmetic.
+     */
+    static inline int amp_atomic_int_fetch_add(amp_atomic_int_t* atomic,
+                                               int value,
+                                               amp_memory_order_t order);
+    
+    /**
+     * Subtracts @a value from @a atomic and returns its previous value.
+     * Overflow wraps around like unsigned arithmetic.
+     */
+    static inline int amp_atomic_int_fetch_sub(amp_atomic_int_t* atomic,
+                                               int value,
+                                               amp_memory_order_t order);
+    
+    
+    
+    /**
+     * size_t version of amp_atomic_int_load.
+     */
+    static inline size_t amp_atomic_size_load(amp_atomic_size_t* atomic,
+                                              amp_memory_order_t order);
+    
+    /**
+     * size_t version of amp_atomic_int_store.
+     */
+    static inline void amp_atomic_size_store(amp_atomic_size_t* atomic,
+                                             size_t value,
+                                             amp_memory_order_t order);
+    
+    /**
+     * size_t version of amp_atomic_int_exchange.
+     */
+    static inline size_t amp_atomic_size_exchange(amp_atomic_size_t* atomic,
+                                                  size_t value,
+                                                  amp_memory_order_t order);
+    
+    /**
+     * size_t version of amp_atomic_int_compare_exchange.
+     */
+    static inline int amp_atomic_size_compare_exchange(amp_atomic_size_t* atomic,
+                                                       size_t* expected,
+                                                       size_t desired,
+                                                       amp_memory_order_t success_order,
+                                                       amp_memory_order_t failure_order);
+    
+    /**
+     * size_t version of amp_atomic_int_fetch_add.
+     */
+    static inline size_t amp_atomic_size_fetch_add(amp_atomic_size_t* atomic,
+                                                   size_t value,
+                                                   amp_memory_order_t order);
+    
+    /**
+     * size_t version of amp_atomic_int_fetch_sub.
+     */
+    static inline size_t amp_atomic_size_fetch_sub(amp_atomic_size_t* atomic,
+                                                   size_t value,
+                                                   amp_memory_order_t order);
+    
+    
+    
+    /**
+     * Pointer version of amp_atomic_int_load.
+     */
+    static inline void* amp_atomic_ptr_load(amp_atomic_ptr_t* atomic,
+                                            amp_memory_order_t order);
+    
+    /**
+     * Pointer version of amp_atomic_int_store.
+     */
+    static inline void amp_atomic_ptr_store(amp_atomic_ptr_t* atomic,
+                                            void* value,
+                                            amp_memory_order_t order);
+    
+    /**
+     * Pointer version of amp_atomic_int_exchange.
+     */
+    static inline void* amp_atomic_ptr_exchange(amp_atomic_ptr_t* atomic,
+                                                void* value,
+                                                amp_memory_order_t order);
+    
+    /**
+     * Pointer version of amp_atomic_int_compare_exchange.
+     */
+    static inline int amp_atomic_ptr_compare_exchange(amp_atomic_ptr_t* atomic,
+                                                      void** expected,
+                                                      void* desired,
+                                                      amp_memory_order_t success_order,
+                                                      amp_memory_order_t failure_order);
+    
+    
+    
+    /**
+     * Memory fence with the ordering constraints of @a order. 
+     * amp_memory_order_relaxed has no effect.
+     */
+    static inline void amp_atomic_thread_fence(amp_memory_order_t order);
+    
+    /**
+     * Hints the processor that the calling thread spin-waits, e.g. to save
+     * power or to give resources to other hardware threads of the same core.
+     * Is no memory fence but prevents the compiler from caching loads across 
+     * the call.
+     */
+    static inline void amp_atomic_cpu_relax(void);
+    
+    
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#include <amp/amp_raw_atomic.h>
+
+
+#endif /* AMP_amp_atomic_H */
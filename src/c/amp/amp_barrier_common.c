@@ -42,6 +42,7 @@
 
 #include "amp_stddef.h"
 #include "amp_return_code.h"
+#include "amp_internal_memory.h"
 
 
 
@@ -63,8 +64,8 @@ int amp_barrier_create(amp_barrier_t* barrier,
     
     *barrier = AMP_BARRIER_UNINITIALIZED;
     
-    tmp_barrier = (amp_barrier_t)AMP_ALLOC(allocator,
-                                           sizeof(*tmp_barrier));
+    tmp_barrier = (amp_barrier_t)AMP_INTERNAL_PRIMITIVE_ALLOC(allocator,
+                                                              sizeof(*tmp_barrier));
     if (NULL == tmp_barrier) {
         return AMP_NOMEM;
     }
@@ -73,7 +74,7 @@ int amp_barrier_create(amp_barrier_t* barrier,
     if (AMP_SUCCESS == retval) {
         *barrier = tmp_barrier;
     } else {
-        int const rv = AMP_DEALLOC(allocator, tmp_barrier);
+        int const rv = AMP_INTERNAL_PRIMITIVE_DEALLOC(allocator, tmp_barrier);
         assert(AMP_SUCCESS == rv);
         (void)rv;
     }
@@ -95,7 +96,7 @@ int amp_barrier_destroy(amp_barrier_t* barrier,
     
     retval = amp_raw_barrier_finalize(*barrier);
     if (AMP_SUCCESS == retval) {
-        retval = AMP_DEALLOC(allocator, *barrier);
+        retval = AMP_INTERNAL_PRIMITIVE_DEALLOC(allocator, *barrier);
         assert(AMP_SUCCESS == retval);
         if (AMP_SUCCESS == retval) {
             *barrier = AMP_BARRIER_UNINITIALIZED;
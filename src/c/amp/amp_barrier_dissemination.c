@@ -0,0 +1,358 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of amp_barrier as a dissemination barrier using atomic 
+ * operations. Selected by defining AMP_USE_DISSEMINATION_BARRIERS.
+ *
+ * A barrier round runs in ceil(log2(init_count)) steps. In step k the thread 
+ * with index i signals the thread with index (i + 2^k) mod init_count and 
+ * waits for the signal of thread (i - 2^k) mod init_count. After the last 
+ * step every thread knows that all other threads arrived. Each thread index 
+ * owns a cache line aligned record of step flags and only spins on its own
+ * record, so waiting threads don't hammer a shared cache line and no mutex 
+ * serializes arriving or leaving threads.
+ *
+ * amp_barrier_wait has no thread index argument - every arriving thread 
+ * draws a ticket with one atomic increment instead. The ticket modulo 
+ * init_count is the thread index, the ticket divided by init_count is the 
+ * episode (barrier round). Episodes are counted modulo episode_count and the
+ * thread drawing the last ticket of the last episode rewinds the ticket 
+ * counter before signaling anyone - no thread can draw the next ticket before
+ * receiving its signals.
+ *
+ * The ticket counter is the only shared location every arriving thread 
+ * changes, with one atomic increment per thread and episode - as many 
+ * contended updates as the counters of the centralized barrier backends. 
+ * Unlike there, waiting and waking stays distributed over the step flags.
+ * Removing the ticket would need a thread index argument to 
+ * amp_barrier_wait or a thread local slot per barrier.
+ *
+ * Flags store episode numbers instead of booleans and are only ever raised, 
+ * so a thread already waiting in the next episode can't have its signal 
+ * overwritten by a slow thread of the previous one. A flag raised by the 
+ * next episode tells a waiting thread that its own episode is complete, too.
+ * At most three consecutive episodes are visible in a flag at any time. The 
+ * thread with index 0 receives AMP_BARRIER_SERIAL_THREAD.
+ *
+ * Behind its step flags each thread index records the last episode a 
+ * thread left with that index. Finalizing compares these records to the 
+ * ticket counter to detect threads still waiting or leaving.
+ *
+ * Waiting threads spin a bounded number of times and then yield the 
+ * processor between checks. The barrier is meant for high thread counts on
+ * machines with as many hardware threads - if more threads than hardware 
+ * threads wait use the sense reversing barrier backend instead which blocks.
+ *
+ * amp_barrier_create and amp_barrier_destroy are implemented in 
+ * amp_barrier_common.c.
+ *
+ * See John M. Mellor-Crummey and Michael L. Scott, Algorithms for Scalable 
+ * Synchronization on Shared-Memory Multiprocessors, ACM Transactions on 
+ * Computer Systems, Vol. 9, No. 1, 1991, pp. 21-65.
+ */
+
+#include "amp_raw_barrier.h"
+
+#include <assert.h>
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "amp_stddef.h"
+#include "amp_return_code.h"
+#include "amp_atomic.h"
+#include "amp_thread.h"
+
+
+
+#if !defined(AMP_USE_DISSEMINATION_BARRIERS)
+#   error Compiling wrong source file for selected backend.
+#endif
+
+
+
+#if !defined(AMP_DISSEMINATION_BARRIER_SPIN_COUNT)
+/**
+ * Number of times a waiting thread checks its step flag before yielding the
+ * processor between checks.
+ */
+#   define AMP_DISSEMINATION_BARRIER_SPIN_COUNT 1024
+#endif
+
+
+
+enum amp_internal_raw_barrier_lifecycle_state {
+    amp_internal_valid_raw_barrier_lifecycle_state = 0xabcdef
+};
+
+
+
+/**
+ * Returns the step flags of the thread with index thread_index followed by
+ * the episode the last thread with this index left.
+ */
+static amp_atomic_int_t* amp_internal_raw_barrier_flags(amp_barrier_t barrier,
+                                                        amp_barrier_count_t thread_index);
+static amp_atomic_int_t* amp_internal_raw_barrier_flags(amp_barrier_t barrier,
+                                                        amp_barrier_count_t thread_index)
+{
+    return (amp_atomic_int_t*)(barrier->flags + (size_t)thread_index * barrier->flags_stride);
+}
+
+
+
+/**
+ * Returns non-zero if flag_value signals that episode or the following 
+ * episode reached the flag.
+ */
+static int amp_internal_raw_barrier_signaled(amp_barrier_t barrier,
+                                             int flag_value,
+                                             int episode);
+static int amp_internal_raw_barrier_signaled(amp_barrier_t barrier,
+                                             int flag_value,
+                                             int episode)
+{
+    int const next_episode = (episode + 1 == barrier->episode_count) ? 0 : episode + 1;
+    
+    return (flag_value == episode) || (flag_value == next_episode);
+}
+
+
+
+/**
+ * Raises the flag to episode unless it already signals the same or the
+ * following episode.
+ */
+static void amp_internal_raw_barrier_signal(amp_barrier_t barrier,
+                                            amp_atomic_int_t* flag,
+                                            int episode);
+static void amp_internal_raw_barrier_signal(amp_barrier_t barrier,
+                                            amp_atomic_int_t* flag,
+                                            int episode)
+{
+    int current = amp_atomic_int_load(flag, amp_memory_order_relaxed);
+    
+    while (!amp_internal_raw_barrier_signaled(barrier, current, episode)) {
+        if (amp_atomic_int_compare_exchange(flag, 
+                                            &current, 
+                                            episode, 
+                                            amp_memory_order_release, 
+                                            amp_memory_order_relaxed)) {
+            break;
+        }
+    }
+}
+
+
+
+int amp_raw_barrier_init(amp_barrier_t barrier,
+                         amp_barrier_count_t init_count)
+{
+    unsigned int round_count = 0;
+    size_t flags_stride = 0;
+    void* flags_memory = NULL;
+    uintptr_t flags_address = 0;
+    
+    assert(NULL != barrier);
+    assert(0 < init_count);
+    assert((amp_barrier_count_t)(INT_MAX / 3) >= init_count);
+    
+    if ((0 == init_count) || ((amp_barrier_count_t)(INT_MAX / 3) < init_count)) {
+        return AMP_ERROR;
+    }
+    
+    while (((amp_barrier_count_t)1 << round_count) < init_count) {
+        ++round_count;
+    }
+    
+    /* Round the step flags and the left episode of each thread up to whole 
+     * cache lines. 
+     */
+    flags_stride = (round_count + 1) * sizeof(amp_atomic_int_t);
+    flags_stride = ((flags_stride + AMP_CACHE_LINE_SIZE - 1) / AMP_CACHE_LINE_SIZE) * AMP_CACHE_LINE_SIZE;
+    
+    if ((SIZE_MAX - (AMP_CACHE_LINE_SIZE - 1)) / flags_stride < (size_t)init_count) {
+        return AMP_NOMEM;
+    }
+    
+    /* amp_raw_barrier_init has no allocator argument, backends are allowed
+     * to allocate internal memory via malloc directly.
+     */
+    flags_memory = malloc(flags_stride * init_count + (AMP_CACHE_LINE_SIZE - 1));
+    if (NULL == flags_memory) {
+        return AMP_NOMEM;
+    }
+    memset(flags_memory, 0, flags_stride * init_count + (AMP_CACHE_LINE_SIZE - 1));
+    
+    flags_address = (uintptr_t)flags_memory;
+    flags_address = (flags_address + AMP_CACHE_LINE_SIZE - 1) & ~((uintptr_t)AMP_CACHE_LINE_SIZE - 1);
+    
+    barrier->flags_memory = flags_memory;
+    barrier->flags = (amp_byte_t*)flags_address;
+    barrier->flags_stride = flags_stride;
+    barrier->init_count = init_count;
+    barrier->round_count = round_count;
+    barrier->episode_count = INT_MAX / (int)init_count;
+    amp_atomic_int_store(&barrier->ticket, 0, amp_memory_order_release);
+    barrier->valid = (int)amp_internal_valid_raw_barrier_lifecycle_state;
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_raw_barrier_finalize(amp_barrier_t barrier)
+{
+    int ticket = 0;
+    int episode = 0;
+    amp_barrier_count_t thread_index = 0;
+    
+    assert(NULL != barrier);
+    assert((int)amp_internal_valid_raw_barrier_lifecycle_state == barrier->valid);
+    
+    if ((int)amp_internal_valid_raw_barrier_lifecycle_state != barrier->valid) {
+        return AMP_ERROR;
+    }
+    
+    /* Weak check that no threads wait for the barrier. A partially drawn 
+     * episode means that threads wait. Otherwise the ticket divided by 
+     * init_count is the flag value of the last drawn episode - zero before
+     * the first episode and after rewinding - and every thread index must 
+     * have left it. Recording the left episode is the last access of a 
+     * thread to the barrier.
+     */
+    ticket = amp_atomic_int_load(&barrier->ticket, amp_memory_order_acquire);
+    if (0 != (ticket % (int)barrier->init_count)) {
+        return AMP_BUSY;
+    }
+    
+    episode = ticket / (int)barrier->init_count;
+    for (thread_index = 0; thread_index < barrier->init_count; ++thread_index) {
+        amp_atomic_int_t* const left_episode = amp_internal_raw_barrier_flags(barrier, thread_index) + barrier->round_count;
+        
+        if (episode != amp_atomic_int_load(left_episode, amp_memory_order_acquire)) {
+            return AMP_BUSY;
+        }
+    }
+    
+    barrier->valid = ~((int)amp_internal_valid_raw_barrier_lifecycle_state);
+    
+    free(barrier->flags_memory);
+    barrier->flags_memory = NULL;
+    barrier->flags = NULL;
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_barrier_wait(amp_barrier_t barrier)
+{
+    int ticket = 0;
+    amp_barrier_count_t thread_index = 0;
+    int episode = 0;
+    amp_atomic_int_t* own_flags = NULL;
+    unsigned int round = 0;
+    
+    assert(NULL != barrier);
+    assert((int)amp_internal_valid_raw_barrier_lifecycle_state == barrier->valid);
+    
+    if ((int)amp_internal_valid_raw_barrier_lifecycle_state != barrier->valid) {
+        
+        return AMP_ERROR;
+    }
+    
+    ticket = amp_atomic_int_fetch_add(&barrier->ticket, 1, amp_memory_order_acq_rel);
+    thread_index = (amp_barrier_count_t)ticket % barrier->init_count;
+    
+    /* Zeroed flags mean that the episode before the first one passed, 
+     * therefore flags are raised to the episode plus one.
+     */
+    episode = ticket / (int)barrier->init_count;
+    if (barrier->episode_count - 1 == episode) {
+        
+        if ((amp_barrier_count_t)(barrier->init_count - 1) == thread_index) {
+            /* Last ticket - rewind before signaling other threads. */
+            amp_atomic_int_fetch_sub(&barrier->ticket, 
+                                     barrier->episode_count * (int)barrier->init_count,
+                                     amp_memory_order_relaxed);
+        }
+        
+        episode = 0;
+    } else {
+        episode = episode + 1;
+    }
+    
+    own_flags = amp_internal_raw_barrier_flags(barrier, thread_index);
+    
+    for (round = 0; round < barrier->round_count; ++round) {
+        
+        amp_barrier_count_t const distance = (amp_barrier_count_t)1 << round;
+        amp_barrier_count_t const partner_index = (thread_index + distance) % barrier->init_count;
+        unsigned int spin_count = 0;
+        
+        amp_internal_raw_barrier_signal(barrier,
+                                        amp_internal_raw_barrier_flags(barrier, partner_index) + round, 
+                                        episode);
+        
+        while (!amp_internal_raw_barrier_signaled(barrier,
+                                                  amp_atomic_int_load(own_flags + round, amp_memory_order_acquire),
+                                                  episode)) {
+            
+            if (spin_count < AMP_DISSEMINATION_BARRIER_SPIN_COUNT) {
+                ++spin_count;
+                amp_atomic_cpu_relax();
+            } else {
+                int const retval = amp_thread_yield();
+                if (AMP_SUCCESS != retval && AMP_UNSUPPORTED != retval) {
+                    return retval;
+                }
+            }
+        }
+    }
+    
+    /* Last access to the barrier, it might be finalized afterwards. */
+    amp_atomic_int_store(own_flags + barrier->round_count, 
+                         episode, 
+                         amp_memory_order_release);
+    
+    if (0 == thread_index) {
+        return AMP_BARRIER_SERIAL_THREAD;
+    }
+    
+    return AMP_SUCCESS;
+}
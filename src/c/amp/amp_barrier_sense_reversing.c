@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of amp_barrier as a centralized sense reversing barrier 
+ * using atomic operations and a Linux futex. Selected by defining 
+ * AMP_USE_SENSE_REVERSING_BARRIERS.
+ *
+ * Every arriving thread reads the current barrier sense and decrements the
+ * barrier count with one atomic operation. The last arriving thread resets 
+ * the count, flips the sense, and wakes all blocked threads with one futex
+ * wake call. It receives AMP_BARRIER_SERIAL_THREAD. All other threads spin a
+ * bounded number of times on the sense flag and then block on it until it 
+ * flips. No mutex serializes the arriving or waking threads and the wake
+ * call is skipped if all waiting threads are still spinning.
+ *
+ * Threads can wait on the barrier again immediately after passing it -
+ * the next barrier round can't complete before all threads of the previous 
+ * round have read the flipped sense because it needs all of them to arrive.
+ *
+ * amp_barrier_create and amp_barrier_destroy are implemented in 
+ * amp_barrier_common.c.
+ *
+ * See Maurice Herlihy and Nir Shavit, The Art of Multiprocessor Programming, 
+ * Morgan Kaufmann, 2008, pp. 399.
+ */
+
+#include "amp_raw_barrier.h"
+
+#include <assert.h>
+#include <limits.h>
+#include <stddef.h>
+
+#include "amp_stddef.h"
+#include "amp_return_code.h"
+#include "amp_atomic.h"
+#include "amp_internal_futex.h"
+
+
+
+#if !defined(AMP_USE_SENSE_REVERSING_BARRIERS)
+#   error Compiling wrong source file for selected backend.
+#endif
+
+
+
+#if !defined(AMP_SENSE_REVERSING_BARRIER_SPIN_COUNT)
+/**
+ * Number of times a waiting thread checks the barrier sense before blocking
+ * on it. Define it to 0 to block immediately, e.g. if the barrier is used by
+ * more threads than hardware threads exist.
+ */
+#   define AMP_SENSE_REVERSING_BARRIER_SPIN_COUNT 1024
+#endif
+
+
+
+enum amp_internal_raw_barrier_lifecycle_state {
+    amp_internal_valid_raw_barrier_lifecycle_state = 0xabcdef
+};
+
+
+
+int amp_raw_barrier_init(amp_barrier_t barrier,
+                         amp_barrier_count_t init_count)
+{
+    assert(NULL != barrier);
+    assert(0 < init_count);
+    assert((amp_barrier_count_t)INT_MAX >= init_count);
+    
+    if (0 == init_count) {
+        return AMP_ERROR;
+    }
+    
+    barrier->init_count = init_count;
+    amp_atomic_int_store(&barrier->sense, 0, amp_memory_order_relaxed);
+    amp_atomic_int_store(&barrier->sleeping, 0, amp_memory_order_relaxed);
+    amp_atomic_int_store(&barrier->releasing, 0, amp_memory_order_relaxed);
+    amp_atomic_int_store(&barrier->count, (int)init_count, amp_memory_order_release);
+    barrier->valid = (int)amp_internal_valid_raw_barrier_lifecycle_state;
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_raw_barrier_finalize(amp_barrier_t barrier)
+{
+    assert(NULL != barrier);
+    assert((int)amp_internal_valid_raw_barrier_lifecycle_state == barrier->valid);
+    
+    if ((int)amp_internal_valid_raw_barrier_lifecycle_state != barrier->valid) {
+        return AMP_ERROR;
+    }
+    
+    /* Weak check that no threads wait for the barrier. */
+    if ((int)barrier->init_count != amp_atomic_int_load(&barrier->count, amp_memory_order_acquire)) {
+        return AMP_BUSY;
+    }
+    
+    /* The released threads might return from waiting before the last arriving
+     * thread finished waking them - wait for it to leave the barrier.
+     */
+    while (0 != amp_atomic_int_load(&barrier->releasing, amp_memory_order_acquire)) {
+        amp_atomic_cpu_relax();
+    }
+    
+    barrier->valid = ~((int)amp_internal_valid_raw_barrier_lifecycle_state);
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_barrier_wait(amp_barrier_t barrier)
+{
+    int local_sense = 0;
+    amp_barrier_count_t previous_count = 0;
+    unsigned int spin_count = 0;
+    
+    assert(NULL != barrier);
+    assert((int)amp_internal_valid_raw_barrier_lifecycle_state == barrier->valid);
+    
+    if ((int)amp_internal_valid_raw_barrier_lifecycle_state != barrier->valid) {
+        
+        return AMP_ERROR;
+    }
+    
+    /* The sense can't flip before this thread arrived so reading it before 
+     * arriving returns the sense of the current round.
+     */
+    local_sense = amp_atomic_int_load(&barrier->sense, amp_memory_order_acquire);
+    
+    previous_count = (amp_barrier_count_t)amp_atomic_int_fetch_sub(&barrier->count, 1, amp_memory_order_acq_rel);
+    assert(0 != previous_count && "Barrier count underflow");
+    
+    if (1 == previous_count) {
+        /* Last arriving thread - reset the barrier for the next round before
+         * releasing the waiting threads.
+         */
+        int retval = AMP_BARRIER_SERIAL_THREAD;
+        
+        amp_atomic_int_store(&barrier->releasing, 1, amp_memory_order_relaxed);
+        amp_atomic_int_store(&barrier->count, (int)barrier->init_count, amp_memory_order_relaxed);
+        amp_atomic_int_store(&barrier->sense, !local_sense, amp_memory_order_seq_cst);
+        
+        if (0 != amp_atomic_int_exchange(&barrier->sleeping, 0, amp_memory_order_seq_cst)) {
+            int const rv = amp_internal_futex_wake(&barrier->sense, INT_MAX);
+            if (AMP_SUCCESS != rv) {
+                retval = rv;
+            }
+        }
+        
+        /* Last access of the barrier by this thread. */
+        amp_atomic_int_store(&barrier->releasing, 0, amp_memory_order_release);
+        
+        return retval;
+    }
+    
+    while (local_sense == amp_atomic_int_load(&barrier->sense, amp_memory_order_acquire)) {
+        
+        if (spin_count < AMP_SENSE_REVERSING_BARRIER_SPIN_COUNT) {
+            ++spin_count;
+            amp_atomic_cpu_relax();
+        } else {
+            int retval = AMP_UNSUPPORTED;
+            
+            /* Announce blocking before checking the sense (inside the futex
+             * call) so the releasing thread can't miss this thread.
+             */
+            amp_atomic_int_store(&barrier->sleeping, 1, amp_memory_order_seq_cst);
+            
+            retval = amp_internal_futex_wait(&barrier->sense, local_sense);
+            if (AMP_SUCCESS != retval) {
+                return retval;
+            }
+        }
+    }
+    
+    return AMP_SUCCESS;
+}
+
+
@@ -43,6 +43,7 @@
 
 #include "amp_raw_condition_variable.h"
 #include "amp_return_code.h"
+#include "amp_internal_memory.h"
 
 
 
@@ -58,8 +59,8 @@ int amp_condition_variable_create(amp_condition_variable_t* cond,
     *cond = AMP_CONDITION_VARIABLE_UNINITIALIZED;
     
     
-    tmp_cond = (amp_condition_variable_t)AMP_ALLOC(allocator,
-                                                   sizeof(*tmp_cond));
+    tmp_cond = (amp_condition_variable_t)AMP_INTERNAL_PRIMITIVE_ALLOC(allocator,
+                                                                      sizeof(*tmp_cond));
     if (NULL == tmp_cond) {
         return AMP_NOMEM;
     }
@@ -68,8 +69,8 @@ int amp_condition_variable_create(amp_condition_variable_t* cond,
     if (AMP_SUCCESS == retval) {
         *cond = tmp_cond;
     } else {
-        int const rc = AMP_DEALLOC(allocator,
-                                   tmp_cond);
+        int const rc = AMP_INTERNAL_PRIMITIVE_DEALLOC(allocator,
+                                                      tmp_cond);
         assert(AMP_SUCCESS == rc);
         (void)rc;
     }
@@ -90,8 +91,8 @@ int amp_condition_variable_destroy(amp_condition_variable_t* cond,
     
     retval = amp_raw_condition_variable_finalize(*cond);
     if (AMP_SUCCESS == retval) {
-        retval = AMP_DEALLOC(allocator,
-                             *cond);
+        retval = AMP_INTERNAL_PRIMITIVE_DEALLOC(allocator,
+                                                *cond);
         assert(AMP_SUCCESS == retval);
         if (AMP_SUCCESS == retval) {
             *cond = AMP_CONDITION_VARIABLE_UNINITIALIZED;
@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Linux futex based amp condition variable backend that works together with
+ * the futex mutex backend from amp_mutex_futex.c. Selected by defining 
+ * AMP_USE_FUTEX_MUTEXES.
+ *
+ * Every signal and broadcast increments a sequence futex word. A waiting
+ * thread reads the sequence while still holding the mutex, unlocks the mutex
+ * and blocks on the sequence word as long as it hasn't changed. Signaling or
+ * broadcasting a condition variable no thread waits on doesn't enter the 
+ * kernel.
+ *
+ * Spurious wake ups can happen, e.g. if more than one thread is woken by
+ * a single signal, therefore always wait in a loop checking the predicate.
+ *
+ * amp_condition_variable_create and amp_condition_variable_destroy are
+ * implemented in amp_condition_variable_common.c.
+ */
+
+#include "amp_condition_variable.h"
+
+#include <assert.h>
+#include <limits.h>
+#include <stddef.h>
+
+#include "amp_return_code.h"
+#include "amp_mutex.h"
+#include "amp_raw_mutex.h"
+#include "amp_raw_condition_variable.h"
+#include "amp_atomic.h"
+#include "amp_internal_futex.h"
+
+
+
+#if !defined(AMP_USE_FUTEX_MUTEXES)
+#   error Build configuration problem - this source file shouldn't be compiled.
+#endif
+
+
+
+int amp_raw_condition_variable_init(amp_condition_variable_t cond)
+{
+    assert(NULL != cond);
+    
+    amp_atomic_int_store(&cond->sequence, 0, amp_memory_order_relaxed);
+    amp_atomic_int_store(&cond->waiter_count, 0, amp_memory_order_release);
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_raw_condition_variable_finalize(amp_condition_variable_t cond)
+{
+    assert(NULL != cond);
+    
+    if (0 != amp_atomic_int_load(&cond->waiter_count, amp_memory_order_acquire)) {
+        assert(0); /* Programming error */
+        return AMP_BUSY;
+    }
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_condition_variable_broadcast(amp_condition_variable_t cond)
+{
+    assert(NULL != cond);
+    
+    amp_atomic_int_fetch_add(&cond->sequence, 1, amp_memory_order_seq_cst);
+    
+    if (0 == amp_atomic_int_load(&cond->waiter_count, amp_memory_order_seq_cst)) {
+        return AMP_SUCCESS;
+    }
+    
+    return amp_internal_futex_wake(&cond->sequence, INT_MAX);
+}
+
+
+
+int amp_condition_variable_signal(amp_condition_variable_t cond)
+{
+    assert(NULL != cond);
+    
+    amp_atomic_int_fetch_add(&cond->sequence, 1, amp_memory_order_seq_cst);
+    
+    if (0 == amp_atomic_int_load(&cond->waiter_count, amp_memory_order_seq_cst)) {
+        return AMP_SUCCESS;
+    }
+    
+    return amp_internal_futex_wake(&cond->sequence, 1);
+}
+
+
+
+int amp_condition_variable_wait(amp_condition_variable_t cond,
+                                amp_mutex_t mutex)
+{
+    int sequence = 0;
+    int retval = AMP_UNSUPPORTED;
+    int retval_lock = AMP_UNSUPPORTED;
+    
+    assert(NULL != cond);
+    assert(NULL != mutex);
+    
+    /* Register as a waiter and read the sequence while holding the mutex so
+     * a signal issued after unlocking is never lost.
+     */
+    amp_atomic_int_fetch_add(&cond->waiter_count, 1, amp_memory_order_seq_cst);
+    sequence = amp_atomic_int_load(&cond->sequence, amp_memory_order_seq_cst);
+    
+    retval = amp_mutex_unlock(mutex);
+    if (AMP_SUCCESS != retval) {
+        amp_atomic_int_fetch_sub(&cond->waiter_count, 1, amp_memory_order_relaxed);
+        assert(0); /* Programming error */
+        return retval;
+    }
+    
+    retval = amp_internal_futex_wait(&cond->sequence, sequence);
+    assert(AMP_SUCCESS == retval);
+    
+    retval_lock = amp_mutex_lock(mutex);
+    assert(AMP_SUCCESS == retval_lock);
+    
+    amp_atomic_int_fetch_sub(&cond->waiter_count, 1, amp_memory_order_relaxed);
+    
+    if (AMP_SUCCESS != retval) {
+        return retval;
+    }
+    
+    return retval_lock;
+}
+
+
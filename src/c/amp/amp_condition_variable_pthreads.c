@@ -50,6 +50,12 @@
 
 
 
+#if !defined(AMP_USE_PTHREADS) || defined(AMP_USE_FUTEX_MUTEXES)
+#   error Build configuration problem - this source file shouldn't be compiled.
+#endif
+
+
+
 int amp_raw_condition_variable_init(amp_condition_variable_t cond)
 {
     assert(NULL != cond);
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * One-shot handoff of a result from the thread producing it to the threads
+ * needing it.
+ *
+ * A promise is the write end and a future the read end of the same shared
+ * state. The producer, e.g. an amp thread or a job of an amp_thread_pool, 
+ * sets the value of the promise exactly once. Consumers wait on the future
+ * or poll it with amp_future_try_get and can wait for a whole array of 
+ * futures with amp_future_when_all. The value is a pointer, point it to a
+ * result struct for larger results.
+ *
+ * The state lives in a single atomic word. Setting the value of a promise
+ * nobody waits on and getting the value of a ready future never blocks or 
+ * enters the kernel. Embed a struct amp_raw_future_s from 
+ * amp_raw_future.h into a job context and initialize it with 
+ * amp_raw_future_init to avoid the allocation.
+ *
+ * Example:
+ * @code
+ * struct job_s {
+ *     amp_promise_t promise;
+ *     int input;
+ * };
+ *
+ * void job_func(void* context)
+ * {
+ *     struct job_s* job = (struct job_s*)context;
+ *     amp_promise_set_value(job->promise, compute(job->input));
+ * }
+ *
+ * amp_promise_create(&job.promise, AMP_DEFAULT_ALLOCATOR);
+ * amp_promise_get_future(job.promise, &future);
+ * amp_thread_pool_submit(pool, &job, job_func);
+ * ...
+ * amp_future_wait(future, &result);
+ * amp_promise_destroy(&job.promise, AMP_DEFAULT_ALLOCATOR);
+ * @endcode
+ *
+ * Backends: define AMP_USE_FUTEX_FUTURES on Linux to block on the state 
+ * word with a futex, or AMP_USE_GENERIC_FUTURES to block with the amp 
+ * mutex and condition variable backends.
+ *
+ * A promise can be destroyed as soon as its value has been got, even if 
+ * amp_promise_set_value hasn't returned yet.
+ *
+ * @attention Don't destroy a promise while threads wait on its future or 
+ *            before its value has been set.
+ *
+ * @attention Uses amp_atomic.h and is therefore not included by amp.h.
+ */
+
+#ifndef AMP_amp_future_H
+#define AMP_amp_future_H
+
+#include <stddef.h>
+
+#include <amp/amp_memory.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+    
+#define AMP_PROMISE_UNINITIALIZED NULL
+#define AMP_FUTURE_UNINITIALIZED NULL
+    
+    /**
+     * Opaque type representing the write end of an amp promise.
+     */
+    typedef struct amp_raw_future_s *amp_promise_t;
+    
+    /**
+     * Opaque type representing the read end of an amp promise. Futures 
+     * aren't created or destroyed on their own, they stay valid as long as
+     * their promise.
+     */
+    typedef struct amp_raw_future_s *amp_future_t;
+    
+    
+    /**
+     * Allocates a promise without a value.
+     *
+     * @return AMP_SUCCESS on successful creation.
+     *         AMP_NOMEM if not enough memory is available.
+     *         Other error codes might be returned to signal errors, too. 
+     */
+    int amp_promise_create(amp_promise_t* promise,
+                           amp_allocator_t allocator);
+    
+    /**
+     * Frees the promise and invalidates its future.
+     *
+     * @return AMP_SUCCESS after freeing the promise.
+     *         Other error codes might be returned to signal errors, too. 
+     *         These are programming errors and mustn't occur in release code.
+     */
+    int amp_promise_destroy(amp_promise_t* promise,
+                            amp_allocator_t allocator);
+    
+    /**
+     * Stores the future reading the value of promise in future.
+     *
+     * @return AMP_SUCCESS.
+     */
+    int amp_promise_get_future(amp_promise_t promise,
+                               amp_future_t* future);
+    
+    /**
+     * Sets the value of promise and wakes all threads waiting on its future.
+     * Memory effects of the calling thread before setting the value are 
+     * visible to threads after they got the value.
+     *
+     * @return AMP_SUCCESS if the value has been set.
+     *         AMP_BUSY if a value has been set before. The value isn't 
+     *         changed.
+     */
+    int amp_promise_set_value(amp_promise_t promise,
+                              void* value);
+    
+    /**
+     * Blocks until the value of the promise of future is set and stores it 
+     * in value unless value is NULL.
+     *
+     * @return AMP_SUCCESS after the value has been set.
+     *         Other error codes might be returned to signal errors, too. 
+     *         These are programming errors and mustn't occur in release code.
+     */
+    int amp_future_wait(amp_future_t future,
+                        void** value);
+    
+    /**
+     * Stores the value of the promise of future in value if it has been set,
+     * without blocking.
+     *
+     * @return AMP_SUCCESS if the value has been set and stored in value.
+     *         AMP_BUSY if the value hasn't been set yet. value is unchanged.
+     */
+    int amp_future_try_get(amp_future_t future,
+                           void** value);
+    
+    /**
+     * Blocks until the values of all future_count futures are set. Get the
+     * values afterwards with amp_future_try_get which doesn't block anymore.
+     *
+     * @return AMP_SUCCESS after all values have been set.
+     *         Other error codes might be returned to signal errors, too. 
+     *         These are programming errors and mustn't occur in release code.
+     */
+    int amp_future_when_all(amp_future_t const* futures,
+                            size_t future_count);
+    
+    
+    
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* AMP_amp_future_H */
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation shared by all amp future backends.
+ */
+
+#include "amp_future.h"
+
+#include <assert.h>
+#include <stddef.h>
+
+#include "amp_stddef.h"
+#include "amp_return_code.h"
+#include "amp_internal_memory.h"
+#include "amp_atomic.h"
+#include "amp_raw_future.h"
+#include "amp_internal_future.h"
+
+
+
+int amp_promise_create(amp_promise_t* promise,
+                       amp_allocator_t allocator)
+{
+    amp_promise_t tmp_promise = AMP_PROMISE_UNINITIALIZED;
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != promise);
+    assert(NULL != allocator);
+    
+    tmp_promise = (amp_promise_t)AMP_INTERNAL_PRIMITIVE_ALLOC(allocator, sizeof(*tmp_promise));
+    if (NULL == tmp_promise) {
+        return AMP_NOMEM;
+    }
+    
+    retval = amp_raw_future_init(tmp_promise);
+    if (AMP_SUCCESS == retval) {
+        *promise = tmp_promise;
+    } else {
+        int const rc = AMP_INTERNAL_PRIMITIVE_DEALLOC(allocator, tmp_promise);
+        assert(AMP_SUCCESS == rc);
+        (void)rc;
+    }
+    
+    return retval;
+}
+
+
+
+int amp_promise_destroy(amp_promise_t* promise,
+                        amp_allocator_t allocator)
+{
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != promise);
+    assert(NULL != *promise);
+    assert(NULL != allocator);
+    
+    retval = amp_raw_future_finalize(*promise);
+    if (AMP_SUCCESS == retval) {
+        retval = AMP_INTERNAL_PRIMITIVE_DEALLOC(allocator, *promise);
+        assert(AMP_SUCCESS == retval);
+        if (AMP_SUCCESS == retval) {
+            *promise = AMP_PROMISE_UNINITIALIZED;
+        }
+    }
+    
+    return retval;
+}
+
+
+
+int amp_promise_get_future(amp_promise_t promise,
+                           amp_future_t* future)
+{
+    assert(NULL != promise);
+    assert(NULL != future);
+    
+    *future = promise;
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_future_try_get(amp_future_t future,
+                       void** value)
+{
+    int state = 0;
+    
+    assert(NULL != future);
+    assert(NULL != value);
+    
+    state = amp_atomic_int_load(&future->state, amp_memory_order_acquire);
+    if (0 == (state & amp_internal_future_flag_ready)) {
+        return AMP_BUSY;
+    }
+    
+    *value = future->value;
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_future_when_all(amp_future_t const* futures,
+                        size_t future_count)
+{
+    size_t i = 0;
+    
+    assert((NULL != futures) || (0 == future_count));
+    
+    /* Every wait returns immediately for already ready futures, so the 
+     * calling thread blocks at most until the last value is set.
+     */
+    for (i = 0; i < future_count; ++i) {
+        int const retval = amp_future_wait(futures[i], NULL);
+        if (AMP_SUCCESS != retval) {
+            return retval;
+        }
+    }
+    
+    return AMP_SUCCESS;
+}
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Linux futex based amp future backend. Selected by defining 
+ * AMP_USE_FUTEX_FUTURES.
+ *
+ * Waiting threads add the waiting flag to the state word and block on it 
+ * with a futex as long as it doesn't contain the ready flag. The setting 
+ * thread only enters the kernel to wake them if it finds the waiting flag.
+ *
+ * Adding the ready flag is the last access of the setting thread to the 
+ * future, so a thread that got the value may finalize and free it right 
+ * away. The following futex wake only passes the address of the state word
+ * to the kernel and never dereferences it. If the memory has been reused 
+ * for another futex in between, its waiters see a spurious wake up that all
+ * amp futex users tolerate.
+ *
+ * amp_promise_create, amp_promise_destroy, amp_future_try_get, and 
+ * amp_future_when_all are implemented in amp_future_common.c.
+ */
+
+#include "amp_future.h"
+
+#include <assert.h>
+#include <limits.h>
+#include <stddef.h>
+
+#include "amp_return_code.h"
+#include "amp_atomic.h"
+#include "amp_raw_future.h"
+#include "amp_internal_future.h"
+#include "amp_internal_futex.h"
+
+
+
+#if !defined(AMP_USE_FUTEX_FUTURES)
+#   error Build configuration problem - this source file shouldn't be compiled.
+#endif
+
+
+
+int amp_raw_future_init(struct amp_raw_future_s* future)
+{
+    assert(NULL != future);
+    
+    future->value = NULL;
+    amp_atomic_int_store(&future->state, 0, amp_memory_order_release);
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_raw_future_finalize(struct amp_raw_future_s* future)
+{
+    assert(NULL != future);
+    (void)future;
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_promise_set_value(amp_promise_t promise,
+                          void* value)
+{
+    amp_atomic_int_t* state_word = NULL;
+    int state = 0;
+    
+    assert(NULL != promise);
+    
+    state_word = &promise->state;
+    
+    state = amp_internal_future_add_flag(&promise->state,
+                                         amp_internal_future_flag_set,
+                                         amp_memory_order_relaxed);
+    if (0 != (state & amp_internal_future_flag_set)) {
+        return AMP_BUSY;
+    }
+    
+    promise->value = value;
+    
+    /* promise mustn't be accessed after publishing the value. */
+    state = amp_internal_future_add_flag(state_word,
+                                         amp_internal_future_flag_ready,
+                                         amp_memory_order_acq_rel);
+    if (0 != (state & amp_internal_future_flag_waiting)) {
+        return amp_internal_futex_wake(state_word, INT_MAX);
+    }
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_future_wait(amp_future_t future,
+                    void** value)
+{
+    int state = 0;
+    
+    assert(NULL != future);
+    
+    state = amp_atomic_int_load(&future->state, amp_memory_order_acquire);
+    
+    while (0 == (state & amp_internal_future_flag_ready)) {
+        
+        if (0 == (state & amp_internal_future_flag_waiting)) {
+            int const waiting_state = state | amp_internal_future_flag_waiting;
+            
+            if (!amp_atomic_int_compare_exchange(&future->state,
+                                                 &state,
+                                                 waiting_state,
+                                                 amp_memory_order_acquire,
+                                                 amp_memory_order_acquire)) {
+                /* state has been reloaded, recheck it. */
+                continue;
+            }
+            state = waiting_state;
+        }
+        
+        {
+            int const retval = amp_internal_futex_wait(&future->state, state);
+            if (AMP_SUCCESS != retval) {
+                assert(0); /* Programming error */
+                return retval;
+            }
+        }
+        
+        state = amp_atomic_int_load(&future->state, amp_memory_order_acquire);
+    }
+    
+    if (NULL != value) {
+        *value = future->value;
+    }
+    
+    return AMP_SUCCESS;
+}
@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * amp future backend blocking waiting threads with the amp mutex and 
+ * condition variable backends. Selected by defining AMP_USE_GENERIC_FUTURES.
+ *
+ * Getting the value of a ready future and setting the value of a promise 
+ * nobody waits on only touch the state word. Waiting threads add the 
+ * waiting flag while holding the mutex and wait on the condition variable
+ * until the ready flag is set. A setting thread that finds the waiting flag
+ * broadcasts the condition variable while holding the mutex so no waiting
+ * thread can miss the wake up.
+ *
+ * A woken thread may get the value and finalize the future before the 
+ * setting thread unlocked the mutex. The setting thread therefore publishes
+ * the value together with the waking flag if it has to wake threads, and 
+ * only removes it after unlocking. Finalizing waits until the waking flag 
+ * is gone.
+ *
+ * amp_promise_create, amp_promise_destroy, amp_future_try_get, and 
+ * amp_future_when_all are implemented in amp_future_common.c.
+ */
+
+#include "amp_future.h"
+
+#include <assert.h>
+#include <stddef.h>
+
+#include "amp_return_code.h"
+#include "amp_atomic.h"
+#include "amp_mutex.h"
+#include "amp_condition_variable.h"
+#include "amp_raw_mutex.h"
+#include "amp_raw_condition_variable.h"
+#include "amp_thread.h"
+#include "amp_raw_future.h"
+#include "amp_internal_future.h"
+
+
+
+#if !defined(AMP_USE_GENERIC_FUTURES)
+#   error Build configuration problem - this source file shouldn't be compiled.
+#endif
+
+
+
+int amp_raw_future_init(struct amp_raw_future_s* future)
+{
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != future);
+    
+    retval = amp_raw_mutex_init(&future->mutex);
+    if (AMP_SUCCESS != retval) {
+        return retval;
+    }
+    
+    retval = amp_raw_condition_variable_init(&future->ready);
+    if (AMP_SUCCESS != retval) {
+        int const rc = amp_raw_mutex_finalize(&future->mutex);
+        assert(AMP_SUCCESS == rc);
+        (void)rc;
+        
+        return retval;
+    }
+    
+    future->value = NULL;
+    amp_atomic_int_store(&future->state, 0, amp_memory_order_release);
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_raw_future_finalize(struct amp_raw_future_s* future)
+{
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != future);
+    
+    /* Let a setting thread finish waking waiting threads. */
+    while (0 != (amp_atomic_int_load(&future->state, amp_memory_order_acquire) & amp_internal_future_flag_waking)) {
+        retval = amp_thread_yield();
+        assert((AMP_SUCCESS == retval) || (AMP_UNSUPPORTED == retval));
+    }
+    
+    retval = amp_raw_condition_variable_finalize(&future->ready);
+    if (AMP_SUCCESS != retval) {
+        return retval;
+    }
+    
+    return amp_raw_mutex_finalize(&future->mutex);
+}
+
+
+
+int amp_promise_set_value(amp_promise_t promise,
+                          void* value)
+{
+    int state = 0;
+    int ready_state = 0;
+    int retval = AMP_SUCCESS;
+    
+    assert(NULL != promise);
+    
+    state = amp_internal_future_add_flag(&promise->state,
+                                         amp_internal_future_flag_set,
+                                         amp_memory_order_relaxed);
+    if (0 != (state & amp_internal_future_flag_set)) {
+        return AMP_BUSY;
+    }
+    
+    promise->value = value;
+    
+    /* Waiting threads add the waiting flag while holding the mutex and 
+     * recheck the ready flag, the wake up can't get lost.
+     */
+    state = amp_atomic_int_load(&promise->state, amp_memory_order_relaxed);
+    do {
+        ready_state = state | amp_internal_future_flag_ready;
+        if (0 != (state & amp_internal_future_flag_waiting)) {
+            ready_state |= amp_internal_future_flag_waking;
+        }
+    } while (!amp_atomic_int_compare_exchange(&promise->state,
+                                              &state,
+                                              ready_state,
+                                              amp_memory_order_acq_rel,
+                                              amp_memory_order_relaxed));
+    
+    if (0 != (ready_state & amp_internal_future_flag_waking)) {
+        int rc = amp_mutex_lock(&promise->mutex);
+        assert(AMP_SUCCESS == rc);
+        {
+            retval = amp_condition_variable_broadcast(&promise->ready);
+        }
+        rc = amp_mutex_unlock(&promise->mutex);
+        assert(AMP_SUCCESS == rc);
+        (void)rc;
+        
+        /* Last access to promise, it might be finalized afterwards. */
+        (void)amp_internal_future_remove_flag(&promise->state,
+                                              amp_internal_future_flag_waking,
+                                              amp_memory_order_release);
+    }
+    
+    return retval;
+}
+
+
+
+int amp_future_wait(amp_future_t future,
+                    void** value)
+{
+    int state = 0;
+    int retval = AMP_SUCCESS;
+    
+    assert(NULL != future);
+    
+    state = amp_atomic_int_load(&future->state, amp_memory_order_acquire);
+    
+    if (0 == (state & amp_internal_future_flag_ready)) {
+        int rc = amp_mutex_lock(&future->mutex);
+        assert(AMP_SUCCESS == rc);
+        {
+            state = amp_internal_future_add_flag(&future->state,
+                                                 amp_internal_future_flag_waiting,
+                                                 amp_memory_order_acq_rel);
+            
+            while ((0 == (state & amp_internal_future_flag_ready))
+                   && (AMP_SUCCESS == retval)) {
+                retval = amp_condition_variable_wait(&future->ready,
+                                                     &future->mutex);
+                assert(AMP_SUCCESS == retval);
+                
+                state = amp_atomic_int_load(&future->state, 
+                                            amp_memory_order_acquire);
+            }
+        }
+        rc = amp_mutex_unlock(&future->mutex);
+        assert(AMP_SUCCESS == rc);
+        (void)rc;
+    }
+    
+    if ((AMP_SUCCESS == retval) && (NULL != value)) {
+        *value = future->value;
+    }
+    
+    return retval;
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of the internal futex wrapper for Linux.
+ *
+ * Only compile for backends using futexes, e.g. if AMP_USE_FUTEX_MUTEXES or
+ * AMP_USE_FUTEX_SEMAPHORES are defined.
+ */
+
+#include "amp_internal_futex.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "amp_return_code.h"
+#include "amp_atomic.h"
+
+
+
+#if !defined(__linux__)
+#   error Build configuration problem - futexes are only supported on Linux.
+#endif
+
+
+
+int amp_internal_futex_wait(amp_atomic_int_t* address,
+                            int expected_value)
+{
+    long retval = 0;
+    
+    assert(NULL != address);
+    /* Atomic ints have the size and representation of plain ints with all 
+     * amp_atomic backends so their address is usable as a futex word.
+     */
+    assert(sizeof(int) == sizeof(*address));
+    
+    retval = syscall(SYS_futex, 
+                     address, 
+                     FUTEX_WAIT_PRIVATE, 
+                     expected_value, 
+                     NULL, /* No timeout */
+                     NULL, 
+                     0);
+    if (0 != retval) {
+        switch (errno) {
+            case EAGAIN: /* Futex word did not contain expected_value */
+                /* Fallthrough */
+            case EINTR: /* Interrupted by a signal */
+                break;
+            default: /* EFAULT, EINVAL, ENOSYS - programming error */
+                assert(0);
+                return AMP_ERROR;
+        }
+    }
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_internal_futex_wake(amp_atomic_int_t* address,
+                            int wake_count)
+{
+    long retval = 0;
+    
+    assert(NULL != address);
+    assert(0 < wake_count);
+    
+    retval = syscall(SYS_futex,
+                     address,
+                     FUTEX_WAKE_PRIVATE,
+                     wake_count,
+                     NULL,
+                     NULL,
+                     0);
+    if (0 > retval) {
+        assert(0); /* EFAULT, EINVAL, ENOSYS - programming error */
+        return AMP_ERROR;
+    }
+    
+    return AMP_SUCCESS;
+}
+
+
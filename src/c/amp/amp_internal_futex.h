@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Internal shallow wrapper around the Linux futex system call used by the
+ * futex based mutex, condition variable, semaphore, and barrier backends.
+ *
+ * A futex is a 32bit integer in user space that threads can block on as long
+ * as it contains an expected value and which can be used to wake a number of
+ * threads blocked on it. All state changes of the futex word are done by
+ * the backends via atomic operations - the kernel is only entered to block
+ * or to wake up blocked threads.
+ *
+ * Only process private futexes are used as amp primitives can't be shared 
+ * between processes.
+ *
+ * See Ulrich Drepper, Futexes Are Tricky, 2004 (revised 2009), 
+ * http://people.redhat.com/drepper/futex.pdf
+ *
+ * See http://man7.org/linux/man-pages/man2/futex.2.html
+ */
+
+#ifndef AMP_amp_internal_futex_H
+#define AMP_amp_internal_futex_H
+
+#include <amp/amp_atomic.h>
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+    
+    
+    /**
+     * Blocks the calling thread on the futex word at address as long as it 
+     * contains expected_value.
+     *
+     * Returns immediately if address does not contain expected_value (checked
+     * atomically by the kernel), if the thread is woken up via 
+     * amp_internal_futex_wake, if a signal interrupts the wait, or 
+     * spuriously. Callers must therefore always recheck the futex word after
+     * returning.
+     *
+     * @return AMP_SUCCESS if the futex word should be rechecked.
+     *         AMP_ERROR is returned if address is invalid which is a 
+     *         programming error.
+     */
+    int amp_internal_futex_wait(amp_atomic_int_t* address,
+                                int expected_value);
+    
+    /**
+     * Wakes up to wake_count threads blocked on the futex word at address.
+     *
+     * Pass INT_MAX as wake_count to wake all blocked threads.
+     *
+     * @return AMP_SUCCESS if the wake up request has been handled, regardless
+     *         if any thread has been woken.
+     *         AMP_ERROR is returned if address is invalid which is a 
+     *         programming error.
+     */
+    int amp_internal_futex_wake(amp_atomic_int_t* address,
+                                int wake_count);
+    
+    
+    
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* AMP_amp_internal_futex_H */
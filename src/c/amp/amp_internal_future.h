@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * State flags shared by the amp future backends.
+ */
+
+#ifndef AMP_amp_internal_future_H
+#define AMP_amp_internal_future_H
+
+#include <amp/amp_atomic.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+    
+    
+    /**
+     * Flags combined in amp_raw_future_s state. A setting thread first 
+     * claims the promise with the set flag, then writes the value and 
+     * publishes it with the ready flag. Waiting threads add the waiting flag
+     * before they block so the setting thread knows it has to wake them.
+     * Backends that still access the future to wake waiting threads after
+     * publishing the value keep the waking flag raised until they are done.
+     */
+    enum amp_internal_future_flag {
+        amp_internal_future_flag_set = 1,
+        amp_internal_future_flag_ready = 2,
+        amp_internal_future_flag_waiting = 4,
+        amp_internal_future_flag_waking = 8
+    };
+    
+    
+    /**
+     * Adds flag to the state word and returns the previous state.
+     */
+    static inline int amp_internal_future_add_flag(amp_atomic_int_t* state,
+                                                   int flag,
+                                                   amp_memory_order_t order)
+    {
+        int previous = amp_atomic_int_load(state, amp_memory_order_relaxed);
+        
+        while (!amp_atomic_int_compare_exchange(state,
+                                                &previous,
+                                                previous | flag,
+                                                order,
+                                                amp_memory_order_relaxed)) {
+            /* previous has been reloaded. */
+        }
+        
+        return previous;
+    }
+    
+    
+    /**
+     * Removes flag from the state word and returns the previous state.
+     */
+    static inline int amp_internal_future_remove_flag(amp_atomic_int_t* state,
+                                                      int flag,
+                                                      amp_memory_order_t order)
+    {
+        int previous = amp_atomic_int_load(state, amp_memory_order_relaxed);
+        
+        while (!amp_atomic_int_compare_exchange(state,
+                                                &previous,
+                                                previous & ~flag,
+                                                order,
+                                                amp_memory_order_relaxed)) {
+            /* previous has been reloaded. */
+        }
+        
+        return previous;
+    }
+    
+    
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* AMP_amp_internal_future_H */
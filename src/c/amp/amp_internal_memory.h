@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Allocation of the amp synchronization primitives by their create and 
+ * destroy functions. With AMP_PAD_PRIMITIVES_TO_CACHE_LINE defined 
+ * primitives are allocated cache line aligned and padded to whole cache 
+ * lines so that primitives created one after another don't share a cache 
+ * line and contend for it. Otherwise the plain allocation functions are 
+ * used.
+ */
+
+#ifndef AMP_amp_internal_memory_H
+#define AMP_amp_internal_memory_H
+
+#include "amp_stddef.h"
+#include "amp_memory.h"
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+    
+    
+#define AMP_INTERNAL_MEMORY_ROUND_TO_CACHE_LINE(size) ((((size) + AMP_CACHE_LINE_SIZE - 1) / AMP_CACHE_LINE_SIZE) * AMP_CACHE_LINE_SIZE)
+    
+    
+#if defined(AMP_PAD_PRIMITIVES_TO_CACHE_LINE)
+    
+#   define AMP_INTERNAL_PRIMITIVE_ALLOC(allocator, size) AMP_ALIGNED_ALLOC((allocator), AMP_CACHE_LINE_SIZE, AMP_INTERNAL_MEMORY_ROUND_TO_CACHE_LINE(size))
+#   define AMP_INTERNAL_PRIMITIVE_DEALLOC(allocator, pointer) AMP_ALIGNED_DEALLOC((allocator), (pointer))
+    
+#else
+    
+#   define AMP_INTERNAL_PRIMITIVE_ALLOC(allocator, size) AMP_ALLOC((allocator), (size))
+#   define AMP_INTERNAL_PRIMITIVE_DEALLOC(allocator, pointer) AMP_DEALLOC((allocator), (pointer))
+    
+#endif
+    
+    
+    
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* AMP_amp_internal_memory_H */
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Spin-wait helper shared by the amp spinlock backends.
+ */
+
+#ifndef AMP_amp_internal_spinlock_H
+#define AMP_amp_internal_spinlock_H
+
+#include <amp/amp_atomic.h>
+#include <amp/amp_thread.h>
+
+
+
+#if !defined(AMP_SPINLOCK_SPIN_COUNT)
+/**
+ * Number of times a waiting thread checks the lock before it yields the 
+ * processor between checks.
+ */
+#   define AMP_SPINLOCK_SPIN_COUNT 4096
+#endif
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+    
+    
+    /**
+     * Called by a waiting thread every time it found the lock taken. 
+     * Hints the processor that the thread spins until spin_count reaches
+     * AMP_SPINLOCK_SPIN_COUNT, afterwards yields the processor so a preempted
+     * lock holder can progress.
+     */
+    static inline void amp_internal_spinlock_pause(unsigned int* spin_count)
+    {
+        if (*spin_count < AMP_SPINLOCK_SPIN_COUNT) {
+            ++(*spin_count);
+            amp_atomic_cpu_relax();
+        } else {
+            (void)amp_thread_yield();
+        }
+    }
+    
+    
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* AMP_amp_internal_spinlock_H */
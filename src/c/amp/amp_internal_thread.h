@@ -147,6 +147,38 @@ extern "C" {
     int amp_internal_thread_configure_function(amp_thread_t thread,
                                                amp_thread_func_t func);
     
+    /**
+     * Sets the CPUs the thread is pinned to when it is launched. NULL or an
+     * empty affinity removes a previously configured affinity.
+     *
+     * A race condition can occur if calling from different threads for the same
+     * thread object.
+     *
+     * @attention Don't call for launched and not yet joined threads.
+     */
+    int amp_internal_thread_configure_affinity(amp_thread_t thread,
+                                               struct amp_thread_affinity_s const* affinity);
+    
+    
+    /**
+     * Sets the stack the thread is created with. NULL restores the platform
+     * default stack.
+     *
+     * A race condition can occur if calling from different threads for the same
+     * thread object.
+     *
+     * @attention Don't call for launched and not yet joined threads.
+     */
+    int amp_internal_thread_configure_stack(amp_thread_t thread,
+                                            struct amp_thread_stack_s const* stack);
+    
+    /**
+     * Returns nonzero if the stack of thread is configured to differ from the
+     * platform default.
+     */
+    int amp_internal_thread_has_configured_stack(amp_thread_t thread);
+    
+    
     /**
      * Returns the thread context in *context.
      *
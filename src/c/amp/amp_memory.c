@@ -36,14 +36,38 @@
  * Implementation of amp memory.
  */ 
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#   define _GNU_SOURCE /* posix_memalign */
+#endif
+
 #include "amp_memory.h"
 
 #include <assert.h>
+#include <stddef.h>
 #include <stdlib.h>
 
+#if defined(_WIN32)
+#   include <malloc.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#   include <unistd.h>
+#endif
+
+#include "amp_stdint.h"
 #include "amp_return_code.h"
 
 
+
+#if defined(_WIN32)
+#   define AMP_INTERNAL_MEMORY_USE_ALIGNED_MALLOC
+#elif defined(_POSIX_VERSION) && (_POSIX_VERSION >= 200112L)
+#   define AMP_INTERNAL_MEMORY_USE_POSIX_MEMALIGN
+#elif defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L)
+#   define AMP_INTERNAL_MEMORY_USE_C11_ALIGNED_ALLOC
+#else
+#   define AMP_INTERNAL_MEMORY_USE_EMULATED_ALIGNED_ALLOC
+#endif
+
+
 void* amp_default_allocator_context = NULL;
 
 
@@ -52,11 +76,80 @@ static struct amp_raw_allocator_s amp_internal_allocator_default = {
     amp_default_alloc,
     amp_default_calloc,
     amp_default_dealloc,
-    NULL /* amp_default_allocator_context */
+    NULL, /* amp_default_allocator_context */
+    amp_default_aligned_alloc,
+    amp_default_aligned_dealloc
 };
 
 
 
+/**
+ * Emulates an aligned allocation by over-allocating via alloc_func and 
+ * storing the start of the allocation right in front of the aligned 
+ * address. alignment must be a power of two and at least sizeof(void*).
+ */
+static void* amp_internal_emulated_aligned_alloc(amp_alloc_func_t alloc_func,
+                                                 void* allocator_context,
+                                                 size_t alignment,
+                                                 size_t bytes_to_allocate,
+                                                 char const* filename,
+                                                 int line);
+
+static void* amp_internal_emulated_aligned_alloc(amp_alloc_func_t alloc_func,
+                                                 void* allocator_context,
+                                                 size_t alignment,
+                                                 size_t bytes_to_allocate,
+                                                 char const* filename,
+                                                 int line)
+{
+    void* allocation = NULL;
+    uintptr_t address = 0;
+    
+    if (bytes_to_allocate > ((size_t)-1) - alignment - sizeof(void*)) {
+        return NULL;
+    }
+    
+    allocation = alloc_func(allocator_context,
+                            bytes_to_allocate + alignment - 1 + sizeof(void*),
+                            filename,
+                            line);
+    if (NULL == allocation) {
+        return NULL;
+    }
+    
+    address = (uintptr_t)allocation + sizeof(void*);
+    address = (address + alignment - 1) & ~((uintptr_t)alignment - 1);
+    ((void**)address)[-1] = allocation;
+    
+    return (void*)address;
+}
+
+
+
+static int amp_internal_emulated_aligned_dealloc(amp_dealloc_func_t dealloc_func,
+                                                 void* allocator_context,
+                                                 void* pointer,
+                                                 char const* filename,
+                                                 int line);
+
+static int amp_internal_emulated_aligned_dealloc(amp_dealloc_func_t dealloc_func,
+                                                 void* allocator_context,
+                                                 void* pointer,
+                                                 char const* filename,
+                                                 int line)
+{
+    if (NULL == pointer) {
+        return AMP_SUCCESS;
+    }
+    
+    return dealloc_func(allocator_context,
+                        ((void**)pointer)[-1],
+                        filename,
+                        line);
+}
+
+
+
 amp_allocator_t amp_default_allocator = &amp_internal_allocator_default;
 
 
@@ -106,6 +199,93 @@ int amp_default_dealloc(void *dummy_allocator_context,
 
 
 
+void* amp_default_aligned_alloc(void* dummy_allocator_context,
+                                size_t alignment,
+                                size_t bytes_to_allocate,
+                                char const* filename,
+                                int line)
+{
+#if defined(AMP_INTERNAL_MEMORY_USE_POSIX_MEMALIGN)
+    void* memory = NULL;
+#endif
+    
+    (void)dummy_allocator_context;
+    (void)filename;
+    (void)line;
+    
+    assert(0 != alignment);
+    assert(0 == (alignment & (alignment - 1)));
+    
+#if defined(AMP_INTERNAL_MEMORY_USE_ALIGNED_MALLOC)
+    
+    return _aligned_malloc(bytes_to_allocate, alignment);
+    
+#elif defined(AMP_INTERNAL_MEMORY_USE_POSIX_MEMALIGN)
+    
+    if (0 != posix_memalign(&memory, alignment, bytes_to_allocate)) {
+        return NULL;
+    }
+    
+    return memory;
+    
+#elif defined(AMP_INTERNAL_MEMORY_USE_C11_ALIGNED_ALLOC)
+    
+    /* aligned_alloc requires a multiple of the alignment as its size. */
+    if (bytes_to_allocate > ((size_t)-1) - alignment) {
+        return NULL;
+    }
+    
+    return aligned_alloc(alignment, 
+                         (bytes_to_allocate + alignment - 1) & ~(alignment - 1));
+    
+#else
+    
+    return amp_internal_emulated_aligned_alloc(amp_default_alloc,
+                                               dummy_allocator_context,
+                                               alignment,
+                                               bytes_to_allocate,
+                                               filename,
+                                               line);
+    
+#endif
+}
+
+
+
+int amp_default_aligned_dealloc(void* dummy_allocator_context,
+                                void* pointer,
+                                char const* filename,
+                                int line)
+{
+    (void)dummy_allocator_context;
+    (void)filename;
+    (void)line;
+    
+#if defined(AMP_INTERNAL_MEMORY_USE_ALIGNED_MALLOC)
+    
+    _aligned_free(pointer);
+    
+    return AMP_SUCCESS;
+    
+#elif defined(AMP_INTERNAL_MEMORY_USE_EMULATED_ALIGNED_ALLOC)
+    
+    return amp_internal_emulated_aligned_dealloc(amp_default_dealloc,
+                                                 dummy_allocator_context,
+                                                 pointer,
+                                                 filename,
+                                                 line);
+    
+#else
+    
+    free(pointer);
+    
+    return AMP_SUCCESS;
+    
+#endif
+}
+
+
+
 int amp_allocator_create(amp_allocator_t* target_allocator,
                          amp_allocator_t source_allocator,
                          void* target_allocator_context,
@@ -130,6 +310,8 @@ int amp_allocator_create(amp_allocator_t* target_allocator,
     tmp_allocator->calloc_func = target_calloc_func;
     tmp_allocator->dealloc_func = target_dealloc_func;
     tmp_allocator->allocator_context = target_allocator_context;
+    tmp_allocator->aligned_alloc_func = NULL;
+    tmp_allocator->aligned_dealloc_func = NULL;
     
     *target_allocator = tmp_allocator;
     
@@ -161,3 +343,73 @@ int amp_allocator_destroy(amp_allocator_t* target_allocator,
 }
 
 
+
+int amp_allocator_set_aligned_funcs(amp_allocator_t allocator,
+                                    amp_aligned_alloc_func_t aligned_alloc_func,
+                                    amp_aligned_dealloc_func_t aligned_dealloc_func)
+{
+    assert(NULL != allocator);
+    assert((NULL == aligned_alloc_func) == (NULL == aligned_dealloc_func));
+    
+    allocator->aligned_alloc_func = aligned_alloc_func;
+    allocator->aligned_dealloc_func = aligned_dealloc_func;
+    
+    return AMP_SUCCESS;
+}
+
+
+
+void* amp_allocator_aligned_alloc(amp_allocator_t allocator,
+                                  size_t alignment,
+                                  size_t bytes_to_allocate,
+                                  char const* filename,
+                                  int line)
+{
+    assert(NULL != allocator);
+    assert(0 != alignment);
+    assert(0 == (alignment & (alignment - 1)));
+    
+    if (alignment < sizeof(void*)) {
+        alignment = sizeof(void*);
+    }
+    
+    if (NULL != allocator->aligned_alloc_func) {
+        return allocator->aligned_alloc_func(allocator->allocator_context,
+                                             alignment,
+                                             bytes_to_allocate,
+                                             filename,
+                                             line);
+    }
+    
+    return amp_internal_emulated_aligned_alloc(allocator->alloc_func,
+                                               allocator->allocator_context,
+                                               alignment,
+                                               bytes_to_allocate,
+                                               filename,
+                                               line);
+}
+
+
+
+int amp_allocator_aligned_dealloc(amp_allocator_t allocator,
+                                  void* pointer,
+                                  char const* filename,
+                                  int line)
+{
+    assert(NULL != allocator);
+    
+    if (NULL != allocator->aligned_dealloc_func) {
+        return allocator->aligned_dealloc_func(allocator->allocator_context,
+                                               pointer,
+                                               filename,
+                                               line);
+    }
+    
+    return amp_internal_emulated_aligned_dealloc(allocator->dealloc_func,
+                                                 allocator->allocator_context,
+                                                 pointer,
+                                                 filename,
+                                                 line);
+}
+
+
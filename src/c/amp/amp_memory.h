@@ -40,7 +40,21 @@
  * The default allocator uses shallow wrappers around C's malloc, calloc, and
  * free.
  *
- * TODO: @todo Add a test, especially to check the amp_calloc_func_t contract.
+ * Memory aligned to a larger boundary than malloc guarantees, e.g. to a 
+ * cache line via AMP_CACHE_LINE_SIZE from amp_stddef.h, is allocated via
+ * AMP_ALIGNED_ALLOC and must be deallocated via AMP_ALIGNED_DEALLOC. 
+ * Allocators can provide their own aligned allocation functions via
+ * amp_allocator_set_aligned_funcs, otherwise aligned allocations are 
+ * emulated by over-allocating via their alloc function. The default 
+ * allocator uses _aligned_malloc on Windows, posix_memalign on POSIX 
+ * systems, and C11 aligned_alloc elsewhere if available.
+ *
+ * Define AMP_PAD_PRIMITIVES_TO_CACHE_LINE when building amp to let the 
+ * create functions of the amp synchronization primitives (mutexes, 
+ * condition variables, semaphores, barriers, spinlocks, reader-writer 
+ * locks, and promises) allocate them cache line aligned and padded to 
+ * whole cache lines, so independently created primitives never share a 
+ * cache line.
  */
 
 #ifndef AMP_amp_memory_H
@@ -97,6 +111,33 @@ extern "C" {
                                       void *pointer,
                                       char const* filename,
                                       int line);
+    
+    /**
+     * Function type defining an aligned allocation function that allocates
+     * bytes_to_allocate bytes of memory starting at an address that is a 
+     * multiple of alignment using the allocator_context. Returns NULL if an
+     * error occured.
+     *
+     * alignment is a power of two and at least sizeof(void*).
+     */
+    typedef void* (*amp_aligned_alloc_func_t)(void* allocator_context,
+                                              size_t alignment,
+                                              size_t bytes_to_allocate,
+                                              char const* filename,
+                                              int line);
+    
+    /**
+     * Function type defining a deallocation function that frees memory 
+     * allocated via the associated aligned alloc function and allocator 
+     * context.
+     *
+     * Returns AMP_SUCCESS on successfull deallocation or function specific
+     * error codes on errors.
+     */
+    typedef int (*amp_aligned_dealloc_func_t)(void* allocator_context,
+                                              void* pointer,
+                                              char const* filename,
+                                              int line);
 
     
     
@@ -151,6 +192,33 @@ extern "C" {
                             int line);
     
     
+    /**
+     * Aligned allocation via _aligned_malloc on Windows, posix_memalign on
+     * POSIX systems, C11 aligned_alloc if available elsewhere, or 
+     * over-allocation via malloc otherwise. Ignores allocator context, 
+     * filename, and line.
+     *
+     * Only thread-safe if the underlying C std functions are thread-safe.
+     */
+    void* amp_default_aligned_alloc(void* dummy_allocator_context,
+                                    size_t alignment,
+                                    size_t bytes_to_allocate,
+                                    char const* filename,
+                                    int line);
+    
+    
+    /**
+     * Frees memory allocated via amp_default_aligned_alloc. Ignores 
+     * allocator context, filename, and line.
+     *
+     * Always returns AMP_SUCCESS.
+     */
+    int amp_default_aligned_dealloc(void* dummy_allocator_context,
+                                    void* pointer,
+                                    char const* filename,
+                                    int line);
+    
+    
     /**
      * Allocator type used by amp's create and destroy functions.
      * Treat as opaque as its implementation can and will change with each 
@@ -166,6 +234,8 @@ extern "C" {
         amp_calloc_func_t calloc_func;
         amp_dealloc_func_t dealloc_func;
         void* allocator_context;
+        amp_aligned_alloc_func_t aligned_alloc_func;
+        amp_aligned_dealloc_func_t aligned_dealloc_func;
     };
     typedef struct amp_raw_allocator_s* amp_allocator_t;
     
@@ -183,6 +253,10 @@ extern "C" {
      * alloc_func, calloc_func, and dealloc_func and allocator_context must
      * work/fit together.
      *
+     * The target allocator has no aligned allocation functions, aligned 
+     * allocations are emulated via alloc_func and dealloc_func until
+     * amp_allocator_set_aligned_funcs is called.
+     *
      * @return AMP_SUCCESS on successful creation.
      *         AMP_NOMEM if not enough memory is available to allocate the
      *         target allocator.
@@ -210,6 +284,54 @@ extern "C" {
     int amp_allocator_destroy(amp_allocator_t* target_allocator,
                               amp_allocator_t source_allocator);
     
+    
+    /**
+     * Sets the functions used by AMP_ALIGNED_ALLOC and AMP_ALIGNED_DEALLOC
+     * for allocator. Pass NULL for both to emulate aligned allocations via
+     * the alloc and dealloc function of allocator.
+     *
+     * Call before aligned memory is allocated via allocator, aligned memory
+     * must be deallocated by the functions it has been allocated with.
+     *
+     * @return AMP_SUCCESS.
+     */
+    int amp_allocator_set_aligned_funcs(amp_allocator_t allocator,
+                                        amp_aligned_alloc_func_t aligned_alloc_func,
+                                        amp_aligned_dealloc_func_t aligned_dealloc_func);
+    
+    
+    /**
+     * Allocates bytes_to_allocate bytes aligned to alignment via the 
+     * aligned alloc function of allocator or, if it has none, by 
+     * over-allocating via its alloc function. alignment must be a power of
+     * two, values smaller than sizeof(void*) are raised to it.
+     *
+     * Use AMP_ALIGNED_ALLOC instead of calling it directly.
+     *
+     * @return Pointer to the aligned memory or NULL if it can't be 
+     *         allocated.
+     */
+    void* amp_allocator_aligned_alloc(amp_allocator_t allocator,
+                                      size_t alignment,
+                                      size_t bytes_to_allocate,
+                                      char const* filename,
+                                      int line);
+    
+    
+    /**
+     * Deallocates memory allocated via amp_allocator_aligned_alloc with 
+     * the same allocator. Passing NULL does nothing.
+     *
+     * Use AMP_ALIGNED_DEALLOC instead of calling it directly.
+     *
+     * @return AMP_SUCCESS on successful deallocation or the error codes of
+     *         the dealloc function of allocator.
+     */
+    int amp_allocator_aligned_dealloc(amp_allocator_t allocator,
+                                      void* pointer,
+                                      char const* filename,
+                                      int line);
+    
 
     
     
@@ -259,6 +381,18 @@ extern "C" {
      */
 #define AMP_DEALLOC(allocator, pointer) (allocator)->dealloc_func((allocator)->allocator_context, (pointer), __FILE__, __LINE__)
     
+    /**
+     * Allocates size bytes starting at a multiple of alignment via 
+     * allocator, see amp_allocator_aligned_alloc.
+     */
+#define AMP_ALIGNED_ALLOC(allocator, alignment, size) amp_allocator_aligned_alloc((allocator), (alignment), (size), __FILE__, __LINE__)
+    
+    /**
+     * Deallocates memory allocated via AMP_ALIGNED_ALLOC with the same 
+     * allocator, see amp_allocator_aligned_dealloc.
+     */
+#define AMP_ALIGNED_DEALLOC(allocator, pointer) amp_allocator_aligned_dealloc((allocator), (pointer), __FILE__, __LINE__)
+    
     
     
 #if defined(__cplusplus)   
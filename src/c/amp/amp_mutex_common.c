@@ -42,6 +42,7 @@
 #include <stddef.h>
 
 #include "amp_return_code.h"
+#include "amp_internal_memory.h"
 #include "amp_raw_mutex.h"
 
 
@@ -55,8 +56,8 @@ int amp_mutex_create(amp_mutex_t* mutex,
     assert(NULL != mutex);
     assert(NULL != allocator);
     
-    tmp_mutex = (amp_mutex_t)AMP_ALLOC(allocator,
-                                       sizeof(*tmp_mutex));
+    tmp_mutex = (amp_mutex_t)AMP_INTERNAL_PRIMITIVE_ALLOC(allocator,
+                                                          sizeof(*tmp_mutex));
     if (NULL == tmp_mutex) {
         return AMP_NOMEM;
     }
@@ -65,8 +66,8 @@ int amp_mutex_create(amp_mutex_t* mutex,
     if (AMP_SUCCESS == retval) {
         *mutex = tmp_mutex;
     } else {
-        int const rc = AMP_DEALLOC(allocator,
-                                   tmp_mutex);
+        int const rc = AMP_INTERNAL_PRIMITIVE_DEALLOC(allocator,
+                                                      tmp_mutex);
         assert(AMP_SUCCESS == rc);
         (void)rc;
     }
@@ -87,8 +88,8 @@ int amp_mutex_destroy(amp_mutex_t* mutex,
     
     retval = amp_raw_mutex_finalize(*mutex);
     if (AMP_SUCCESS == retval) {
-        retval = AMP_DEALLOC(allocator,
-                             *mutex);
+        retval = AMP_INTERNAL_PRIMITIVE_DEALLOC(allocator,
+                                                *mutex);
         assert(AMP_SUCCESS == retval);
         if (AMP_SUCCESS == retval) {
             *mutex = AMP_MUTEX_UNINITIALIZED;
@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Linux futex based amp mutex backend. Locking and unlocking an uncontended 
+ * mutex only needs a single atomic operation and never enters the kernel.
+ * Only if a thread needs to block on a locked mutex or if a thread unlocks a 
+ * mutex other threads might be blocked on the futex system call is used.
+ *
+ * The mutex state is a futex word that is 0 if the mutex is unlocked, 1 if it 
+ * is locked and no other threads block on it, and 2 if it is locked and other
+ * threads might block on it. This is the third mutex described in 
+ * Ulrich Drepper's "Futexes Are Tricky".
+ *
+ * In contrast to the Pthreads backend no error checking mutex is used in
+ * debug mode - recursive locking or unlocking from a non-owner thread is not
+ * detected.
+ *
+ * amp_mutex_create and amp_mutex_destroy are implemented in 
+ * amp_mutex_common.c. Use amp_condition_variable_futex.c for the condition
+ * variable backend that works together with this mutex backend.
+ */
+
+#include "amp_mutex.h"
+
+#include <assert.h>
+#include <stddef.h>
+
+#include "amp_return_code.h"
+#include "amp_raw_mutex.h"
+#include "amp_atomic.h"
+#include "amp_internal_futex.h"
+
+
+
+#if !defined(AMP_USE_FUTEX_MUTEXES)
+#   error Build configuration problem - this source file shouldn't be compiled.
+#endif
+
+
+
+enum amp_internal_futex_mutex_state {
+    amp_internal_unlocked_futex_mutex_state = 0,
+    amp_internal_locked_futex_mutex_state = 1,
+    amp_internal_contended_futex_mutex_state = 2
+};
+
+
+
+int amp_raw_mutex_init(amp_mutex_t mutex)
+{
+    assert(NULL != mutex);
+    
+    amp_atomic_int_store(&mutex->state, 
+                         (int)amp_internal_unlocked_futex_mutex_state,
+                         amp_memory_order_release);
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_raw_mutex_finalize(amp_mutex_t mutex)
+{
+    assert(NULL != mutex);
+    
+    if ((int)amp_internal_unlocked_futex_mutex_state != amp_atomic_int_load(&mutex->state, amp_memory_order_acquire)) {
+        assert(0); /* Programming error */
+        return AMP_BUSY;
+    }
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_mutex_lock(amp_mutex_t mutex)
+{
+    int state = (int)amp_internal_unlocked_futex_mutex_state;
+    
+    assert(NULL != mutex);
+    
+    /* Uncontended fast path. */
+    if (amp_atomic_int_compare_exchange(&mutex->state,
+                                        &state,
+                                        (int)amp_internal_locked_futex_mutex_state,
+                                        amp_memory_order_acquire,
+                                        amp_memory_order_relaxed)) {
+        return AMP_SUCCESS;
+    }
+    
+    /* Contended path - mark the mutex as contended before blocking so the
+     * unlocking thread knows that it needs to wake a blocked thread. A thread
+     * taking the lock in this path also marks it as contended as it can't
+     * know if other threads still block on it.
+     */
+    if ((int)amp_internal_contended_futex_mutex_state != state) {
+        state = amp_atomic_int_exchange(&mutex->state,
+                                        (int)amp_internal_contended_futex_mutex_state,
+                                        amp_memory_order_acquire);
+    }
+    
+    while ((int)amp_internal_unlocked_futex_mutex_state != state) {
+        int const retval = amp_internal_futex_wait(&mutex->state,
+                                                   (int)amp_internal_contended_futex_mutex_state);
+        if (AMP_SUCCESS != retval) {
+            return retval;
+        }
+        
+        state = amp_atomic_int_exchange(&mutex->state,
+                                        (int)amp_internal_contended_futex_mutex_state,
+                                        amp_memory_order_acquire);
+    }
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_mutex_trylock(amp_mutex_t mutex)
+{
+    int state = (int)amp_internal_unlocked_futex_mutex_state;
+    
+    assert(NULL != mutex);
+    
+    if (amp_atomic_int_compare_exchange(&mutex->state,
+                                        &state,
+                                        (int)amp_internal_locked_futex_mutex_state,
+                                        amp_memory_order_acquire,
+                                        amp_memory_order_relaxed)) {
+        return AMP_SUCCESS;
+    }
+    
+    return AMP_BUSY;
+}
+
+
+
+int amp_mutex_unlock(amp_mutex_t mutex)
+{
+    int previous_state = (int)amp_internal_unlocked_futex_mutex_state;
+    
+    assert(NULL != mutex);
+    
+    previous_state = amp_atomic_int_exchange(&mutex->state, 
+                                             (int)amp_internal_unlocked_futex_mutex_state,
+                                             amp_memory_order_release);
+    
+    if ((int)amp_internal_locked_futex_mutex_state == previous_state) {
+        /* Uncontended fast path - nobody to wake. */
+        return AMP_SUCCESS;
+    }
+    
+    if ((int)amp_internal_contended_futex_mutex_state != previous_state) {
+        /* Mutex wasn't locked. */
+        assert(0); /* Programming error */
+        return AMP_ERROR;
+    }
+    
+    return amp_internal_futex_wake(&mutex->state, 1);
+}
+
+
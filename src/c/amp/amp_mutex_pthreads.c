@@ -48,6 +48,12 @@
 
 
 
+#if !defined(AMP_USE_PTHREADS) || defined(AMP_USE_FUTEX_MUTEXES)
+#   error Build configuration problem - this source file shouldn't be compiled.
+#endif
+
+
+
 int amp_raw_mutex_init(amp_mutex_t mutex)
 {
     assert(NULL != mutex);
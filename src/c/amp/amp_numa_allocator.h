@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Allocator placing the memory it hands out on a given NUMA node. Create it
+ * with amp_numa_allocator_create and use it via AMP_ALLOC, AMP_CALLOC, and
+ * AMP_DEALLOC for large buffers worked on by threads running on the node 
+ * (see amp_platform_get_numa_node_hwthreads and 
+ * amp_thread_create_and_launch_with_affinity).
+ *
+ * Every allocation is a system call sequence and occupies whole pages, 
+ * therefore don't pass the allocator to the amp create functions or use it
+ * for small objects. To place many small objects on a node, pass it as the
+ * source allocator to amp_arena_allocator_create or 
+ * amp_pool_allocator_create which carve their blocks out of large chunks.
+ *
+ * Example:
+ * @code
+ * amp_allocator_t node_allocator = AMP_ALLOCATOR_UNINITIALIZED;
+ * amp_numa_allocator_create(&node_allocator, AMP_DEFAULT_ALLOCATOR, 1);
+ * float* buffer = (float*)AMP_ALLOC(node_allocator, count * sizeof(float));
+ * ...
+ * AMP_DEALLOC(node_allocator, buffer);
+ * amp_numa_allocator_destroy(&node_allocator, AMP_DEFAULT_ALLOCATOR);
+ * @endcode
+ *
+ * Backends: compile amp_numa_allocator_mbind.c on Linux to map whole pages
+ * for each allocation with mmap and bind them to the node via the mbind 
+ * system call. Allocations are cache line aligned. If the kernel doesn't 
+ * support NUMA memory policies (single node machines, kernels without NUMA
+ * support, or containers not allowed to call mbind) the memory is left to 
+ * the default policy of the system, normally placing pages on the node of 
+ * the thread touching them first.
+ *
+ * Compile amp_numa_allocator_generic.c on other platforms. It is plain 
+ * malloc and free and ignores node completely - placement is up to the 
+ * platform, normally on the node of the thread touching a page first, so 
+ * initialize memory from threads running on the node.
+ *
+ * amp_numa_allocator_create and amp_numa_allocator_destroy are implemented
+ * in amp_numa_allocator_common.c.
+ */
+
+#ifndef AMP_amp_numa_allocator_H
+#define AMP_amp_numa_allocator_H
+
+#include <stddef.h>
+
+#include <amp/amp_memory.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+    
+    
+    /**
+     * Creates an allocator placing memory on NUMA node node. 
+     * source_allocator is used to allocate the allocator itself. The 
+     * generic backend ignores node.
+     *
+     * node isn't checked against the online nodes (see 
+     * amp_platform_get_numa_node_count), node 0 always works. Allocating
+     * via an allocator for an invalid node fails when the platform supports
+     * NUMA memory policies.
+     *
+     * @return AMP_SUCCESS on successful creation.
+     *         AMP_NOMEM if not enough memory is available.
+     *         AMP_ERROR if node is larger than the backend supports.
+     */
+    int amp_numa_allocator_create(amp_allocator_t* numa_allocator,
+                                  amp_allocator_t source_allocator,
+                                  size_t node);
+    
+    /**
+     * Destroys numa_allocator using source_allocator to deallocate its 
+     * memory. All memory allocated via numa_allocator must have been 
+     * deallocated before.
+     *
+     * @return AMP_SUCCESS on successful destruction.
+     *         AMP_ERROR might be returned if an error is detected.
+     */
+    int amp_numa_allocator_destroy(amp_allocator_t* numa_allocator,
+                                   amp_allocator_t source_allocator);
+    
+    
+    /**
+     * Allocation function of allocators created by amp_numa_allocator_create.
+     * Returns NULL if the memory can't be allocated or bound to the node.
+     *
+     * Thread-safe.
+     */
+    void* amp_numa_alloc(void* numa_allocator_context,
+                         size_t bytes_to_allocate,
+                         char const* filename,
+                         int line);
+    
+    /**
+     * Zeroing array allocation function of allocators created by 
+     * amp_numa_allocator_create. Returns NULL on overflow of 
+     * elem_count * bytes_per_elem or if the memory can't be allocated or
+     * bound to the node.
+     *
+     * Thread-safe.
+     */
+    void* amp_numa_calloc(void* numa_allocator_context,
+                          size_t elem_count,
+                          size_t bytes_per_elem,
+                          char const* filename,
+                          int line);
+    
+    /**
+     * Deallocation function of allocators created by 
+     * amp_numa_allocator_create.
+     *
+     * Thread-safe.
+     *
+     * @return AMP_SUCCESS on successful deallocation.
+     *         AMP_ERROR if the memory couldn't be returned to the system.
+     */
+    int amp_numa_dealloc(void* numa_allocator_context,
+                         void* pointer,
+                         char const* filename,
+                         int line);
+    
+    
+    
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* AMP_amp_numa_allocator_H */
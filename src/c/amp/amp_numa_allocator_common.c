@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation shared by all amp NUMA allocator backends.
+ */
+
+#include "amp_numa_allocator.h"
+
+#include <assert.h>
+#include <stddef.h>
+
+#include "amp_return_code.h"
+#include "amp_memory.h"
+#include "amp_internal_numa_allocator.h"
+
+
+
+int amp_numa_allocator_create(amp_allocator_t* numa_allocator,
+                              amp_allocator_t source_allocator,
+                              size_t node)
+{
+    struct amp_internal_numa_allocator_context_s* context = NULL;
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != numa_allocator);
+    assert(NULL != source_allocator);
+    
+    if (AMP_INTERNAL_NUMA_ALLOCATOR_NODE_CAPACITY <= node) {
+        return AMP_ERROR;
+    }
+    
+    context = (struct amp_internal_numa_allocator_context_s*)AMP_ALLOC(source_allocator,
+                                                                        sizeof(*context));
+    if (NULL == context) {
+        return AMP_NOMEM;
+    }
+    
+    context->node = node;
+    
+    retval = amp_allocator_create(numa_allocator,
+                                  source_allocator,
+                                  context,
+                                  amp_numa_alloc,
+                                  amp_numa_calloc,
+                                  amp_numa_dealloc);
+    if (AMP_SUCCESS != retval) {
+        int const rc = AMP_DEALLOC(source_allocator, context);
+        assert(AMP_SUCCESS == rc);
+        (void)rc;
+    }
+    
+    return retval;
+}
+
+
+
+int amp_numa_allocator_destroy(amp_allocator_t* numa_allocator,
+                               amp_allocator_t source_allocator)
+{
+    void* context = NULL;
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != numa_allocator);
+    assert(NULL != *numa_allocator);
+    assert(NULL != source_allocator);
+    
+    context = (*numa_allocator)->allocator_context;
+    
+    retval = amp_allocator_destroy(numa_allocator, source_allocator);
+    if (AMP_SUCCESS == retval) {
+        retval = AMP_DEALLOC(source_allocator, context);
+    }
+    
+    return retval;
+}
+
+
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * amp NUMA allocator backend for platforms without NUMA memory policy 
+ * support. Allocates via malloc and ignores the node, memory is placed by
+ * the platform, normally on the node of the thread touching a page first.
+ *
+ * amp_numa_allocator_create and amp_numa_allocator_destroy are implemented
+ * in amp_numa_allocator_common.c.
+ */
+
+#include "amp_numa_allocator.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "amp_return_code.h"
+#include "amp_internal_numa_allocator.h"
+
+
+
+void* amp_numa_alloc(void* numa_allocator_context,
+                     size_t bytes_to_allocate,
+                     char const* filename,
+                     int line)
+{
+    (void)numa_allocator_context;
+    (void)filename;
+    (void)line;
+    
+    assert(NULL != numa_allocator_context);
+    
+    return malloc(bytes_to_allocate);
+}
+
+
+
+void* amp_numa_calloc(void* numa_allocator_context,
+                      size_t elem_count,
+                      size_t bytes_per_elem,
+                      char const* filename,
+                      int line)
+{
+    (void)numa_allocator_context;
+    (void)filename;
+    (void)line;
+    
+    assert(NULL != numa_allocator_context);
+    
+    return calloc(elem_count, bytes_per_elem);
+}
+
+
+
+int amp_numa_dealloc(void* numa_allocator_context,
+                     void* pointer,
+                     char const* filename,
+                     int line)
+{
+    (void)numa_allocator_context;
+    (void)filename;
+    (void)line;
+    
+    assert(NULL != numa_allocator_context);
+    
+    free(pointer);
+    
+    return AMP_SUCCESS;
+}
+
+
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * amp NUMA allocator backend for Linux. Each allocation maps whole pages 
+ * and binds them to the node of the allocator via the mbind system call 
+ * (called directly to not depend on libnuma). The size of the mapping is
+ * stored in a cache line sized header in front of the returned memory.
+ *
+ * mbind failing with ENOSYS (kernel without NUMA support) or EPERM 
+ * (e.g. containers filtering the system call) leaves the pages to the
+ * default memory policy instead of failing the allocation.
+ *
+ * amp_numa_allocator_create and amp_numa_allocator_destroy are implemented
+ * in amp_numa_allocator_common.c.
+ *
+ * See http://man7.org/linux/man-pages/man2/mbind.2.html
+ */
+
+/* Needed for MAP_ANONYMOUS and syscall. Must be defined before any system 
+ * header is included.
+ */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#   define _GNU_SOURCE
+#endif
+
+#include "amp_numa_allocator.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "amp_stddef.h"
+#include "amp_return_code.h"
+#include "amp_internal_numa_allocator.h"
+
+
+
+/* From linux/mempolicy.h. */
+#define AMP_INTERNAL_MPOL_BIND 2
+
+#define AMP_INTERNAL_NUMA_ALLOCATOR_HEADER_SIZE ((size_t)AMP_CACHE_LINE_SIZE)
+
+#define AMP_INTERNAL_NUMA_ALLOCATOR_NODE_MASK_BITS (sizeof(unsigned long) * CHAR_BIT)
+
+#define AMP_INTERNAL_NUMA_ALLOCATOR_NODE_MASK_WORDS ((AMP_INTERNAL_NUMA_ALLOCATOR_NODE_CAPACITY + AMP_INTERNAL_NUMA_ALLOCATOR_NODE_MASK_BITS - 1) / AMP_INTERNAL_NUMA_ALLOCATOR_NODE_MASK_BITS)
+
+
+
+/**
+ * Binds the pages of [memory, memory + size) to node.
+ */
+static int amp_internal_numa_allocator_bind(void* memory,
+                                            size_t size,
+                                            size_t node)
+{
+    unsigned long node_mask[AMP_INTERNAL_NUMA_ALLOCATOR_NODE_MASK_WORDS];
+    long retval = 0;
+    
+    assert(AMP_INTERNAL_NUMA_ALLOCATOR_NODE_CAPACITY > node);
+    
+    memset(node_mask, 0, sizeof(node_mask));
+    node_mask[node / AMP_INTERNAL_NUMA_ALLOCATOR_NODE_MASK_BITS] = 1ul << (node % AMP_INTERNAL_NUMA_ALLOCATOR_NODE_MASK_BITS);
+    
+    /* The kernel ignores the last bit of maxnode. */
+    retval = syscall(SYS_mbind, 
+                     memory, 
+                     (unsigned long)size, 
+                     AMP_INTERNAL_MPOL_BIND,
+                     node_mask,
+                     (unsigned long)(sizeof(node_mask) * CHAR_BIT + 1),
+                     0u);
+    
+    if ((0 == retval) || (ENOSYS == errno) || (EPERM == errno)) {
+        return AMP_SUCCESS;
+    }
+    
+    return AMP_ERROR;
+}
+
+
+
+void* amp_numa_alloc(void* numa_allocator_context,
+                     size_t bytes_to_allocate,
+                     char const* filename,
+                     int line)
+{
+    struct amp_internal_numa_allocator_context_s* context = (struct amp_internal_numa_allocator_context_s*)numa_allocator_context;
+    size_t const page_size = (size_t)sysconf(_SC_PAGESIZE);
+    size_t mapping_size = 0;
+    void* mapping = NULL;
+    
+    (void)filename;
+    (void)line;
+    
+    assert(NULL != context);
+    
+    if (bytes_to_allocate > (~(size_t)0) - AMP_INTERNAL_NUMA_ALLOCATOR_HEADER_SIZE - page_size) {
+        return NULL;
+    }
+    
+    mapping_size = (bytes_to_allocate + AMP_INTERNAL_NUMA_ALLOCATOR_HEADER_SIZE + page_size - 1) / page_size * page_size;
+    
+    mapping = mmap(NULL, 
+                   mapping_size, 
+                   PROT_READ | PROT_WRITE, 
+                   MAP_PRIVATE | MAP_ANONYMOUS, 
+                   -1, 
+                   0);
+    if (MAP_FAILED == mapping) {
+        return NULL;
+    }
+    
+    /* Bind before touching the header so the first page is placed on the
+     * node, too.
+     */
+    if (AMP_SUCCESS != amp_internal_numa_allocator_bind(mapping, 
+                                                        mapping_size, 
+                                                        context->node)) {
+        int const rc = munmap(mapping, mapping_size);
+        assert(0 == rc);
+        (void)rc;
+        
+        return NULL;
+    }
+    
+    *(size_t*)mapping = mapping_size;
+    
+    return (amp_byte_t*)mapping + AMP_INTERNAL_NUMA_ALLOCATOR_HEADER_SIZE;
+}
+
+
+
+void* amp_numa_calloc(void* numa_allocator_context,
+                      size_t elem_count,
+                      size_t bytes_per_elem,
+                      char const* filename,
+                      int line)
+{
+    if ((0 != bytes_per_elem) && (elem_count > (~(size_t)0) / bytes_per_elem)) {
+        return NULL;
+    }
+    
+    /* Anonymous mappings are zero filled. */
+    return amp_numa_alloc(numa_allocator_context,
+                          elem_count * bytes_per_elem,
+                          filename,
+                          line);
+}
+
+
+
+int amp_numa_dealloc(void* numa_allocator_context,
+                     void* pointer,
+                     char const* filename,
+                     int line)
+{
+    amp_byte_t* mapping = NULL;
+    
+    (void)numa_allocator_context;
+    (void)filename;
+    (void)line;
+    
+    assert(NULL != numa_allocator_context);
+    
+    if (NULL == pointer) {
+        return AMP_SUCCESS;
+    }
+    
+    mapping = (amp_byte_t*)pointer - AMP_INTERNAL_NUMA_ALLOCATOR_HEADER_SIZE;
+    
+    if (0 != munmap(mapping, *(size_t*)(void*)mapping)) {
+        return AMP_ERROR;
+    }
+    
+    return AMP_SUCCESS;
+}
+
+
@@ -0,0 +1,281 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of amp_parallel_for on top of amp_thread_pool and 
+ * amp_atomic.
+ *
+ * The loop state lives on the stack of the calling thread. It submits one 
+ * job per helping worker, all jobs and the calling thread claim chunks from
+ * the shared next counter until none is left, and the calling thread waits
+ * for the jobs before the state goes out of scope. As every participant 
+ * keeps claiming chunks, the loop completes even if not all jobs could be 
+ * submitted.
+ *
+ * For the static schedule next counts the claimed blocks, for the dynamic 
+ * and guided schedules it is the offset of the first unclaimed index.
+ */
+
+#include "amp_parallel_for.h"
+
+#include <assert.h>
+#include <stddef.h>
+
+#include "amp_stddef.h"
+#include "amp_return_code.h"
+#include "amp_atomic.h"
+#include "amp_thread_pool.h"
+
+
+
+struct amp_internal_parallel_for_s {
+    /* Claimed by all participants, kept off the cache line of the 
+     * read-only fields.
+     */
+    amp_atomic_size_t next;
+    amp_byte_t next_padding[AMP_CACHE_LINE_SIZE - sizeof(amp_atomic_size_t)];
+    
+    amp_parallel_for_func_t body;
+    void* context;
+    size_t range_begin;
+    size_t index_count;
+    size_t grain;
+    size_t participant_count;
+    amp_parallel_for_schedule_t schedule;
+};
+
+
+
+static int amp_internal_parallel_for_claim_static(struct amp_internal_parallel_for_s* state,
+                                                  size_t* begin,
+                                                  size_t* end)
+{
+    size_t const block = amp_atomic_size_fetch_add(&state->next, 
+                                                   1, 
+                                                   amp_memory_order_relaxed);
+    size_t const block_size = state->index_count / state->participant_count;
+    size_t const remainder = state->index_count % state->participant_count;
+    
+    if (block >= state->participant_count) {
+        return 0;
+    }
+    
+    /* The first remainder blocks hold one more index. */
+    *begin = block * block_size + ((block < remainder) ? block : remainder);
+    *end = *begin + block_size + ((block < remainder) ? 1 : 0);
+    
+    return 1;
+}
+
+
+static int amp_internal_parallel_for_claim_dynamic(struct amp_internal_parallel_for_s* state,
+                                                   size_t* begin,
+                                                   size_t* end)
+{
+    size_t const offset = amp_atomic_size_fetch_add(&state->next,
+                                                    state->grain,
+                                                    amp_memory_order_relaxed);
+    
+    if (offset >= state->index_count) {
+        return 0;
+    }
+    
+    *begin = offset;
+    *end = (state->index_count - offset < state->grain) ? state->index_count : offset + state->grain;
+    
+    return 1;
+}
+
+
+static int amp_internal_parallel_for_claim_guided(struct amp_internal_parallel_for_s* state,
+                                                  size_t* begin,
+                                                  size_t* end)
+{
+    size_t offset = amp_atomic_size_load(&state->next, 
+                                         amp_memory_order_relaxed);
+    size_t chunk_size = 0;
+    
+    do {
+        size_t remaining = 0;
+        
+        if (offset >= state->index_count) {
+            return 0;
+        }
+        
+        remaining = state->index_count - offset;
+        chunk_size = remaining / (2 * state->participant_count);
+        if (chunk_size < state->grain) {
+            chunk_size = state->grain;
+        }
+        if (chunk_size > remaining) {
+            chunk_size = remaining;
+        }
+    } while (!amp_atomic_size_compare_exchange(&state->next,
+                                               &offset,
+                                               offset + chunk_size,
+                                               amp_memory_order_relaxed,
+                                               amp_memory_order_relaxed));
+    
+    *begin = offset;
+    *end = offset + chunk_size;
+    
+    return 1;
+}
+
+
+/**
+ * Job run by the workers and the calling thread.
+ */
+static void amp_internal_parallel_for_job_func(void* context)
+{
+    struct amp_internal_parallel_for_s* state = 
+        (struct amp_internal_parallel_for_s*)context;
+    int (*claim)(struct amp_internal_parallel_for_s*, size_t*, size_t*) = NULL;
+    size_t begin = 0;
+    size_t end = 0;
+    
+    switch (state->schedule) {
+        case amp_parallel_for_schedule_static:
+            claim = &amp_internal_parallel_for_claim_static;
+            break;
+        case amp_parallel_for_schedule_dynamic:
+            claim = &amp_internal_parallel_for_claim_dynamic;
+            break;
+        case amp_parallel_for_schedule_guided:
+            claim = &amp_internal_parallel_for_claim_guided;
+            break;
+        default:
+            assert(0); /* Checked by amp_parallel_for */
+            return;
+    }
+    
+    while (claim(state, &begin, &end)) {
+        state->body(state->context, 
+                    state->range_begin + begin, 
+                    state->range_begin + end);
+    }
+}
+
+
+
+int amp_parallel_for(amp_thread_pool_t pool,
+                     size_t range_begin,
+                     size_t range_end,
+                     size_t grain,
+                     amp_parallel_for_func_t body,
+                     void* context,
+                     amp_parallel_for_schedule_t schedule)
+{
+    struct amp_internal_parallel_for_s state;
+    size_t worker_count = 0;
+    size_t chunk_count = 0;
+    size_t helper_count = 0;
+    size_t submitted_count = 0;
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != pool);
+    assert(NULL != body);
+    
+    if ((amp_parallel_for_schedule_static != schedule)
+        && (amp_parallel_for_schedule_dynamic != schedule)
+        && (amp_parallel_for_schedule_guided != schedule)) {
+        
+        assert(0); /* Unknown schedule */
+        return AMP_ERROR;
+    }
+    
+    if (range_begin >= range_end) {
+        return AMP_SUCCESS;
+    }
+    
+    if (0 == grain) {
+        grain = 1;
+    }
+    
+    retval = amp_thread_pool_get_worker_count(pool, &worker_count);
+    assert(AMP_SUCCESS == retval);
+    
+    state.body = body;
+    state.context = context;
+    state.range_begin = range_begin;
+    state.index_count = range_end - range_begin;
+    state.grain = grain;
+    state.schedule = schedule;
+    amp_atomic_size_store(&state.next, 0, amp_memory_order_relaxed);
+    
+    /* Don't wake more workers than there are chunks for them. Static blocks
+     * hold at least grain indices, so the last partial chunk doesn't count.
+     */
+    if (amp_parallel_for_schedule_static == schedule) {
+        chunk_count = state.index_count / grain;
+        if (0 == chunk_count) {
+            chunk_count = 1;
+        }
+    } else {
+        chunk_count = (state.index_count - 1) / grain + 1;
+    }
+    helper_count = (chunk_count - 1 < worker_count) ? chunk_count - 1 : worker_count;
+    state.participant_count = helper_count + 1;
+    
+    /* The dynamic counter overshoots the range by up to one grain per 
+     * participant. 
+     */
+    assert((amp_parallel_for_schedule_dynamic != schedule)
+           || (state.index_count <= ((size_t)-1) - state.participant_count * grain));
+    
+    for (submitted_count = 0; submitted_count < helper_count; ++submitted_count) {
+        retval = amp_thread_pool_submit(pool,
+                                        &state,
+                                        &amp_internal_parallel_for_job_func);
+        if (AMP_SUCCESS != retval) {
+            /* Remaining chunks are claimed by the participants that are
+             * running.
+             */
+            break;
+        }
+    }
+    
+    amp_internal_parallel_for_job_func(&state);
+    
+    if (0 != submitted_count) {
+        retval = amp_thread_pool_wait_all(pool);
+        assert(AMP_SUCCESS == retval);
+        
+        if (AMP_SUCCESS != retval) {
+            return retval;
+        }
+    }
+    
+    return AMP_SUCCESS;
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Parallel loop over an index range running on the workers of an 
+ * amp_thread_pool.
+ *
+ * amp_parallel_for splits [range_begin, range_end) into chunks of at least
+ * grain indices and calls the body once per chunk with the chunk bounds. The
+ * calling thread works on chunks, too, and returns after the whole range has
+ * been processed. The schedule controls how chunks are formed and assigned:
+ *
+ * - amp_parallel_for_schedule_static splits the range into one contiguous 
+ *   block per participating thread. It has the lowest overhead and is the
+ *   right choice if every index costs the same.
+ * - amp_parallel_for_schedule_dynamic lets threads grab grain sized chunks 
+ *   from a shared atomic counter until the range is exhausted. Threads 
+ *   that got cheap indices simply grab more chunks, which balances skewed
+ *   per-index costs at the price of one atomic operation per chunk.
+ * - amp_parallel_for_schedule_guided grabs chunks proportional to the 
+ *   remaining indices divided by the number of threads, but never smaller
+ *   than grain. Large chunks at the start keep the overhead low while small
+ *   chunks at the end balance the load.
+ *
+ * Example:
+ * @code
+ * void scale_body(void* context, size_t begin, size_t end)
+ * {
+ *     float* values = (float*)context;
+ *     size_t i;
+ *     for (i = begin; i < end; ++i) {
+ *         values[i] *= 2.0f;
+ *     }
+ * }
+ *
+ * amp_parallel_for(pool, 0, value_count, 1024, scale_body, values,
+ *                  amp_parallel_for_schedule_dynamic);
+ * @endcode
+ *
+ * @attention amp_parallel_for waits for its chunks with 
+ *            amp_thread_pool_wait_all. Never call it from a job running on
+ *            the same pool - the job would wait for itself and deadlock. 
+ *            Threads calling it concurrently on the same pool also wait for
+ *            each others chunks.
+ *
+ * @attention amp_parallel_for uses amp_atomic.h and is therefore not 
+ *            included by amp.h.
+ */
+
+#ifndef AMP_amp_parallel_for_H
+#define AMP_amp_parallel_for_H
+
+#include <stddef.h>
+
+#include <amp/amp_thread_pool.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+    
+    /**
+     * Chunking and assignment strategies of amp_parallel_for.
+     */
+    enum amp_parallel_for_schedule {
+        amp_parallel_for_schedule_static = 0,
+        amp_parallel_for_schedule_dynamic,
+        amp_parallel_for_schedule_guided
+    };
+    typedef enum amp_parallel_for_schedule amp_parallel_for_schedule_t;
+    
+    
+    /**
+     * Loop body type. Processes the indices from begin to end, end excluded.
+     */
+    typedef void (*amp_parallel_for_func_t)(void* context, 
+                                            size_t begin, 
+                                            size_t end);
+    
+    
+    /**
+     * Calls body with context for disjoint chunks covering 
+     * [range_begin, range_end) on the workers of pool and the calling 
+     * thread, and returns after all chunks have been processed. Chunks hold
+     * at least grain indices, only the last chunk can be smaller. A grain 
+     * of 0 is treated as 1. An empty range returns immediately.
+     *
+     * If fewer chunks than worker jobs could be submitted to the pool, e.g.
+     * because it has been shut down, the remaining chunks are processed by 
+     * the calling thread and the loop still completes.
+     *
+     * @return AMP_SUCCESS after the whole range has been processed.
+     *         Other error codes might be returned to signal errors, too. 
+     *         These are programming errors and mustn't occur in release code.
+     */
+    int amp_parallel_for(amp_thread_pool_t pool,
+                         size_t range_begin,
+                         size_t range_end,
+                         size_t grain,
+                         amp_parallel_for_func_t body,
+                         void* context,
+                         amp_parallel_for_schedule_t schedule);
+    
+    
+    
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* AMP_amp_parallel_for_H */
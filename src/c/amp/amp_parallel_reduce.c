@@ -0,0 +1,445 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of amp_parallel_reduce and amp_parallel_scan on top of 
+ * amp_parallel_for.
+ *
+ * The array is split into at most one block per participating thread of
+ * the pool and amp_parallel_for runs over the block indices. Every block 
+ * owns a partial element in its own cache line sized slot so threads don't
+ * share cache lines while accumulating. The calling thread combines or 
+ * scans the block partials as there are only a few of them.
+ */
+
+#include "amp_parallel_reduce.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "amp_stddef.h"
+#include "amp_stdint.h"
+#include "amp_return_code.h"
+#include "amp_memory.h"
+#include "amp_thread_pool.h"
+#include "amp_parallel_for.h"
+
+
+
+#if !defined(AMP_PARALLEL_REDUCE_MIN_BLOCK_SIZE)
+/**
+ * Minimal number of elements per block. Smaller arrays use fewer threads.
+ */
+#   define AMP_PARALLEL_REDUCE_MIN_BLOCK_SIZE 4096
+#endif
+
+
+
+struct amp_internal_parallel_reduce_s {
+    amp_byte_t const* input;
+    amp_byte_t* output;
+    size_t element_count;
+    size_t element_size;
+    size_t block_count;
+    
+    /* Cache line aligned, slot_size bytes per slot. */
+    amp_byte_t* slots;
+    size_t slot_size;
+    
+    void const* identity;
+    amp_parallel_combine_func_t combine;
+    void* context;
+    amp_parallel_scan_kind_t kind;
+};
+
+
+
+static amp_byte_t* amp_internal_parallel_reduce_slot(struct amp_internal_parallel_reduce_s* state,
+                                                     size_t index)
+{
+    return state->slots + index * state->slot_size;
+}
+
+
+static void amp_internal_parallel_reduce_block_bounds(struct amp_internal_parallel_reduce_s* state,
+                                                      size_t block,
+                                                      size_t* begin,
+                                                      size_t* end)
+{
+    size_t const block_size = state->element_count / state->block_count;
+    size_t const remainder = state->element_count % state->block_count;
+    
+    /* The first remainder blocks hold one more element. */
+    *begin = block * block_size + ((block < remainder) ? block : remainder);
+    *end = *begin + block_size + ((block < remainder) ? 1 : 0);
+}
+
+
+/**
+ * Copies an element. Common sizes use a constant size memcpy that compilers
+ * turn into a plain load and store instead of a library call per element.
+ */
+static void amp_internal_parallel_reduce_copy(void* destination,
+                                              void const* source,
+                                              size_t element_size)
+{
+    switch (element_size) {
+        case 4:
+            memcpy(destination, source, 4);
+            break;
+        case 8:
+            memcpy(destination, source, 8);
+            break;
+        default:
+            memcpy(destination, source, element_size);
+            break;
+    }
+}
+
+
+/**
+ * Allocates slot_count slots after block_count and slot_size have been 
+ * set. Stores the pointer to free in allocation.
+ */
+static int amp_internal_parallel_reduce_alloc_slots(struct amp_internal_parallel_reduce_s* state,
+                                                    amp_allocator_t allocator,
+                                                    size_t slot_count,
+                                                    void** allocation)
+{
+    uintptr_t address = 0;
+    
+    *allocation = AMP_ALLOC(allocator, 
+                            slot_count * state->slot_size + AMP_CACHE_LINE_SIZE - 1);
+    if (NULL == *allocation) {
+        return AMP_NOMEM;
+    }
+    
+    address = (uintptr_t)*allocation;
+    address = (address + AMP_CACHE_LINE_SIZE - 1) & ~((uintptr_t)AMP_CACHE_LINE_SIZE - 1);
+    state->slots = (amp_byte_t*)address;
+    
+    return AMP_SUCCESS;
+}
+
+
+/**
+ * Sets up state for element_count elements on pool. 
+ */
+static void amp_internal_parallel_reduce_init(struct amp_internal_parallel_reduce_s* state,
+                                              amp_thread_pool_t pool,
+                                              size_t element_count,
+                                              size_t element_size,
+                                              void const* identity,
+                                              amp_parallel_combine_func_t combine,
+                                              void* context)
+{
+    size_t worker_count = 0;
+    size_t block_count = 0;
+    int retval = AMP_UNSUPPORTED;
+    
+    retval = amp_thread_pool_get_worker_count(pool, &worker_count);
+    assert(AMP_SUCCESS == retval);
+    (void)retval;
+    
+    block_count = (element_count - 1) / AMP_PARALLEL_REDUCE_MIN_BLOCK_SIZE + 1;
+    if (block_count > worker_count + 1) {
+        block_count = worker_count + 1;
+    }
+    
+    state->input = NULL;
+    state->output = NULL;
+    state->element_count = element_count;
+    state->element_size = element_size;
+    state->block_count = block_count;
+    state->slots = NULL;
+    state->slot_size = (element_size + AMP_CACHE_LINE_SIZE - 1) & ~((size_t)AMP_CACHE_LINE_SIZE - 1);
+    state->identity = identity;
+    state->combine = combine;
+    state->context = context;
+    state->kind = amp_parallel_scan_inclusive;
+}
+
+
+/**
+ * Reduces the blocks from first_block to end_block into their slots.
+ */
+static void amp_internal_parallel_reduce_blocks(void* context,
+                                                size_t first_block,
+                                                size_t end_block)
+{
+    struct amp_internal_parallel_reduce_s* state = 
+        (struct amp_internal_parallel_reduce_s*)context;
+    size_t const element_size = state->element_size;
+    size_t block = 0;
+    
+    for (block = first_block; block < end_block; ++block) {
+        amp_byte_t* const partial = amp_internal_parallel_reduce_slot(state, block);
+        size_t begin = 0;
+        size_t end = 0;
+        size_t i = 0;
+        
+        amp_internal_parallel_reduce_block_bounds(state, block, &begin, &end);
+        
+        memcpy(partial, state->identity, element_size);
+        for (i = begin; i < end; ++i) {
+            state->combine(state->context, 
+                           partial, 
+                           state->input + i * element_size);
+        }
+    }
+}
+
+
+/**
+ * Scans the blocks from first_block to end_block starting with the offsets
+ * stored in their slots. Every block uses a second slot after the 
+ * block_count offset slots to keep an input element while an exclusive 
+ * scan in place overwrites it.
+ */
+static void amp_internal_parallel_scan_blocks(void* context,
+                                              size_t first_block,
+                                              size_t end_block)
+{
+    struct amp_internal_parallel_reduce_s* state = 
+        (struct amp_internal_parallel_reduce_s*)context;
+    size_t const element_size = state->element_size;
+    size_t block = 0;
+    
+    for (block = first_block; block < end_block; ++block) {
+        amp_byte_t* const accumulator = amp_internal_parallel_reduce_slot(state, block);
+        amp_byte_t* const value = amp_internal_parallel_reduce_slot(state, state->block_count + block);
+        size_t begin = 0;
+        size_t end = 0;
+        size_t i = 0;
+        
+        amp_internal_parallel_reduce_block_bounds(state, block, &begin, &end);
+        
+        if (amp_parallel_scan_inclusive == state->kind) {
+            for (i = begin; i < end; ++i) {
+                state->combine(state->context, 
+                               accumulator, 
+                               state->input + i * element_size);
+                amp_internal_parallel_reduce_copy(state->output + i * element_size, accumulator, element_size);
+            }
+        } else {
+            for (i = begin; i < end; ++i) {
+                amp_internal_parallel_reduce_copy(value, state->input + i * element_size, element_size);
+                amp_internal_parallel_reduce_copy(state->output + i * element_size, accumulator, element_size);
+                state->combine(state->context, accumulator, value);
+            }
+        }
+    }
+}
+
+
+
+int amp_parallel_reduce(amp_thread_pool_t pool,
+                        amp_allocator_t allocator,
+                        void const* elements,
+                        size_t element_count,
+                        size_t element_size,
+                        void const* identity,
+                        amp_parallel_combine_func_t combine,
+                        void* context,
+                        void* result)
+{
+    struct amp_internal_parallel_reduce_s state;
+    void* allocation = NULL;
+    size_t stride = 0;
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != pool);
+    assert(NULL != allocator);
+    assert((NULL != elements) || (0 == element_count));
+    assert(0 != element_size);
+    assert(NULL != identity);
+    assert(NULL != combine);
+    assert(NULL != result);
+    
+    if (0 == element_count) {
+        memcpy(result, identity, element_size);
+        return AMP_SUCCESS;
+    }
+    
+    amp_internal_parallel_reduce_init(&state,
+                                      pool,
+                                      element_count,
+                                      element_size,
+                                      identity,
+                                      combine,
+                                      context);
+    state.input = (amp_byte_t const*)elements;
+    
+    retval = amp_internal_parallel_reduce_alloc_slots(&state, 
+                                                      allocator, 
+                                                      state.block_count,
+                                                      &allocation);
+    if (AMP_SUCCESS != retval) {
+        return retval;
+    }
+    
+    retval = amp_parallel_for(pool,
+                              0,
+                              state.block_count,
+                              1,
+                              &amp_internal_parallel_reduce_blocks,
+                              &state,
+                              amp_parallel_for_schedule_dynamic);
+    
+    if (AMP_SUCCESS == retval) {
+        /* Pairwise tree: after the pass with stride s slot i holds the 
+         * partial of blocks i to i + 2s - 1.
+         */
+        for (stride = 1; stride < state.block_count; stride *= 2) {
+            size_t i = 0;
+            
+            for (i = 0; i + stride < state.block_count; i += 2 * stride) {
+                combine(context,
+                        amp_internal_parallel_reduce_slot(&state, i),
+                        amp_internal_parallel_reduce_slot(&state, i + stride));
+            }
+        }
+        
+        memcpy(result, amp_internal_parallel_reduce_slot(&state, 0), element_size);
+    }
+    
+    {
+        int const rc = AMP_DEALLOC(allocator, allocation);
+        assert(AMP_SUCCESS == rc);
+        (void)rc;
+    }
+    
+    return retval;
+}
+
+
+
+int amp_parallel_scan(amp_thread_pool_t pool,
+                      amp_allocator_t allocator,
+                      void const* input,
+                      void* output,
+                      size_t element_count,
+                      size_t element_size,
+                      void const* identity,
+                      amp_parallel_combine_func_t combine,
+                      void* context,
+                      amp_parallel_scan_kind_t kind)
+{
+    struct amp_internal_parallel_reduce_s state;
+    void* allocation = NULL;
+    amp_byte_t* running = NULL;
+    amp_byte_t* block_total = NULL;
+    size_t block = 0;
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != pool);
+    assert(NULL != allocator);
+    assert((NULL != input) || (0 == element_count));
+    assert((NULL != output) || (0 == element_count));
+    assert(0 != element_size);
+    assert(NULL != identity);
+    assert(NULL != combine);
+    
+    if ((amp_parallel_scan_inclusive != kind) 
+        && (amp_parallel_scan_exclusive != kind)) {
+        
+        assert(0); /* Unknown scan kind */
+        return AMP_ERROR;
+    }
+    
+    if (0 == element_count) {
+        return AMP_SUCCESS;
+    }
+    
+    amp_internal_parallel_reduce_init(&state,
+                                      pool,
+                                      element_count,
+                                      element_size,
+                                      identity,
+                                      combine,
+                                      context);
+    state.input = (amp_byte_t const*)input;
+    state.output = (amp_byte_t*)output;
+    state.kind = kind;
+    
+    /* Offset and value slot per block, running offset and block total. */
+    retval = amp_internal_parallel_reduce_alloc_slots(&state,
+                                                      allocator,
+                                                      2 * state.block_count + 2,
+                                                      &allocation);
+    if (AMP_SUCCESS != retval) {
+        return retval;
+    }
+    running = amp_internal_parallel_reduce_slot(&state, 2 * state.block_count);
+    block_total = amp_internal_parallel_reduce_slot(&state, 2 * state.block_count + 1);
+    
+    /* Pass one: block totals. */
+    retval = amp_parallel_for(pool,
+                              0,
+                              state.block_count,
+                              1,
+                              &amp_internal_parallel_reduce_blocks,
+                              &state,
+                              amp_parallel_for_schedule_dynamic);
+    
+    if (AMP_SUCCESS == retval) {
+        /* Replace the block totals with their exclusive prefixes. */
+        memcpy(running, identity, element_size);
+        for (block = 0; block < state.block_count; ++block) {
+            amp_byte_t* const slot = amp_internal_parallel_reduce_slot(&state, block);
+            
+            memcpy(block_total, slot, element_size);
+            memcpy(slot, running, element_size);
+            combine(context, running, block_total);
+        }
+        
+        /* Pass two: scan every block from its offset. */
+        retval = amp_parallel_for(pool,
+                                  0,
+                                  state.block_count,
+                                  1,
+                                  &amp_internal_parallel_scan_blocks,
+                                  &state,
+                                  amp_parallel_for_schedule_dynamic);
+    }
+    
+    {
+        int const rc = AMP_DEALLOC(allocator, allocation);
+        assert(AMP_SUCCESS == rc);
+        (void)rc;
+    }
+    
+    return retval;
+}
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Parallel reduction and prefix scan over arrays running on the workers of
+ * an amp_thread_pool.
+ *
+ * Both work on arrays of element_count elements of element_size bytes and 
+ * are driven by a user combine function which must be associative and for 
+ * which identity must be a neutral element. The combination order isn't 
+ * sequential but it is deterministic for a given pool size and element 
+ * count, which matters for floating point sums.
+ *
+ * amp_parallel_reduce splits the array into one block per participating 
+ * thread, reduces every block into its own cache line padded partial and 
+ * combines the partials pairwise in a tree.
+ *
+ * amp_parallel_scan computes inclusive or exclusive prefix combinations in
+ * two passes over blocks: the first pass reduces every block, the block 
+ * totals are scanned to get the offset of every block, and the second pass 
+ * scans every block starting from its offset.
+ *
+ * Example summing doubles:
+ * @code
+ * void add_doubles(void* context, void* accumulator, void const* value)
+ * {
+ *     *(double*)accumulator += *(double const*)value;
+ * }
+ *
+ * double const zero = 0.0;
+ * double sum;
+ * amp_parallel_reduce(pool, AMP_DEFAULT_ALLOCATOR, values, value_count,
+ *                     sizeof(double), &zero, add_doubles, NULL, &sum);
+ * @endcode
+ *
+ * @attention Both functions wait with amp_thread_pool_wait_all, see 
+ *            amp_parallel_for.h for the implications.
+ *
+ * @attention Uses amp_atomic.h through amp_parallel_for and is therefore 
+ *            not included by amp.h.
+ */
+
+#ifndef AMP_amp_parallel_reduce_H
+#define AMP_amp_parallel_reduce_H
+
+#include <stddef.h>
+
+#include <amp/amp_memory.h>
+#include <amp/amp_thread_pool.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+    
+    /**
+     * Combines value into accumulator, both pointing to elements of the 
+     * size passed to the reduce or scan call: 
+     * *accumulator = *accumulator op *value.
+     */
+    typedef void (*amp_parallel_combine_func_t)(void* context, 
+                                                void* accumulator, 
+                                                void const* value);
+    
+    
+    /**
+     * Kind of prefix computed by amp_parallel_scan. Inclusive scans store 
+     * the combination of all elements up to and including an index, 
+     * exclusive scans the combination of all elements before it starting 
+     * with identity.
+     */
+    enum amp_parallel_scan_kind {
+        amp_parallel_scan_inclusive = 0,
+        amp_parallel_scan_exclusive
+    };
+    typedef enum amp_parallel_scan_kind amp_parallel_scan_kind_t;
+    
+    
+    /**
+     * Combines identity and all element_count elements into result. 
+     * Stores a copy of identity in result for an empty array.
+     *
+     * allocator is used for the temporary per-block partials.
+     *
+     * @return AMP_SUCCESS after result has been stored.
+     *         AMP_NOMEM if the partials couldn't be allocated.
+     *         Other error codes might be returned to signal errors, too. 
+     *         These are programming errors and mustn't occur in release code.
+     */
+    int amp_parallel_reduce(amp_thread_pool_t pool,
+                            amp_allocator_t allocator,
+                            void const* elements,
+                            size_t element_count,
+                            size_t element_size,
+                            void const* identity,
+                            amp_parallel_combine_func_t combine,
+                            void* context,
+                            void* result);
+    
+    /**
+     * Stores the inclusive or exclusive prefix combinations of input in 
+     * output. output may be the same array as input to scan in place, but 
+     * the arrays mustn't overlap otherwise.
+     *
+     * allocator is used for the temporary per-block partials.
+     *
+     * @return AMP_SUCCESS after output has been written.
+     *         AMP_NOMEM if the partials couldn't be allocated.
+     *         Other error codes might be returned to signal errors, too. 
+     *         These are programming errors and mustn't occur in release code.
+     */
+    int amp_parallel_scan(amp_thread_pool_t pool,
+                          amp_allocator_t allocator,
+                          void const* input,
+                          void* output,
+                          size_t element_count,
+                          size_t element_size,
+                          void const* identity,
+                          amp_parallel_combine_func_t combine,
+                          void* context,
+                          amp_parallel_scan_kind_t kind);
+    
+    
+    
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* AMP_amp_parallel_reduce_H */
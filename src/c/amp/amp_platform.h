@@ -83,6 +83,32 @@ extern "C" {
      */
     typedef struct amp_raw_platform_s* amp_platform_t;
 
+    /* Defined in amp_thread.h. */
+    struct amp_thread_affinity_s;
+    
+    /**
+     * Kind of content a cache holds.
+     */
+    enum amp_platform_cache_type {
+        amp_platform_cache_type_unified = 0,
+        amp_platform_cache_type_data,
+        amp_platform_cache_type_instruction
+    };
+    typedef enum amp_platform_cache_type amp_platform_cache_type_t;
+    
+    /**
+     * Description of one cache of a hardware thread. Sizes are in bytes. 
+     * Fields the platform doesn't report are 0, an associativity of 0 also
+     * describes a fully associative cache.
+     */
+    struct amp_platform_cache_s {
+        size_t level;
+        size_t size;
+        size_t line_size;
+        size_t associativity;
+        amp_platform_cache_type_t type;
+    };
+
 
     
     
@@ -112,6 +138,23 @@ extern "C" {
                             amp_allocator_t allocator);
     
     
+    /**
+     * Like amp_platform_create but backends reading the hardware description
+     * from the file system (the Linux sysfs backend reading /sys and
+     * /proc/self/cgroup) prefix all paths with filesystem_root, e.g. 
+     * /sys/devices/system/cpu is read from 
+     * <filesystem_root>/sys/devices/system/cpu. Intended to run tests 
+     * against fixture directories. Backends querying the operating system 
+     * differently ignore filesystem_root.
+     *
+     * filesystem_root is not copied and must stay valid until descr is 
+     * destroyed. Pass NULL to use the default root.
+     */
+    int amp_platform_create_with_filesystem_root(amp_platform_t* descr,
+                                                 amp_allocator_t allocator,
+                                                 char const* filesystem_root);
+    
+    
     /**
      * Finalizes descr (invalidates it), frees its memory.
      *
@@ -209,11 +252,237 @@ extern "C" {
                                                size_t* result);
     
     
+    /**
+     * Queries the platform for the number of processor packages (sockets).
+     *
+     * descr must be valid (created) and not be NULL.
+     *
+     * If the information can not be queried result isn't touched or changed.
+     *
+     * @return AMP_SUCCESS if the information can be queried or
+     *         AMP_UNSUPPORTED if the information can not be queried.
+     *         AMP_NOMEM if the backend couldn't allocate a query buffer.
+     *         AMP_ERROR might be returned on error based on the used backend.
+     */
+    int amp_platform_get_installed_package_count(amp_platform_t descr,
+                                                 size_t* result);
+    
+    /**
+     * Queries the package and the core (inside the package) the hardware 
+     * thread with the operating system index hwthread belongs to. Hardware
+     * threads with the same package and core ids are SMT siblings sharing 
+     * one core. Ids are not necessarily contiguous.
+     *
+     * descr must be valid (created) and not be NULL. package_id and core_id
+     * must not be NULL.
+     *
+     * @return AMP_SUCCESS if the information can be queried or
+     *         AMP_UNSUPPORTED if the information can not be queried.
+     *         AMP_ERROR if hwthread is not installed or its topology is 
+     *         unknown.
+     */
+    int amp_platform_get_hwthread_topology(amp_platform_t descr,
+                                           size_t hwthread,
+                                           size_t* package_id,
+                                           size_t* core_id);
+    
+    /**
+     * Stores the hardware threads sharing a core with hwthread (including
+     * hwthread itself) in siblings. Hardware threads with indices not smaller
+     * than AMP_THREAD_AFFINITY_CPU_CAPACITY are not reported. Use siblings
+     * to pin only one thread per physical core.
+     *
+     * descr must be valid (created) and not be NULL. siblings must not be
+     * NULL.
+     *
+     * @return AMP_SUCCESS if the information can be queried or
+     *         AMP_UNSUPPORTED if the information can not be queried.
+     *         AMP_ERROR if hwthread is not installed or its topology is 
+     *         unknown.
+     */
+    int amp_platform_get_hwthread_siblings(amp_platform_t descr,
+                                           size_t hwthread,
+                                           struct amp_thread_affinity_s* siblings);
+    
+    
+    /**
+     * Queries the coherency line size of the level 1 data cache in bytes.
+     * Use it to pad data accessed by different threads to separate cache 
+     * lines instead of assuming AMP_CACHE_LINE_SIZE.
+     *
+     * descr must be valid (created) and not be NULL.
+     *
+     * If the information can not be queried result isn't touched or changed.
+     *
+     * @return AMP_SUCCESS if the information can be queried or
+     *         AMP_UNSUPPORTED if the information can not be queried.
+     */
+    int amp_platform_get_cache_line_size(amp_platform_t descr,
+                                         size_t* result);
+    
+    /**
+     * Queries the number of caches (of all levels and types) the hardware
+     * thread with the operating system index hwthread uses. Query them with
+     * indices from 0 to result - 1 via amp_platform_get_hwthread_cache.
+     *
+     * descr must be valid (created) and not be NULL.
+     *
+     * @return AMP_SUCCESS if the information can be queried or
+     *         AMP_UNSUPPORTED if the information can not be queried.
+     *         AMP_ERROR if hwthread is not installed.
+     */
+    int amp_platform_get_hwthread_cache_count(amp_platform_t descr,
+                                              size_t hwthread,
+                                              size_t* result);
+    
+    /**
+     * Describes cache cache_index of hardware thread hwthread. Caches are
+     * ordered like the platform reports them, typically by ascending level.
+     *
+     * descr must be valid (created) and not be NULL. result must not be NULL.
+     *
+     * @return AMP_SUCCESS if the information can be queried or
+     *         AMP_UNSUPPORTED if the information can not be queried.
+     *         AMP_ERROR if hwthread is not installed or cache_index is out of
+     *         range.
+     */
+    int amp_platform_get_hwthread_cache(amp_platform_t descr,
+                                        size_t hwthread,
+                                        size_t cache_index,
+                                        struct amp_platform_cache_s* result);
+    
+    /**
+     * Stores the hardware threads sharing cache cache_index of hwthread 
+     * (including hwthread itself) in sharing. Hardware threads with indices
+     * not smaller than AMP_THREAD_AFFINITY_CPU_CAPACITY are not reported.
+     *
+     * descr must be valid (created) and not be NULL. sharing must not be NULL.
+     *
+     * @return AMP_SUCCESS if the information can be queried or
+     *         AMP_UNSUPPORTED if the information can not be queried.
+     *         AMP_ERROR if hwthread is not installed or cache_index is out of
+     *         range.
+     */
+    int amp_platform_get_hwthread_cache_sharing(amp_platform_t descr,
+                                                size_t hwthread,
+                                                size_t cache_index,
+                                                struct amp_thread_affinity_s* sharing);
+    
+    
+    /**
+     * Queries the number of NUMA (non-uniform memory access) nodes. Node ids
+     * range from 0 to result - 1, result is one more than the highest id of
+     * an online node. Queries for ids of offline nodes return AMP_ERROR.
+     *
+     * descr must be valid (created) and not be NULL.
+     *
+     * If the information can not be queried result isn't touched or changed.
+     *
+     * @return AMP_SUCCESS if the information can be queried or
+     *         AMP_UNSUPPORTED if the information can not be queried, e.g. 
+     *         because the kernel has been built without NUMA support.
+     */
+    int amp_platform_get_numa_node_count(amp_platform_t descr,
+                                         size_t* result);
+    
+    /**
+     * Stores the hardware threads belonging to NUMA node node in hwthreads.
+     * Hardware threads with indices not smaller than 
+     * AMP_THREAD_AFFINITY_CPU_CAPACITY are not reported. Pass hwthreads to
+     * amp_thread_create_and_launch_with_affinity to run threads close to
+     * the memory of node.
+     *
+     * descr must be valid (created) and not be NULL. hwthreads must not be
+     * NULL.
+     *
+     * @return AMP_SUCCESS if the information can be queried or
+     *         AMP_UNSUPPORTED if the information can not be queried.
+     *         AMP_ERROR if node is not online.
+     */
+    int amp_platform_get_numa_node_hwthreads(amp_platform_t descr,
+                                             size_t node,
+                                             struct amp_thread_affinity_s* hwthreads);
+    
+    /**
+     * Queries the relative cost of accessing memory of to_node from 
+     * from_node as reported by the firmware (ACPI SLIT). Local access has a
+     * distance of 10, a distance of 20 means remote access is about twice
+     * as expensive.
+     *
+     * descr must be valid (created) and not be NULL. distance must not be
+     * NULL.
+     *
+     * @return AMP_SUCCESS if the information can be queried or
+     *         AMP_UNSUPPORTED if the information can not be queried.
+     *         AMP_ERROR if from_node or to_node is not online.
+     */
+    int amp_platform_get_numa_node_distance(amp_platform_t descr,
+                                            size_t from_node,
+                                            size_t to_node,
+                                            size_t* distance);
+    
+    /**
+     * Queries the NUMA node hardware thread hwthread belongs to.
+     *
+     * descr must be valid (created) and not be NULL. node must not be NULL.
+     *
+     * @return AMP_SUCCESS if the information can be queried or
+     *         AMP_UNSUPPORTED if the information can not be queried.
+     *         AMP_ERROR if hwthread doesn't belong to an online node.
+     */
+    int amp_platform_get_hwthread_numa_node(amp_platform_t descr,
+                                            size_t hwthread,
+                                            size_t* node);
+    
+    
+    /**
+     * Queries the number of hardware threads the calling thread is allowed to
+     * run on (its affinity mask, inherited from the process by default, e.g.
+     * restricted by taskset or a container runtime).
+     *
+     * descr must be valid (created) and not be NULL.
+     *
+     * If the information can not be queried result isn't touched or changed.
+     *
+     * @return AMP_SUCCESS if the information can be queried or
+     *         AMP_UNSUPPORTED if the information can not be queried.
+     *         AMP_NOMEM if the backend couldn't allocate a query buffer.
+     */
+    int amp_platform_get_affinity_hwthread_count(amp_platform_t descr,
+                                                 size_t* result);
+    
+    /**
+     * Queries the CPU bandwidth quota of the process: it may use quota_us 
+     * microseconds of CPU time every period_us microseconds, i.e.
+     * quota_us / period_us hardware threads worth of CPU time. Threads 
+     * exceeding the quota are throttled until the next period. Container
+     * orchestrators like Kubernetes translate CPU limits into such quotas
+     * (Linux cgroup v1 cpu.cfs_quota_us and cgroup v2 cpu.max). If nested
+     * cgroups have quotas the most restrictive one is reported.
+     *
+     * descr must be valid (created) and not be NULL. quota_us and period_us
+     * must not be NULL.
+     *
+     * @return AMP_SUCCESS if a quota limits the process or
+     *         AMP_UNSUPPORTED if no quota is set or if the information can
+     *         not be queried. quota_us and period_us are not changed then.
+     */
+    int amp_platform_get_cpu_quota(amp_platform_t descr,
+                                   size_t* quota_us,
+                                   size_t* period_us);
+    
+    
     /**
      * Queries the platform for the maximum concurrency level supported, 
      * that might be the count of installed hardware-threads or cores, or the
      * number of active hardware-threads or cores based on what is supported by
-     * the platform's backend.
+     * the platform's backend. 
+     *
+     * The level is capped by the number of hardware threads the calling
+     * thread may run on (amp_platform_get_affinity_hwthread_count) and by
+     * the CPU quota rounded up to whole hardware threads 
+     * (amp_platform_get_cpu_quota) where the backend supports these 
+     * queries, so thread pools sized by it don't oversubscribe containers.
      *
      * If the query is not supported AMP_UNSUPPORTED is returned and result 
      * is unchanged and untouched.
@@ -139,3 +139,221 @@ int amp_platform_get_active_hwthread_count(amp_platform_t descr,
 }
 
 
+
+int amp_platform_get_installed_package_count(amp_platform_t descr,
+                                             size_t* result)
+{
+    (void)descr;
+    
+    assert(NULL != descr); 
+    
+    /* Functionality not supported, no value returned. */
+    (void)result;
+    
+    return AMP_UNSUPPORTED;
+}
+
+
+
+int amp_platform_get_hwthread_topology(amp_platform_t descr,
+                                       size_t hwthread,
+                                       size_t* package_id,
+                                       size_t* core_id)
+{
+    (void)descr;
+    
+    assert(NULL != descr); 
+    
+    /* Functionality not supported, no value returned. */
+    (void)hwthread;
+    (void)package_id;
+    (void)core_id;
+    
+    return AMP_UNSUPPORTED;
+}
+
+
+
+int amp_platform_get_hwthread_siblings(amp_platform_t descr,
+                                       size_t hwthread,
+                                       struct amp_thread_affinity_s* siblings)
+{
+    (void)descr;
+    
+    assert(NULL != descr); 
+    
+    /* Functionality not supported, no value returned. */
+    (void)hwthread;
+    (void)siblings;
+    
+    return AMP_UNSUPPORTED;
+}
+
+
+int amp_platform_get_cache_line_size(amp_platform_t descr,
+                                     size_t* result)
+{
+    (void)descr;
+    
+    assert(NULL != descr); 
+    
+    /* Functionality not supported, no value returned. */
+    (void)result;
+    
+    return AMP_UNSUPPORTED;
+}
+
+
+
+int amp_platform_get_hwthread_cache_count(amp_platform_t descr,
+                                          size_t hwthread,
+                                          size_t* result)
+{
+    (void)descr;
+    
+    assert(NULL != descr); 
+    
+    /* Functionality not supported, no value returned. */
+    (void)hwthread;
+    (void)result;
+    
+    return AMP_UNSUPPORTED;
+}
+
+
+
+int amp_platform_get_hwthread_cache(amp_platform_t descr,
+                                    size_t hwthread,
+                                    size_t cache_index,
+                                    struct amp_platform_cache_s* result)
+{
+    (void)descr;
+    
+    assert(NULL != descr); 
+    
+    /* Functionality not supported, no value returned. */
+    (void)hwthread;
+    (void)cache_index;
+    (void)result;
+    
+    return AMP_UNSUPPORTED;
+}
+
+
+
+int amp_platform_get_hwthread_cache_sharing(amp_platform_t descr,
+                                            size_t hwthread,
+                                            size_t cache_index,
+                                            struct amp_thread_affinity_s* sharing)
+{
+    (void)descr;
+    
+    assert(NULL != descr); 
+    
+    /* Functionality not supported, no value returned. */
+    (void)hwthread;
+    (void)cache_index;
+    (void)sharing;
+    
+    return AMP_UNSUPPORTED;
+}
+
+
+int amp_platform_get_numa_node_count(amp_platform_t descr,
+                                     size_t* result)
+{
+    (void)descr;
+    
+    assert(NULL != descr); 
+    
+    /* Functionality not supported, no value returned. */
+    (void)result;
+    
+    return AMP_UNSUPPORTED;
+}
+
+
+
+int amp_platform_get_numa_node_hwthreads(amp_platform_t descr,
+                                         size_t node,
+                                         struct amp_thread_affinity_s* hwthreads)
+{
+    (void)descr;
+    
+    assert(NULL != descr); 
+    
+    /* Functionality not supported, no value returned. */
+    (void)node;
+    (void)hwthreads;
+    
+    return AMP_UNSUPPORTED;
+}
+
+
+
+int amp_platform_get_numa_node_distance(amp_platform_t descr,
+                                        size_t from_node,
+                                        size_t to_node,
+                                        size_t* distance)
+{
+    (void)descr;
+    
+    assert(NULL != descr); 
+    
+    /* Functionality not supported, no value returned. */
+    (void)from_node;
+    (void)to_node;
+    (void)distance;
+    
+    return AMP_UNSUPPORTED;
+}
+
+
+
+int amp_platform_get_hwthread_numa_node(amp_platform_t descr,
+                                        size_t hwthread,
+                                        size_t* node)
+{
+    (void)descr;
+    
+    assert(NULL != descr); 
+    
+    /* Functionality not supported, no value returned. */
+    (void)hwthread;
+    (void)node;
+    
+    return AMP_UNSUPPORTED;
+}
+
+
+int amp_platform_get_affinity_hwthread_count(amp_platform_t descr,
+                                             size_t* result)
+{
+    (void)descr;
+    
+    assert(NULL != descr); 
+    
+    /* Functionality not supported, no value returned. */
+    (void)result;
+    
+    return AMP_UNSUPPORTED;
+}
+
+
+
+int amp_platform_get_cpu_quota(amp_platform_t descr,
+                               size_t* quota_us,
+                               size_t* period_us)
+{
+    (void)descr;
+    
+    assert(NULL != descr); 
+    
+    /* Functionality not supported, no value returned. */
+    (void)quota_us;
+    (void)period_us;
+    
+    return AMP_UNSUPPORTED;
+}
+
+
@@ -57,6 +57,17 @@ size_t amp_internal_max(size_t a, size_t b)
 
 
 
+/**
+ * Internal helper function returning the smaller value of a and b.
+ */
+size_t amp_internal_min(size_t a, size_t b);
+size_t amp_internal_min(size_t a, size_t b)
+{
+    return ((a <= b)? a : b);
+}
+
+
+
 /**
  * TODO: @todo Change the signature of amp_raw_platform_init or of the 
  *             platform create functions to make it explicit that an allocator
@@ -72,6 +83,7 @@ int amp_raw_platform_init(amp_platform_t descr,
     descr->allocator_context = allocator->allocator_context;
     descr->alloc_func = allocator->alloc_func;
     descr->dealloc_func = allocator->dealloc_func;
+    descr->filesystem_root = NULL;
     
     return AMP_SUCCESS;
 }
@@ -88,6 +100,7 @@ int amp_raw_platform_finalize(amp_platform_t descr,
     descr->allocator_context = NULL;
     descr->alloc_func = NULL;
     descr->dealloc_func = NULL;
+    descr->filesystem_root = NULL;
     
     return AMP_SUCCESS;
 }
@@ -96,6 +109,17 @@ int amp_raw_platform_finalize(amp_platform_t descr,
 
 int amp_platform_create(amp_platform_t* descr,
                         amp_allocator_t allocator)
+{
+    return amp_platform_create_with_filesystem_root(descr,
+                                                    allocator,
+                                                    NULL);
+}
+
+
+
+int amp_platform_create_with_filesystem_root(amp_platform_t* descr,
+                                             amp_allocator_t allocator,
+                                             char const* filesystem_root)
 {
     amp_platform_t tmp_platform = AMP_PLATFORM_UNINITIALIZED;
     int retval = AMP_UNSUPPORTED;
@@ -114,6 +138,7 @@ int amp_platform_create(amp_platform_t* descr,
     retval = amp_raw_platform_init(tmp_platform,
                                    allocator);
     if (AMP_SUCCESS == retval) {
+        tmp_platform->filesystem_root = filesystem_root;
         *descr = tmp_platform;
     } else {
         int const rc = AMP_DEALLOC(allocator, tmp_platform);
@@ -194,8 +219,31 @@ int amp_platform_get_concurrency_level(amp_platform_t descr,
     if (AMP_SUCCESS == return_value 
         && NULL != result) {
         
-        *result = amp_internal_max(amp_internal_max(retval_installed_hwthreads, retval_installed_cores),
-                                   amp_internal_max(retval_active_hwthreads, retval_active_cores));
+        size_t level = amp_internal_max(amp_internal_max(retval_installed_hwthreads, retval_installed_cores),
+                                        amp_internal_max(retval_active_hwthreads, retval_active_cores));
+        size_t affinity_hwthreads = 0;
+        size_t quota_us = 0;
+        size_t period_us = 0;
+        
+        /* Don't count hardware threads the process isn't allowed to run on
+         * or CPU time its cgroup quota doesn't grant (containers).
+         */
+        if (AMP_SUCCESS == amp_platform_get_affinity_hwthread_count(descr,
+                                                                    &affinity_hwthreads)) {
+            level = amp_internal_min(level, affinity_hwthreads);
+        }
+        
+        if (AMP_SUCCESS == amp_platform_get_cpu_quota(descr,
+                                                      &quota_us,
+                                                      &period_us)) {
+            size_t const quota_hwthreads = quota_us / period_us 
+                + ((0 != quota_us % period_us) ? 1 : 0);
+            
+            level = amp_internal_min(level, 
+                                     amp_internal_max(quota_hwthreads, 1));
+        }
+        
+        *result = level;
     }
 
     return return_value;
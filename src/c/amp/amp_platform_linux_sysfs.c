@@ -0,0 +1,1594 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Platform hardware detection for Linux by parsing the CPU description the
+ * kernel exports below /sys/devices/system/cpu. Reports installed (present)
+ * and active (online) hardware threads, cores (distinct pairs of
+ * topology/physical_package_id and topology/core_id), packages, and the
+ * SMT siblings of a hardware thread (topology/thread_siblings_list), and
+ * the caches of each hardware thread (cache/index*). The cache line size 
+ * falls back to sysconf(_SC_LEVEL1_DCACHE_LINESIZE) if sysfs doesn't 
+ * describe caches. NUMA nodes, their hardware threads and distances are read
+ * from /sys/devices/system/node.
+ *
+ * The CPU quota of the process is read from the cgroup v2 cpu.max or cgroup
+ * v1 cpu.cfs_quota_us and cpu.cfs_period_us files of the cgroups listed in
+ * /proc/self/cgroup and their ancestors, below the standard mount points 
+ * /sys/fs/cgroup (v2) and /sys/fs/cgroup/cpu,cpuacct or /sys/fs/cgroup/cpu
+ * (v1). Inside containers the cgroup of the container is normally mounted at
+ * the mount point itself which is checked, too.
+ *
+ * The file system root is taken from the platform description (see
+ * amp_platform_create_with_filesystem_root) so tests can run against
+ * fixture directories.
+ *
+ * Every query re-reads sysfs - CPUs can be hot-plugged - using the
+ * platform allocator for a temporary topology table.
+ *
+ * amp_platform_create and amp_platform_destroy are implemented in 
+ * amp_platform_common.c.
+ *
+ * See http://www.kernel.org/doc/Documentation/cputopology.txt
+ *
+ * See http://www.kernel.org/doc/Documentation/ABI/stable/sysfs-devices-node
+ *
+ * See http://www.kernel.org/doc/Documentation/cgroup-v2.txt
+ *
+ * See http://www.kernel.org/doc/Documentation/scheduler/sched-bwc.txt
+ */
+
+/* _SC_LEVEL1_DCACHE_LINESIZE, sched_getaffinity and the CPU_ macros are 
+ * GNU extensions. Must be defined before any system header is included.
+ */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#   define _GNU_SOURCE
+#endif
+
+#include "amp_platform.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+
+#include <unistd.h>
+#include <sched.h>
+
+#include "amp_return_code.h"
+#include "amp_memory.h"
+#include "amp_thread.h"
+#include "amp_raw_platform.h"
+
+
+
+#define AMP_INTERNAL_PLATFORM_SYSFS_DEFAULT_ROOT ""
+
+#define AMP_INTERNAL_PLATFORM_SYSFS_PATH_CAPACITY 4096
+
+/* Passed instead of a CPU or node index to open files directly in the cpu 
+ * or node dir. 
+ */
+#define AMP_INTERNAL_PLATFORM_SYSFS_NO_INDEX (~(size_t)0)
+
+#define AMP_INTERNAL_PLATFORM_SYSFS_CPU_DIRECTORY "cpu"
+#define AMP_INTERNAL_PLATFORM_SYSFS_NODE_DIRECTORY "node"
+
+#define AMP_INTERNAL_PLATFORM_SYSFS_FILE_NAME_CAPACITY 64
+
+
+typedef int (*amp_internal_platform_sysfs_range_visitor_t)(void* context,
+                                                           size_t first,
+                                                           size_t last);
+
+
+struct amp_internal_platform_sysfs_hwthread_s {
+    size_t package_id;
+    size_t core_id;
+    int present;
+    int online;
+    int topology_known;
+};
+
+
+struct amp_internal_platform_sysfs_topology_s {
+    struct amp_internal_platform_sysfs_hwthread_s* hwthreads;
+    size_t hwthread_capacity;
+};
+
+
+
+/**
+ * Opens path (starting with a slash) below the file system root of descr.
+ *
+ * Returns NULL if the file can not be opened.
+ */
+static FILE* amp_internal_platform_sysfs_open_path(amp_platform_t descr,
+                                                   char const* path)
+{
+    char full_path[AMP_INTERNAL_PLATFORM_SYSFS_PATH_CAPACITY];
+    char const* root = descr->filesystem_root;
+    int length = 0;
+    
+    if (NULL == root) {
+        root = AMP_INTERNAL_PLATFORM_SYSFS_DEFAULT_ROOT;
+    }
+    
+    length = snprintf(full_path, sizeof(full_path), "%s%s", root, path);
+    
+    if ((0 > length) || ((size_t)length >= sizeof(full_path))) {
+        return NULL;
+    }
+    
+    return fopen(full_path, "r");
+}
+
+
+
+/**
+ * Opens file_name inside /sys/devices/system/<directory> (directory is 
+ * "cpu" or "node") below the file system root of descr, or inside the directory of CPU or
+ * node index (e.g. devices/system/cpu/cpu<index>) if index is not
+ * AMP_INTERNAL_PLATFORM_SYSFS_NO_INDEX.
+ *
+ * Returns NULL if the file can not be opened.
+ */
+static FILE* amp_internal_platform_sysfs_open_in(amp_platform_t descr,
+                                                 char const* directory,
+                                                 size_t index,
+                                                 char const* file_name)
+{
+    char path[AMP_INTERNAL_PLATFORM_SYSFS_PATH_CAPACITY];
+    int length = 0;
+    
+    if (AMP_INTERNAL_PLATFORM_SYSFS_NO_INDEX == index) {
+        length = snprintf(path, sizeof(path), 
+                          "/sys/devices/system/%s/%s", 
+                          directory, file_name);
+    } else {
+        length = snprintf(path, sizeof(path), 
+                          "/sys/devices/system/%s/%s%lu/%s", 
+                          directory, directory, (unsigned long)index, 
+                          file_name);
+    }
+    
+    if ((0 > length) || ((size_t)length >= sizeof(path))) {
+        return NULL;
+    }
+    
+    return amp_internal_platform_sysfs_open_path(descr, path);
+}
+
+
+
+/**
+ * Opens file_name inside the cpu directory or, if cpu is not
+ * AMP_INTERNAL_PLATFORM_SYSFS_NO_INDEX, inside the directory of CPU cpu.
+ */
+static FILE* amp_internal_platform_sysfs_open(amp_platform_t descr,
+                                              size_t cpu,
+                                              char const* file_name)
+{
+    return amp_internal_platform_sysfs_open_in(descr,
+                                               AMP_INTERNAL_PLATFORM_SYSFS_CPU_DIRECTORY,
+                                               cpu,
+                                               file_name);
+}
+
+
+
+/**
+ * Parses a non-negative decimal number starting with character c from file.
+ * On return c contains the first character following the number.
+ */
+static int amp_internal_platform_sysfs_parse_number(FILE* file,
+                                                    int* c,
+                                                    size_t* result)
+{
+    size_t value = 0;
+    
+    if (!isdigit(*c)) {
+        return AMP_ERROR;
+    }
+    
+    while (isdigit(*c)) {
+        size_t const digit = (size_t)(*c - '0');
+        
+        if (value > ((~(size_t)0) - digit) / 10) {
+            return AMP_ERROR;
+        }
+        
+        value = value * 10 + digit;
+        *c = getc(file);
+    }
+    
+    *result = value;
+    
+    return AMP_SUCCESS;
+}
+
+
+
+/**
+ * Parses a kernel CPU list like "0-3,8,10-11" and calls visitor for each
+ * range. An empty list is valid. Stops and returns the visitor result if it
+ * does not return AMP_SUCCESS.
+ */
+static int amp_internal_platform_sysfs_parse_cpu_list(FILE* file,
+                                                      amp_internal_platform_sysfs_range_visitor_t visitor,
+                                                      void* visitor_context)
+{
+    int c = getc(file);
+    
+    while (isspace(c)) {
+        c = getc(file);
+    }
+    
+    while (EOF != c) {
+        size_t first = 0;
+        size_t last = 0;
+        int retval = amp_internal_platform_sysfs_parse_number(file, &c, &first);
+        
+        if (AMP_SUCCESS != retval) {
+            return retval;
+        }
+        
+        last = first;
+        
+        if ('-' == c) {
+            c = getc(file);
+            retval = amp_internal_platform_sysfs_parse_number(file, &c, &last);
+            
+            if ((AMP_SUCCESS != retval) || (last < first)) {
+                return AMP_ERROR;
+            }
+        }
+        
+        retval = visitor(visitor_context, first, last);
+        if (AMP_SUCCESS != retval) {
+            return retval;
+        }
+        
+        if (',' == c) {
+            c = getc(file);
+        } else {
+            while (isspace(c)) {
+                c = getc(file);
+            }
+            
+            if (EOF != c) {
+                return AMP_ERROR;
+            }
+        }
+    }
+    
+    return AMP_SUCCESS;
+}
+
+
+
+/**
+ * Reads a single decimal id. Negative ids (the kernel reports -1 for an 
+ * unknown physical package on some architectures) are mapped to 0.
+ */
+static int amp_internal_platform_sysfs_read_id(amp_platform_t descr,
+                                               size_t cpu,
+                                               char const* file_name,
+                                               size_t* result)
+{
+    FILE* file = amp_internal_platform_sysfs_open(descr, cpu, file_name);
+    long value = 0;
+    int retval = AMP_ERROR;
+    
+    if (NULL == file) {
+        return AMP_ERROR;
+    }
+    
+    if (1 == fscanf(file, "%ld", &value)) {
+        *result = (0 > value) ? 0 : (size_t)value;
+        retval = AMP_SUCCESS;
+    }
+    
+    (void)fclose(file);
+    
+    return retval;
+}
+
+
+
+static int amp_internal_platform_sysfs_find_capacity(void* context,
+                                                     size_t first,
+                                                     size_t last)
+{
+    size_t* capacity = (size_t*)context;
+    
+    (void)first;
+    
+    if (last == (~(size_t)0)) {
+        return AMP_ERROR;
+    }
+    
+    if (last + 1 > *capacity) {
+        *capacity = last + 1;
+    }
+    
+    return AMP_SUCCESS;
+}
+
+
+
+static int amp_internal_platform_sysfs_mark_present(void* context,
+                                                    size_t first,
+                                                    size_t last)
+{
+    struct amp_internal_platform_sysfs_topology_s* topology = (struct amp_internal_platform_sysfs_topology_s*)context;
+    size_t i;
+    
+    for (i = first; (i <= last) && (i < topology->hwthread_capacity); ++i) {
+        topology->hwthreads[i].present = 1;
+    }
+    
+    return AMP_SUCCESS;
+}
+
+
+
+static int amp_internal_platform_sysfs_mark_online(void* context,
+                                                   size_t first,
+                                                   size_t last)
+{
+    struct amp_internal_platform_sysfs_topology_s* topology = (struct amp_internal_platform_sysfs_topology_s*)context;
+    size_t i;
+    
+    for (i = first; (i <= last) && (i < topology->hwthread_capacity); ++i) {
+        topology->hwthreads[i].online = topology->hwthreads[i].present;
+    }
+    
+    return AMP_SUCCESS;
+}
+
+
+
+static int amp_internal_platform_sysfs_add_to_affinity(void* context,
+                                                   size_t first,
+                                                   size_t last)
+{
+    struct amp_thread_affinity_s* siblings = (struct amp_thread_affinity_s*)context;
+    size_t i;
+    
+    for (i = first; (i <= last) && (i < AMP_THREAD_AFFINITY_CPU_CAPACITY); ++i) {
+        int const retval = amp_thread_affinity_add_cpu(siblings, i);
+        if (AMP_SUCCESS != retval) {
+            return retval;
+        }
+    }
+    
+    return AMP_SUCCESS;
+}
+
+
+
+/**
+ * Opens file_name like amp_internal_platform_sysfs_open_in and visits the
+ * ranges of the CPU or node list it contains.
+ *
+ * Returns AMP_UNSUPPORTED if the file can not be opened.
+ */
+static int amp_internal_platform_sysfs_visit_list_in(amp_platform_t descr,
+                                                     char const* directory,
+                                                     size_t index,
+                                                     char const* file_name,
+                                                     amp_internal_platform_sysfs_range_visitor_t visitor,
+                                                     void* visitor_context)
+{
+    FILE* file = amp_internal_platform_sysfs_open_in(descr,
+                                                     directory,
+                                                     index,
+                                                     file_name);
+    int retval = AMP_UNSUPPORTED;
+    
+    if (NULL == file) {
+        return AMP_UNSUPPORTED;
+    }
+    
+    retval = amp_internal_platform_sysfs_parse_cpu_list(file,
+                                                        visitor,
+                                                        visitor_context);
+    (void)fclose(file);
+    
+    return retval;
+}
+
+
+
+static int amp_internal_platform_sysfs_visit_cpu_list(amp_platform_t descr,
+                                                      char const* file_name,
+                                                      amp_internal_platform_sysfs_range_visitor_t visitor,
+                                                      void* visitor_context)
+{
+    return amp_internal_platform_sysfs_visit_list_in(descr,
+                                                     AMP_INTERNAL_PLATFORM_SYSFS_CPU_DIRECTORY,
+                                                     AMP_INTERNAL_PLATFORM_SYSFS_NO_INDEX,
+                                                     file_name,
+                                                     visitor,
+                                                     visitor_context);
+}
+
+
+
+/**
+ * Reads the present and online CPU lists and the package and core id of 
+ * each present CPU into topology.
+ *
+ * Returns AMP_UNSUPPORTED if sysfs does not contain a present CPU list,
+ * AMP_NOMEM if the table can not be allocated, or AMP_ERROR if a list
+ * can not be parsed.
+ */
+static int amp_internal_platform_sysfs_topology_init(amp_platform_t descr,
+                                                     struct amp_internal_platform_sysfs_topology_s* topology)
+{
+    size_t capacity = 0;
+    size_t i = 0;
+    int retval = amp_internal_platform_sysfs_visit_cpu_list(descr,
+                                                            "present",
+                                                            amp_internal_platform_sysfs_find_capacity,
+                                                            &capacity);
+    if (AMP_SUCCESS != retval) {
+        return retval;
+    }
+    
+    if (0 == capacity) {
+        return AMP_UNSUPPORTED;
+    }
+    
+    if (capacity > (~(size_t)0) / sizeof(*topology->hwthreads)) {
+        return AMP_NOMEM;
+    }
+    
+    topology->hwthreads = (struct amp_internal_platform_sysfs_hwthread_s*)AMP_ALLOC(descr,
+                                                                                    capacity * sizeof(*topology->hwthreads));
+    if (NULL == topology->hwthreads) {
+        return AMP_NOMEM;
+    }
+    topology->hwthread_capacity = capacity;
+    
+    for (i = 0; i < capacity; ++i) {
+        topology->hwthreads[i].package_id = 0;
+        topology->hwthreads[i].core_id = 0;
+        topology->hwthreads[i].present = 0;
+        topology->hwthreads[i].online = 0;
+        topology->hwthreads[i].topology_known = 0;
+    }
+    
+    retval = amp_internal_platform_sysfs_visit_cpu_list(descr,
+                                                        "present",
+                                                        amp_internal_platform_sysfs_mark_present,
+                                                        topology);
+    if (AMP_SUCCESS == retval) {
+        retval = amp_internal_platform_sysfs_visit_cpu_list(descr,
+                                                            "online",
+                                                            amp_internal_platform_sysfs_mark_online,
+                                                            topology);
+        if (AMP_UNSUPPORTED == retval) {
+            /* Kernels without CPU hot-plug support treat all CPUs as online. */
+            for (i = 0; i < capacity; ++i) {
+                topology->hwthreads[i].online = topology->hwthreads[i].present;
+            }
+            
+            retval = AMP_SUCCESS;
+        }
+    }
+    
+    if (AMP_SUCCESS != retval) {
+        int const rc = AMP_DEALLOC(descr, topology->hwthreads);
+        assert(AMP_SUCCESS == rc);
+        (void)rc;
+        
+        topology->hwthreads = NULL;
+        topology->hwthread_capacity = 0;
+        
+        return retval;
+    }
+    
+    for (i = 0; i < capacity; ++i) {
+        struct amp_internal_platform_sysfs_hwthread_s* hwthread = &topology->hwthreads[i];
+        
+        if (hwthread->present) {
+            /* Offline CPUs might not expose a topology directory. */
+            hwthread->topology_known = 
+                (AMP_SUCCESS == amp_internal_platform_sysfs_read_id(descr, i, "topology/physical_package_id", &hwthread->package_id))
+                && (AMP_SUCCESS == amp_internal_platform_sysfs_read_id(descr, i, "topology/core_id", &hwthread->core_id));
+        }
+    }
+    
+    return AMP_SUCCESS;
+}
+
+
+
+static void amp_internal_platform_sysfs_topology_finalize(amp_platform_t descr,
+                                                          struct amp_internal_platform_sysfs_topology_s* topology)
+{
+    int const retval = AMP_DEALLOC(descr, topology->hwthreads);
+    assert(AMP_SUCCESS == retval);
+    (void)retval;
+    
+    topology->hwthreads = NULL;
+    topology->hwthread_capacity = 0;
+}
+
+
+
+enum amp_internal_platform_sysfs_count_kind {
+    amp_internal_platform_sysfs_count_hwthreads,
+    amp_internal_platform_sysfs_count_cores,
+    amp_internal_platform_sysfs_count_packages
+};
+
+
+/**
+ * Counts hardware threads, cores (distinct package and core id pairs) or 
+ * packages among the present or online hardware threads. A hardware thread
+ * with unknown topology is counted as a core and package of its own.
+ */
+static size_t amp_internal_platform_sysfs_count(struct amp_internal_platform_sysfs_topology_s const* topology,
+                                                enum amp_internal_platform_sysfs_count_kind kind,
+                                                int online_only)
+{
+    size_t count = 0;
+    size_t i = 0;
+    
+    for (i = 0; i < topology->hwthread_capacity; ++i) {
+        struct amp_internal_platform_sysfs_hwthread_s const* hwthread = &topology->hwthreads[i];
+        int counted_before = 0;
+        size_t k = 0;
+        
+        if (!hwthread->present || (online_only && !hwthread->online)) {
+            continue;
+        }
+        
+        if ((amp_internal_platform_sysfs_count_hwthreads != kind) 
+            && hwthread->topology_known) {
+            
+            for (k = 0; (k < i) && !counted_before; ++k) {
+                struct amp_internal_platform_sysfs_hwthread_s const* other = &topology->hwthreads[k];
+                
+                counted_before = other->present 
+                    && (!online_only || other->online)
+                    && other->topology_known
+                    && (other->package_id == hwthread->package_id)
+                    && ((amp_internal_platform_sysfs_count_packages == kind)
+                        || (other->core_id == hwthread->core_id));
+            }
+        }
+        
+        if (!counted_before) {
+            ++count;
+        }
+    }
+    
+    return count;
+}
+
+
+
+static int amp_internal_platform_sysfs_query_count(amp_platform_t descr,
+                                                   enum amp_internal_platform_sysfs_count_kind kind,
+                                                   int online_only,
+                                                   size_t* result)
+{
+    struct amp_internal_platform_sysfs_topology_s topology = {NULL, 0};
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != descr);
+    
+    retval = amp_internal_platform_sysfs_topology_init(descr, &topology);
+    if (AMP_SUCCESS != retval) {
+        return retval;
+    }
+    
+    if (NULL != result) {
+        *result = amp_internal_platform_sysfs_count(&topology,
+                                                    kind,
+                                                    online_only);
+    }
+    
+    amp_internal_platform_sysfs_topology_finalize(descr, &topology);
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_platform_get_installed_core_count(amp_platform_t descr, 
+                                          size_t* result)
+{
+    return amp_internal_platform_sysfs_query_count(descr,
+                                                   amp_internal_platform_sysfs_count_cores,
+                                                   0,
+                                                   result);
+}
+
+
+
+int amp_platform_get_active_core_count(amp_platform_t descr, 
+                                       size_t* result)
+{
+    return amp_internal_platform_sysfs_query_count(descr,
+                                                   amp_internal_platform_sysfs_count_cores,
+                                                   1,
+                                                   result);
+}
+
+
+
+int amp_platform_get_installed_hwthread_count(amp_platform_t descr, 
+                                              size_t* result)
+{
+    return amp_internal_platform_sysfs_query_count(descr,
+                                                   amp_internal_platform_sysfs_count_hwthreads,
+                                                   0,
+                                                   result);
+}
+
+
+
+int amp_platform_get_active_hwthread_count(amp_platform_t descr, 
+                                           size_t* result)
+{
+    return amp_internal_platform_sysfs_query_count(descr,
+                                                   amp_internal_platform_sysfs_count_hwthreads,
+                                                   1,
+                                                   result);
+}
+
+
+
+int amp_platform_get_installed_package_count(amp_platform_t descr,
+                                             size_t* result)
+{
+    return amp_internal_platform_sysfs_query_count(descr,
+                                                   amp_internal_platform_sysfs_count_packages,
+                                                   0,
+                                                   result);
+}
+
+
+
+int amp_platform_get_hwthread_topology(amp_platform_t descr,
+                                       size_t hwthread,
+                                       size_t* package_id,
+                                       size_t* core_id)
+{
+    struct amp_internal_platform_sysfs_topology_s topology = {NULL, 0};
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != descr);
+    assert(NULL != package_id);
+    assert(NULL != core_id);
+    
+    retval = amp_internal_platform_sysfs_topology_init(descr, &topology);
+    if (AMP_SUCCESS != retval) {
+        return retval;
+    }
+    
+    if ((hwthread < topology.hwthread_capacity)
+        && topology.hwthreads[hwthread].present
+        && topology.hwthreads[hwthread].topology_known) {
+        
+        *package_id = topology.hwthreads[hwthread].package_id;
+        *core_id = topology.hwthreads[hwthread].core_id;
+        retval = AMP_SUCCESS;
+    } else {
+        retval = AMP_ERROR;
+    }
+    
+    amp_internal_platform_sysfs_topology_finalize(descr, &topology);
+    
+    return retval;
+}
+
+
+
+int amp_platform_get_hwthread_siblings(amp_platform_t descr,
+                                       size_t hwthread,
+                                       struct amp_thread_affinity_s* siblings)
+{
+    struct amp_thread_affinity_s tmp_siblings;
+    FILE* file = NULL;
+    size_t capacity = 0;
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != descr);
+    assert(NULL != siblings);
+    
+    retval = amp_internal_platform_sysfs_visit_cpu_list(descr,
+                                                        "present",
+                                                        amp_internal_platform_sysfs_find_capacity,
+                                                        &capacity);
+    if (AMP_SUCCESS != retval) {
+        return retval;
+    }
+    
+    if (hwthread >= capacity) {
+        return AMP_ERROR;
+    }
+    
+    file = amp_internal_platform_sysfs_open(descr, 
+                                            hwthread, 
+                                            "topology/thread_siblings_list");
+    if (NULL == file) {
+        return AMP_ERROR;
+    }
+    
+    retval = amp_thread_affinity_clear(&tmp_siblings);
+    assert(AMP_SUCCESS == retval);
+    
+    retval = amp_internal_platform_sysfs_parse_cpu_list(file,
+                                                        amp_internal_platform_sysfs_add_to_affinity,
+                                                        &tmp_siblings);
+    (void)fclose(file);
+    
+    if (AMP_SUCCESS == retval) {
+        *siblings = tmp_siblings;
+    }
+    
+    return retval;
+}
+
+
+
+/**
+ * Opens file_name in directory cache/index<cache_index> of CPU cpu.
+ */
+static FILE* amp_internal_platform_sysfs_open_cache(amp_platform_t descr,
+                                                    size_t cpu,
+                                                    size_t cache_index,
+                                                    char const* file_name)
+{
+    char cache_file_name[AMP_INTERNAL_PLATFORM_SYSFS_FILE_NAME_CAPACITY];
+    int const length = snprintf(cache_file_name, sizeof(cache_file_name),
+                                "cache/index%lu/%s",
+                                (unsigned long)cache_index, file_name);
+    
+    if ((0 > length) || ((size_t)length >= sizeof(cache_file_name))) {
+        return NULL;
+    }
+    
+    return amp_internal_platform_sysfs_open(descr, cpu, cache_file_name);
+}
+
+
+
+/**
+ * Reads a number with an optional K, M, or G suffix (used by the size file)
+ * from file_name of cache cache_index of CPU cpu. A missing file results 
+ * in 0.
+ */
+static size_t amp_internal_platform_sysfs_read_cache_value(amp_platform_t descr,
+                                                           size_t cpu,
+                                                           size_t cache_index,
+                                                           char const* file_name)
+{
+    FILE* file = amp_internal_platform_sysfs_open_cache(descr, 
+                                                        cpu, 
+                                                        cache_index, 
+                                                        file_name);
+    unsigned long value = 0;
+    size_t result = 0;
+    
+    if (NULL == file) {
+        return 0;
+    }
+    
+    if (1 == fscanf(file, "%lu", &value)) {
+        result = (size_t)value;
+        
+        switch (getc(file)) {
+            case 'G':
+                result *= 1024;
+                /* Fall through. */
+            case 'M':
+                result *= 1024;
+                /* Fall through. */
+            case 'K':
+                result *= 1024;
+                break;
+            default:
+                break;
+        }
+    }
+    
+    (void)fclose(file);
+    
+    return result;
+}
+
+
+
+/**
+ * Checks that hwthread is installed and counts the cache/index* directories
+ * of it.
+ *
+ * Returns AMP_UNSUPPORTED if sysfs doesn't describe present CPUs, or 
+ * AMP_ERROR if hwthread isn't installed.
+ */
+static int amp_internal_platform_sysfs_count_caches(amp_platform_t descr,
+                                                    size_t hwthread,
+                                                    size_t* result)
+{
+    size_t capacity = 0;
+    size_t count = 0;
+    int retval = amp_internal_platform_sysfs_visit_cpu_list(descr,
+                                                            "present",
+                                                            amp_internal_platform_sysfs_find_capacity,
+                                                            &capacity);
+    if (AMP_SUCCESS != retval) {
+        return retval;
+    }
+    
+    if (hwthread >= capacity) {
+        return AMP_ERROR;
+    }
+    
+    for (;;) {
+        FILE* file = amp_internal_platform_sysfs_open_cache(descr,
+                                                            hwthread,
+                                                            count,
+                                                            "level");
+        if (NULL == file) {
+            break;
+        }
+        
+        (void)fclose(file);
+        ++count;
+    }
+    
+    *result = count;
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_platform_get_cache_line_size(amp_platform_t descr,
+                                     size_t* result)
+{
+    size_t cache_count = 0;
+    size_t line_size = 0;
+    size_t i = 0;
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != descr);
+    
+    retval = amp_internal_platform_sysfs_count_caches(descr, 0, &cache_count);
+    
+    for (i = 0; (AMP_SUCCESS == retval) && (i < cache_count) && (0 == line_size); ++i) {
+        struct amp_platform_cache_s cache;
+        
+        retval = amp_platform_get_hwthread_cache(descr, 0, i, &cache);
+        
+        if ((AMP_SUCCESS == retval) 
+            && (1 == cache.level) 
+            && (amp_platform_cache_type_instruction != cache.type)) {
+            
+            line_size = cache.line_size;
+        }
+    }
+    
+#if defined(_SC_LEVEL1_DCACHE_LINESIZE)
+    if (0 == line_size) {
+        long const sysconf_line_size = sysconf(_SC_LEVEL1_DCACHE_LINESIZE);
+        
+        if (0 < sysconf_line_size) {
+            line_size = (size_t)sysconf_line_size;
+        }
+    }
+#endif
+    
+    if (0 == line_size) {
+        return AMP_UNSUPPORTED;
+    }
+    
+    if (NULL != result) {
+        *result = line_size;
+    }
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_platform_get_hwthread_cache_count(amp_platform_t descr,
+                                          size_t hwthread,
+                                          size_t* result)
+{
+    size_t count = 0;
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != descr);
+    
+    retval = amp_internal_platform_sysfs_count_caches(descr, hwthread, &count);
+    
+    if (AMP_SUCCESS == retval) {
+        if (0 == count) {
+            /* Kernel or architecture doesn't export cache information. */
+            retval = AMP_UNSUPPORTED;
+        } else if (NULL != result) {
+            *result = count;
+        }
+    }
+    
+    return retval;
+}
+
+
+
+int amp_platform_get_hwthread_cache(amp_platform_t descr,
+                                    size_t hwthread,
+                                    size_t cache_index,
+                                    struct amp_platform_cache_s* result)
+{
+    struct amp_platform_cache_s cache;
+    char type_name[16];
+    size_t count = 0;
+    FILE* file = NULL;
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != descr);
+    assert(NULL != result);
+    
+    retval = amp_platform_get_hwthread_cache_count(descr, hwthread, &count);
+    if (AMP_SUCCESS != retval) {
+        return retval;
+    }
+    
+    if (cache_index >= count) {
+        return AMP_ERROR;
+    }
+    
+    cache.level = amp_internal_platform_sysfs_read_cache_value(descr, hwthread, cache_index, "level");
+    cache.size = amp_internal_platform_sysfs_read_cache_value(descr, hwthread, cache_index, "size");
+    cache.line_size = amp_internal_platform_sysfs_read_cache_value(descr, hwthread, cache_index, "coherency_line_size");
+    cache.associativity = amp_internal_platform_sysfs_read_cache_value(descr, hwthread, cache_index, "ways_of_associativity");
+    cache.type = amp_platform_cache_type_unified;
+    
+    file = amp_internal_platform_sysfs_open_cache(descr, hwthread, cache_index, "type");
+    if (NULL != file) {
+        if (1 == fscanf(file, "%15s", type_name)) {
+            if (0 == strcmp(type_name, "Data")) {
+                cache.type = amp_platform_cache_type_data;
+            } else if (0 == strcmp(type_name, "Instruction")) {
+                cache.type = amp_platform_cache_type_instruction;
+            }
+        }
+        
+        (void)fclose(file);
+    }
+    
+    *result = cache;
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_platform_get_hwthread_cache_sharing(amp_platform_t descr,
+                                            size_t hwthread,
+                                            size_t cache_index,
+                                            struct amp_thread_affinity_s* sharing)
+{
+    struct amp_thread_affinity_s tmp_sharing;
+    size_t count = 0;
+    FILE* file = NULL;
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != descr);
+    assert(NULL != sharing);
+    
+    retval = amp_platform_get_hwthread_cache_count(descr, hwthread, &count);
+    if (AMP_SUCCESS != retval) {
+        return retval;
+    }
+    
+    if (cache_index >= count) {
+        return AMP_ERROR;
+    }
+    
+    file = amp_internal_platform_sysfs_open_cache(descr,
+                                                  hwthread,
+                                                  cache_index,
+                                                  "shared_cpu_list");
+    if (NULL == file) {
+        return AMP_UNSUPPORTED;
+    }
+    
+    retval = amp_thread_affinity_clear(&tmp_sharing);
+    assert(AMP_SUCCESS == retval);
+    
+    retval = amp_internal_platform_sysfs_parse_cpu_list(file,
+                                                        amp_internal_platform_sysfs_add_to_affinity,
+                                                        &tmp_sharing);
+    (void)fclose(file);
+    
+    if (AMP_SUCCESS == retval) {
+        *sharing = tmp_sharing;
+    }
+    
+    return retval;
+}
+
+
+
+/**
+ * Visitor context to find a CPU or node index in a list and to count the 
+ * list entries smaller than it.
+ */
+struct amp_internal_platform_sysfs_search_s {
+    size_t index;
+    size_t smaller_count;
+    int found;
+};
+
+
+
+static int amp_internal_platform_sysfs_search(void* context,
+                                              size_t first,
+                                              size_t last)
+{
+    struct amp_internal_platform_sysfs_search_s* search = (struct amp_internal_platform_sysfs_search_s*)context;
+    
+    if ((first <= search->index) && (search->index <= last)) {
+        search->smaller_count += search->index - first;
+        search->found = 1;
+    } else if (last < search->index) {
+        search->smaller_count += last - first + 1;
+    }
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_platform_get_numa_node_count(amp_platform_t descr,
+                                     size_t* result)
+{
+    size_t capacity = 0;
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != descr);
+    
+    retval = amp_internal_platform_sysfs_visit_list_in(descr,
+                                                       AMP_INTERNAL_PLATFORM_SYSFS_NODE_DIRECTORY,
+                                                       AMP_INTERNAL_PLATFORM_SYSFS_NO_INDEX,
+                                                       "online",
+                                                       amp_internal_platform_sysfs_find_capacity,
+                                                       &capacity);
+    if (AMP_SUCCESS != retval) {
+        return retval;
+    }
+    
+    if (0 == capacity) {
+        return AMP_UNSUPPORTED;
+    }
+    
+    if (NULL != result) {
+        *result = capacity;
+    }
+    
+    return AMP_SUCCESS;
+}
+
+
+
+/**
+ * Checks that node is online.
+ *
+ * Returns AMP_UNSUPPORTED if sysfs doesn't describe NUMA nodes or AMP_ERROR
+ * if node isn't online. smaller_online_count, if not NULL, receives the 
+ * number of online nodes with a smaller id than node.
+ */
+static int amp_internal_platform_sysfs_check_node(amp_platform_t descr,
+                                                  size_t node,
+                                                  size_t* smaller_online_count)
+{
+    struct amp_internal_platform_sysfs_search_s search = {0, 0, 0};
+    int retval = AMP_UNSUPPORTED;
+    
+    search.index = node;
+    
+    retval = amp_internal_platform_sysfs_visit_list_in(descr,
+                                                       AMP_INTERNAL_PLATFORM_SYSFS_NODE_DIRECTORY,
+                                                       AMP_INTERNAL_PLATFORM_SYSFS_NO_INDEX,
+                                                       "online",
+                                                       amp_internal_platform_sysfs_search,
+                                                       &search);
+    if (AMP_SUCCESS != retval) {
+        return retval;
+    }
+    
+    if (!search.found) {
+        return AMP_ERROR;
+    }
+    
+    if (NULL != smaller_online_count) {
+        *smaller_online_count = search.smaller_count;
+    }
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_platform_get_numa_node_hwthreads(amp_platform_t descr,
+                                         size_t node,
+                                         struct amp_thread_affinity_s* hwthreads)
+{
+    struct amp_thread_affinity_s tmp_hwthreads;
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != descr);
+    assert(NULL != hwthreads);
+    
+    retval = amp_internal_platform_sysfs_check_node(descr, node, NULL);
+    if (AMP_SUCCESS != retval) {
+        return retval;
+    }
+    
+    retval = amp_thread_affinity_clear(&tmp_hwthreads);
+    assert(AMP_SUCCESS == retval);
+    
+    retval = amp_internal_platform_sysfs_visit_list_in(descr,
+                                                       AMP_INTERNAL_PLATFORM_SYSFS_NODE_DIRECTORY,
+                                                       node,
+                                                       "cpulist",
+                                                       amp_internal_platform_sysfs_add_to_affinity,
+                                                       &tmp_hwthreads);
+    if (AMP_UNSUPPORTED == retval) {
+        /* Node is online but doesn't describe its CPUs. */
+        retval = AMP_ERROR;
+    }
+    
+    if (AMP_SUCCESS == retval) {
+        *hwthreads = tmp_hwthreads;
+    }
+    
+    return retval;
+}
+
+
+
+int amp_platform_get_numa_node_distance(amp_platform_t descr,
+                                        size_t from_node,
+                                        size_t to_node,
+                                        size_t* distance)
+{
+    size_t to_position = 0;
+    size_t i = 0;
+    unsigned long value = 0;
+    FILE* file = NULL;
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != descr);
+    assert(NULL != distance);
+    
+    retval = amp_internal_platform_sysfs_check_node(descr, from_node, NULL);
+    if (AMP_SUCCESS != retval) {
+        return retval;
+    }
+    
+    /* The distance file lists the distances to all online nodes ordered by 
+     * node id.
+     */
+    retval = amp_internal_platform_sysfs_check_node(descr, to_node, &to_position);
+    if (AMP_SUCCESS != retval) {
+        return retval;
+    }
+    
+    file = amp_internal_platform_sysfs_open_in(descr,
+                                               AMP_INTERNAL_PLATFORM_SYSFS_NODE_DIRECTORY,
+                                               from_node,
+                                               "distance");
+    if (NULL == file) {
+        return AMP_ERROR;
+    }
+    
+    for (i = 0; (i <= to_position) && (AMP_SUCCESS == retval); ++i) {
+        if (1 != fscanf(file, "%lu", &value)) {
+            retval = AMP_ERROR;
+        }
+    }
+    
+    (void)fclose(file);
+    
+    if (AMP_SUCCESS == retval) {
+        *distance = (size_t)value;
+    }
+    
+    return retval;
+}
+
+
+
+int amp_platform_get_hwthread_numa_node(amp_platform_t descr,
+                                        size_t hwthread,
+                                        size_t* node)
+{
+    size_t node_count = 0;
+    size_t i = 0;
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != descr);
+    assert(NULL != node);
+    
+    retval = amp_platform_get_numa_node_count(descr, &node_count);
+    if (AMP_SUCCESS != retval) {
+        return retval;
+    }
+    
+    for (i = 0; i < node_count; ++i) {
+        struct amp_internal_platform_sysfs_search_s search = {0, 0, 0};
+        
+        search.index = hwthread;
+        
+        /* Offline node ids inside the online range have no directory. */
+        retval = amp_internal_platform_sysfs_visit_list_in(descr,
+                                                           AMP_INTERNAL_PLATFORM_SYSFS_NODE_DIRECTORY,
+                                                           i,
+                                                           "cpulist",
+                                                           amp_internal_platform_sysfs_search,
+                                                           &search);
+        if ((AMP_SUCCESS == retval) && search.found) {
+            *node = i;
+            
+            return AMP_SUCCESS;
+        }
+    }
+    
+    return AMP_ERROR;
+}
+
+
+
+int amp_platform_get_affinity_hwthread_count(amp_platform_t descr,
+                                             size_t* result)
+{
+    /* The kernel rejects sets smaller than its own CPU mask, therefore grow
+     * the set until the query succeeds (Linux supports at most 8192 CPUs).
+     */
+    size_t cpu_capacity = CPU_SETSIZE;
+    int retval = EINVAL;
+    int count = 0;
+    
+    assert(NULL != descr);
+    
+    (void)descr;
+    
+    while ((EINVAL == retval) 
+           && (cpu_capacity <= (size_t)65536)) {
+        size_t const set_size = CPU_ALLOC_SIZE(cpu_capacity);
+        cpu_set_t* set = CPU_ALLOC(cpu_capacity);
+        if (NULL == set) {
+            return AMP_NOMEM;
+        }
+        
+        CPU_ZERO_S(set_size, set);
+        
+        retval = 0;
+        if (0 != sched_getaffinity(0, set_size, set)) {
+            retval = errno;
+        } else {
+            count = CPU_COUNT_S(set_size, set);
+        }
+        
+        CPU_FREE(set);
+        cpu_capacity *= 2;
+    }
+    
+    if ((0 != retval) || (0 >= count)) {
+        return AMP_UNSUPPORTED;
+    }
+    
+    if (NULL != result) {
+        *result = (size_t)count;
+    }
+    
+    return AMP_SUCCESS;
+}
+
+
+
+/**
+ * Most restrictive CPU quota found while walking the cgroup hierarchies.
+ */
+struct amp_internal_platform_sysfs_quota_s {
+    size_t quota;
+    size_t period;
+    int limited;
+};
+
+
+
+static void amp_internal_platform_sysfs_apply_quota(struct amp_internal_platform_sysfs_quota_s* result,
+                                                    size_t quota,
+                                                    size_t period)
+{
+    if ((0 == quota) || (0 == period)) {
+        return;
+    }
+    
+    if (!result->limited
+        || (((double)quota / (double)period) < ((double)result->quota / (double)result->period))) {
+        
+        result->quota = quota;
+        result->period = period;
+        result->limited = 1;
+    }
+}
+
+
+
+/**
+ * Reads the CPU quota of the cgroup directory (relative to the file system
+ * root) and applies it to result if it limits CPU usage.
+ */
+static void amp_internal_platform_sysfs_read_quota(amp_platform_t descr,
+                                                   char const* directory,
+                                                   int cgroup_version,
+                                                   struct amp_internal_platform_sysfs_quota_s* result)
+{
+    char path[AMP_INTERNAL_PLATFORM_SYSFS_PATH_CAPACITY];
+    FILE* file = NULL;
+    long quota = -1;
+    unsigned long period = 0;
+    int length = 0;
+    
+    if (2 == cgroup_version) {
+        length = snprintf(path, sizeof(path), "%s/cpu.max", directory);
+        if ((0 > length) || ((size_t)length >= sizeof(path))) {
+            return;
+        }
+        
+        file = amp_internal_platform_sysfs_open_path(descr, path);
+        if (NULL == file) {
+            return;
+        }
+        
+        /* Unlimited cgroups contain "max <period>" which fails to match. */
+        if (2 != fscanf(file, "%ld %lu", &quota, &period)) {
+            quota = -1;
+        }
+        (void)fclose(file);
+    } else {
+        length = snprintf(path, sizeof(path), "%s/cpu.cfs_quota_us", directory);
+        if ((0 > length) || ((size_t)length >= sizeof(path))) {
+            return;
+        }
+        
+        file = amp_internal_platform_sysfs_open_path(descr, path);
+        if (NULL == file) {
+            return;
+        }
+        
+        /* Unlimited cgroups contain -1. */
+        if (1 != fscanf(file, "%ld", &quota)) {
+            quota = -1;
+        }
+        (void)fclose(file);
+        
+        length = snprintf(path, sizeof(path), "%s/cpu.cfs_period_us", directory);
+        if ((0 > length) || ((size_t)length >= sizeof(path))) {
+            return;
+        }
+        
+        file = amp_internal_platform_sysfs_open_path(descr, path);
+        if (NULL == file) {
+            return;
+        }
+        
+        if (1 != fscanf(file, "%lu", &period)) {
+            period = 0;
+        }
+        (void)fclose(file);
+    }
+    
+    if (0 < quota) {
+        amp_internal_platform_sysfs_apply_quota(result, 
+                                                (size_t)quota, 
+                                                (size_t)period);
+    }
+}
+
+
+
+/**
+ * Applies the quotas of cgroup_path below mount_point and of all its 
+ * ancestors up to and including the mount point to result - the quota of 
+ * an ancestor limits all its descendants.
+ */
+static void amp_internal_platform_sysfs_walk_quotas(amp_platform_t descr,
+                                                    char const* mount_point,
+                                                    char const* cgroup_path,
+                                                    int cgroup_version,
+                                                    struct amp_internal_platform_sysfs_quota_s* result)
+{
+    char directory[AMP_INTERNAL_PLATFORM_SYSFS_PATH_CAPACITY];
+    size_t const mount_point_length = strlen(mount_point);
+    size_t length = 0;
+    int const printed = snprintf(directory, sizeof(directory), 
+                                 "%s%s", mount_point, cgroup_path);
+    
+    if ((0 > printed) || ((size_t)printed >= sizeof(directory))) {
+        return;
+    }
+    
+    length = (size_t)printed;
+    
+    for (;;) {
+        char* last_slash = NULL;
+        
+        while ((length > mount_point_length) && ('/' == directory[length - 1])) {
+            directory[--length] = '\0';
+        }
+        
+        amp_internal_platform_sysfs_read_quota(descr, 
+                                               directory, 
+                                               cgroup_version, 
+                                               result);
+        
+        if (length <= mount_point_length) {
+            break;
+        }
+        
+        last_slash = strrchr(directory + mount_point_length, '/');
+        if (NULL == last_slash) {
+            length = mount_point_length;
+        } else {
+            length = (size_t)(last_slash - directory);
+        }
+        directory[length] = '\0';
+    }
+}
+
+
+
+/**
+ * Returns non-zero if the comma separated controller list contains cpu.
+ */
+static int amp_internal_platform_sysfs_has_cpu_controller(char const* controllers)
+{
+    char const* controller = controllers;
+    
+    while (NULL != controller) {
+        if ((0 == strncmp(controller, "cpu", 3))
+            && ((',' == controller[3]) || ('\0' == controller[3]))) {
+            return 1;
+        }
+        
+        controller = strchr(controller, ',');
+        if (NULL != controller) {
+            ++controller;
+        }
+    }
+    
+    return 0;
+}
+
+
+
+int amp_platform_get_cpu_quota(amp_platform_t descr,
+                               size_t* quota_us,
+                               size_t* period_us)
+{
+    static char const* const v1_mount_points[] = {
+        "/sys/fs/cgroup/cpu,cpuacct",
+        "/sys/fs/cgroup/cpu"
+    };
+    
+    struct amp_internal_platform_sysfs_quota_s quota = {0, 0, 0};
+    char line[AMP_INTERNAL_PLATFORM_SYSFS_PATH_CAPACITY];
+    FILE* file = NULL;
+    size_t i = 0;
+    
+    assert(NULL != descr);
+    assert(NULL != quota_us);
+    assert(NULL != period_us);
+    
+    /* Lines look like "0::/path" (v2) or "4:cpu,cpuacct:/path" (v1). */
+    file = amp_internal_platform_sysfs_open_path(descr, "/proc/self/cgroup");
+    
+    while ((NULL != file) && (NULL != fgets(line, sizeof(line), file))) {
+        char* controllers = strchr(line, ':');
+        char* path = NULL;
+        char* newline = NULL;
+        
+        if (NULL == controllers) {
+            continue;
+        }
+        *controllers++ = '\0';
+        
+        path = strchr(controllers, ':');
+        if (NULL == path) {
+            continue;
+        }
+        *path++ = '\0';
+        
+        newline = strchr(path, '\n');
+        if (NULL != newline) {
+            *newline = '\0';
+        }
+        
+        if ((0 == strcmp(line, "0")) && ('\0' == controllers[0])) {
+            amp_internal_platform_sysfs_walk_quotas(descr,
+                                                    "/sys/fs/cgroup",
+                                                    path,
+                                                    2,
+                                                    &quota);
+        } else if (amp_internal_platform_sysfs_has_cpu_controller(controllers)) {
+            for (i = 0; i < sizeof(v1_mount_points) / sizeof(v1_mount_points[0]); ++i) {
+                amp_internal_platform_sysfs_walk_quotas(descr,
+                                                        v1_mount_points[i],
+                                                        path,
+                                                        1,
+                                                        &quota);
+            }
+        }
+    }
+    
+    if (NULL != file) {
+        (void)fclose(file);
+    } else {
+        /* No process information, check the cgroup mounted at the mount 
+         * points.
+         */
+        amp_internal_platform_sysfs_read_quota(descr, "/sys/fs/cgroup", 2, &quota);
+        
+        for (i = 0; i < sizeof(v1_mount_points) / sizeof(v1_mount_points[0]); ++i) {
+            amp_internal_platform_sysfs_read_quota(descr, v1_mount_points[i], 1, &quota);
+        }
+    }
+    
+    if (!quota.limited) {
+        return AMP_UNSUPPORTED;
+    }
+    
+    *quota_us = quota.quota;
+    *period_us = quota.period;
+    
+    return AMP_SUCCESS;
+}
+
+
@@ -0,0 +1,526 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implements the lock-free fixed-size object pool allocator.
+ *
+ * Every size class owns a free list of blocks linked by block indices. The
+ * head of the list packs a tag into the upper and the index of the first 
+ * free block plus one into the lower half of a size_t (zero marks an empty
+ * list). Each successful pop or push increments the tag so a thread 
+ * holding a stale head fails its compare-and-swap even if the same block
+ * has been popped and pushed back in the meantime. amp_atomic offers no 
+ * double width compare-and-swap, therefore indices instead of pointers.
+ *
+ * Slab k of a size class holds 
+ * AMP_INTERNAL_POOL_ALLOCATOR_FIRST_SLAB_BLOCK_COUNT << k blocks, block 
+ * indices are consecutive over all slabs of the class. Slabs are never 
+ * freed before the pool is destroyed, a stale index read by a losing 
+ * thread therefore always refers to readable memory.
+ *
+ * Every block starts with a header storing its size class and index and 
+ * the index link of the free list, the memory handed out follows the 
+ * header. Allocations too large for a size class get a header marking 
+ * them as such and are forwarded to the source allocator.
+ */
+
+#include "amp_pool_allocator.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <limits.h>
+#include <string.h>
+
+#include "amp_stddef.h"
+#include "amp_return_code.h"
+#include "amp_memory.h"
+#include "amp_atomic.h"
+
+
+
+#define AMP_INTERNAL_POOL_ALLOCATOR_ROUND_TO_CACHE_LINE(size) ((((size) + AMP_CACHE_LINE_SIZE - 1) / AMP_CACHE_LINE_SIZE) * AMP_CACHE_LINE_SIZE)
+
+#define AMP_INTERNAL_POOL_ALLOCATOR_CLASS_COUNT (AMP_POOL_ALLOCATOR_MAX_BLOCK_SIZE / AMP_POOL_ALLOCATOR_SIZE_CLASS_GRANULARITY)
+
+/* Size class id marking allocations forwarded to the source allocator. */
+#define AMP_INTERNAL_POOL_ALLOCATOR_LARGE_CLASS AMP_INTERNAL_POOL_ALLOCATOR_CLASS_COUNT
+
+#define AMP_INTERNAL_POOL_ALLOCATOR_INDEX_BITS (sizeof(size_t) * CHAR_BIT / 2)
+
+#define AMP_INTERNAL_POOL_ALLOCATOR_INDEX_MASK ((((size_t)1) << AMP_INTERNAL_POOL_ALLOCATOR_INDEX_BITS) - 1)
+
+#define AMP_INTERNAL_POOL_ALLOCATOR_FIRST_SLAB_BLOCK_COUNT ((size_t)16)
+
+/* Enough slabs to exhaust the block indices of 64bit platforms. */
+#define AMP_INTERNAL_POOL_ALLOCATOR_SLAB_CAPACITY 28
+
+
+struct amp_internal_pool_block_header_fields_s {
+    size_t block_id;
+    amp_atomic_size_t next;
+};
+
+/*
+ * The header is padded to the size class granularity to keep the memory 
+ * following it aligned.
+ */
+union amp_internal_pool_block_header_u {
+    struct amp_internal_pool_block_header_fields_s fields;
+    amp_byte_t padding[((sizeof(struct amp_internal_pool_block_header_fields_s) + AMP_POOL_ALLOCATOR_SIZE_CLASS_GRANULARITY - 1) / AMP_POOL_ALLOCATOR_SIZE_CLASS_GRANULARITY) * AMP_POOL_ALLOCATOR_SIZE_CLASS_GRANULARITY];
+};
+
+
+struct amp_internal_pool_class_fields_s {
+    amp_atomic_size_t head;
+    amp_atomic_ptr_t slabs[AMP_INTERNAL_POOL_ALLOCATOR_SLAB_CAPACITY];
+};
+
+/*
+ * Size classes are padded to whole cache lines so threads working on 
+ * different classes don't contend for the same line.
+ */
+union amp_internal_pool_class_u {
+    struct amp_internal_pool_class_fields_s fields;
+    amp_byte_t padding[AMP_INTERNAL_POOL_ALLOCATOR_ROUND_TO_CACHE_LINE(sizeof(struct amp_internal_pool_class_fields_s))];
+};
+
+
+/*
+ * Cache line aligned context of a pool allocator.
+ */
+struct amp_internal_pool_allocator_s {
+    union amp_internal_pool_class_u classes[AMP_INTERNAL_POOL_ALLOCATOR_CLASS_COUNT];
+    amp_allocator_t source_allocator;
+};
+
+
+
+static size_t amp_internal_pool_block_stride(size_t class_index);
+
+static size_t amp_internal_pool_block_stride(size_t class_index)
+{
+    return sizeof(union amp_internal_pool_block_header_u) 
+        + (class_index + 1) * AMP_POOL_ALLOCATOR_SIZE_CLASS_GRANULARITY;
+}
+
+
+
+static size_t amp_internal_pool_slab_first_block_index(size_t slab_index);
+
+static size_t amp_internal_pool_slab_first_block_index(size_t slab_index)
+{
+    return AMP_INTERNAL_POOL_ALLOCATOR_FIRST_SLAB_BLOCK_COUNT * ((((size_t)1) << slab_index) - 1);
+}
+
+
+
+static union amp_internal_pool_block_header_u* amp_internal_pool_block(struct amp_internal_pool_class_fields_s* pool_class,
+                                                                       size_t class_index,
+                                                                       size_t block_index);
+
+static union amp_internal_pool_block_header_u* amp_internal_pool_block(struct amp_internal_pool_class_fields_s* pool_class,
+                                                                       size_t class_index,
+                                                                       size_t block_index)
+{
+    size_t scaled_index = block_index / AMP_INTERNAL_POOL_ALLOCATOR_FIRST_SLAB_BLOCK_COUNT + 1;
+    size_t slab_index = 0;
+    amp_byte_t* slab = NULL;
+    
+    while (1 < scaled_index) {
+        scaled_index >>= 1;
+        ++slab_index;
+    }
+    
+    /* Published via release compare-and-swap before any of its blocks has
+     * been pushed onto the free list.
+     */
+    slab = (amp_byte_t*)amp_atomic_ptr_load(&pool_class->slabs[slab_index],
+                                            amp_memory_order_acquire);
+    assert(NULL != slab);
+    
+    return (union amp_internal_pool_block_header_u*)(slab + (block_index - amp_internal_pool_slab_first_block_index(slab_index)) * amp_internal_pool_block_stride(class_index));
+}
+
+
+
+/**
+ * Allocates the next slab of a size class and pushes its blocks onto the
+ * free list of the class.
+ *
+ * Returns AMP_SUCCESS if a slab has been added, either by the calling or
+ * by a concurrently growing thread. Returns AMP_NOMEM if the slab can't 
+ * be allocated or the class ran out of block indices.
+ */
+static int amp_internal_pool_grow(struct amp_internal_pool_allocator_s* pool,
+                                  size_t class_index);
+
+static int amp_internal_pool_grow(struct amp_internal_pool_allocator_s* pool,
+                                  size_t class_index)
+{
+    struct amp_internal_pool_class_fields_s* pool_class = &pool->classes[class_index].fields;
+    size_t const stride = amp_internal_pool_block_stride(class_index);
+    size_t slab_index = 0;
+    size_t first_block_index = 0;
+    size_t block_count = 0;
+    size_t i = 0;
+    amp_byte_t* slab = NULL;
+    void* expected_slab = NULL;
+    union amp_internal_pool_block_header_u* last_block = NULL;
+    size_t head = 0;
+    
+    while ((AMP_INTERNAL_POOL_ALLOCATOR_SLAB_CAPACITY > slab_index)
+           && (NULL != amp_atomic_ptr_load(&pool_class->slabs[slab_index], 
+                                           amp_memory_order_acquire))) {
+        ++slab_index;
+    }
+    
+    if (AMP_INTERNAL_POOL_ALLOCATOR_SLAB_CAPACITY == slab_index) {
+        return AMP_NOMEM;
+    }
+    
+    first_block_index = amp_internal_pool_slab_first_block_index(slab_index);
+    block_count = AMP_INTERNAL_POOL_ALLOCATOR_FIRST_SLAB_BLOCK_COUNT << slab_index;
+    
+    /* Stored indices are offset by one, the largest index must fit. */
+    if ((first_block_index + block_count > AMP_INTERNAL_POOL_ALLOCATOR_INDEX_MASK)
+        || (block_count > ((size_t)-1) / stride)) {
+        return AMP_NOMEM;
+    }
+    
+    slab = (amp_byte_t*)AMP_ALLOC(pool->source_allocator, block_count * stride);
+    if (NULL == slab) {
+        return AMP_NOMEM;
+    }
+    
+    for (i = 0; i < block_count; ++i) {
+        union amp_internal_pool_block_header_u* block = (union amp_internal_pool_block_header_u*)(slab + i * stride);
+        
+        block->fields.block_id = (class_index << AMP_INTERNAL_POOL_ALLOCATOR_INDEX_BITS) | (first_block_index + i);
+        amp_atomic_size_store(&block->fields.next,
+                              first_block_index + i + 2,
+                              amp_memory_order_relaxed);
+    }
+    last_block = (union amp_internal_pool_block_header_u*)(slab + (block_count - 1) * stride);
+    
+    if (!amp_atomic_ptr_compare_exchange(&pool_class->slabs[slab_index],
+                                         &expected_slab,
+                                         slab,
+                                         amp_memory_order_release,
+                                         amp_memory_order_relaxed)) {
+        /* Another thread added the slab first, use its blocks. */
+        int const rv = AMP_DEALLOC(pool->source_allocator, slab);
+        assert(AMP_SUCCESS == rv);
+        (void)rv;
+        
+        return AMP_SUCCESS;
+    }
+    
+    /* Splice the whole slab onto the free list in one go. */
+    head = amp_atomic_size_load(&pool_class->head, amp_memory_order_relaxed);
+    do {
+        amp_atomic_size_store(&last_block->fields.next,
+                              head & AMP_INTERNAL_POOL_ALLOCATOR_INDEX_MASK,
+                              amp_memory_order_relaxed);
+    } while (!amp_atomic_size_compare_exchange(&pool_class->head,
+                                               &head,
+                                               ((head & ~AMP_INTERNAL_POOL_ALLOCATOR_INDEX_MASK) + (AMP_INTERNAL_POOL_ALLOCATOR_INDEX_MASK + 1)) | (first_block_index + 1),
+                                               amp_memory_order_release,
+                                               amp_memory_order_relaxed));
+    
+    return AMP_SUCCESS;
+}
+
+
+
+/**
+ * Returns the memory of a block with a header marking it as a large 
+ * allocation drawn from the source allocator or NULL if no memory is 
+ * available.
+ */
+static void* amp_internal_pool_alloc_large(struct amp_internal_pool_allocator_s* pool,
+                                           size_t bytes_to_allocate,
+                                           char const* filename,
+                                           int line);
+
+static void* amp_internal_pool_alloc_large(struct amp_internal_pool_allocator_s* pool,
+                                           size_t bytes_to_allocate,
+                                           char const* filename,
+                                           int line)
+{
+    union amp_internal_pool_block_header_u* block = NULL;
+    
+    if (bytes_to_allocate > ((size_t)-1) - sizeof(*block)) {
+        return NULL;
+    }
+    
+    block = (union amp_internal_pool_block_header_u*)pool->source_allocator->alloc_func(pool->source_allocator->allocator_context,
+                                                                                        sizeof(*block) + bytes_to_allocate,
+                                                                                        filename,
+                                                                                        line);
+    if (NULL == block) {
+        return NULL;
+    }
+    
+    block->fields.block_id = ((size_t)AMP_INTERNAL_POOL_ALLOCATOR_LARGE_CLASS) << AMP_INTERNAL_POOL_ALLOCATOR_INDEX_BITS;
+    
+    return block + 1;
+}
+
+
+
+int amp_pool_allocator_create(amp_allocator_t* pool_allocator,
+                              amp_allocator_t source_allocator)
+{
+    struct amp_internal_pool_allocator_s* pool = NULL;
+    size_t class_index = 0;
+    size_t slab_index = 0;
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != pool_allocator);
+    assert(NULL != source_allocator);
+    
+    /* Align the size class heads to cache lines. */
+    pool = (struct amp_internal_pool_allocator_s*)AMP_ALIGNED_ALLOC(source_allocator,
+                                                                   AMP_CACHE_LINE_SIZE,
+                                                                   sizeof(*pool));
+    if (NULL == pool) {
+        return AMP_NOMEM;
+    }
+    
+    for (class_index = 0; class_index < AMP_INTERNAL_POOL_ALLOCATOR_CLASS_COUNT; ++class_index) {
+        struct amp_internal_pool_class_fields_s* pool_class = &pool->classes[class_index].fields;
+        
+        amp_atomic_size_store(&pool_class->head, 0, amp_memory_order_relaxed);
+        for (slab_index = 0; slab_index < AMP_INTERNAL_POOL_ALLOCATOR_SLAB_CAPACITY; ++slab_index) {
+            amp_atomic_ptr_store(&pool_class->slabs[slab_index],
+                                 NULL,
+                                 amp_memory_order_relaxed);
+        }
+    }
+    pool->source_allocator = source_allocator;
+    
+    retval = amp_allocator_create(pool_allocator,
+                                  source_allocator,
+                                  pool,
+                                  amp_pool_alloc,
+                                  amp_pool_calloc,
+                                  amp_pool_dealloc);
+    if (AMP_SUCCESS != retval) {
+        int const rc = AMP_ALIGNED_DEALLOC(source_allocator, pool);
+        assert(AMP_SUCCESS == rc);
+        (void)rc;
+    }
+    
+    return retval;
+}
+
+
+
+int amp_pool_allocator_destroy(amp_allocator_t* pool_allocator,
+                               amp_allocator_t source_allocator)
+{
+    struct amp_internal_pool_allocator_s* pool = NULL;
+    size_t class_index = 0;
+    size_t slab_index = 0;
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != pool_allocator);
+    assert(NULL != *pool_allocator);
+    assert(NULL != source_allocator);
+    
+    pool = (struct amp_internal_pool_allocator_s*)(*pool_allocator)->allocator_context;
+    
+    for (class_index = 0; class_index < AMP_INTERNAL_POOL_ALLOCATOR_CLASS_COUNT; ++class_index) {
+        struct amp_internal_pool_class_fields_s* pool_class = &pool->classes[class_index].fields;
+        
+        for (slab_index = 0; slab_index < AMP_INTERNAL_POOL_ALLOCATOR_SLAB_CAPACITY; ++slab_index) {
+            void* slab = amp_atomic_ptr_load(&pool_class->slabs[slab_index],
+                                             amp_memory_order_acquire);
+            
+            if (NULL != slab) {
+                retval = AMP_DEALLOC(pool->source_allocator, slab);
+                if (AMP_SUCCESS != retval) {
+                    return retval;
+                }
+                amp_atomic_ptr_store(&pool_class->slabs[slab_index],
+                                     NULL,
+                                     amp_memory_order_relaxed);
+            }
+        }
+    }
+    
+    retval = amp_allocator_destroy(pool_allocator, source_allocator);
+    if (AMP_SUCCESS == retval) {
+        retval = AMP_ALIGNED_DEALLOC(source_allocator, pool);
+    }
+    
+    return retval;
+}
+
+
+
+void* amp_pool_alloc(void* pool_allocator_context,
+                     size_t bytes_to_allocate,
+                     char const* filename,
+                     int line)
+{
+    struct amp_internal_pool_allocator_s* pool = (struct amp_internal_pool_allocator_s*)pool_allocator_context;
+    struct amp_internal_pool_class_fields_s* pool_class = NULL;
+    size_t class_index = 0;
+    size_t head = 0;
+    
+    assert(NULL != pool);
+    
+    if (AMP_POOL_ALLOCATOR_MAX_BLOCK_SIZE < bytes_to_allocate) {
+        return amp_internal_pool_alloc_large(pool, 
+                                             bytes_to_allocate, 
+                                             filename, 
+                                             line);
+    }
+    
+    if (0 != bytes_to_allocate) {
+        class_index = (bytes_to_allocate - 1) / AMP_POOL_ALLOCATOR_SIZE_CLASS_GRANULARITY;
+    }
+    pool_class = &pool->classes[class_index].fields;
+    
+    head = amp_atomic_size_load(&pool_class->head, amp_memory_order_acquire);
+    while (1) {
+        
+        while (0 != (head & AMP_INTERNAL_POOL_ALLOCATOR_INDEX_MASK)) {
+            union amp_internal_pool_block_header_u* block = amp_internal_pool_block(pool_class,
+                                                                                    class_index,
+                                                                                    (head & AMP_INTERNAL_POOL_ALLOCATOR_INDEX_MASK) - 1);
+            /* Might be stale if another thread pops block concurrently, 
+             * the tag check of the compare-and-swap rejects it then.
+             */
+            size_t const next = amp_atomic_size_load(&block->fields.next,
+                                                     amp_memory_order_relaxed);
+            
+            if (amp_atomic_size_compare_exchange(&pool_class->head,
+                                                 &head,
+                                                 ((head & ~AMP_INTERNAL_POOL_ALLOCATOR_INDEX_MASK) + (AMP_INTERNAL_POOL_ALLOCATOR_INDEX_MASK + 1)) | next,
+                                                 amp_memory_order_acquire,
+                                                 amp_memory_order_acquire)) {
+                return block + 1;
+            }
+        }
+        
+        if (AMP_SUCCESS != amp_internal_pool_grow(pool, class_index)) {
+            /* Out of slab memory or block indices, the source allocator
+             * might still be able to serve a single block.
+             */
+            return amp_internal_pool_alloc_large(pool, 
+                                                 bytes_to_allocate,
+                                                 filename,
+                                                 line);
+        }
+        
+        head = amp_atomic_size_load(&pool_class->head, amp_memory_order_acquire);
+    }
+}
+
+
+
+void* amp_pool_calloc(void* pool_allocator_context,
+                      size_t elem_count,
+                      size_t bytes_per_elem,
+                      char const* filename,
+                      int line)
+{
+    void* memory = NULL;
+    
+    if ((0 != bytes_per_elem) && (elem_count > ((size_t)-1) / bytes_per_elem)) {
+        return NULL;
+    }
+    
+    memory = amp_pool_alloc(pool_allocator_context,
+                            elem_count * bytes_per_elem,
+                            filename,
+                            line);
+    if (NULL != memory) {
+        memset(memory, 0, elem_count * bytes_per_elem);
+    }
+    
+    return memory;
+}
+
+
+
+int amp_pool_dealloc(void* pool_allocator_context,
+                     void* pointer,
+                     char const* filename,
+                     int line)
+{
+    struct amp_internal_pool_allocator_s* pool = (struct amp_internal_pool_allocator_s*)pool_allocator_context;
+    struct amp_internal_pool_class_fields_s* pool_class = NULL;
+    union amp_internal_pool_block_header_u* block = NULL;
+    size_t class_index = 0;
+    size_t block_index = 0;
+    size_t head = 0;
+    
+    assert(NULL != pool);
+    
+    if (NULL == pointer) {
+        return AMP_SUCCESS;
+    }
+    
+    block = ((union amp_internal_pool_block_header_u*)pointer) - 1;
+    class_index = block->fields.block_id >> AMP_INTERNAL_POOL_ALLOCATOR_INDEX_BITS;
+    block_index = block->fields.block_id & AMP_INTERNAL_POOL_ALLOCATOR_INDEX_MASK;
+    
+    if (AMP_INTERNAL_POOL_ALLOCATOR_LARGE_CLASS == class_index) {
+        return pool->source_allocator->dealloc_func(pool->source_allocator->allocator_context,
+                                                    block,
+                                                    filename,
+                                                    line);
+    }
+    
+    assert(AMP_INTERNAL_POOL_ALLOCATOR_CLASS_COUNT > class_index);
+    pool_class = &pool->classes[class_index].fields;
+    
+    head = amp_atomic_size_load(&pool_class->head, amp_memory_order_relaxed);
+    do {
+        amp_atomic_size_store(&block->fields.next,
+                              head & AMP_INTERNAL_POOL_ALLOCATOR_INDEX_MASK,
+                              amp_memory_order_relaxed);
+    } while (!amp_atomic_size_compare_exchange(&pool_class->head,
+                                               &head,
+                                               ((head & ~AMP_INTERNAL_POOL_ALLOCATOR_INDEX_MASK) + (AMP_INTERNAL_POOL_ALLOCATOR_INDEX_MASK + 1)) | (block_index + 1),
+                                               amp_memory_order_release,
+                                               amp_memory_order_relaxed));
+    
+    return AMP_SUCCESS;
+}
+
+
@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Fixed-size object pool allocator serving small allocations from per size
+ * class free lists instead of the general purpose heap. Size classes are 
+ * AMP_POOL_ALLOCATOR_SIZE_CLASS_GRANULARITY bytes apart and go up to 
+ * AMP_POOL_ALLOCATOR_MAX_BLOCK_SIZE bytes which covers the raw structs of 
+ * the amp synchronization primitives (mutexes, condition variables, 
+ * semaphores, barriers, spinlocks) on all backends. Larger requests are
+ * forwarded to the source allocator the pool has been created with.
+ *
+ * Pass a pool allocator to the amp create and destroy functions to avoid
+ * a round trip through the heap when creating and destroying many 
+ * primitives:
+ * @code
+ * amp_allocator_t pool = AMP_ALLOCATOR_UNINITIALIZED;
+ * amp_mutex_t mutex = AMP_MUTEX_UNINITIALIZED;
+ * amp_pool_allocator_create(&pool, AMP_DEFAULT_ALLOCATOR);
+ * amp_mutex_create(&mutex, pool);
+ * ...
+ * amp_mutex_destroy(&mutex, pool);
+ * amp_pool_allocator_destroy(&pool, AMP_DEFAULT_ALLOCATOR);
+ * @endcode
+ *
+ * Blocks of a size class are carved out of slabs allocated from the source
+ * allocator, each slab twice as large as the previous one of its class. 
+ * Slabs are only returned to the source allocator when the pool is 
+ * destroyed. Allocation and deallocation are thread-safe and lock-free: 
+ * every size class keeps a free list updated via compare-and-swap, 
+ * guarded against the ABA problem by a tag stored next to the index of 
+ * the first free block.
+ *
+ * Memory returned by the pool is aligned to 
+ * AMP_POOL_ALLOCATOR_SIZE_CLASS_GRANULARITY bytes if the source allocator
+ * returns memory aligned at least to that boundary.
+ */
+
+#ifndef AMP_amp_pool_allocator_H
+#define AMP_amp_pool_allocator_H
+
+#include <stddef.h>
+
+#include <amp/amp_memory.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+    
+    
+    /**
+     * Distance in bytes between the block sizes of neighboring size 
+     * classes.
+     */
+#define AMP_POOL_ALLOCATOR_SIZE_CLASS_GRANULARITY ((size_t)16)
+    
+    /**
+     * Largest allocation served from a size class, larger allocations are
+     * forwarded to the source allocator.
+     */
+#define AMP_POOL_ALLOCATOR_MAX_BLOCK_SIZE ((size_t)256)
+    
+    
+    /**
+     * Creates a pool allocator drawing its slabs and allocations larger 
+     * than AMP_POOL_ALLOCATOR_MAX_BLOCK_SIZE from source_allocator. The 
+     * pool itself is allocated via source_allocator, too. No slab is 
+     * allocated until the first allocation of a size class.
+     *
+     * source_allocator must stay valid until the pool has been destroyed.
+     *
+     * @return AMP_SUCCESS on successful creation.
+     *         AMP_NOMEM if not enough memory is available.
+     */
+    int amp_pool_allocator_create(amp_allocator_t* pool_allocator,
+                                  amp_allocator_t source_allocator);
+    
+    /**
+     * Destroys pool_allocator and returns all of its slabs to the source
+     * allocator it has been created with. source_allocator is used to 
+     * deallocate the pool itself and must be the allocator passed to 
+     * amp_pool_allocator_create. All memory allocated via pool_allocator 
+     * must have been deallocated before.
+     *
+     * @return AMP_SUCCESS on successful destruction.
+     *         AMP_ERROR might be returned if an error is detected.
+     */
+    int amp_pool_allocator_destroy(amp_allocator_t* pool_allocator,
+                                   amp_allocator_t source_allocator);
+    
+    
+    /**
+     * Allocation function of allocators created by 
+     * amp_pool_allocator_create. Returns NULL if no memory is available.
+     *
+     * Thread-safe and lock-free unless a new slab needs to be allocated.
+     */
+    void* amp_pool_alloc(void* pool_allocator_context,
+                         size_t bytes_to_allocate,
+                         char const* filename,
+                         int line);
+    
+    /**
+     * Zeroing array allocation function of allocators created by 
+     * amp_pool_allocator_create. Returns NULL on overflow of 
+     * elem_count * bytes_per_elem or if no memory is available.
+     *
+     * Thread-safe and lock-free unless a new slab needs to be allocated.
+     */
+    void* amp_pool_calloc(void* pool_allocator_context,
+                          size_t elem_count,
+                          size_t bytes_per_elem,
+                          char const* filename,
+                          int line);
+    
+    /**
+     * Deallocation function of allocators created by 
+     * amp_pool_allocator_create. Blocks of a size class are pushed back 
+     * onto the free list of their class, larger allocations are returned to
+     * the source allocator.
+     *
+     * Thread-safe and lock-free for blocks of a size class.
+     *
+     * @return AMP_SUCCESS on successful deallocation.
+     *         Error codes of the source allocator for allocations larger 
+     *         than AMP_POOL_ALLOCATOR_MAX_BLOCK_SIZE.
+     */
+    int amp_pool_dealloc(void* pool_allocator_context,
+                         void* pointer,
+                         char const* filename,
+                         int line);
+    
+    
+    
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* AMP_amp_pool_allocator_H */
@@ -0,0 +1,366 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Backend specific definitions of the amp_atomic types and inline functions
+ * declared in amp_atomic.h. See amp_atomic.h for the selection of backends.
+ */
+
+#ifndef AMP_amp_raw_atomic_H
+#define AMP_amp_raw_atomic_H
+
+#include <stddef.h>
+
+#include <amp/amp_atomic.h>
+
+
+
+#if defined(AMP_USE_C11_ATOMICS) && !defined(__cplusplus)
+#   define AMP_INTERNAL_ATOMIC_USE_C11
+#   include <stdatomic.h>
+#elif defined(AMP_USE_C11_ATOMICS) || defined(AMP_USE_GNUC_ATOMICS) || defined(__GNUC__)
+#   if !defined(__GNUC__)
+#       error Unsupported platform.
+#   endif
+#   define AMP_INTERNAL_ATOMIC_USE_GNUC
+#else
+#   error Unsupported platform.
+#endif
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+    
+    /**
+     * Returns the ordering of the load part of an operation ordered by 
+     * order. Used to derive valid failure orders of compare and exchange 
+     * operations.
+     */
+    static inline amp_memory_order_t amp_internal_atomic_load_order(amp_memory_order_t order);
+    static inline amp_memory_order_t amp_internal_atomic_load_order(amp_memory_order_t order)
+    {
+        switch (order) {
+            case amp_memory_order_release:
+                return amp_memory_order_relaxed;
+            case amp_memory_order_acq_rel:
+                return amp_memory_order_acquire;
+            default:
+                return order;
+        }
+    }
+    
+    /**
+     * Returns failure_order weakened to be valid for the failure case of a
+     * compare and exchange operation ordered by success_order.
+     */
+    static inline amp_memory_order_t amp_internal_atomic_failure_order(amp_memory_order_t success_order,
+                                                                       amp_memory_order_t failure_order);
+    static inline amp_memory_order_t amp_internal_atomic_failure_order(amp_memory_order_t success_order,
+                                                                       amp_memory_order_t failure_order)
+    {
+        amp_memory_order_t const success_load_order = amp_internal_atomic_load_order(success_order);
+        
+        failure_order = amp_internal_atomic_load_order(failure_order);
+        
+        return (failure_order < success_load_order) ? failure_order : success_load_order;
+    }
+    
+    
+    
+#if defined(AMP_INTERNAL_ATOMIC_USE_C11)
+    
+    struct amp_atomic_int_s {
+        _Atomic(int) value;
+    };
+    
+    struct amp_atomic_size_s {
+        _Atomic(size_t) value;
+    };
+    
+    struct amp_atomic_ptr_s {
+        _Atomic(void*) value;
+    };
+    
+    
+    static inline memory_order amp_internal_atomic_native_order(amp_memory_order_t order);
+    static inline memory_order amp_internal_atomic_native_order(amp_memory_order_t order)
+    {
+        switch (order) {
+            case amp_memory_order_relaxed:
+                return memory_order_relaxed;
+            case amp_memory_order_acquire:
+                return memory_order_acquire;
+            case amp_memory_order_release:
+                return memory_order_release;
+            case amp_memory_order_acq_rel:
+                return memory_order_acq_rel;
+            default:
+                return memory_order_seq_cst;
+        }
+    }
+    
+#   define AMP_INTERNAL_ATOMIC_LOAD(atomic, order) \
+        atomic_load_explicit(&(atomic)->value, amp_internal_atomic_native_order(order))
+#   define AMP_INTERNAL_ATOMIC_STORE(atomic, value, order) \
+        atomic_store_explicit(&(atomic)->value, (value), amp_internal_atomic_native_order(order))
+#   define AMP_INTERNAL_ATOMIC_EXCHANGE(atomic, value, order) \
+        atomic_exchange_explicit(&(atomic)->value, (value), amp_internal_atomic_native_order(order))
+#   define AMP_INTERNAL_ATOMIC_COMPARE_EXCHANGE(atomic, expected, desired, success_order, failure_order) \
+        atomic_compare_exchange_strong_explicit(&(atomic)->value, \
+                                                (expected), \
+                                                (desired), \
+                                                amp_internal_atomic_native_order(success_order), \
+                                                amp_internal_atomic_native_order(amp_internal_atomic_failure_order((success_order), (failure_order))))
+#   define AMP_INTERNAL_ATOMIC_FETCH_ADD(atomic, value, order) \
+        atomic_fetch_add_explicit(&(atomic)->value, (value), amp_internal_atomic_native_order(order))
+#   define AMP_INTERNAL_ATOMIC_FETCH_SUB(atomic, value, order) \
+        atomic_fetch_sub_explicit(&(atomic)->value, (value), amp_internal_atomic_native_order(order))
+#   define AMP_INTERNAL_ATOMIC_THREAD_FENCE(order) \
+        atomic_thread_fence(amp_internal_atomic_native_order(order))
+    
+#elif defined(AMP_INTERNAL_ATOMIC_USE_GNUC)
+    
+    struct amp_atomic_int_s {
+        int value;
+    };
+    
+    struct amp_atomic_size_s {
+        size_t value;
+    };
+    
+    struct amp_atomic_ptr_s {
+        void* value;
+    };
+    
+    
+    static inline int amp_internal_atomic_native_order(amp_memory_order_t order);
+    static inline int amp_internal_atomic_native_order(amp_memory_order_t order)
+    {
+        switch (order) {
+            case amp_memory_order_relaxed:
+                return __ATOMIC_RELAXED;
+            case amp_memory_order_acquire:
+                return __ATOMIC_ACQUIRE;
+            case amp_memory_order_release:
+                return __ATOMIC_RELEASE;
+            case amp_memory_order_acq_rel:
+                return __ATOMIC_ACQ_REL;
+            default:
+                return __ATOMIC_SEQ_CST;
+        }
+    }
+    
+#   define AMP_INTERNAL_ATOMIC_LOAD(atomic, order) \
+        __atomic_load_n(&(atomic)->value, amp_internal_atomic_native_order(order))
+#   define AMP_INTERNAL_ATOMIC_STORE(atomic, value, order) \
+        __atomic_store_n(&(atomic)->value, (value), amp_internal_atomic_native_order(order))
+#   define AMP_INTERNAL_ATOMIC_EXCHANGE(atomic, value, order) \
+        __atomic_exchange_n(&(atomic)->value, (value), amp_internal_atomic_native_order(order))
+#   define AMP_INTERNAL_ATOMIC_COMPARE_EXCHANGE(atomic, expected, desired, success_order, failure_order) \
+        __atomic_compare_exchange_n(&(atomic)->value, \
+                                    (expected), \
+                                    (desired), \
+                                    0, \
+                                    amp_internal_atomic_native_order(success_order), \
+                                    amp_internal_atomic_native_order(amp_internal_atomic_failure_order((success_order), (failure_order))))
+#   define AMP_INTERNAL_ATOMIC_FETCH_ADD(atomic, value, order) \
+        __atomic_fetch_add(&(atomic)->value, (value), amp_internal_atomic_native_order(order))
+#   define AMP_INTERNAL_ATOMIC_FETCH_SUB(atomic, value, order) \
+        __atomic_fetch_sub(&(atomic)->value, (value), amp_internal_atomic_native_order(order))
+#   define AMP_INTERNAL_ATOMIC_THREAD_FENCE(order) \
+        __atomic_thread_fence(amp_internal_atomic_native_order(order))
+    
+#else
+#   error Unsupported backend.
+#endif
+    
+    
+    
+    static inline int amp_atomic_int_load(amp_atomic_int_t* atomic,
+                                          amp_memory_order_t order)
+    {
+        return AMP_INTERNAL_ATOMIC_LOAD(atomic, order);
+    }
+    
+    static inline void amp_atomic_int_store(amp_atomic_int_t* atomic,
+                                            int value,
+                                            amp_memory_order_t order)
+    {
+        AMP_INTERNAL_ATOMIC_STORE(atomic, value, order);
+    }
+    
+    static inline int amp_atomic_int_exchange(amp_atomic_int_t* atomic,
+                                              int value,
+                                              amp_memory_order_t order)
+    {
+        return AMP_INTERNAL_ATOMIC_EXCHANGE(atomic, value, order);
+    }
+    
+    static inline int amp_atomic_int_compare_exchange(amp_atomic_int_t* atomic,
+                                                      int* expected,
+                                                      int desired,
+                                                      amp_memory_order_t success_order,
+                                                      amp_memory_order_t failure_order)
+    {
+        return AMP_INTERNAL_ATOMIC_COMPARE_EXCHANGE(atomic, expected, desired, success_order, failure_order) ? 1 : 0;
+    }
+    
+    static inline int amp_atomic_int_fetch_add(amp_atomic_int_t* atomic,
+                                               int value,
+                                               amp_memory_order_t order)
+    {
+        return AMP_INTERNAL_ATOMIC_FETCH_ADD(atomic, value, order);
+    }
+    
+    static inline int amp_atomic_int_fetch_sub(amp_atomic_int_t* atomic,
+                                               int value,
+                                               amp_memory_order_t order)
+    {
+        return AMP_INTERNAL_ATOMIC_FETCH_SUB(atomic, value, order);
+    }
+    
+    
+    
+    static inline size_t amp_atomic_size_load(amp_atomic_size_t* atomic,
+                                              amp_memory_order_t order)
+    {
+        return AMP_INTERNAL_ATOMIC_LOAD(atomic, order);
+    }
+    
+    static inline void amp_atomic_size_store(amp_atomic_size_t* atomic,
+                                             size_t value,
+                                             amp_memory_order_t order)
+    {
+        AMP_INTERNAL_ATOMIC_STORE(atomic, value, order);
+    }
+    
+    static inline size_t amp_atomic_size_exchange(amp_atomic_size_t* atomic,
+                                                  size_t value,
+                                                  amp_memory_order_t order)
+    {
+        return AMP_INTERNAL_ATOMIC_EXCHANGE(atomic, value, order);
+    }
+    
+    static inline int amp_atomic_size_compare_exchange(amp_atomic_size_t* atomic,
+                                                       size_t* expected,
+                                                       size_t desired,
+                                                       amp_memory_order_t success_order,
+                                                       amp_memory_order_t failure_order)
+    {
+        return AMP_INTERNAL_ATOMIC_COMPARE_EXCHANGE(atomic, expected, desired, success_order, failure_order) ? 1 : 0;
+    }
+    
+    static inline size_t amp_atomic_size_fetch_add(amp_atomic_size_t* atomic,
+                                                   size_t value,
+                                                   amp_memory_order_t order)
+    {
+        return AMP_INTERNAL_ATOMIC_FETCH_ADD(atomic, value, order);
+    }
+    
+    static inline size_t amp_atomic_size_fetch_sub(amp_atomic_size_t* atomic,
+                                                   size_t value,
+                                                   amp_memory_order_t order)
+    {
+        return AMP_INTERNAL_ATOMIC_FETCH_SUB(atomic, value, order);
+    }
+    
+    
+    
+    static inline void* amp_atomic_ptr_load(amp_atomic_ptr_t* atomic,
+                                            amp_memory_order_t order)
+    {
+        return AMP_INTERNAL_ATOMIC_LOAD(atomic, order);
+    }
+    
+    static inline void amp_atomic_ptr_store(amp_atomic_ptr_t* atomic,
+                                            void* value,
+                                            amp_memory_order_t order)
+    {
+        AMP_INTERNAL_ATOMIC_STORE(atomic, value, order);
+    }
+    
+    static inline void* amp_atomic_ptr_exchange(amp_atomic_ptr_t* atomic,
+                                                void* value,
+                                                amp_memory_order_t order)
+    {
+        return AMP_INTERNAL_ATOMIC_EXCHANGE(atomic, value, order);
+    }
+    
+    static inline int amp_atomic_ptr_compare_exchange(amp_atomic_ptr_t* atomic,
+                                                      void** expected,
+                                                      void* desired,
+                                                      amp_memory_order_t success_order,
+                                                      amp_memory_order_t failure_order)
+    {
+        return AMP_INTERNAL_ATOMIC_COMPARE_EXCHANGE(atomic, expected, desired, success_order, failure_order) ? 1 : 0;
+    }
+    
+    
+    
+    static inline void amp_atomic_thread_fence(amp_memory_order_t order)
+    {
+        if (amp_memory_order_relaxed != order) {
+            AMP_INTERNAL_ATOMIC_THREAD_FENCE(order);
+        }
+    }
+    
+    static inline void amp_atomic_cpu_relax(void)
+    {
+#if defined(__i386__) || defined(__x86_64__)
+        __asm__ __volatile__ ("pause" ::: "memory");
+#elif defined(__aarch64__) || (defined(__arm__) && defined(__ARM_ARCH) && (__ARM_ARCH >= 7))
+        __asm__ __volatile__ ("yield" ::: "memory");
+#else
+        __asm__ __volatile__ ("" ::: "memory");
+#endif
+    }
+    
+    
+#   undef AMP_INTERNAL_ATOMIC_LOAD
+#   undef AMP_INTERNAL_ATOMIC_STORE
+#   undef AMP_INTERNAL_ATOMIC_EXCHANGE
+#   undef AMP_INTERNAL_ATOMIC_COMPARE_EXCHANGE
+#   undef AMP_INTERNAL_ATOMIC_FETCH_ADD
+#   undef AMP_INTERNAL_ATOMIC_FETCH_SUB
+#   undef AMP_INTERNAL_ATOMIC_THREAD_FENCE
+    
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* AMP_amp_raw_atomic_H */
@@ -47,6 +47,10 @@
 #if defined(AMP_USE_GENERIC_BROADCAST_BARRIERS) || defined(AMP_USE_GENERIC_SIGNAL_BARRIERS)
 #   include <amp/amp_raw_mutex.h>
 #   include <amp/amp_raw_condition_variable.h>
+#elif defined(AMP_USE_SENSE_REVERSING_BARRIERS) || defined(AMP_USE_DISSEMINATION_BARRIERS)
+#   include <stddef.h>
+#   include <amp/amp_stddef.h>
+#   include <amp/amp_atomic.h>
 #else
 #   error Unsupported backend.
 #endif
@@ -81,6 +85,40 @@ extern "C" {
         amp_barrier_count_t init_count;
         int state;
         int valid;
+#elif defined(AMP_USE_SENSE_REVERSING_BARRIERS)
+        /* Counter every arriving thread decrements, on its own cache line. */
+        amp_atomic_int_t count;
+        amp_byte_t count_padding[AMP_CACHE_LINE_SIZE - sizeof(amp_atomic_int_t)];
+        
+        /* Futex word flipped by the last arriving thread to release the 
+         * waiting threads, a flag signaling that threads might block on it,
+         * and a flag set while the last arriving thread still releases the
+         * others. All only change atomically and are only read by waiting 
+         * threads, therefore share a cache line of their own.
+         */
+        amp_atomic_int_t sense;
+        amp_atomic_int_t sleeping;
+        amp_atomic_int_t releasing;
+        amp_byte_t sense_padding[AMP_CACHE_LINE_SIZE - 3 * sizeof(amp_atomic_int_t)];
+        
+        amp_barrier_count_t init_count;
+        int valid;
+#elif defined(AMP_USE_DISSEMINATION_BARRIERS)
+        /* Arrival ticket counter on its own cache line. Every arriving thread
+         * draws a ticket that determines its index and episode.
+         */
+        amp_atomic_int_t ticket;
+        amp_byte_t ticket_padding[AMP_CACHE_LINE_SIZE - sizeof(amp_atomic_int_t)];
+        
+        /* Per thread index a cache line aligned record of round flags. */
+        amp_byte_t* flags;
+        void* flags_memory;
+        size_t flags_stride;
+        
+        amp_barrier_count_t init_count;
+        unsigned int round_count;
+        int episode_count;
+        int valid;
 #else
 #   error Unsupported backend.
 #endif
@@ -48,7 +48,9 @@
 
 
 
-#if defined(AMP_USE_PTHREADS)
+#if defined(AMP_USE_FUTEX_MUTEXES)
+#   include <amp/amp_atomic.h>
+#elif defined(AMP_USE_PTHREADS)
 #   include <pthread.h>
 #elif defined(AMP_USE_WINVISTA_CONDITION_VARIABLES)
 #   define WIN32_LEAN_AND_MEAN /* Only include streamlined windows header. */
@@ -79,7 +81,12 @@ extern "C" {
      */
     struct amp_raw_condition_variable_s
     {
-#if defined(AMP_USE_PTHREADS)
+#if defined(AMP_USE_FUTEX_MUTEXES)
+        /* Futex word incremented by every signal and broadcast. */
+        amp_atomic_int_t sequence;
+        /* Number of threads inside wait, only changed atomically. */
+        amp_atomic_int_t waiter_count;
+#elif defined(AMP_USE_PTHREADS)
         pthread_cond_t cond;
 #elif defined(AMP_USE_WINVISTA_CONDITION_VARIABLES)
         CONDITION_VARIABLE cond;
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Definition of amp_raw_future_s containing backend dependencies.
+ *
+ * @attention Don't copy or move raw futures - copying and moving pointers to
+ *            them is ok though you need to take care about ownership 
+ *            management.
+ */
+
+#ifndef AMP_amp_raw_future_H
+#define AMP_amp_raw_future_H
+
+#include <amp/amp_future.h>
+#include <amp/amp_atomic.h>
+
+#if defined(AMP_USE_FUTEX_FUTURES)
+    /* No additional includes. */
+#elif defined(AMP_USE_GENERIC_FUTURES)
+#   include <amp/amp_raw_mutex.h>
+#   include <amp/amp_raw_condition_variable.h>
+#else
+#   error Unsupported backend.
+#endif
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+    
+    
+    /**
+     * Must be initialized before usage and finalized to free reserved 
+     * resources.
+     *
+     * @attention Don't copy or move, otherwise behavior is undefined.
+     */
+    struct amp_raw_future_s {
+        /* Combination of the internal set, ready, and waiting flags. Only 
+         * change atomically.
+         */
+        amp_atomic_int_t state;
+        /* Written once by the setting thread before the ready flag. */
+        void* value;
+#if defined(AMP_USE_FUTEX_FUTURES)
+        /* state is the futex word. */
+#elif defined(AMP_USE_GENERIC_FUTURES)
+        /* Only used if threads have to block. */
+        struct amp_raw_mutex_s mutex;
+        struct amp_raw_condition_variable_s ready;
+#else
+#   error Unsupported backend.
+#endif
+    };
+    
+    
+    /**
+     * Like amp_promise_create but doesn't allocate memory. Pass the raw 
+     * future as promise and as future to the other functions.
+     */
+    int amp_raw_future_init(struct amp_raw_future_s* future);
+    
+    /**
+     * Like amp_promise_destroy but doesn't free memory.
+     */
+    int amp_raw_future_finalize(struct amp_raw_future_s* future);
+    
+    
+    
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* AMP_amp_raw_future_H */
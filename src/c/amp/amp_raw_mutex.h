@@ -50,7 +50,9 @@
 
 
 
-#if defined(AMP_USE_PTHREADS)
+#if defined(AMP_USE_FUTEX_MUTEXES)
+#   include <amp/amp_atomic.h>
+#elif defined(AMP_USE_PTHREADS)
 #   include <pthread.h>
 #elif defined(AMP_USE_WINTHREADS)
 #   define WIN32_LEAN_AND_MEAN /* Only include streamlined windows header. */
@@ -80,7 +82,12 @@ extern "C" {
      *            undefined - use pointers to an amp_raw_mutex instead.
      */
     struct amp_raw_mutex_s {
-#if defined(AMP_USE_PTHREADS)
+#if defined(AMP_USE_FUTEX_MUTEXES)
+        /* Futex word, 0 if unlocked, 1 if locked, 2 if locked and threads
+         * might be blocked on it. Only change atomically.
+         */
+        amp_atomic_int_t state;
+#elif defined(AMP_USE_PTHREADS)
         /* Don't copy or move - therefore don't copy or move amp_mutex_s. */
         pthread_mutex_t mutex;
 #elif defined(AMP_USE_WINTHREADS)
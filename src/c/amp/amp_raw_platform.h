@@ -60,6 +60,9 @@ extern "C" {
         void* allocator_context;
         amp_alloc_func_t alloc_func;
         amp_dealloc_func_t dealloc_func;
+        
+        /* Root of the file system hardware description, NULL for default. */
+        char const* filesystem_root;
     };
     
     
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Backend specific definition of amp_raw_rwlock_s and the associated init
+ * and finalize functions to enable placement of a rwlock on the stack.
+ *
+ * @attention Don't copy a variable of type amp_raw_rwlock_s - copying a 
+ *            pointer to this type is ok though.
+ */
+
+#ifndef AMP_amp_raw_rwlock_H
+#define AMP_amp_raw_rwlock_H
+
+#include <amp/amp_rwlock.h>
+
+
+
+#if defined(AMP_USE_ATOMIC_RWLOCKS)
+#   include <amp/amp_stddef.h>
+#   include <amp/amp_atomic.h>
+#   include <amp/amp_raw_mutex.h>
+#   include <amp/amp_raw_condition_variable.h>
+#elif defined(AMP_USE_PTHREADS)
+#   include <pthread.h>
+#else
+#   error Unsupported backend.
+#endif
+
+
+
+#if defined(AMP_USE_ATOMIC_RWLOCKS) && !defined(AMP_RWLOCK_READER_SLOT_COUNT)
+/**
+ * Number of cache line sized reader counters of an atomic backend rwlock.
+ * More counters make it less likely that two reading threads share one.
+ */
+#   define AMP_RWLOCK_READER_SLOT_COUNT 16
+#endif
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+    
+#if defined(AMP_USE_ATOMIC_RWLOCKS)
+    /**
+     * A reader counter padded to fill a whole cache line.
+     */
+    struct amp_raw_rwlock_reader_slot_s {
+        amp_atomic_size_t count;
+        amp_byte_t padding[AMP_CACHE_LINE_SIZE - sizeof(amp_atomic_size_t)];
+    };
+#endif
+    
+    
+    /**
+     * Reader-writer lock. Treat definition and size as opaque as these can 
+     * change without a warning in future versions of amp.
+     *
+     * @attention Don't copy or move an amp_raw_rwlock instance or behavior is
+     *            undefined - use pointers to an amp_raw_rwlock instead.
+     */
+    struct amp_raw_rwlock_s {
+#if defined(AMP_USE_ATOMIC_RWLOCKS)
+        /* Readers increment a counter when taking the read lock and decrement
+         * a counter when releasing it. Counters wrap around, only the sum of 
+         * all counters - the number of readers - is meaningful.
+         */
+        struct amp_raw_rwlock_reader_slot_s reader_slots[AMP_RWLOCK_READER_SLOT_COUNT];
+        
+        /* Number of threads waiting for or holding the write lock. Readers 
+         * only read it on their fast path.
+         */
+        amp_atomic_int_t writer_count;
+        amp_byte_t writer_count_padding[AMP_CACHE_LINE_SIZE - sizeof(amp_atomic_int_t)];
+        
+        /* Protects writer_active and waiting on the conditions. */
+        struct amp_raw_mutex_s mutex;
+        struct amp_raw_condition_variable_s writer_condition;
+        struct amp_raw_condition_variable_s reader_condition;
+        int writer_active;
+#elif defined(AMP_USE_PTHREADS)
+        /* Don't copy or move - therefore don't copy or move amp_rwlock_s. */
+        pthread_rwlock_t rwlock;
+#else
+#   error Unsupported backend.
+#endif
+    };
+    
+    
+    
+    /**
+     * Like amp_rwlock_create but does not allocate memory for the amp rwlock
+     * other than indirectly via the platform API to create a platform rwlock.
+     */
+    int amp_raw_rwlock_init(amp_rwlock_t rwlock);
+    
+    /**
+     * Like amp_rwlock_destroy but does not free memory for the amp rwlock
+     * other than indirectly via the platform API to destroy a platform rwlock.
+     */
+    int amp_raw_rwlock_finalize(amp_rwlock_t rwlock);
+    
+    
+    
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* AMP_amp_raw_rwlock_H */
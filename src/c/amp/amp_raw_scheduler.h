@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Definition of amp_raw_scheduler_group_s and the associated init and 
+ * finalize functions to enable placement of a scheduler group on the stack,
+ * e.g. in every task of a recursive computation.
+ */
+
+#ifndef AMP_amp_raw_scheduler_H
+#define AMP_amp_raw_scheduler_H
+
+#include <amp/amp_scheduler.h>
+#include <amp/amp_atomic.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+    
+    /**
+     * Group of tasks. Treat definition and size as opaque as these can 
+     * change without a warning in future versions of amp.
+     *
+     * @attention Don't copy or move a group while tasks are counted in it.
+     */
+    struct amp_raw_scheduler_group_s {
+        /* Spawned but unfinished tasks. */
+        amp_atomic_size_t pending_count;
+    };
+    
+    
+    /**
+     * Like amp_scheduler_group_create but doesn't allocate memory.
+     */
+    int amp_raw_scheduler_group_init(amp_scheduler_group_t group);
+    
+    /**
+     * Like amp_scheduler_group_destroy but doesn't free memory.
+     */
+    int amp_raw_scheduler_group_finalize(amp_scheduler_group_t group);
+    
+    
+    
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* AMP_amp_raw_scheduler_H */
@@ -68,6 +68,9 @@
 #elif defined(AMP_USE_LIBDISPATCH_SEMAPHORES)
 #   include <dispatch/dispatch.h>
 #   include <limits.h>
+#elif defined(AMP_USE_FUTEX_SEMAPHORES)
+#   include <limits.h>
+#   include <amp/amp_atomic.h>
 #elif defined(AMP_USE_PTHREADS)
 #   include <pthread.h>
 #   include <limits.h>
@@ -97,6 +100,8 @@ extern "C" {
     typedef unsigned int amp_raw_semaphore_counter_t;
 #elif defined(AMP_USE_LIBDISPATCH_SEMAPHORES)
     typedef long amp_raw_semaphore_counter_t;
+#elif defined(AMP_USE_FUTEX_SEMAPHORES)
+    typedef int amp_raw_semaphore_counter_t;
 #elif defined(AMP_USE_PTHREADS)
     typedef unsigned int amp_raw_semaphore_counter_t;
 #elif defined(AMP_USE_WINTHREADS)
@@ -118,6 +123,8 @@ extern "C" {
 #   define AMP_RAW_SEMAPHORE_COUNT_MAX ((amp_raw_semaphore_counter_t)(SEM_VALUE_MAX))
 #elif defined(AMP_USE_LIBDISPATCH_SEMAPHORES)
 #   define AMP_RAW_SEMAPHORE_COUNT_MAX ((amp_raw_semaphore_counter_t)(LONG_MAX))
+#elif defined(AMP_USE_FUTEX_SEMAPHORES)
+#   define AMP_RAW_SEMAPHORE_COUNT_MAX ((amp_raw_semaphore_counter_t)(INT_MAX))
 #elif defined(AMP_USE_PTHREADS)
 #   define AMP_RAW_SEMAPHORE_COUNT_MAX ((amp_raw_semaphore_counter_t)(LONG_MAX))
 #elif defined(AMP_USE_WINTHREADS)
@@ -138,6 +145,11 @@ extern "C" {
         sem_t semaphore;
 #elif defined(AMP_USE_LIBDISPATCH_SEMAPHORES)
         dispatch_semaphore_t semaphore;
+#elif defined(AMP_USE_FUTEX_SEMAPHORES)
+        /* Semaphore count, negative if threads wait. Only change atomically. */
+        amp_atomic_int_t count;
+        /* Futex word counting wake ups handed to waiting threads. */
+        amp_atomic_int_t wake_count;
 #elif defined(AMP_USE_PTHREADS)
         pthread_mutex_t mutex;
         pthread_cond_t a_thread_can_pass;
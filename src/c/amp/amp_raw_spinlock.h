@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Backend specific definition of amp spinlock to allow placing a spinlock 
+ * inside other data structures.
+ *
+ * @attention Don't copy a variable of type amp_raw_spinlock_s - copying a 
+ *            pointer to this type is ok though.
+ */
+
+#ifndef AMP_amp_raw_spinlock_H
+#define AMP_amp_raw_spinlock_H
+
+#include <amp/amp_spinlock.h>
+
+
+
+#if defined(AMP_USE_TTAS_SPINLOCKS) || defined(AMP_USE_TICKET_SPINLOCKS) || defined(AMP_USE_MCS_SPINLOCKS)
+#   include <amp/amp_atomic.h>
+#else
+#   error Unsupported backend.
+#endif
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+    
+    /**
+     * Treat definition and size as opaque as these can change without a 
+     * warning in future versions of amp.
+     *
+     * @attention Don't copy or move an amp_raw_spinlock instance or behavior 
+     *            is undefined.
+     */
+    struct amp_raw_spinlock_s {
+#if defined(AMP_USE_TTAS_SPINLOCKS)
+        /* 0 if unlocked, 1 if locked. */
+        amp_atomic_int_t state;
+#elif defined(AMP_USE_TICKET_SPINLOCKS)
+        /* Ticket drawn by the next arriving thread and the ticket of the 
+         * thread allowed to hold the lock. The lock is free if both are
+         * equal.
+         */
+        amp_atomic_int_t next_ticket;
+        amp_atomic_int_t now_serving;
+#elif defined(AMP_USE_MCS_SPINLOCKS)
+        /* The lock doubles as the queue node of its holder and waiting 
+         * threads use a node of the same type on their stack. For the lock
+         * tail points to the last node in the queue (NULL if unlocked) and 
+         * next to the first waiting node. For a waiting node tail is a 
+         * waiting marker until the lock is handed to it.
+         */
+        amp_atomic_ptr_t tail;
+        amp_atomic_ptr_t next;
+#else
+#   error Unsupported backend.
+#endif
+    };
+    
+    
+    
+    /**
+     * Like amp_spinlock_create but does not allocate memory.
+     */
+    int amp_raw_spinlock_init(amp_spinlock_t spinlock);
+    
+    /**
+     * Like amp_spinlock_destroy but does not free memory.
+     */
+    int amp_raw_spinlock_finalize(amp_spinlock_t spinlock);
+    
+    
+    
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* AMP_amp_raw_spinlock_H */
@@ -78,6 +78,10 @@ extern "C" {
 #elif defined(AMP_USE_WINTHREADS)
         HANDLE thread_handle;
         DWORD thread_id;
+        /* Set before resuming a suspended thread that mustn't run its 
+         * function because configuring it failed.
+         */
+        int launch_cancelled;
 #else
 #   error Unsupported platform.        
 #endif
@@ -91,15 +95,18 @@ extern "C" {
         amp_thread_func_t func;
         void *func_context;
         
-        /* Reserved to store the allocator context and dealloc function to
-         * store for automatic memory freeing when thread detaching is 
-         * implemented.
+        /* Stack size, guard size and optional caller-owned stack memory to
+         * create the thread with. The caller keeps ownership of the memory.
          */
-        uintptr_t reserved0;
-        uintptr_t reserved1;
+        struct amp_thread_stack_s stack;
         
         struct amp_native_thread_s native_thread_description;
         
+        /* CPUs the thread is pinned to when launched, empty if the operating
+         * system should decide.
+         */
+        struct amp_thread_affinity_s affinity;
+        
         /**
          * TODO: @todo The moment the amp atomic operations are ready make it
          *             an atomically changed flag that is queryable. Currently
@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Non-recursive reader-writer lock which lets many threads read shared data
+ * concurrently while writers get exclusive access.
+ *
+ * amp_rwlock_t is used like amp_mutex_t but offers two kinds of locks. 
+ * Any number of threads can hold the read lock at the same time as long as 
+ * no thread holds the write lock. Only one thread can hold the write lock and
+ * while it holds it no other thread holds the read or the write lock. Use it 
+ * to protect data that is read often and changed rarely, e.g. a lookup table
+ * that is read on every request and updated a few times per minute.
+ *
+ * Writers are preferred: as soon as a thread waits to write no new reader 
+ * gets the read lock, so a steady stream of readers can't starve writers. 
+ * The Pthreads backend only prefers writers on glibc, other Pthreads 
+ * implementations choose their own policy.
+ *
+ * Select one of the following backends at build time:
+ * - The default Pthreads backend wraps pthread_rwlock_t.
+ * - AMP_USE_ATOMIC_RWLOCKS selects a backend in which readers count 
+ *   themselves in one of several reader counters, each on its own cache line. 
+ *   Taking and releasing an uncontended read lock only modifies the counter
+ *   picked by the reading thread and reads the writer state, so readers 
+ *   on different processors don't fight over a shared cache line.
+ *   Writers and readers that need to wait block on an amp mutex and 
+ *   condition variable.
+ *
+ * All functions return return codes. Don't enter the critical section if the
+ * return code isn't AMP_SUCCESS.
+ *
+ * @attention A thread must not lock a rwlock it already holds - neither to 
+ *            read nor to write - or it might deadlock. Because writers are 
+ *            preferred a recursive read lock deadlocks as soon as a writer
+ *            waits.
+ *
+ * @attention If a thread that isn't holding the corresponding lock tries to 
+ *            unlock it behavior is undefined.
+ *
+ * @attention If a invalid rwlock is passed to any function behavior is 
+ *            undefined. Never pass an uninitialized (or after initialization
+ *            finalized) rwlock to any function other than amp_rwlock_create.
+ *            Never pass an initialized rwlock to amp_rwlock_create.
+ */
+
+#ifndef AMP_amp_rwlock_H
+#define AMP_amp_rwlock_H
+
+#include <stddef.h>
+
+#include <amp/amp_memory.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+    
+#define AMP_RWLOCK_UNINITIALIZED NULL
+    
+    
+    /**
+     * Non-recursive reader-writer lock.
+     * See amp_raw_rwlock_s.
+     * Can be moved or copied - but every copy identifies the same rwlock - 
+     * manage ownership and reference counts yourself.
+     */
+    typedef struct amp_raw_rwlock_s *amp_rwlock_t;
+    
+    
+    
+    /**
+     * Allocates and initializes an amp_rwlock_t before using it.
+     *
+     * If the initialization fails the allocator is called to free the
+     * already allocated memory which must not result in an error or otherwise
+     * behavior is undefined.
+     *
+     * @return AMP_SUCCESS is returned on successful initialization of rwlock.
+     *         AMP_NOMEM is returned if memory is insufficient.
+     *         AMP_ERROR is returned if the system temporarily has insufficent 
+     *         resources.
+     */
+    int amp_rwlock_create(amp_rwlock_t* rwlock,
+                          amp_allocator_t allocator);
+    
+    /**
+     * Finalizes the rwlock and frees its memory and platform resources.
+     *
+     * allocator must be capable of freeing the memory allocated via the 
+     * create function otherwise behavior is undefined and resources might 
+     * be leaked.
+     *
+     * @return AMP_SUCCESS on successful destruction of the rwlock.
+     *         AMP_BUSY if a thread holds or waits for the rwlock. This is 
+     *         a programming error and must not happen in release code.
+     *
+     * @attention Only call for successfully initialized rwlocks which no 
+     *            thread holds or waits for, otherwise behavior is undefined.
+     */
+    int amp_rwlock_destroy(amp_rwlock_t* rwlock,
+                           amp_allocator_t allocator);
+    
+    /**
+     * Takes the read lock or, if a thread holds or waits for the write lock,
+     * blocks until the read lock can be taken.
+     *
+     * @return AMP_SUCCESS is returned if locking is successful.
+     *         AMP_ERROR if the rwlock is invalid or if the maximum number
+     *         of readers the backend supports has been reached.
+     */
+    int amp_rwlock_read_lock(amp_rwlock_t rwlock);
+    
+    /**
+     * Takes the read lock or, if a thread holds or waits for the write lock,
+     * returns AMP_BUSY without taking it.
+     *
+     * @return AMP_SUCCESS if the read lock has been taken.
+     *         AMP_BUSY if the read lock hasn't been taken.
+     *         AMP_ERROR if the rwlock is invalid.
+     */
+    int amp_rwlock_read_trylock(amp_rwlock_t rwlock);
+    
+    /**
+     * Releases a read lock held by the calling thread. If it was the last 
+     * reader a waiting writer can take the write lock.
+     *
+     * @return AMP_SUCCESS after successful unlocking.
+     *         AMP_ERROR might be returned if the calling thread doesn't hold
+     *         the read lock.
+     */
+    int amp_rwlock_read_unlock(amp_rwlock_t rwlock);
+    
+    /**
+     * Takes the write lock or, if other threads hold the read or the write 
+     * lock, blocks until it can be taken. From the moment the calling thread
+     * waits no new readers are let in.
+     *
+     * @return AMP_SUCCESS is returned if locking is successful.
+     *         AMP_ERROR if the rwlock is invalid or if the calling thread 
+     *         already holds the write lock.
+     */
+    int amp_rwlock_write_lock(amp_rwlock_t rwlock);
+    
+    /**
+     * Takes the write lock or, if other threads hold the read or the write 
+     * lock, returns AMP_BUSY without taking it.
+     *
+     * @return AMP_SUCCESS if the write lock has been taken.
+     *         AMP_BUSY if the write lock hasn't been taken.
+     *         AMP_ERROR if the rwlock is invalid.
+     */
+    int amp_rwlock_write_trylock(amp_rwlock_t rwlock);
+    
+    /**
+     * Releases the write lock held by the calling thread. Waiting writers 
+     * are served before waiting readers.
+     *
+     * @return AMP_SUCCESS after successful unlocking.
+     *         AMP_ERROR might be returned if the calling thread doesn't hold
+     *         the write lock.
+     */
+    int amp_rwlock_write_unlock(amp_rwlock_t rwlock);
+    
+    
+    
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+    
+
+#endif /* AMP_amp_rwlock_H */
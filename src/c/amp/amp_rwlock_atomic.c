@@ -0,0 +1,410 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Writer preferring rwlock backend in which readers count themselves in 
+ * cache line sized reader slots. Selected by defining AMP_USE_ATOMIC_RWLOCKS.
+ *
+ * A reader increments the slot picked from its stack address and then checks
+ * the writer count. If no writer holds or waits for the lock the reader 
+ * holds the read lock, otherwise it takes its increment back and waits.
+ * A writer first increments the writer count, which stops new readers, and 
+ * then waits until the sum of all reader slots drops to zero. Both sides use
+ * sequentially consistent operations so either the reader sees the writer 
+ * or the writer sees the reader.
+ *
+ * Waiting threads block on an amp mutex and two condition variables. 
+ * Readers leaving while a writer is around wake writers, the last writer 
+ * leaving wakes readers. The mutex is never held while a thread is inside 
+ * the read or write critical section.
+ *
+ * amp_rwlock_create and amp_rwlock_destroy are implemented in 
+ * amp_rwlock_common.c.
+ */
+
+#include "amp_rwlock.h"
+
+#include <assert.h>
+#include <stddef.h>
+
+#include "amp_stdint.h"
+#include "amp_return_code.h"
+#include "amp_atomic.h"
+#include "amp_mutex.h"
+#include "amp_condition_variable.h"
+#include "amp_raw_rwlock.h"
+
+
+
+#if !defined(AMP_USE_ATOMIC_RWLOCKS)
+#   error Build configuration problem - this source file shouldn't be compiled.
+#endif
+
+
+
+/**
+ * Granularity of stack addresses mapped to one reader slot. Threads run on 
+ * different stacks that are larger than this, a thread itself mostly stays
+ * inside one region.
+ */
+#define AMP_INTERNAL_RWLOCK_STACK_REGION_SHIFT 16
+
+
+
+/**
+ * Picks the reader slot of the calling thread from the address of a local 
+ * variable. A thread might pick another slot to release a read lock than it 
+ * picked to take it, e.g. if it is called from a deeper stack frame, which
+ * is fine as only the sum of all slots is meaningful.
+ */
+static size_t amp_internal_rwlock_reader_slot_index(void)
+{
+    unsigned char stack_marker = 0;
+    uintptr_t region = ((uintptr_t)&stack_marker) >> AMP_INTERNAL_RWLOCK_STACK_REGION_SHIFT;
+    
+    /* Stacks of threads are usually spaced by a power of two, fold higher
+     * bits in to spread them across the slots.
+     */
+    region ^= region >> 7;
+    region ^= region >> 13;
+    
+    return (size_t)(region % AMP_RWLOCK_READER_SLOT_COUNT);
+}
+
+
+/**
+ * Returns the number of threads holding or trying to take the read lock.
+ * Slots wrap around and the sum wraps back.
+ */
+static size_t amp_internal_rwlock_reader_count(amp_rwlock_t rwlock)
+{
+    size_t reader_count = 0;
+    size_t i = 0;
+    
+    for (i = 0; i < AMP_RWLOCK_READER_SLOT_COUNT; ++i) {
+        reader_count += amp_atomic_size_load(&rwlock->reader_slots[i].count,
+                                             amp_memory_order_seq_cst);
+    }
+    
+    return reader_count;
+}
+
+
+/**
+ * Takes back the reader count increment of slot_index and wakes a writer 
+ * that might wait for the readers to leave.
+ */
+static void amp_internal_rwlock_leave_reader_slot(amp_rwlock_t rwlock,
+                                                  size_t slot_index)
+{
+    int retval = AMP_UNSUPPORTED;
+    
+    (void)amp_atomic_size_fetch_sub(&rwlock->reader_slots[slot_index].count,
+                                    1,
+                                    amp_memory_order_seq_cst);
+    
+    if (0 != amp_atomic_int_load(&rwlock->writer_count, amp_memory_order_seq_cst)) {
+        retval = amp_mutex_lock(&rwlock->mutex);
+        assert(AMP_SUCCESS == retval);
+        {
+            retval = amp_condition_variable_broadcast(&rwlock->writer_condition);
+            assert(AMP_SUCCESS == retval);
+        }
+        retval = amp_mutex_unlock(&rwlock->mutex);
+        assert(AMP_SUCCESS == retval);
+    }
+    
+    (void)retval;
+}
+
+
+/**
+ * Called with the mutex locked by the writer that just released the write 
+ * lock or failed to take it. Decrements the writer count and wakes the
+ * waiting readers if it was the last writer, or the waiting writers 
+ * otherwise.
+ */
+static void amp_internal_rwlock_leave_writer(amp_rwlock_t rwlock)
+{
+    int retval = AMP_UNSUPPORTED;
+    int const previous_writer_count = amp_atomic_int_fetch_sub(&rwlock->writer_count,
+                                                               1,
+                                                               amp_memory_order_seq_cst);
+    assert(0 < previous_writer_count);
+    
+    if (1 == previous_writer_count) {
+        retval = amp_condition_variable_broadcast(&rwlock->reader_condition);
+    } else {
+        retval = amp_condition_variable_broadcast(&rwlock->writer_condition);
+    }
+    assert(AMP_SUCCESS == retval);
+    (void)retval;
+}
+
+
+
+int amp_raw_rwlock_init(amp_rwlock_t rwlock)
+{
+    int retval = AMP_UNSUPPORTED;
+    size_t i = 0;
+    
+    assert(NULL != rwlock);
+    
+    retval = amp_raw_mutex_init(&rwlock->mutex);
+    if (AMP_SUCCESS != retval) {
+        return retval;
+    }
+    
+    retval = amp_raw_condition_variable_init(&rwlock->writer_condition);
+    if (AMP_SUCCESS != retval) {
+        int const rc = amp_raw_mutex_finalize(&rwlock->mutex);
+        assert(AMP_SUCCESS == rc);
+        (void)rc;
+        
+        return retval;
+    }
+    
+    retval = amp_raw_condition_variable_init(&rwlock->reader_condition);
+    if (AMP_SUCCESS != retval) {
+        int rc = amp_raw_condition_variable_finalize(&rwlock->writer_condition);
+        assert(AMP_SUCCESS == rc);
+        
+        rc = amp_raw_mutex_finalize(&rwlock->mutex);
+        assert(AMP_SUCCESS == rc);
+        (void)rc;
+        
+        return retval;
+    }
+    
+    for (i = 0; i < AMP_RWLOCK_READER_SLOT_COUNT; ++i) {
+        amp_atomic_size_store(&rwlock->reader_slots[i].count,
+                              0,
+                              amp_memory_order_relaxed);
+    }
+    amp_atomic_int_store(&rwlock->writer_count, 0, amp_memory_order_relaxed);
+    rwlock->writer_active = 0;
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_raw_rwlock_finalize(amp_rwlock_t rwlock)
+{
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != rwlock);
+    
+    if ((0 != amp_atomic_int_load(&rwlock->writer_count, amp_memory_order_seq_cst))
+        || (0 != amp_internal_rwlock_reader_count(rwlock))) {
+        
+        return AMP_BUSY;
+    }
+    
+    retval = amp_raw_condition_variable_finalize(&rwlock->reader_condition);
+    assert(AMP_SUCCESS == retval);
+    
+    retval = amp_raw_condition_variable_finalize(&rwlock->writer_condition);
+    assert(AMP_SUCCESS == retval);
+    
+    retval = amp_raw_mutex_finalize(&rwlock->mutex);
+    assert(AMP_SUCCESS == retval);
+    
+    return retval;
+}
+
+
+
+int amp_rwlock_read_lock(amp_rwlock_t rwlock)
+{
+    int retval = AMP_UNSUPPORTED;
+    size_t const slot_index = amp_internal_rwlock_reader_slot_index();
+    
+    assert(NULL != rwlock);
+    
+    for (;;) {
+        (void)amp_atomic_size_fetch_add(&rwlock->reader_slots[slot_index].count,
+                                        1,
+                                        amp_memory_order_seq_cst);
+        
+        if (0 == amp_atomic_int_load(&rwlock->writer_count, amp_memory_order_seq_cst)) {
+            return AMP_SUCCESS;
+        }
+        
+        /* A writer holds or waits for the lock - step back and wait until
+         * all writers left.
+         */
+        amp_internal_rwlock_leave_reader_slot(rwlock, slot_index);
+        
+        retval = amp_mutex_lock(&rwlock->mutex);
+        assert(AMP_SUCCESS == retval);
+        {
+            while (0 != amp_atomic_int_load(&rwlock->writer_count, amp_memory_order_seq_cst)) {
+                retval = amp_condition_variable_wait(&rwlock->reader_condition,
+                                                     &rwlock->mutex);
+                assert(AMP_SUCCESS == retval);
+            }
+        }
+        retval = amp_mutex_unlock(&rwlock->mutex);
+        assert(AMP_SUCCESS == retval);
+    }
+}
+
+
+
+int amp_rwlock_read_trylock(amp_rwlock_t rwlock)
+{
+    size_t const slot_index = amp_internal_rwlock_reader_slot_index();
+    
+    assert(NULL != rwlock);
+    
+    (void)amp_atomic_size_fetch_add(&rwlock->reader_slots[slot_index].count,
+                                    1,
+                                    amp_memory_order_seq_cst);
+    
+    if (0 == amp_atomic_int_load(&rwlock->writer_count, amp_memory_order_seq_cst)) {
+        return AMP_SUCCESS;
+    }
+    
+    amp_internal_rwlock_leave_reader_slot(rwlock, slot_index);
+    
+    return AMP_BUSY;
+}
+
+
+
+int amp_rwlock_read_unlock(amp_rwlock_t rwlock)
+{
+    assert(NULL != rwlock);
+    
+    amp_internal_rwlock_leave_reader_slot(rwlock, 
+                                          amp_internal_rwlock_reader_slot_index());
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_rwlock_write_lock(amp_rwlock_t rwlock)
+{
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != rwlock);
+    
+    /* Stop new readers from entering before waiting for other writers. */
+    (void)amp_atomic_int_fetch_add(&rwlock->writer_count, 
+                                   1, 
+                                   amp_memory_order_seq_cst);
+    
+    retval = amp_mutex_lock(&rwlock->mutex);
+    assert(AMP_SUCCESS == retval);
+    {
+        while (0 != rwlock->writer_active) {
+            retval = amp_condition_variable_wait(&rwlock->writer_condition,
+                                                 &rwlock->mutex);
+            assert(AMP_SUCCESS == retval);
+        }
+        rwlock->writer_active = 1;
+        
+        while (0 != amp_internal_rwlock_reader_count(rwlock)) {
+            retval = amp_condition_variable_wait(&rwlock->writer_condition,
+                                                 &rwlock->mutex);
+            assert(AMP_SUCCESS == retval);
+        }
+    }
+    retval = amp_mutex_unlock(&rwlock->mutex);
+    assert(AMP_SUCCESS == retval);
+    
+    return retval;
+}
+
+
+
+int amp_rwlock_write_trylock(amp_rwlock_t rwlock)
+{
+    int retval = AMP_UNSUPPORTED;
+    int lock_result = AMP_BUSY;
+    
+    assert(NULL != rwlock);
+    
+    retval = amp_mutex_lock(&rwlock->mutex);
+    assert(AMP_SUCCESS == retval);
+    {
+        if (0 == rwlock->writer_active) {
+            
+            (void)amp_atomic_int_fetch_add(&rwlock->writer_count, 
+                                           1, 
+                                           amp_memory_order_seq_cst);
+            
+            if (0 == amp_internal_rwlock_reader_count(rwlock)) {
+                rwlock->writer_active = 1;
+                lock_result = AMP_SUCCESS;
+            } else {
+                /* Readers might have stepped back and wait for us. */
+                amp_internal_rwlock_leave_writer(rwlock);
+            }
+        }
+    }
+    retval = amp_mutex_unlock(&rwlock->mutex);
+    assert(AMP_SUCCESS == retval);
+    (void)retval;
+    
+    return lock_result;
+}
+
+
+
+int amp_rwlock_write_unlock(amp_rwlock_t rwlock)
+{
+    int retval = AMP_UNSUPPORTED;
+    int unlock_result = AMP_SUCCESS;
+    
+    assert(NULL != rwlock);
+    
+    retval = amp_mutex_lock(&rwlock->mutex);
+    assert(AMP_SUCCESS == retval);
+    {
+        if (0 != rwlock->writer_active) {
+            rwlock->writer_active = 0;
+            amp_internal_rwlock_leave_writer(rwlock);
+        } else {
+            unlock_result = AMP_ERROR;
+        }
+    }
+    retval = amp_mutex_unlock(&rwlock->mutex);
+    assert(AMP_SUCCESS == retval);
+    (void)retval;
+    
+    return unlock_result;
+}
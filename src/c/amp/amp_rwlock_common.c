@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation shared by all amp rwlock backends.
+ */
+
+#include "amp_rwlock.h"
+
+#include <assert.h>
+#include <stddef.h>
+
+#include "amp_return_code.h"
+#include "amp_internal_memory.h"
+#include "amp_raw_rwlock.h"
+
+
+
+int amp_rwlock_create(amp_rwlock_t* rwlock,
+                      amp_allocator_t allocator)
+{
+    amp_rwlock_t tmp_rwlock = AMP_RWLOCK_UNINITIALIZED;
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != rwlock);
+    assert(NULL != allocator);
+    
+    tmp_rwlock = (amp_rwlock_t)AMP_INTERNAL_PRIMITIVE_ALLOC(allocator,
+                                                            sizeof(*tmp_rwlock));
+    if (NULL == tmp_rwlock) {
+        return AMP_NOMEM;
+    }
+ 
+    retval = amp_raw_rwlock_init(tmp_rwlock);
+    if (AMP_SUCCESS == retval) {
+        *rwlock = tmp_rwlock;
+    } else {
+        int const rc = AMP_INTERNAL_PRIMITIVE_DEALLOC(allocator,
+                                                      tmp_rwlock);
+        assert(AMP_SUCCESS == rc);
+        (void)rc;
+    }
+    
+    return retval;
+}
+
+
+
+int amp_rwlock_destroy(amp_rwlock_t* rwlock,
+                       amp_allocator_t allocator)
+{
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != rwlock);
+    assert(NULL != *rwlock);
+    assert(NULL != allocator);
+    
+    retval = amp_raw_rwlock_finalize(*rwlock);
+    if (AMP_SUCCESS == retval) {
+        retval = AMP_INTERNAL_PRIMITIVE_DEALLOC(allocator,
+                                                *rwlock);
+        assert(AMP_SUCCESS == retval);
+        if (AMP_SUCCESS == retval) {
+            *rwlock = AMP_RWLOCK_UNINITIALIZED;
+        }
+    }
+    
+    return retval;
+}
+
+
@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Shallow raw wrapper around the Pthread rwlock primitive. Used when 
+ * AMP_USE_PTHREADS is defined and AMP_USE_ATOMIC_RWLOCKS isn't.
+ *
+ * On glibc the rwlock is configured to prefer writers, other Pthreads 
+ * implementations use their default policy.
+ */
+
+/* Needed for pthread_rwlockattr_setkind_np. Must be defined before any 
+ * system header is included.
+ */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#   define _GNU_SOURCE
+#endif
+
+#include "amp_rwlock.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+
+#include "amp_return_code.h"
+#include "amp_raw_rwlock.h"
+
+
+
+#if !defined(AMP_USE_PTHREADS) || defined(AMP_USE_ATOMIC_RWLOCKS)
+#   error Build configuration problem - this source file shouldn't be compiled.
+#endif
+
+
+
+int amp_raw_rwlock_init(amp_rwlock_t rwlock)
+{
+    assert(NULL != rwlock);
+    
+    pthread_rwlockattr_t rwlock_attributes;
+    int retval = pthread_rwlockattr_init(&rwlock_attributes);
+    if (0 != retval) {
+        if (ENOMEM == retval) {
+            return AMP_NOMEM;
+        } else {
+            return AMP_ERROR;
+        }
+    }
+    
+    /* glibc prefers readers by default and only honors writer preference
+     * for non-recursive read locking which is what amp_rwlock documents.
+     */
+#if defined(__GLIBC__)
+    retval = pthread_rwlockattr_setkind_np(&rwlock_attributes,
+                                           PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+    assert(0 == retval);
+#endif
+    
+    /* Might generate EAGAIN or ENOMEM errors which are handed back to the 
+     * caller. EPERM, EBUSY, and EINVAL error codes are programming errors.
+     */
+    retval = pthread_rwlock_init(&rwlock->rwlock, &rwlock_attributes);
+    switch (retval) {
+        case 0:
+            /* retval is already equal to AMP_SUCCESS */
+            break;
+        case ENOMEM:
+            /* retval is already equal to AMP_NOMEM */
+            break;
+        case EAGAIN:
+            retval = AMP_ERROR;
+            break;
+        default: /* EPERM, EBUSY, EINVAL - programming error */
+            assert(0);
+            retval = AMP_ERROR;
+    }
+    
+    int const rwattr_destroy_retval = pthread_rwlockattr_destroy(&rwlock_attributes);
+    assert(0 == rwattr_destroy_retval);
+    (void)rwattr_destroy_retval;
+    
+    return retval;
+}
+
+
+
+int amp_raw_rwlock_finalize(amp_rwlock_t rwlock)
+{
+    assert(NULL != rwlock);
+    
+    int retval = pthread_rwlock_destroy(&rwlock->rwlock);
+    switch (retval) {
+        case 0:
+            /* retval is already equal to AMP_SUCCESS */
+            break;
+        case EBUSY:
+            /* retval is already equal to AMP_BUSY */
+            break;
+        default: /* EINVAL - programming error */
+            assert(0);
+            retval = AMP_ERROR;
+    }
+    
+    return retval;
+}
+
+
+
+int amp_rwlock_read_lock(amp_rwlock_t rwlock)
+{
+    assert(NULL != rwlock);
+    
+    int retval = pthread_rwlock_rdlock(&rwlock->rwlock);
+    if (0 != retval) {
+        /* EAGAIN if the maximum number of readers is reached, EDEADLK and 
+         * EINVAL are programming errors.
+         */
+        assert(EAGAIN == retval);
+        retval = AMP_ERROR;
+    }
+    
+    return retval;
+}
+
+
+
+int amp_rwlock_read_trylock(amp_rwlock_t rwlock)
+{
+    assert(NULL != rwlock);
+    
+    int retval = pthread_rwlock_tryrdlock(&rwlock->rwlock);
+    switch (retval) {
+        case 0:
+            /* retval is already equal to AMP_SUCCESS */
+            break;
+        case EBUSY:
+            /* retval is already equal to AMP_BUSY */
+            break;
+        case EAGAIN:
+            retval = AMP_ERROR;
+            break;
+        default: /* EINVAL - programming error */
+            assert(0);
+            retval = AMP_ERROR;
+    }
+    
+    return retval;
+}
+
+
+
+int amp_rwlock_read_unlock(amp_rwlock_t rwlock)
+{
+    assert(NULL != rwlock);
+    
+    int retval = pthread_rwlock_unlock(&rwlock->rwlock);
+    if (0 != retval) {
+        assert(0); /* Programming error */
+        retval = AMP_ERROR;
+    }
+    
+    return retval;
+}
+
+
+
+int amp_rwlock_write_lock(amp_rwlock_t rwlock)
+{
+    assert(NULL != rwlock);
+    
+    int retval = pthread_rwlock_wrlock(&rwlock->rwlock);
+    if (0 != retval) {
+        assert(0); /* EDEADLK, EINVAL - programming error */
+        retval = AMP_ERROR;
+    }
+    
+    return retval;
+}
+
+
+
+int amp_rwlock_write_trylock(amp_rwlock_t rwlock)
+{
+    assert(NULL != rwlock);
+    
+    int retval = pthread_rwlock_trywrlock(&rwlock->rwlock);
+    switch (retval) {
+        case 0:
+            /* retval is already equal to AMP_SUCCESS */
+            break;
+        case EBUSY:
+            /* retval is already equal to AMP_BUSY */
+            break;
+        default: /* EINVAL - programming error */
+            assert(0);
+            retval = AMP_ERROR;
+    }
+    
+    return retval;
+}
+
+
+
+int amp_rwlock_write_unlock(amp_rwlock_t rwlock)
+{
+    assert(NULL != rwlock);
+    
+    int retval = pthread_rwlock_unlock(&rwlock->rwlock);
+    if (0 != retval) {
+        assert(0); /* Programming error */
+        retval = AMP_ERROR;
+    }
+    
+    return retval;
+}
@@ -0,0 +1,1119 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of the amp work-stealing scheduler.
+ *
+ * The deques follow "Correct and Efficient Work-Stealing for Weak Memory 
+ * Models" by Le, Pop, Cohen, and Zappa Nardelli. The owner pushes and pops
+ * at bottom, thieves advance top with a compare-and-swap, and only taking
+ * the last task races between owner and thieves. Indices start at 1 so the
+ * owner can decrement bottom of an empty deque without wrapping around. 
+ * A full deque grows into an array of twice the capacity; retired arrays 
+ * might still be read by thieves and are freed when the scheduler is 
+ * destroyed.
+ *
+ * Task records are cached per worker. A worker allocates records from its 
+ * own cache and the worker running a task returns the record to the cache of
+ * the allocating worker - directly if it is the same worker, otherwise by 
+ * pushing it onto the allocating worker's returned_tasks list which the 
+ * owner takes over as a whole when its cache runs empty.
+ *
+ * Idle workers register in sleeping_count, check for tasks once more and 
+ * wait on the parking semaphore. Spawning a task checks sleeping_count and 
+ * signals the semaphore for one registered worker. Both sides separate their
+ * store from the following load with a sequentially consistent fence so 
+ * either the spawner sees the sleeping worker or the worker sees the task.
+ *
+ * Root tasks come from threads that aren't workers. They live on the stack
+ * of amp_scheduler_run and reach the workers through a mutex protected 
+ * injection queue.
+ */
+
+#include "amp_scheduler.h"
+
+#include <assert.h>
+#include <stddef.h>
+
+#include "amp_stddef.h"
+#include "amp_return_code.h"
+#include "amp_atomic.h"
+#include "amp_platform.h"
+#include "amp_thread.h"
+#include "amp_thread_array.h"
+#include "amp_thread_local_slot.h"
+#include "amp_semaphore.h"
+#include "amp_mutex.h"
+#include "amp_condition_variable.h"
+#include "amp_raw_scheduler.h"
+
+
+
+#if !defined(AMP_SCHEDULER_DEQUE_INITIAL_CAPACITY)
+/**
+ * Number of tasks a worker deque holds before it grows the first time. 
+ * Must be a power of two.
+ */
+#   define AMP_SCHEDULER_DEQUE_INITIAL_CAPACITY 256
+#endif
+
+#if !defined(AMP_SCHEDULER_TASK_CHUNK_SIZE)
+/**
+ * Number of task records a worker allocates at once when its cache is empty.
+ */
+#   define AMP_SCHEDULER_TASK_CHUNK_SIZE 256
+#endif
+
+#if !defined(AMP_SCHEDULER_IDLE_SPIN_COUNT)
+/**
+ * Number of unsuccessful rounds of looking for tasks after which an idle 
+ * worker parks, or after which a worker waiting for a group starts yielding
+ * the processor between rounds.
+ */
+#   define AMP_SCHEDULER_IDLE_SPIN_COUNT 64
+#endif
+
+
+
+struct amp_internal_scheduler_worker_s;
+
+
+struct amp_internal_scheduler_task_s {
+    amp_thread_func_t func;
+    void* context;
+    amp_scheduler_group_t group;
+    /* Worker whose cache the record returns to, NULL for root tasks. */
+    struct amp_internal_scheduler_worker_s* owner;
+    /* Links records in task caches and in the injection queue. */
+    struct amp_internal_scheduler_task_s* next;
+    /* Only used by root tasks, protected by the scheduler mutex. */
+    int done;
+};
+
+
+struct amp_internal_scheduler_task_chunk_s {
+    struct amp_internal_scheduler_task_chunk_s* next;
+    struct amp_internal_scheduler_task_s tasks[AMP_SCHEDULER_TASK_CHUNK_SIZE];
+};
+
+
+struct amp_internal_scheduler_deque_array_s {
+    /* Smaller array this one replaced, freed when the scheduler is destroyed. */
+    struct amp_internal_scheduler_deque_array_s* retired;
+    size_t capacity;
+    amp_atomic_ptr_t slots[];
+};
+
+
+struct amp_internal_scheduler_worker_s {
+    /* Advanced by thieves. */
+    amp_atomic_size_t top;
+    amp_byte_t top_padding[AMP_CACHE_LINE_SIZE - sizeof(amp_atomic_size_t)];
+    
+    /* Written by the owner, read by thieves. */
+    amp_atomic_size_t bottom;
+    amp_atomic_ptr_t array;
+    
+    /* Only accessed by the owner. */
+    struct amp_internal_scheduler_task_s* free_tasks;
+    struct amp_internal_scheduler_task_chunk_s* task_chunks;
+    struct amp_scheduler_s* scheduler;
+    unsigned int random_state;
+    amp_byte_t owner_padding[AMP_CACHE_LINE_SIZE];
+    
+    /* Records of tasks allocated by this worker and run by other workers. */
+    amp_atomic_ptr_t returned_tasks;
+    amp_byte_t returned_tasks_padding[AMP_CACHE_LINE_SIZE - sizeof(amp_atomic_ptr_t)];
+};
+
+
+/**
+ * Internal opaque scheduler data structure
+ */
+struct amp_scheduler_s {
+    struct amp_internal_scheduler_worker_s* workers;
+    size_t worker_count;
+    amp_thread_array_t threads;
+    
+    /* Points to the worker struct of the calling worker thread. */
+    amp_thread_local_slot_key_t current_worker_key;
+    
+    amp_semaphore_t parking_semaphore;
+    amp_atomic_int_t sleeping_count;
+    amp_atomic_int_t shutting_down;
+    
+    /* Root task queue and completion, protected by mutex. */
+    amp_mutex_t mutex;
+    amp_condition_variable_t root_done;
+    struct amp_internal_scheduler_task_s* injected_head;
+    struct amp_internal_scheduler_task_s* injected_tail;
+    amp_atomic_size_t injected_count;
+    
+    amp_allocator_t allocator;
+};
+
+
+
+static struct amp_internal_scheduler_deque_array_s* amp_internal_scheduler_deque_array_alloc(amp_allocator_t allocator,
+                                                                                                size_t capacity)
+{
+    struct amp_internal_scheduler_deque_array_s* array = NULL;
+    
+    array = (struct amp_internal_scheduler_deque_array_s*)AMP_ALLOC(allocator,
+                                                                     sizeof(*array) + capacity * sizeof(amp_atomic_ptr_t));
+    if (NULL != array) {
+        array->retired = NULL;
+        array->capacity = capacity;
+    }
+    
+    return array;
+}
+
+
+/**
+ * Called by the owner when the deque is full. Copies the tasks from top to 
+ * bottom into an array of twice the capacity and publishes it.
+ */
+static struct amp_internal_scheduler_deque_array_s* amp_internal_scheduler_deque_grow(struct amp_internal_scheduler_worker_s* worker,
+                                                                                        struct amp_internal_scheduler_deque_array_s* array,
+                                                                                        size_t top,
+                                                                                        size_t bottom)
+{
+    struct amp_internal_scheduler_deque_array_s* grown = NULL;
+    size_t i = 0;
+    
+    grown = amp_internal_scheduler_deque_array_alloc(worker->scheduler->allocator,
+                                                     2 * array->capacity);
+    if (NULL == grown) {
+        return NULL;
+    }
+    
+    for (i = top; i != bottom; ++i) {
+        void* const task = amp_atomic_ptr_load(&array->slots[i & (array->capacity - 1)],
+                                               amp_memory_order_relaxed);
+        amp_atomic_ptr_store(&grown->slots[i & (grown->capacity - 1)],
+                             task,
+                             amp_memory_order_relaxed);
+    }
+    grown->retired = array;
+    
+    amp_atomic_ptr_store(&worker->array, grown, amp_memory_order_release);
+    
+    return grown;
+}
+
+
+static int amp_internal_scheduler_deque_push(struct amp_internal_scheduler_worker_s* worker,
+                                             struct amp_internal_scheduler_task_s* task)
+{
+    size_t const bottom = amp_atomic_size_load(&worker->bottom, amp_memory_order_relaxed);
+    size_t const top = amp_atomic_size_load(&worker->top, amp_memory_order_acquire);
+    struct amp_internal_scheduler_deque_array_s* array = 
+        (struct amp_internal_scheduler_deque_array_s*)amp_atomic_ptr_load(&worker->array,
+                                                                          amp_memory_order_relaxed);
+    
+    if (bottom - top > array->capacity - 1) {
+        array = amp_internal_scheduler_deque_grow(worker, array, top, bottom);
+        if (NULL == array) {
+            return AMP_NOMEM;
+        }
+    }
+    
+    amp_atomic_ptr_store(&array->slots[bottom & (array->capacity - 1)],
+                         task,
+                         amp_memory_order_relaxed);
+    amp_atomic_thread_fence(amp_memory_order_release);
+    amp_atomic_size_store(&worker->bottom, bottom + 1, amp_memory_order_relaxed);
+    
+    return AMP_SUCCESS;
+}
+
+
+static struct amp_internal_scheduler_task_s* amp_internal_scheduler_deque_pop(struct amp_internal_scheduler_worker_s* worker)
+{
+    size_t const bottom = amp_atomic_size_load(&worker->bottom, amp_memory_order_relaxed) - 1;
+    struct amp_internal_scheduler_deque_array_s* array = 
+        (struct amp_internal_scheduler_deque_array_s*)amp_atomic_ptr_load(&worker->array,
+                                                                          amp_memory_order_relaxed);
+    struct amp_internal_scheduler_task_s* task = NULL;
+    size_t top = 0;
+    
+    amp_atomic_size_store(&worker->bottom, bottom, amp_memory_order_relaxed);
+    amp_atomic_thread_fence(amp_memory_order_seq_cst);
+    top = amp_atomic_size_load(&worker->top, amp_memory_order_relaxed);
+    
+    if (top <= bottom) {
+        task = (struct amp_internal_scheduler_task_s*)amp_atomic_ptr_load(&array->slots[bottom & (array->capacity - 1)],
+                                                                          amp_memory_order_relaxed);
+        if (top == bottom) {
+            /* Last task - race thieves for it. */
+            if (!amp_atomic_size_compare_exchange(&worker->top,
+                                                  &top,
+                                                  top + 1,
+                                                  amp_memory_order_seq_cst,
+                                                  amp_memory_order_relaxed)) {
+                task = NULL;
+            }
+            amp_atomic_size_store(&worker->bottom, bottom + 1, amp_memory_order_relaxed);
+        }
+    } else {
+        amp_atomic_size_store(&worker->bottom, bottom + 1, amp_memory_order_relaxed);
+    }
+    
+    return task;
+}
+
+
+/**
+ * Returns the top task of victim or NULL if the deque is empty or another 
+ * thread took the top task first.
+ */
+static struct amp_internal_scheduler_task_s* amp_internal_scheduler_deque_steal(struct amp_internal_scheduler_worker_s* victim)
+{
+    size_t top = amp_atomic_size_load(&victim->top, amp_memory_order_acquire);
+    size_t bottom = 0;
+    struct amp_internal_scheduler_deque_array_s* array = NULL;
+    struct amp_internal_scheduler_task_s* task = NULL;
+    
+    amp_atomic_thread_fence(amp_memory_order_seq_cst);
+    bottom = amp_atomic_size_load(&victim->bottom, amp_memory_order_acquire);
+    
+    if (top < bottom) {
+        array = (struct amp_internal_scheduler_deque_array_s*)amp_atomic_ptr_load(&victim->array,
+                                                                                  amp_memory_order_acquire);
+        task = (struct amp_internal_scheduler_task_s*)amp_atomic_ptr_load(&array->slots[top & (array->capacity - 1)],
+                                                                          amp_memory_order_relaxed);
+        if (!amp_atomic_size_compare_exchange(&victim->top,
+                                              &top,
+                                              top + 1,
+                                              amp_memory_order_seq_cst,
+                                              amp_memory_order_relaxed)) {
+            task = NULL;
+        }
+    }
+    
+    return task;
+}
+
+
+
+static struct amp_internal_scheduler_task_s* amp_internal_scheduler_task_alloc(struct amp_internal_scheduler_worker_s* worker)
+{
+    struct amp_internal_scheduler_task_s* task = NULL;
+    
+    if (NULL == worker->free_tasks) {
+        worker->free_tasks = 
+            (struct amp_internal_scheduler_task_s*)amp_atomic_ptr_exchange(&worker->returned_tasks,
+                                                                           NULL,
+                                                                           amp_memory_order_acquire);
+    }
+    
+    if (NULL == worker->free_tasks) {
+        struct amp_internal_scheduler_task_chunk_s* chunk = NULL;
+        size_t i = 0;
+        
+        chunk = (struct amp_internal_scheduler_task_chunk_s*)AMP_ALLOC(worker->scheduler->allocator,
+                                                                       sizeof(*chunk));
+        if (NULL == chunk) {
+            return NULL;
+        }
+        
+        for (i = 0; i < AMP_SCHEDULER_TASK_CHUNK_SIZE; ++i) {
+            chunk->tasks[i].owner = worker;
+            chunk->tasks[i].next = (i + 1 < AMP_SCHEDULER_TASK_CHUNK_SIZE) ? &chunk->tasks[i + 1] : NULL;
+        }
+        
+        chunk->next = worker->task_chunks;
+        worker->task_chunks = chunk;
+        worker->free_tasks = &chunk->tasks[0];
+    }
+    
+    task = worker->free_tasks;
+    worker->free_tasks = task->next;
+    
+    return task;
+}
+
+
+static void amp_internal_scheduler_task_free(struct amp_internal_scheduler_worker_s* worker,
+                                             struct amp_internal_scheduler_task_s* task)
+{
+    struct amp_internal_scheduler_worker_s* const owner = task->owner;
+    
+    if (owner == worker) {
+        task->next = worker->free_tasks;
+        worker->free_tasks = task;
+    } else {
+        void* head = amp_atomic_ptr_load(&owner->returned_tasks, 
+                                         amp_memory_order_relaxed);
+        do {
+            task->next = (struct amp_internal_scheduler_task_s*)head;
+        } while (!amp_atomic_ptr_compare_exchange(&owner->returned_tasks,
+                                                  &head,
+                                                  task,
+                                                  amp_memory_order_release,
+                                                  amp_memory_order_relaxed));
+    }
+}
+
+
+
+static unsigned int amp_internal_scheduler_random(struct amp_internal_scheduler_worker_s* worker)
+{
+    /* Xorshift, good enough to pick victims. */
+    unsigned int x = worker->random_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    worker->random_state = x;
+    
+    return x;
+}
+
+
+static struct amp_internal_scheduler_task_s* amp_internal_scheduler_take_injected(struct amp_scheduler_s* scheduler)
+{
+    struct amp_internal_scheduler_task_s* task = NULL;
+    int retval = AMP_UNSUPPORTED;
+    
+    if (0 == amp_atomic_size_load(&scheduler->injected_count, amp_memory_order_acquire)) {
+        return NULL;
+    }
+    
+    retval = amp_mutex_lock(scheduler->mutex);
+    assert(AMP_SUCCESS == retval);
+    {
+        task = scheduler->injected_head;
+        if (NULL != task) {
+            scheduler->injected_head = task->next;
+            if (NULL == scheduler->injected_head) {
+                scheduler->injected_tail = NULL;
+            }
+            (void)amp_atomic_size_fetch_sub(&scheduler->injected_count,
+                                            1,
+                                            amp_memory_order_relaxed);
+        }
+    }
+    retval = amp_mutex_unlock(scheduler->mutex);
+    assert(AMP_SUCCESS == retval);
+    (void)retval;
+    
+    return task;
+}
+
+
+/**
+ * Pops a task from the own deque, or steals one from another worker 
+ * starting at a random victim, or takes a root task.
+ */
+static struct amp_internal_scheduler_task_s* amp_internal_scheduler_find_task(struct amp_internal_scheduler_worker_s* worker)
+{
+    struct amp_scheduler_s* const scheduler = worker->scheduler;
+    size_t const worker_count = scheduler->worker_count;
+    struct amp_internal_scheduler_task_s* task = NULL;
+    
+    task = amp_internal_scheduler_deque_pop(worker);
+    
+    if ((NULL == task) && (1 < worker_count)) {
+        size_t const first_victim = (size_t)amp_internal_scheduler_random(worker) % worker_count;
+        size_t i = 0;
+        
+        for (i = 0; (i < worker_count) && (NULL == task); ++i) {
+            struct amp_internal_scheduler_worker_s* const victim = 
+                &scheduler->workers[(first_victim + i) % worker_count];
+            
+            if (victim != worker) {
+                task = amp_internal_scheduler_deque_steal(victim);
+            }
+        }
+    }
+    
+    if (NULL == task) {
+        task = amp_internal_scheduler_take_injected(scheduler);
+    }
+    
+    return task;
+}
+
+
+static void amp_internal_scheduler_execute(struct amp_internal_scheduler_worker_s* worker,
+                                           struct amp_internal_scheduler_task_s* task)
+{
+    if (NULL == task->owner) {
+        /* Root task - its record lives on the stack of amp_scheduler_run and
+         * mustn't be touched after signaling its completion.
+         */
+        amp_mutex_t const mutex = worker->scheduler->mutex;
+        amp_condition_variable_t const root_done = worker->scheduler->root_done;
+        int retval = AMP_UNSUPPORTED;
+        
+        task->func(task->context);
+        
+        retval = amp_mutex_lock(mutex);
+        assert(AMP_SUCCESS == retval);
+        {
+            task->done = 1;
+            retval = amp_condition_variable_broadcast(root_done);
+            assert(AMP_SUCCESS == retval);
+        }
+        retval = amp_mutex_unlock(mutex);
+        assert(AMP_SUCCESS == retval);
+        (void)retval;
+    } else {
+        amp_thread_func_t const func = task->func;
+        void* const context = task->context;
+        amp_scheduler_group_t const group = task->group;
+        
+        amp_internal_scheduler_task_free(worker, task);
+        
+        func(context);
+        
+        /* Last access to the group, the waiting task might return and 
+         * finalize it right after.
+         */
+        (void)amp_atomic_size_fetch_sub(&group->pending_count,
+                                        1,
+                                        amp_memory_order_release);
+    }
+}
+
+
+
+static int amp_internal_scheduler_has_tasks(struct amp_scheduler_s* scheduler)
+{
+    size_t i = 0;
+    
+    for (i = 0; i < scheduler->worker_count; ++i) {
+        struct amp_internal_scheduler_worker_s* const worker = &scheduler->workers[i];
+        size_t const top = amp_atomic_size_load(&worker->top, amp_memory_order_seq_cst);
+        size_t const bottom = amp_atomic_size_load(&worker->bottom, amp_memory_order_seq_cst);
+        
+        if (top < bottom) {
+            return 1;
+        }
+    }
+    
+    return 0 != amp_atomic_size_load(&scheduler->injected_count, 
+                                     amp_memory_order_seq_cst);
+}
+
+
+static void amp_internal_scheduler_wake_one(struct amp_scheduler_s* scheduler)
+{
+    int sleeping_count = amp_atomic_int_load(&scheduler->sleeping_count,
+                                             amp_memory_order_relaxed);
+    
+    while (0 < sleeping_count) {
+        if (amp_atomic_int_compare_exchange(&scheduler->sleeping_count,
+                                            &sleeping_count,
+                                            sleeping_count - 1,
+                                            amp_memory_order_seq_cst,
+                                            amp_memory_order_relaxed)) {
+            int const retval = amp_semaphore_signal(scheduler->parking_semaphore);
+            assert(AMP_SUCCESS == retval);
+            (void)retval;
+            
+            return;
+        }
+    }
+}
+
+
+/**
+ * Called after the fence following the publication of a task.
+ */
+static void amp_internal_scheduler_wake_if_sleeping(struct amp_scheduler_s* scheduler)
+{
+    if (0 != amp_atomic_int_load(&scheduler->sleeping_count, 
+                                 amp_memory_order_relaxed)) {
+        amp_internal_scheduler_wake_one(scheduler);
+    }
+}
+
+
+static void amp_internal_scheduler_park(struct amp_scheduler_s* scheduler)
+{
+    int retval = AMP_UNSUPPORTED;
+    
+    (void)amp_atomic_int_fetch_add(&scheduler->sleeping_count,
+                                   1,
+                                   amp_memory_order_seq_cst);
+    amp_atomic_thread_fence(amp_memory_order_seq_cst);
+    
+    if (amp_internal_scheduler_has_tasks(scheduler)
+        || (0 != amp_atomic_int_load(&scheduler->shutting_down, amp_memory_order_seq_cst))) {
+        
+        /* Take the registration back unless a spawner already took one and
+         * signals the semaphore for it.
+         */
+        int sleeping_count = amp_atomic_int_load(&scheduler->sleeping_count,
+                                                 amp_memory_order_relaxed);
+        while (0 < sleeping_count) {
+            if (amp_atomic_int_compare_exchange(&scheduler->sleeping_count,
+                                                &sleeping_count,
+                                                sleeping_count - 1,
+                                                amp_memory_order_seq_cst,
+                                                amp_memory_order_relaxed)) {
+                return;
+            }
+        }
+    }
+    
+    retval = amp_semaphore_wait(scheduler->parking_semaphore);
+    assert(AMP_SUCCESS == retval);
+    (void)retval;
+}
+
+
+
+static void amp_internal_scheduler_worker_func(void* context)
+{
+    struct amp_internal_scheduler_worker_s* const worker = 
+        (struct amp_internal_scheduler_worker_s*)context;
+    struct amp_scheduler_s* const scheduler = worker->scheduler;
+    struct amp_internal_scheduler_task_s* task = NULL;
+    unsigned int idle_round_count = 0;
+    int retval = AMP_UNSUPPORTED;
+    
+    retval = amp_thread_local_slot_set_value(scheduler->current_worker_key,
+                                             worker);
+    assert(AMP_SUCCESS == retval);
+    (void)retval;
+    
+    for (;;) {
+        task = amp_internal_scheduler_find_task(worker);
+        
+        if (NULL != task) {
+            amp_internal_scheduler_execute(worker, task);
+            idle_round_count = 0;
+        } else if (0 != amp_atomic_int_load(&scheduler->shutting_down, 
+                                            amp_memory_order_acquire)) {
+            break;
+        } else if (idle_round_count < AMP_SCHEDULER_IDLE_SPIN_COUNT) {
+            ++idle_round_count;
+            (void)amp_thread_yield();
+        } else {
+            amp_internal_scheduler_park(scheduler);
+            idle_round_count = 0;
+        }
+    }
+}
+
+
+
+static struct amp_internal_scheduler_worker_s* amp_internal_scheduler_current_worker(struct amp_scheduler_s* scheduler)
+{
+    return (struct amp_internal_scheduler_worker_s*)amp_thread_local_slot_value(scheduler->current_worker_key);
+}
+
+
+static size_t amp_internal_scheduler_default_worker_count(amp_allocator_t allocator)
+{
+    amp_platform_t platform = NULL;
+    size_t concurrency_level = 0;
+    int retval = amp_platform_create(&platform, allocator);
+    
+    if (AMP_SUCCESS == retval) {
+        retval = amp_platform_get_concurrency_level(platform, 
+                                                    &concurrency_level);
+        if (AMP_SUCCESS != retval) {
+            concurrency_level = 0;
+        }
+        
+        retval = amp_platform_destroy(&platform, allocator);
+        assert(AMP_SUCCESS == retval);
+    }
+    
+    return (0 != concurrency_level) ? concurrency_level : (size_t)1;
+}
+
+
+/**
+ * Frees everything a possibly partially created scheduler without running 
+ * workers holds.
+ */
+static void amp_internal_scheduler_free(struct amp_scheduler_s* scheduler,
+                                        amp_allocator_t allocator)
+{
+    size_t i = 0;
+    int retval = AMP_UNSUPPORTED;
+    
+    if (NULL != scheduler->workers) {
+        for (i = 0; i < scheduler->worker_count; ++i) {
+            struct amp_internal_scheduler_worker_s* const worker = &scheduler->workers[i];
+            struct amp_internal_scheduler_deque_array_s* array = 
+                (struct amp_internal_scheduler_deque_array_s*)amp_atomic_ptr_load(&worker->array,
+                                                                                  amp_memory_order_relaxed);
+            struct amp_internal_scheduler_task_chunk_s* chunk = worker->task_chunks;
+            
+            while (NULL != array) {
+                struct amp_internal_scheduler_deque_array_s* const retired = array->retired;
+                retval = AMP_DEALLOC(allocator, array);
+                assert(AMP_SUCCESS == retval);
+                array = retired;
+            }
+            
+            while (NULL != chunk) {
+                struct amp_internal_scheduler_task_chunk_s* const next = chunk->next;
+                retval = AMP_DEALLOC(allocator, chunk);
+                assert(AMP_SUCCESS == retval);
+                chunk = next;
+            }
+        }
+        
+        retval = AMP_DEALLOC(allocator, scheduler->workers);
+        assert(AMP_SUCCESS == retval);
+    }
+    
+    if (AMP_THREAD_ARRAY_UNINITIALIZED != scheduler->threads) {
+        retval = amp_thread_array_destroy(&scheduler->threads, allocator);
+        assert(AMP_SUCCESS == retval);
+    }
+    
+    if (AMP_THREAD_LOCAL_SLOT_UNINITIALIZED != scheduler->current_worker_key) {
+        retval = amp_thread_local_slot_destroy(&scheduler->current_worker_key,
+                                               allocator);
+        assert(AMP_SUCCESS == retval);
+    }
+    
+    if (AMP_SEMAPHORE_UNINITIALIZED != scheduler->parking_semaphore) {
+        retval = amp_semaphore_destroy(&scheduler->parking_semaphore, allocator);
+        assert(AMP_SUCCESS == retval);
+    }
+    
+    if (AMP_CONDITION_VARIABLE_UNINITIALIZED != scheduler->root_done) {
+        retval = amp_condition_variable_destroy(&scheduler->root_done, allocator);
+        assert(AMP_SUCCESS == retval);
+    }
+    
+    if (AMP_MUTEX_UNINITIALIZED != scheduler->mutex) {
+        retval = amp_mutex_destroy(&scheduler->mutex, allocator);
+        assert(AMP_SUCCESS == retval);
+    }
+    
+    retval = AMP_DEALLOC(allocator, scheduler);
+    assert(AMP_SUCCESS == retval);
+    (void)retval;
+}
+
+
+/**
+ * Tells the workers to exit, wakes parked ones and joins all launched 
+ * workers.
+ */
+static int amp_internal_scheduler_stop_workers(struct amp_scheduler_s* scheduler)
+{
+    size_t i = 0;
+    int retval = AMP_UNSUPPORTED;
+    
+    amp_atomic_int_store(&scheduler->shutting_down, 1, amp_memory_order_seq_cst);
+    
+    for (i = 0; i < scheduler->worker_count; ++i) {
+        retval = amp_semaphore_signal(scheduler->parking_semaphore);
+        assert(AMP_SUCCESS == retval);
+    }
+    (void)retval;
+    
+    return amp_thread_array_join_all(scheduler->threads, NULL);
+}
+
+
+
+int amp_scheduler_create(amp_scheduler_t* scheduler,
+                         amp_allocator_t allocator,
+                         size_t worker_count)
+{
+    struct amp_scheduler_s* tmp = NULL;
+    size_t i = 0;
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != scheduler);
+    assert(NULL != allocator);
+    
+    if (0 == worker_count) {
+        worker_count = amp_internal_scheduler_default_worker_count(allocator);
+    }
+    
+    tmp = (struct amp_scheduler_s*)AMP_ALLOC(allocator, sizeof(*tmp));
+    if (NULL == tmp) {
+        return AMP_NOMEM;
+    }
+    
+    tmp->workers = NULL;
+    tmp->worker_count = worker_count;
+    tmp->threads = AMP_THREAD_ARRAY_UNINITIALIZED;
+    tmp->current_worker_key = AMP_THREAD_LOCAL_SLOT_UNINITIALIZED;
+    tmp->parking_semaphore = AMP_SEMAPHORE_UNINITIALIZED;
+    amp_atomic_int_store(&tmp->sleeping_count, 0, amp_memory_order_relaxed);
+    amp_atomic_int_store(&tmp->shutting_down, 0, amp_memory_order_relaxed);
+    tmp->mutex = AMP_MUTEX_UNINITIALIZED;
+    tmp->root_done = AMP_CONDITION_VARIABLE_UNINITIALIZED;
+    tmp->injected_head = NULL;
+    tmp->injected_tail = NULL;
+    amp_atomic_size_store(&tmp->injected_count, 0, amp_memory_order_relaxed);
+    tmp->allocator = allocator;
+    
+    tmp->workers = (struct amp_internal_scheduler_worker_s*)AMP_CALLOC(allocator,
+                                                                       worker_count,
+                                                                       sizeof(*tmp->workers));
+    if (NULL == tmp->workers) {
+        amp_internal_scheduler_free(tmp, allocator);
+        return AMP_NOMEM;
+    }
+    
+    for (i = 0; i < worker_count; ++i) {
+        struct amp_internal_scheduler_worker_s* const worker = &tmp->workers[i];
+        struct amp_internal_scheduler_deque_array_s* const array = 
+            amp_internal_scheduler_deque_array_alloc(allocator,
+                                                     AMP_SCHEDULER_DEQUE_INITIAL_CAPACITY);
+        
+        amp_atomic_size_store(&worker->top, 1, amp_memory_order_relaxed);
+        amp_atomic_size_store(&worker->bottom, 1, amp_memory_order_relaxed);
+        amp_atomic_ptr_store(&worker->array, array, amp_memory_order_relaxed);
+        amp_atomic_ptr_store(&worker->returned_tasks, NULL, amp_memory_order_relaxed);
+        worker->free_tasks = NULL;
+        worker->task_chunks = NULL;
+        worker->scheduler = tmp;
+        worker->random_state = (unsigned int)(i + 1) * 2654435761u;
+        
+        if (NULL == array) {
+            amp_internal_scheduler_free(tmp, allocator);
+            return AMP_NOMEM;
+        }
+    }
+    
+    retval = amp_thread_local_slot_create(&tmp->current_worker_key, allocator);
+    if (AMP_SUCCESS != retval) {
+        tmp->current_worker_key = AMP_THREAD_LOCAL_SLOT_UNINITIALIZED;
+        amp_internal_scheduler_free(tmp, allocator);
+        return retval;
+    }
+    
+    retval = amp_semaphore_create(&tmp->parking_semaphore, allocator, 0);
+    if (AMP_SUCCESS != retval) {
+        tmp->parking_semaphore = AMP_SEMAPHORE_UNINITIALIZED;
+        amp_internal_scheduler_free(tmp, allocator);
+        return retval;
+    }
+    
+    retval = amp_mutex_create(&tmp->mutex, allocator);
+    if (AMP_SUCCESS != retval) {
+        tmp->mutex = AMP_MUTEX_UNINITIALIZED;
+        amp_internal_scheduler_free(tmp, allocator);
+        return retval;
+    }
+    
+    retval = amp_condition_variable_create(&tmp->root_done, allocator);
+    if (AMP_SUCCESS != retval) {
+        tmp->root_done = AMP_CONDITION_VARIABLE_UNINITIALIZED;
+        amp_internal_scheduler_free(tmp, allocator);
+        return retval;
+    }
+    
+    retval = amp_thread_array_create(&tmp->threads, allocator, worker_count);
+    if (AMP_SUCCESS != retval) {
+        tmp->threads = AMP_THREAD_ARRAY_UNINITIALIZED;
+        amp_internal_scheduler_free(tmp, allocator);
+        return retval;
+    }
+    
+    for (i = 0; i < worker_count; ++i) {
+        retval = amp_thread_array_configure(tmp->threads,
+                                            i,
+                                            1,
+                                            &tmp->workers[i],
+                                            &amp_internal_scheduler_worker_func);
+        assert(AMP_SUCCESS == retval);
+    }
+    
+    retval = amp_thread_array_launch_all(tmp->threads, NULL);
+    if (AMP_SUCCESS != retval) {
+        int const rc = amp_internal_scheduler_stop_workers(tmp);
+        assert(AMP_SUCCESS == rc);
+        (void)rc;
+        
+        amp_internal_scheduler_free(tmp, allocator);
+        return retval;
+    }
+    
+    *scheduler = tmp;
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_scheduler_destroy(amp_scheduler_t* scheduler,
+                          amp_allocator_t allocator)
+{
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != scheduler);
+    assert(NULL != *scheduler);
+    assert(NULL != allocator);
+    
+    retval = amp_internal_scheduler_stop_workers(*scheduler);
+    if (AMP_SUCCESS != retval) {
+        return retval;
+    }
+    
+    amp_internal_scheduler_free(*scheduler, allocator);
+    *scheduler = AMP_SCHEDULER_UNINITIALIZED;
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_scheduler_run(amp_scheduler_t scheduler,
+                      void* context,
+                      amp_thread_func_t func)
+{
+    struct amp_internal_scheduler_task_s root;
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != scheduler);
+    assert(NULL != func);
+    
+    if (NULL != amp_internal_scheduler_current_worker(scheduler)) {
+        return AMP_ERROR;
+    }
+    
+    root.func = func;
+    root.context = context;
+    root.group = NULL;
+    root.owner = NULL;
+    root.next = NULL;
+    root.done = 0;
+    
+    retval = amp_mutex_lock(scheduler->mutex);
+    assert(AMP_SUCCESS == retval);
+    {
+        if (NULL == scheduler->injected_tail) {
+            scheduler->injected_head = &root;
+        } else {
+            scheduler->injected_tail->next = &root;
+        }
+        scheduler->injected_tail = &root;
+        (void)amp_atomic_size_fetch_add(&scheduler->injected_count,
+                                        1,
+                                        amp_memory_order_seq_cst);
+    }
+    retval = amp_mutex_unlock(scheduler->mutex);
+    assert(AMP_SUCCESS == retval);
+    
+    amp_atomic_thread_fence(amp_memory_order_seq_cst);
+    amp_internal_scheduler_wake_if_sleeping(scheduler);
+    
+    retval = amp_mutex_lock(scheduler->mutex);
+    assert(AMP_SUCCESS == retval);
+    {
+        while (0 == root.done) {
+            retval = amp_condition_variable_wait(scheduler->root_done,
+                                                 scheduler->mutex);
+            assert(AMP_SUCCESS == retval);
+        }
+    }
+    retval = amp_mutex_unlock(scheduler->mutex);
+    assert(AMP_SUCCESS == retval);
+    
+    return retval;
+}
+
+
+
+int amp_scheduler_spawn(amp_scheduler_t scheduler,
+                        amp_scheduler_group_t group,
+                        void* context,
+                        amp_thread_func_t func)
+{
+    struct amp_internal_scheduler_worker_s* const worker = 
+        amp_internal_scheduler_current_worker(scheduler);
+    struct amp_internal_scheduler_task_s* task = NULL;
+    
+    assert(NULL != group);
+    assert(NULL != func);
+    
+    if (NULL == worker) {
+        return AMP_ERROR;
+    }
+    
+    task = amp_internal_scheduler_task_alloc(worker);
+    if (NULL == task) {
+        return AMP_NOMEM;
+    }
+    
+    task->func = func;
+    task->context = context;
+    task->group = group;
+    
+    (void)amp_atomic_size_fetch_add(&group->pending_count,
+                                    1,
+                                    amp_memory_order_relaxed);
+    
+    if (AMP_SUCCESS != amp_internal_scheduler_deque_push(worker, task)) {
+        (void)amp_atomic_size_fetch_sub(&group->pending_count,
+                                        1,
+                                        amp_memory_order_relaxed);
+        amp_internal_scheduler_task_free(worker, task);
+        
+        return AMP_NOMEM;
+    }
+    
+    amp_atomic_thread_fence(amp_memory_order_seq_cst);
+    amp_internal_scheduler_wake_if_sleeping(scheduler);
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_scheduler_group_wait(amp_scheduler_t scheduler,
+                             amp_scheduler_group_t group)
+{
+    struct amp_internal_scheduler_worker_s* const worker = 
+        amp_internal_scheduler_current_worker(scheduler);
+    struct amp_internal_scheduler_task_s* task = NULL;
+    unsigned int idle_round_count = 0;
+    
+    assert(NULL != group);
+    
+    if (NULL == worker) {
+        return AMP_ERROR;
+    }
+    
+    while (0 != amp_atomic_size_load(&group->pending_count, amp_memory_order_acquire)) {
+        
+        task = amp_internal_scheduler_find_task(worker);
+        
+        if (NULL != task) {
+            amp_internal_scheduler_execute(worker, task);
+            idle_round_count = 0;
+        } else if (idle_round_count < AMP_SCHEDULER_IDLE_SPIN_COUNT) {
+            ++idle_round_count;
+            amp_atomic_cpu_relax();
+        } else {
+            /* The remaining tasks of the group run on other workers which 
+             * might need this processor.
+             */
+            (void)amp_thread_yield();
+        }
+    }
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_scheduler_get_worker_count(amp_scheduler_t scheduler,
+                                   size_t* worker_count)
+{
+    assert(NULL != scheduler);
+    assert(NULL != worker_count);
+    
+    *worker_count = scheduler->worker_count;
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_scheduler_group_create(amp_scheduler_group_t* group,
+                               amp_allocator_t allocator)
+{
+    amp_scheduler_group_t tmp_group = AMP_SCHEDULER_GROUP_UNINITIALIZED;
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != group);
+    assert(NULL != allocator);
+    
+    tmp_group = (amp_scheduler_group_t)AMP_ALLOC(allocator, sizeof(*tmp_group));
+    if (NULL == tmp_group) {
+        return AMP_NOMEM;
+    }
+    
+    retval = amp_raw_scheduler_group_init(tmp_group);
+    assert(AMP_SUCCESS == retval);
+    
+    *group = tmp_group;
+    
+    return retval;
+}
+
+
+
+int amp_scheduler_group_destroy(amp_scheduler_group_t* group,
+                                amp_allocator_t allocator)
+{
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != group);
+    assert(NULL != *group);
+    assert(NULL != allocator);
+    
+    retval = amp_raw_scheduler_group_finalize(*group);
+    if (AMP_SUCCESS == retval) {
+        retval = AMP_DEALLOC(allocator, *group);
+        assert(AMP_SUCCESS == retval);
+        if (AMP_SUCCESS == retval) {
+            *group = AMP_SCHEDULER_GROUP_UNINITIALIZED;
+        }
+    }
+    
+    return retval;
+}
+
+
+
+int amp_raw_scheduler_group_init(amp_scheduler_group_t group)
+{
+    assert(NULL != group);
+    
+    amp_atomic_size_store(&group->pending_count, 0, amp_memory_order_relaxed);
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_raw_scheduler_group_finalize(amp_scheduler_group_t group)
+{
+    assert(NULL != group);
+    
+    if (0 != amp_atomic_size_load(&group->pending_count, amp_memory_order_acquire)) {
+        return AMP_BUSY;
+    }
+    
+    return AMP_SUCCESS;
+}
@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Work-stealing scheduler running fork-join style tasks on a fixed set of 
+ * amp_thread_array workers.
+ *
+ * Every worker owns a lock-free Chase-Lev deque. A task spawning a child task
+ * pushes it to the bottom of its worker's deque and the worker pops tasks 
+ * from the bottom again, so each worker mostly works depth-first on its own 
+ * tasks without touching shared data. Workers running out of tasks steal 
+ * the oldest - and usually biggest - task from the top of the deque of a 
+ * randomly selected victim. Workers that find nothing to steal for a while 
+ * park on an amp semaphore until new tasks are spawned.
+ *
+ * Tasks are an amp_thread_func_t and its context. A thread that isn't a 
+ * worker of the scheduler hands a root task to it via amp_scheduler_run and 
+ * blocks until the root task returns. Tasks spawn child tasks into an 
+ * amp_scheduler_group_t and wait for the group before using the childrens' 
+ * results. While waiting the worker runs other tasks instead of blocking.
+ *
+ * Example computing Fibonacci numbers:
+ * @code
+ * struct fib_s { amp_scheduler_t scheduler; int n; int result; };
+ *
+ * void fib_task(void* context)
+ * {
+ *     struct fib_s* fib = (struct fib_s*)context;
+ *     struct amp_raw_scheduler_group_s group;
+ *     struct fib_s child = { fib->scheduler, fib->n - 1, 0 };
+ *     int other = 0;
+ *
+ *     if (fib->n < 2) { fib->result = fib->n; return; }
+ *
+ *     amp_raw_scheduler_group_init(&group);
+ *     amp_scheduler_spawn(fib->scheduler, &group, &child, fib_task);
+ *     other = serial_fib(fib->n - 2);
+ *     amp_scheduler_group_wait(fib->scheduler, &group);
+ *     amp_raw_scheduler_group_finalize(&group);
+ *
+ *     fib->result = child.result + other;
+ * }
+ * @endcode
+ *
+ * @attention A task must wait for all groups it spawned tasks into before it
+ *            returns - when amp_scheduler_run returns all tasks spawned 
+ *            from the root task must have finished.
+ *
+ * @attention amp_scheduler_spawn and amp_scheduler_group_wait can only be 
+ *            called from tasks running on the scheduler, amp_scheduler_run 
+ *            can only be called from threads that aren't workers of the 
+ *            scheduler.
+ *
+ * @attention The scheduler builds on amp_atomic and is therefore not 
+ *            available on Windows yet.
+ */
+
+#ifndef AMP_amp_scheduler_H
+#define AMP_amp_scheduler_H
+
+#include <stddef.h>
+
+#include <amp/amp_memory.h>
+#include <amp/amp_thread.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+    
+#define AMP_SCHEDULER_UNINITIALIZED NULL
+#define AMP_SCHEDULER_GROUP_UNINITIALIZED NULL
+    
+    /**
+     * Opaque type representing an amp work-stealing scheduler.
+     */
+    typedef struct amp_scheduler_s *amp_scheduler_t;
+    
+    /**
+     * Counts the unfinished tasks spawned into it. See 
+     * amp_raw_scheduler_group_s to place a group on the stack.
+     */
+    typedef struct amp_raw_scheduler_group_s *amp_scheduler_group_t;
+    
+    
+    /**
+     * Allocates a scheduler and launches worker_count workers. If 
+     * worker_count is 0 the scheduler launches as many workers as 
+     * amp_platform_get_concurrency_level reports, or a single worker if the
+     * platform can't be queried.
+     *
+     * allocator is stored in the scheduler to allocate task records and to
+     * grow deques and must stay valid until the scheduler is destroyed.
+     *
+     * On error no memory is leaked and no worker is left running.
+     *
+     * @return AMP_SUCCESS on successful creation and launch of all workers.
+     *         AMP_NOMEM if not enough memory is available.
+     *         AMP_ERROR if the system lacks the resources to launch the 
+     *         workers.
+     */
+    int amp_scheduler_create(amp_scheduler_t* scheduler,
+                             amp_allocator_t allocator,
+                             size_t worker_count);
+    
+    /**
+     * Stops and joins the workers and frees the scheduler's memory.
+     *
+     * Must not be called while amp_scheduler_run is running.
+     *
+     * @return AMP_SUCCESS after the workers have been joined and the memory 
+     *         has been freed.
+     *         Other error codes might be returned to signal errors, too. 
+     *         These are programming errors and mustn't occur in release code.
+     */
+    int amp_scheduler_destroy(amp_scheduler_t* scheduler,
+                              amp_allocator_t allocator);
+    
+    /**
+     * Runs func with context as a root task on one of the workers and blocks
+     * until it returns. Several threads can run root tasks concurrently.
+     *
+     * @return AMP_SUCCESS after func returned.
+     *         AMP_ERROR if called from a worker of scheduler.
+     */
+    int amp_scheduler_run(amp_scheduler_t scheduler,
+                          void* context,
+                          amp_thread_func_t func);
+    
+    /**
+     * Pushes a task calling func with context to the deque of the calling 
+     * worker and counts it in group. The task runs on the calling worker 
+     * or on a worker stealing it.
+     *
+     * Only call from tasks running on scheduler.
+     *
+     * @return AMP_SUCCESS if the task has been spawned.
+     *         AMP_NOMEM if no memory for the task record or to grow the deque
+     *         is available. The task isn't spawned.
+     *         AMP_ERROR if called from a thread that isn't a worker of 
+     *         scheduler.
+     */
+    int amp_scheduler_spawn(amp_scheduler_t scheduler,
+                            amp_scheduler_group_t group,
+                            void* context,
+                            amp_thread_func_t func);
+    
+    /**
+     * Returns after all tasks spawned into group have finished. The calling 
+     * worker runs its own and stolen tasks while waiting.
+     *
+     * Only call from tasks running on scheduler.
+     *
+     * @return AMP_SUCCESS after all tasks of group have finished.
+     *         AMP_ERROR if called from a thread that isn't a worker of 
+     *         scheduler.
+     */
+    int amp_scheduler_group_wait(amp_scheduler_t scheduler,
+                                 amp_scheduler_group_t group);
+    
+    /**
+     * Stores the number of workers of scheduler in worker_count.
+     *
+     * @return AMP_SUCCESS.
+     */
+    int amp_scheduler_get_worker_count(amp_scheduler_t scheduler,
+                                       size_t* worker_count);
+    
+    
+    /**
+     * Allocates and initializes an empty group.
+     *
+     * @return AMP_SUCCESS on successful creation.
+     *         AMP_NOMEM if not enough memory is available.
+     */
+    int amp_scheduler_group_create(amp_scheduler_group_t* group,
+                                   amp_allocator_t allocator);
+    
+    /**
+     * Finalizes and frees a group.
+     *
+     * @return AMP_SUCCESS on successful destruction.
+     *         AMP_BUSY if tasks of the group haven't finished yet. The group
+     *         isn't destroyed.
+     */
+    int amp_scheduler_group_destroy(amp_scheduler_group_t* group,
+                                    amp_allocator_t allocator);
+    
+    
+    
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* AMP_amp_scheduler_H */
@@ -43,6 +43,7 @@
 
 #include "amp_stddef.h"
 #include "amp_return_code.h"
+#include "amp_internal_memory.h"
 
 
 
@@ -67,8 +68,8 @@ int amp_semaphore_create(amp_semaphore_t* semaphore,
         return AMP_ERROR;
     }
 
-    tmp_sema = (amp_semaphore_t)AMP_ALLOC(allocator,
-                                           sizeof(*tmp_sema));
+    tmp_sema = (amp_semaphore_t)AMP_INTERNAL_PRIMITIVE_ALLOC(allocator,
+                                                             sizeof(*tmp_sema));
     if (NULL == tmp_sema) {
         return AMP_NOMEM;
     }
@@ -78,7 +79,7 @@ int amp_semaphore_create(amp_semaphore_t* semaphore,
     if (AMP_SUCCESS == retval) {
         *semaphore = tmp_sema;
     } else {
-        int const rc = AMP_DEALLOC(allocator, tmp_sema);
+        int const rc = AMP_INTERNAL_PRIMITIVE_DEALLOC(allocator, tmp_sema);
         assert(AMP_SUCCESS == rc);
         (void)rc;
     }
@@ -99,8 +100,8 @@ int amp_semaphore_destroy(amp_semaphore_t* semaphore,
     
     retval = amp_raw_semaphore_finalize(*semaphore);
     if (AMP_SUCCESS == retval) {
-        retval = AMP_DEALLOC(allocator,
-                             *semaphore);
+        retval = AMP_INTERNAL_PRIMITIVE_DEALLOC(allocator,
+                                                *semaphore);
         assert(AMP_SUCCESS == retval);
         if (AMP_SUCCESS == retval) {
             *semaphore = AMP_SEMAPHORE_UNINITIALIZED;
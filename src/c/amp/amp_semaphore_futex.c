@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Linux futex based amp semaphore backend. Selected by defining 
+ * AMP_USE_PTHREADS and AMP_USE_FUTEX_SEMAPHORES.
+ *
+ * The semaphore count lives in an atomically changed word. A negative count
+ * records the number of threads that are blocked or about to block on the 
+ * semaphore. Waiting on a semaphore with a positive count and signaling a
+ * semaphore nobody waits on are a single atomic operation and never enter
+ * the kernel. Only if the count drops below zero the waiting thread blocks on
+ * a second futex word counting pending wake ups, and only if a signal finds a
+ * recorded waiter it hands out a wake up and calls into the kernel.
+ *
+ * amp_semaphore_create and amp_semaphore_destroy are implemented in 
+ * amp_semaphore_common.c.
+ */
+
+
+#include "amp_semaphore.h"
+
+#include <assert.h>
+#include <stddef.h>
+
+#include "amp_stddef.h"
+#include "amp_return_code.h"
+#include "amp_raw_semaphore.h"
+#include "amp_atomic.h"
+#include "amp_internal_futex.h"
+
+
+
+#if !defined(AMP_USE_FUTEX_SEMAPHORES)
+#   error Build configuration problem - this source file shouldn't be compiled.
+#endif
+
+
+
+int amp_raw_semaphore_init(amp_semaphore_t semaphore,
+                           amp_semaphore_counter_t init_count)
+{
+    assert(NULL != semaphore);
+    assert((amp_semaphore_counter_t)0 <= init_count);
+    assert(AMP_RAW_SEMAPHORE_COUNT_MAX >= (amp_raw_semaphore_counter_t)init_count);
+    
+    if ((amp_semaphore_counter_t)0 > init_count
+        || (amp_semaphore_counter_t)AMP_RAW_SEMAPHORE_COUNT_MAX < init_count) {
+        
+        return AMP_ERROR;
+    }
+    
+    amp_atomic_int_store(&semaphore->wake_count, 0, amp_memory_order_relaxed);
+    amp_atomic_int_store(&semaphore->count, (int)init_count, amp_memory_order_release);
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_raw_semaphore_finalize(amp_semaphore_t semaphore)
+{
+    assert(NULL != semaphore);
+    
+    if (0 > amp_atomic_int_load(&semaphore->count, amp_memory_order_acquire)) {
+        assert(0); /* Programming error - threads block on the semaphore */
+        return AMP_BUSY;
+    }
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_semaphore_wait(amp_semaphore_t semaphore)
+{
+    int previous_count = 0;
+    int wake_count = 0;
+    
+    assert(NULL != semaphore);
+    
+    previous_count = amp_atomic_int_fetch_sub(&semaphore->count, 1, amp_memory_order_acquire);
+    if (0 < previous_count) {
+        /* Fast path - passed without blocking. */
+        return AMP_SUCCESS;
+    }
+    
+    /* Recorded as a waiter, block until a signal hands out a wake up. */
+    for (;;) {
+        wake_count = amp_atomic_int_load(&semaphore->wake_count, amp_memory_order_relaxed);
+        
+        while (0 < wake_count) {
+            if (amp_atomic_int_compare_exchange(&semaphore->wake_count,
+                                                &wake_count,
+                                                wake_count - 1,
+                                                amp_memory_order_acquire,
+                                                amp_memory_order_relaxed)) {
+                return AMP_SUCCESS;
+            }
+        }
+        
+        {
+            int const retval = amp_internal_futex_wait(&semaphore->wake_count, 0);
+            if (AMP_SUCCESS != retval) {
+                return retval;
+            }
+        }
+    }
+}
+
+
+
+int amp_semaphore_signal(amp_semaphore_t semaphore)
+{
+    int previous_count = 0;
+    
+    assert(NULL != semaphore);
+    
+    previous_count = amp_atomic_int_fetch_add(&semaphore->count, 1, amp_memory_order_release);
+    if (0 <= previous_count) {
+        
+        if ((int)AMP_RAW_SEMAPHORE_COUNT_MAX == previous_count) {
+            amp_atomic_int_fetch_sub(&semaphore->count, 1, amp_memory_order_relaxed);
+            assert(0); /* Programming error */
+            return AMP_ERROR;
+        }
+        
+        /* Fast path - nobody waits. */
+        return AMP_SUCCESS;
+    }
+    
+    /* At least one thread waits or is about to wait - hand out a wake up. */
+    amp_atomic_int_fetch_add(&semaphore->wake_count, 1, amp_memory_order_release);
+    
+    return amp_internal_futex_wake(&semaphore->wake_count, 1);
+}
+
+
@@ -49,7 +49,7 @@
 
 
 
-#if !defined(AMP_USE_PTHREADS) || defined(AMP_USE_POSIX_1003_1B_SEMAPHORES)
+#if !defined(AMP_USE_PTHREADS) || defined(AMP_USE_POSIX_1003_1B_SEMAPHORES) || defined(AMP_USE_FUTEX_SEMAPHORES)
 #   error Build configuration problem - this source file shouldn't be compiled.
 #endif
 
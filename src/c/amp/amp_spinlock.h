@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Non-recursive spinlock for very short critical sections, e.g. to update a 
+ * counter or to pop a node from a free list.
+ *
+ * amp_spinlock_t has the same usage and semantics as amp_mutex_t but 
+ * threads waiting for the lock busy-wait on a memory location instead of 
+ * blocking in the kernel and the lock itself never enters the kernel. This 
+ * avoids the cost of blocking and waking threads but wastes processor time 
+ * while waiting, therefore only use spinlocks for critical sections which 
+ * take less time than a context switch and if threads don't outnumber 
+ * hardware threads. Waiting threads yield the processor after spinning a 
+ * while to keep progressing if a lock holder is preempted.
+ *
+ * Select one of the following backends at build time:
+ * - AMP_USE_TTAS_SPINLOCKS for a test-and-test-and-set lock with exponential
+ *   backoff. Cheapest uncontended, unfair under contention.
+ * - AMP_USE_TICKET_SPINLOCKS for a ticket lock which hands the lock to 
+ *   waiting threads in FIFO order.
+ * - AMP_USE_MCS_SPINLOCKS for an MCS queue lock which hands the lock to 
+ *   waiting threads in FIFO order and where each waiting thread spins on its
+ *   own memory location so the lock scales to many waiting threads.
+ *
+ * @attention If the thread already holding the spinlock calls 
+ *            amp_spinlock_lock recursively it deadlocks.
+ *
+ * @attention If a thread that isn't holding the spinlock tries to unlock 
+ *            it behavior is undefined.
+ *
+ * @attention If an invalid spinlock is passed to any function behavior is 
+ *            undefined.
+ */
+
+#ifndef AMP_amp_spinlock_H
+#define AMP_amp_spinlock_H
+
+#include <stddef.h>
+
+#include <amp/amp_memory.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+    
+#define AMP_SPINLOCK_UNINITIALIZED NULL
+    
+    
+    /**
+     * Non-recursive spinlock.
+     * See amp_raw_spinlock_s.
+     * Can be moved or copied - but every copy identifies the same spinlock - 
+     * manage ownership and reference counts yourself.
+     */
+    typedef struct amp_raw_spinlock_s *amp_spinlock_t;
+    
+    
+    
+    /**
+     * Allocates and initializes an amp_spinlock_t before using it.
+     *
+     * If the initialization fails the allocator is called to free the
+     * already allocated memory which must not result in an error or otherwise
+     * behavior is undefined.
+     *
+     * @return AMP_SUCCESS is returned on successful initialization.
+     *         AMP_NOMEM is returned if memory is insufficient.
+     */
+    int amp_spinlock_create(amp_spinlock_t* spinlock,
+                            amp_allocator_t allocator);
+    
+    /**
+     * Finalizes the spinlock and frees its memory.
+     *
+     * @return AMP_SUCCESS on successful destruction of the spinlock.
+     *         Error codes might be returned to signal errors while
+     *         finalizing, too. These are programming errors and mustn't 
+     *         occur in release code. When @em amp is compiled without NDEBUG
+     *         set it might assert that these programming errors don't happen.
+     *         AMP_BUSY if the spinlock is locked by a thread.
+     *
+     * @attention Only call for spinlocks which aren't locked by any thread 
+     *            and for which no threads are waiting.
+     */
+    int amp_spinlock_destroy(amp_spinlock_t* spinlock,
+                             amp_allocator_t allocator);
+    
+    /**
+     * Locks the spinlock or, if another thread holds the lock, busy-waits 
+     * until it gathers the lock.
+     *
+     * @return AMP_SUCCESS is returned if locking is successful.
+     *
+     * @attention Trying to recursively lock a spinlock from the same thread
+     *            deadlocks. Never lock recursively.
+     */
+    int amp_spinlock_lock(amp_spinlock_t spinlock);
+    
+    /**
+     * Locks the spinlock or, if the spinlock is already locked, returns with 
+     * an error code without waiting.
+     *
+     * @return AMP_SUCCESS if the lock has been taken.
+     *         AMP_BUSY if lock hasn't been taken because it is locked by  
+     *         another thread.
+     *
+     * @attention Don't enter the critical section if an error code is returned
+     *            because the lock hasn't been taken.
+     */
+    int amp_spinlock_trylock(amp_spinlock_t spinlock);
+    
+    /**
+     * Unlocks the spinlock.
+     *
+     * @return AMP_SUCCESS after successful unlocking.
+     *         Error codes might be returned to signal errors while
+     *         unlocking, too. These are programming errors and mustn't 
+     *         occur in release code. When @em amp is compiled without NDEBUG
+     *         set it might assert that these programming errors don't happen.
+     *         AMP_ERROR if the spinlock isn't locked.
+     *
+     * @attention Only the thread holding the lock is allowed to unlock it, 
+     *            otherwise behavior is undefined.
+     */
+    int amp_spinlock_unlock(amp_spinlock_t spinlock);
+    
+    
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+    
+
+#endif /* AMP_amp_spinlock_H */
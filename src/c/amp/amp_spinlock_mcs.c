@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of amp_spinlock as an MCS queue lock. Selected by defining
+ * AMP_USE_MCS_SPINLOCKS.
+ *
+ * Waiting threads enqueue a node and each one spins on its own node until 
+ * its predecessor hands the lock over by writing to it. The lock is handed 
+ * to waiting threads in FIFO order and unlocking only touches the cache line
+ * of the next waiting thread instead of one shared by all of them.
+ *
+ * The original MCS lock needs a queue node per lock and holding thread that 
+ * is passed to lock and unlock. This is the variant by the IBM K42 project 
+ * which fits the amp_spinlock_lock and amp_spinlock_unlock interface: the 
+ * lock itself serves as the node of its holder, and waiting threads use a 
+ * node on their stack which they leave behind the moment they get the lock.
+ *
+ * amp_spinlock_create and amp_spinlock_destroy are implemented in 
+ * amp_spinlock_common.c.
+ *
+ * See John M. Mellor-Crummey and Michael L. Scott, Algorithms for Scalable 
+ * Synchronization on Shared-Memory Multiprocessors, ACM Transactions on 
+ * Computer Systems, Vol. 9, No. 1, 1991, pp. 21-65.
+ *
+ * See Michael L. Scott, Shared-Memory Synchronization, Morgan & Claypool, 
+ * 2013, pp. 59.
+ */
+
+#include "amp_spinlock.h"
+
+#include <assert.h>
+#include <stddef.h>
+
+#include "amp_return_code.h"
+#include "amp_raw_spinlock.h"
+#include "amp_atomic.h"
+#include "amp_internal_spinlock.h"
+
+
+
+#if !defined(AMP_USE_MCS_SPINLOCKS)
+#   error Build configuration problem - this source file shouldn't be compiled.
+#endif
+
+
+
+/**
+ * Its address marks the tail field of a waiting node that hasn't got the 
+ * lock yet.
+ */
+static char amp_internal_mcs_spinlock_waiting_marker;
+
+
+
+int amp_raw_spinlock_init(amp_spinlock_t spinlock)
+{
+    assert(NULL != spinlock);
+    
+    amp_atomic_ptr_store(&spinlock->next, NULL, amp_memory_order_relaxed);
+    amp_atomic_ptr_store(&spinlock->tail, NULL, amp_memory_order_release);
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_raw_spinlock_finalize(amp_spinlock_t spinlock)
+{
+    assert(NULL != spinlock);
+    
+    if (NULL != amp_atomic_ptr_load(&spinlock->tail, amp_memory_order_acquire)) {
+        assert(0); /* Programming error */
+        return AMP_BUSY;
+    }
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_spinlock_lock(amp_spinlock_t spinlock)
+{
+    assert(NULL != spinlock);
+    
+    for (;;) {
+        void* predecessor = amp_atomic_ptr_load(&spinlock->tail, amp_memory_order_relaxed);
+        
+        if (NULL == predecessor) {
+            /* Looks unlocked - the lock becomes the node of its holder. */
+            if (amp_atomic_ptr_compare_exchange(&spinlock->tail,
+                                                &predecessor,
+                                                spinlock,
+                                                amp_memory_order_acquire,
+                                                amp_memory_order_relaxed)) {
+                return AMP_SUCCESS;
+            }
+        } else {
+            struct amp_raw_spinlock_s node;
+            
+            amp_atomic_ptr_store(&node.tail, &amp_internal_mcs_spinlock_waiting_marker, amp_memory_order_relaxed);
+            amp_atomic_ptr_store(&node.next, NULL, amp_memory_order_relaxed);
+            
+            if (amp_atomic_ptr_compare_exchange(&spinlock->tail,
+                                                &predecessor,
+                                                &node,
+                                                amp_memory_order_acq_rel,
+                                                amp_memory_order_relaxed)) {
+                
+                unsigned int spin_count = 0;
+                void* successor = NULL;
+                
+                amp_atomic_ptr_store(&((amp_spinlock_t)predecessor)->next, 
+                                     &node, 
+                                     amp_memory_order_release);
+                
+                while (&amp_internal_mcs_spinlock_waiting_marker == amp_atomic_ptr_load(&node.tail, amp_memory_order_acquire)) {
+                    amp_internal_spinlock_pause(&spin_count);
+                }
+                
+                /* Got the lock - move the link to the next waiting thread 
+                 * from the node into the lock before leaving the node.
+                 */
+                successor = amp_atomic_ptr_load(&node.next, amp_memory_order_acquire);
+                
+                if (NULL == successor) {
+                    void* expected_tail = &node;
+                    
+                    amp_atomic_ptr_store(&spinlock->next, NULL, amp_memory_order_relaxed);
+                    
+                    if (!amp_atomic_ptr_compare_exchange(&spinlock->tail,
+                                                         &expected_tail,
+                                                         spinlock,
+                                                         amp_memory_order_release,
+                                                         amp_memory_order_relaxed)) {
+                        
+                        /* Another thread enqueued behind node, wait till 
+                         * it linked itself to node.
+                         */
+                        while (NULL == (successor = amp_atomic_ptr_load(&node.next, amp_memory_order_acquire))) {
+                            amp_internal_spinlock_pause(&spin_count);
+                        }
+                        
+                        amp_atomic_ptr_store(&spinlock->next, successor, amp_memory_order_relaxed);
+                    }
+                } else {
+                    amp_atomic_ptr_store(&spinlock->next, successor, amp_memory_order_relaxed);
+                }
+                
+                return AMP_SUCCESS;
+            }
+        }
+    }
+}
+
+
+
+int amp_spinlock_trylock(amp_spinlock_t spinlock)
+{
+    void* expected_tail = NULL;
+    
+    assert(NULL != spinlock);
+    
+    if (amp_atomic_ptr_compare_exchange(&spinlock->tail,
+                                        &expected_tail,
+                                        spinlock,
+                                        amp_memory_order_acquire,
+                                        amp_memory_order_relaxed)) {
+        return AMP_SUCCESS;
+    }
+    
+    return AMP_BUSY;
+}
+
+
+
+int amp_spinlock_unlock(amp_spinlock_t spinlock)
+{
+    void* successor = NULL;
+    
+    assert(NULL != spinlock);
+    
+    successor = amp_atomic_ptr_load(&spinlock->next, amp_memory_order_acquire);
+    
+    if (NULL == successor) {
+        void* expected_tail = spinlock;
+        
+        if (amp_atomic_ptr_compare_exchange(&spinlock->tail,
+                                            &expected_tail,
+                                            NULL,
+                                            amp_memory_order_release,
+                                            amp_memory_order_relaxed)) {
+            return AMP_SUCCESS;
+        }
+        
+        if (NULL == expected_tail) {
+            assert(0); /* Programming error - spinlock isn't locked */
+            return AMP_ERROR;
+        }
+        
+        /* A thread is enqueuing, wait till it linked itself to the lock. */
+        {
+            unsigned int spin_count = 0;
+            
+            while (NULL == (successor = amp_atomic_ptr_load(&spinlock->next, amp_memory_order_acquire))) {
+                amp_internal_spinlock_pause(&spin_count);
+            }
+        }
+    }
+    
+    /* Hand the lock over - the lock mustn't be touched afterwards. */
+    amp_atomic_ptr_store(&((amp_spinlock_t)successor)->tail, 
+                         NULL, 
+                         amp_memory_order_release);
+    
+    return AMP_SUCCESS;
+}
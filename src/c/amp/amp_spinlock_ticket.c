@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of amp_spinlock as a ticket lock. Selected by defining
+ * AMP_USE_TICKET_SPINLOCKS.
+ *
+ * Every arriving thread draws a ticket with one atomic increment and waits 
+ * until the lock serves its ticket. Unlocking serves the next ticket, so 
+ * threads get the lock in the order they arrived and no thread starves. 
+ * Ticket numbers wrap around which is harmless as long as less than INT_MAX 
+ * threads wait at the same time.
+ *
+ * amp_spinlock_create and amp_spinlock_destroy are implemented in 
+ * amp_spinlock_common.c.
+ *
+ * See John M. Mellor-Crummey and Michael L. Scott, Algorithms for Scalable 
+ * Synchronization on Shared-Memory Multiprocessors, ACM Transactions on 
+ * Computer Systems, Vol. 9, No. 1, 1991, pp. 21-65.
+ */
+
+#include "amp_spinlock.h"
+
+#include <assert.h>
+#include <stddef.h>
+
+#include "amp_return_code.h"
+#include "amp_raw_spinlock.h"
+#include "amp_atomic.h"
+#include "amp_internal_spinlock.h"
+
+
+
+#if !defined(AMP_USE_TICKET_SPINLOCKS)
+#   error Build configuration problem - this source file shouldn't be compiled.
+#endif
+
+
+
+/**
+ * Returns the ticket following ticket, wrapping around at INT_MAX.
+ */
+static int amp_internal_spinlock_next_ticket(int ticket);
+static int amp_internal_spinlock_next_ticket(int ticket)
+{
+    return (int)((unsigned int)ticket + 1u);
+}
+
+
+
+int amp_raw_spinlock_init(amp_spinlock_t spinlock)
+{
+    assert(NULL != spinlock);
+    
+    amp_atomic_int_store(&spinlock->now_serving, 0, amp_memory_order_relaxed);
+    amp_atomic_int_store(&spinlock->next_ticket, 0, amp_memory_order_release);
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_raw_spinlock_finalize(amp_spinlock_t spinlock)
+{
+    assert(NULL != spinlock);
+    
+    if (amp_atomic_int_load(&spinlock->next_ticket, amp_memory_order_acquire) 
+        != amp_atomic_int_load(&spinlock->now_serving, amp_memory_order_acquire)) {
+        
+        assert(0); /* Programming error */
+        return AMP_BUSY;
+    }
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_spinlock_lock(amp_spinlock_t spinlock)
+{
+    int ticket = 0;
+    unsigned int spin_count = 0;
+    
+    assert(NULL != spinlock);
+    
+    ticket = amp_atomic_int_fetch_add(&spinlock->next_ticket, 
+                                      1, 
+                                      amp_memory_order_relaxed);
+    
+    while (ticket != amp_atomic_int_load(&spinlock->now_serving, amp_memory_order_acquire)) {
+        amp_internal_spinlock_pause(&spin_count);
+    }
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_spinlock_trylock(amp_spinlock_t spinlock)
+{
+    int ticket = 0;
+    
+    assert(NULL != spinlock);
+    
+    /* Only draw a ticket if it is served immediately. */
+    ticket = amp_atomic_int_load(&spinlock->now_serving, amp_memory_order_relaxed);
+    
+    if (amp_atomic_int_compare_exchange(&spinlock->next_ticket,
+                                        &ticket,
+                                        amp_internal_spinlock_next_ticket(ticket),
+                                        amp_memory_order_acquire,
+                                        amp_memory_order_relaxed)) {
+        return AMP_SUCCESS;
+    }
+    
+    return AMP_BUSY;
+}
+
+
+
+int amp_spinlock_unlock(amp_spinlock_t spinlock)
+{
+    int ticket = 0;
+    
+    assert(NULL != spinlock);
+    
+    /* Only the lock holder changes now_serving. */
+    ticket = amp_atomic_int_load(&spinlock->now_serving, amp_memory_order_relaxed);
+    
+    if (ticket == amp_atomic_int_load(&spinlock->next_ticket, amp_memory_order_relaxed)) {
+        assert(0); /* Programming error - spinlock isn't locked */
+        return AMP_ERROR;
+    }
+    
+    amp_atomic_int_store(&spinlock->now_serving, 
+                         amp_internal_spinlock_next_ticket(ticket), 
+                         amp_memory_order_release);
+    
+    return AMP_SUCCESS;
+}
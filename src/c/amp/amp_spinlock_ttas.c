@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of amp_spinlock as a test-and-test-and-set lock with 
+ * exponential backoff. Selected by defining AMP_USE_TTAS_SPINLOCKS.
+ *
+ * Waiting threads only read the lock state (which stays in their caches) 
+ * until it looks free before trying to take it with an atomic exchange. A 
+ * thread that lost the race backs off for an exponentially growing number of
+ * cycles so waiting threads don't all try to take the lock at the same time
+ * after it is released.
+ *
+ * amp_spinlock_create and amp_spinlock_destroy are implemented in 
+ * amp_spinlock_common.c.
+ *
+ * See Maurice Herlihy and Nir Shavit, The Art of Multiprocessor Programming, 
+ * Morgan Kaufmann, 2008, pp. 144.
+ */
+
+#include "amp_spinlock.h"
+
+#include <assert.h>
+#include <stddef.h>
+
+#include "amp_return_code.h"
+#include "amp_raw_spinlock.h"
+#include "amp_atomic.h"
+#include "amp_internal_spinlock.h"
+
+
+
+#if !defined(AMP_USE_TTAS_SPINLOCKS)
+#   error Build configuration problem - this source file shouldn't be compiled.
+#endif
+
+
+
+#if !defined(AMP_TTAS_SPINLOCK_MAX_BACKOFF)
+/**
+ * Maximal number of processor spin hints a thread backs off after failing 
+ * to take the lock.
+ */
+#   define AMP_TTAS_SPINLOCK_MAX_BACKOFF 1024
+#endif
+
+
+
+int amp_raw_spinlock_init(amp_spinlock_t spinlock)
+{
+    assert(NULL != spinlock);
+    
+    amp_atomic_int_store(&spinlock->state, 0, amp_memory_order_release);
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_raw_spinlock_finalize(amp_spinlock_t spinlock)
+{
+    assert(NULL != spinlock);
+    
+    if (0 != amp_atomic_int_load(&spinlock->state, amp_memory_order_acquire)) {
+        assert(0); /* Programming error */
+        return AMP_BUSY;
+    }
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_spinlock_lock(amp_spinlock_t spinlock)
+{
+    unsigned int backoff = 1;
+    unsigned int spin_count = 0;
+    
+    assert(NULL != spinlock);
+    
+    while (0 != amp_atomic_int_exchange(&spinlock->state, 1, amp_memory_order_acquire)) {
+        
+        unsigned int i = 0;
+        
+        for (i = 0; i < backoff; ++i) {
+            amp_atomic_cpu_relax();
+        }
+        if (backoff < AMP_TTAS_SPINLOCK_MAX_BACKOFF) {
+            backoff *= 2;
+        }
+        
+        while (0 != amp_atomic_int_load(&spinlock->state, amp_memory_order_relaxed)) {
+            amp_internal_spinlock_pause(&spin_count);
+        }
+    }
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_spinlock_trylock(amp_spinlock_t spinlock)
+{
+    assert(NULL != spinlock);
+    
+    if ((0 == amp_atomic_int_load(&spinlock->state, amp_memory_order_relaxed))
+        && (0 == amp_atomic_int_exchange(&spinlock->state, 1, amp_memory_order_acquire))) {
+        
+        return AMP_SUCCESS;
+    }
+    
+    return AMP_BUSY;
+}
+
+
+
+int amp_spinlock_unlock(amp_spinlock_t spinlock)
+{
+    assert(NULL != spinlock);
+    
+    if (0 == amp_atomic_int_load(&spinlock->state, amp_memory_order_relaxed)) {
+        assert(0); /* Programming error - spinlock isn't locked */
+        return AMP_ERROR;
+    }
+    
+    amp_atomic_int_store(&spinlock->state, 0, amp_memory_order_release);
+    
+    return AMP_SUCCESS;
+}
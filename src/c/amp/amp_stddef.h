@@ -76,6 +76,19 @@ extern "C" {
 #   define AMP_BYTE unsigned char
 #endif
 
+    
+    
+#if !defined(AMP_CACHE_LINE_SIZE)
+/**
+ * Assumed size of a cache line in bytes used to pad data that is written
+ * concurrently by different threads to prevent false sharing.
+ *
+ * Define AMP_CACHE_LINE_SIZE if the target platform uses a different cache
+ * line size. Use amp_platform to query the actual cache line size at runtime.
+ */
+#   define AMP_CACHE_LINE_SIZE 64
+#endif
+
 
 typedef AMP_BOOL amp_bool_t;
 typedef AMP_BYTE amp_byte_t;
@@ -0,0 +1,658 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of amp_task_graph on top of amp_scheduler.
+ *
+ * Nodes and edges are appended to arrays that double their capacity. The 
+ * first execution after a change counts the predecessors of every node, 
+ * gathers the successors of all nodes in one array indexed by the nodes, 
+ * and sorts the nodes topologically, which also detects cycles. Later 
+ * executions only reset the atomic predecessor counters.
+ *
+ * The execution is a root task on the scheduler that spawns all nodes 
+ * without predecessors into one group and waits for it. A finishing node 
+ * spawns every successor whose counter it decrements to zero into the same
+ * group. If a spawn fails for lack of memory the spawning thread runs the
+ * node itself.
+ *
+ * After the execution the calling thread walks the nodes in topological 
+ * order to find the longest path of measured task run times.
+ *
+ * Run times are measured with QueryPerformanceCounter on Windows, with 
+ * mach_absolute_time on Mac OS X, and with the POSIX monotonic clock 
+ * elsewhere.
+ */
+
+#if !defined(_WIN32) && !defined(__APPLE__) && !defined(_POSIX_C_SOURCE)
+#   define _POSIX_C_SOURCE 200112L /* clock_gettime */
+#endif
+
+#include "amp_task_graph.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#   define WIN32_LEAN_AND_MEAN
+#   include <windows.h>
+#elif defined(__APPLE__)
+#   include <mach/mach_time.h>
+#elif defined(__unix__)
+#   include <time.h>
+#   include <unistd.h>
+#endif
+
+#include "amp_stddef.h"
+#include "amp_return_code.h"
+#include "amp_atomic.h"
+#include "amp_memory.h"
+#include "amp_scheduler.h"
+#include "amp_raw_scheduler.h"
+
+
+
+#if defined(_WIN32)
+#   define AMP_INTERNAL_TASK_GRAPH_USE_QUERY_PERFORMANCE_COUNTER
+#elif defined(__APPLE__)
+#   define AMP_INTERNAL_TASK_GRAPH_USE_MACH_ABSOLUTE_TIME
+#elif defined(_POSIX_TIMERS) && (_POSIX_TIMERS > 0) && defined(CLOCK_MONOTONIC)
+#   define AMP_INTERNAL_TASK_GRAPH_USE_CLOCK_GETTIME
+#else
+#   error Unsupported platform - no monotonic clock to measure task run times.
+#endif
+
+
+
+/**
+ * Number of nodes or edges the graph can hold before it grows the first 
+ * time.
+ */
+#define AMP_INTERNAL_TASK_GRAPH_INITIAL_CAPACITY ((size_t)16)
+
+
+
+struct amp_internal_task_graph_node_s {
+    amp_atomic_size_t pending_predecessor_count;
+    
+    amp_thread_func_t func;
+    void* context;
+    struct amp_task_graph_s* graph;
+    
+    /* Set when the graph is sorted. */
+    size_t predecessor_count;
+    size_t first_successor;
+    size_t successor_count;
+    
+    /* Measured by the execution. */
+    double start_time;
+    double finish_time;
+    
+    /* Longest path ending in a predecessor, used to find the critical path.*/
+    double predecessor_path_time;
+    size_t predecessor_path_node_count;
+};
+
+
+struct amp_internal_task_graph_edge_s {
+    size_t predecessor;
+    size_t successor;
+};
+
+
+/**
+ * Internal opaque task graph data structure
+ */
+struct amp_task_graph_s {
+    struct amp_internal_task_graph_node_s* nodes;
+    size_t node_count;
+    size_t node_capacity;
+    
+    struct amp_internal_task_graph_edge_s* edges;
+    size_t edge_count;
+    size_t edge_capacity;
+    
+    /* Built when sorting, valid while sorted is nonzero. */
+    size_t* successors;
+    size_t* topological_order;
+    int sorted;
+    
+    /* Only valid during an execution. */
+    amp_scheduler_t scheduler;
+    struct amp_raw_scheduler_group_s group;
+    
+    struct amp_task_graph_statistics_s statistics;
+    
+    amp_allocator_t allocator;
+};
+
+
+
+/**
+ * Returns the seconds elapsed since an arbitrary fixed point in time.
+ */
+static double amp_internal_task_graph_time(void);
+static double amp_internal_task_graph_time(void)
+{
+#if defined(AMP_INTERNAL_TASK_GRAPH_USE_QUERY_PERFORMANCE_COUNTER)
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER now;
+    BOOL retval = QueryPerformanceFrequency(&frequency);
+    assert(FALSE != retval);
+    retval = QueryPerformanceCounter(&now);
+    assert(FALSE != retval);
+    (void)retval;
+    
+    return (double)now.QuadPart / (double)frequency.QuadPart;
+#elif defined(AMP_INTERNAL_TASK_GRAPH_USE_MACH_ABSOLUTE_TIME)
+    mach_timebase_info_data_t timebase;
+    kern_return_t const retval = mach_timebase_info(&timebase);
+    assert(KERN_SUCCESS == retval);
+    (void)retval;
+    
+    return (double)mach_absolute_time() * (double)timebase.numer / (double)timebase.denom * 1.0e-9;
+#elif defined(AMP_INTERNAL_TASK_GRAPH_USE_CLOCK_GETTIME)
+    struct timespec now;
+    int const retval = clock_gettime(CLOCK_MONOTONIC, &now);
+    assert(0 == retval);
+    (void)retval;
+    
+    return (double)now.tv_sec + (double)now.tv_nsec * 1.0e-9;
+#else
+#   error Unsupported platform.
+#endif
+}
+
+
+/**
+ * Doubles the capacity of the array pointed to by array. On error the 
+ * array is unchanged.
+ */
+static int amp_internal_task_graph_grow(amp_allocator_t allocator,
+                                        void** array,
+                                        size_t* capacity,
+                                        size_t count,
+                                        size_t element_size)
+{
+    size_t const new_capacity = (0 == *capacity) ? AMP_INTERNAL_TASK_GRAPH_INITIAL_CAPACITY : 2 * *capacity;
+    void* new_array = NULL;
+    int retval = AMP_UNSUPPORTED;
+    
+    new_array = AMP_ALLOC(allocator, new_capacity * element_size);
+    if (NULL == new_array) {
+        return AMP_NOMEM;
+    }
+    
+    if (NULL != *array) {
+        memcpy(new_array, *array, count * element_size);
+        
+        retval = AMP_DEALLOC(allocator, *array);
+        assert(AMP_SUCCESS == retval);
+        (void)retval;
+    }
+    
+    *array = new_array;
+    *capacity = new_capacity;
+    
+    return AMP_SUCCESS;
+}
+
+
+static void amp_internal_task_graph_free_sorting(struct amp_task_graph_s* graph)
+{
+    int retval = AMP_SUCCESS;
+    
+    if (NULL != graph->successors) {
+        retval = AMP_DEALLOC(graph->allocator, graph->successors);
+        assert(AMP_SUCCESS == retval);
+        graph->successors = NULL;
+    }
+    
+    if (NULL != graph->topological_order) {
+        retval = AMP_DEALLOC(graph->allocator, graph->topological_order);
+        assert(AMP_SUCCESS == retval);
+        graph->topological_order = NULL;
+    }
+    (void)retval;
+    
+    graph->sorted = 0;
+}
+
+
+/**
+ * Gathers the successors of every node and sorts the nodes topologically.
+ *
+ * @return AMP_SUCCESS, AMP_NOMEM, or AMP_ERROR if the graph has a cycle.
+ */
+static int amp_internal_task_graph_sort(struct amp_task_graph_s* graph)
+{
+    struct amp_internal_task_graph_node_s* const nodes = graph->nodes;
+    size_t sorted_count = 0;
+    size_t ready_count = 0;
+    size_t offset = 0;
+    size_t i = 0;
+    
+    amp_internal_task_graph_free_sorting(graph);
+    
+    graph->topological_order = (size_t*)AMP_ALLOC(graph->allocator, 
+                                                  graph->node_count * sizeof(size_t));
+    if (NULL == graph->topological_order) {
+        return AMP_NOMEM;
+    }
+    
+    if (0 != graph->edge_count) {
+        graph->successors = (size_t*)AMP_ALLOC(graph->allocator,
+                                               graph->edge_count * sizeof(size_t));
+        if (NULL == graph->successors) {
+            amp_internal_task_graph_free_sorting(graph);
+            return AMP_NOMEM;
+        }
+    }
+    
+    for (i = 0; i < graph->node_count; ++i) {
+        nodes[i].predecessor_count = 0;
+        nodes[i].successor_count = 0;
+    }
+    
+    for (i = 0; i < graph->edge_count; ++i) {
+        ++(nodes[graph->edges[i].predecessor].successor_count);
+        ++(nodes[graph->edges[i].successor].predecessor_count);
+    }
+    
+    for (i = 0; i < graph->node_count; ++i) {
+        nodes[i].first_successor = offset;
+        offset += nodes[i].successor_count;
+        nodes[i].successor_count = 0;
+    }
+    
+    for (i = 0; i < graph->edge_count; ++i) {
+        struct amp_internal_task_graph_node_s* const predecessor = &nodes[graph->edges[i].predecessor];
+        
+        graph->successors[predecessor->first_successor + predecessor->successor_count] = graph->edges[i].successor;
+        ++(predecessor->successor_count);
+    }
+    
+    /* Kahn's algorithm, the sorted prefix of topological_order doubles as 
+     * the queue of ready nodes.
+     */
+    for (i = 0; i < graph->node_count; ++i) {
+        amp_atomic_size_store(&nodes[i].pending_predecessor_count,
+                              nodes[i].predecessor_count,
+                              amp_memory_order_relaxed);
+        if (0 == nodes[i].predecessor_count) {
+            graph->topological_order[ready_count++] = i;
+        }
+    }
+    
+    for (sorted_count = 0; sorted_count < ready_count; ++sorted_count) {
+        struct amp_internal_task_graph_node_s* const node = &nodes[graph->topological_order[sorted_count]];
+        
+        for (i = node->first_successor; i < node->first_successor + node->successor_count; ++i) {
+            size_t const successor = graph->successors[i];
+            size_t const pending = amp_atomic_size_load(&nodes[successor].pending_predecessor_count,
+                                                        amp_memory_order_relaxed) - 1;
+            
+            amp_atomic_size_store(&nodes[successor].pending_predecessor_count,
+                                  pending,
+                                  amp_memory_order_relaxed);
+            if (0 == pending) {
+                graph->topological_order[ready_count++] = successor;
+            }
+        }
+    }
+    
+    if (sorted_count != graph->node_count) {
+        amp_internal_task_graph_free_sorting(graph);
+        return AMP_ERROR;
+    }
+    
+    graph->sorted = 1;
+    
+    return AMP_SUCCESS;
+}
+
+
+
+static void amp_internal_task_graph_node_func(void* context)
+{
+    struct amp_internal_task_graph_node_s* const node = 
+        (struct amp_internal_task_graph_node_s*)context;
+    struct amp_task_graph_s* const graph = node->graph;
+    size_t i = 0;
+    
+    node->start_time = amp_internal_task_graph_time();
+    node->func(node->context);
+    node->finish_time = amp_internal_task_graph_time();
+    
+    for (i = node->first_successor; i < node->first_successor + node->successor_count; ++i) {
+        struct amp_internal_task_graph_node_s* const successor = &graph->nodes[graph->successors[i]];
+        
+        /* Releases the results of this node to the successor, the last 
+         * predecessor acquires the results of all others.
+         */
+        if (1 == amp_atomic_size_fetch_sub(&successor->pending_predecessor_count,
+                                           1,
+                                           amp_memory_order_acq_rel)) {
+            
+            if (AMP_SUCCESS != amp_scheduler_spawn(graph->scheduler,
+                                                   &graph->group,
+                                                   successor,
+                                                   &amp_internal_task_graph_node_func)) {
+                amp_internal_task_graph_node_func(successor);
+            }
+        }
+    }
+}
+
+
+static void amp_internal_task_graph_root_func(void* context)
+{
+    struct amp_task_graph_s* const graph = (struct amp_task_graph_s*)context;
+    size_t i = 0;
+    int retval = AMP_UNSUPPORTED;
+    
+    retval = amp_raw_scheduler_group_init(&graph->group);
+    assert(AMP_SUCCESS == retval);
+    
+    /* Nodes without predecessors lead the topological order. */
+    for (i = 0; (i < graph->node_count) && (0 == graph->nodes[graph->topological_order[i]].predecessor_count); ++i) {
+        struct amp_internal_task_graph_node_s* const node = &graph->nodes[graph->topological_order[i]];
+        
+        if (AMP_SUCCESS != amp_scheduler_spawn(graph->scheduler,
+                                               &graph->group,
+                                               node,
+                                               &amp_internal_task_graph_node_func)) {
+            amp_internal_task_graph_node_func(node);
+        }
+    }
+    
+    retval = amp_scheduler_group_wait(graph->scheduler, &graph->group);
+    assert(AMP_SUCCESS == retval);
+    
+    retval = amp_raw_scheduler_group_finalize(&graph->group);
+    assert(AMP_SUCCESS == retval);
+    (void)retval;
+}
+
+
+static void amp_internal_task_graph_measure(struct amp_task_graph_s* graph,
+                                            double elapsed_time)
+{
+    struct amp_internal_task_graph_node_s* const nodes = graph->nodes;
+    struct amp_task_graph_statistics_s* const statistics = &graph->statistics;
+    size_t i = 0;
+    size_t j = 0;
+    
+    statistics->elapsed_time = elapsed_time;
+    statistics->work_time = 0.0;
+    statistics->critical_path_time = 0.0;
+    statistics->critical_path_node_count = 0;
+    
+    for (i = 0; i < graph->node_count; ++i) {
+        nodes[i].predecessor_path_time = 0.0;
+        nodes[i].predecessor_path_node_count = 0;
+    }
+    
+    for (i = 0; i < graph->node_count; ++i) {
+        struct amp_internal_task_graph_node_s* const node = &nodes[graph->topological_order[i]];
+        double const run_time = node->finish_time - node->start_time;
+        double const path_time = node->predecessor_path_time + run_time;
+        size_t const path_node_count = node->predecessor_path_node_count + 1;
+        
+        statistics->work_time += run_time;
+        
+        if ((path_time > statistics->critical_path_time) 
+            || (0 == statistics->critical_path_node_count)) {
+            statistics->critical_path_time = path_time;
+            statistics->critical_path_node_count = path_node_count;
+        }
+        
+        for (j = node->first_successor; j < node->first_successor + node->successor_count; ++j) {
+            struct amp_internal_task_graph_node_s* const successor = &nodes[graph->successors[j]];
+            
+            if ((path_time > successor->predecessor_path_time)
+                || (0 == successor->predecessor_path_node_count)) {
+                successor->predecessor_path_time = path_time;
+                successor->predecessor_path_node_count = path_node_count;
+            }
+        }
+    }
+    
+    statistics->achieved_parallelism = (0.0 < elapsed_time) ? statistics->work_time / elapsed_time : 0.0;
+    statistics->available_parallelism = (0.0 < statistics->critical_path_time) ? statistics->work_time / statistics->critical_path_time : 0.0;
+}
+
+
+
+int amp_task_graph_create(amp_task_graph_t* graph,
+                          amp_allocator_t allocator)
+{
+    struct amp_task_graph_s* tmp = NULL;
+    
+    assert(NULL != graph);
+    assert(NULL != allocator);
+    
+    tmp = (struct amp_task_graph_s*)AMP_CALLOC(allocator, 1, sizeof(*tmp));
+    if (NULL == tmp) {
+        return AMP_NOMEM;
+    }
+    
+    tmp->nodes = NULL;
+    tmp->edges = NULL;
+    tmp->successors = NULL;
+    tmp->topological_order = NULL;
+    tmp->scheduler = AMP_SCHEDULER_UNINITIALIZED;
+    tmp->allocator = allocator;
+    
+    *graph = tmp;
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_task_graph_destroy(amp_task_graph_t* graph,
+                           amp_allocator_t allocator)
+{
+    struct amp_task_graph_s* tmp = NULL;
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != graph);
+    assert(NULL != *graph);
+    assert(NULL != allocator);
+    
+    tmp = *graph;
+    
+    amp_internal_task_graph_free_sorting(tmp);
+    
+    if (NULL != tmp->nodes) {
+        retval = AMP_DEALLOC(allocator, tmp->nodes);
+        assert(AMP_SUCCESS == retval);
+    }
+    
+    if (NULL != tmp->edges) {
+        retval = AMP_DEALLOC(allocator, tmp->edges);
+        assert(AMP_SUCCESS == retval);
+    }
+    
+    retval = AMP_DEALLOC(allocator, tmp);
+    assert(AMP_SUCCESS == retval);
+    
+    *graph = AMP_TASK_GRAPH_UNINITIALIZED;
+    
+    return retval;
+}
+
+
+
+int amp_task_graph_add_node(amp_task_graph_t graph,
+                            void* context,
+                            amp_thread_func_t func,
+                            size_t* node)
+{
+    struct amp_internal_task_graph_node_s* new_node = NULL;
+    
+    assert(NULL != graph);
+    assert(NULL != func);
+    assert(NULL != node);
+    
+    if (graph->node_count == graph->node_capacity) {
+        void* nodes = graph->nodes;
+        int const retval = amp_internal_task_graph_grow(graph->allocator,
+                                                        &nodes,
+                                                        &graph->node_capacity,
+                                                        graph->node_count,
+                                                        sizeof(*graph->nodes));
+        if (AMP_SUCCESS != retval) {
+            return retval;
+        }
+        graph->nodes = (struct amp_internal_task_graph_node_s*)nodes;
+    }
+    
+    new_node = &graph->nodes[graph->node_count];
+    amp_atomic_size_store(&new_node->pending_predecessor_count, 
+                          0, 
+                          amp_memory_order_relaxed);
+    new_node->func = func;
+    new_node->context = context;
+    new_node->graph = graph;
+    new_node->predecessor_count = 0;
+    new_node->first_successor = 0;
+    new_node->successor_count = 0;
+    new_node->start_time = 0.0;
+    new_node->finish_time = 0.0;
+    new_node->predecessor_path_time = 0.0;
+    new_node->predecessor_path_node_count = 0;
+    
+    *node = graph->node_count;
+    ++(graph->node_count);
+    graph->sorted = 0;
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_task_graph_add_edge(amp_task_graph_t graph,
+                            size_t predecessor,
+                            size_t successor)
+{
+    assert(NULL != graph);
+    
+    if ((predecessor >= graph->node_count) || (successor >= graph->node_count)) {
+        assert(0); /* Unknown node id */
+        return AMP_ERROR;
+    }
+    
+    if (graph->edge_count == graph->edge_capacity) {
+        void* edges = graph->edges;
+        int const retval = amp_internal_task_graph_grow(graph->allocator,
+                                                        &edges,
+                                                        &graph->edge_capacity,
+                                                        graph->edge_count,
+                                                        sizeof(*graph->edges));
+        if (AMP_SUCCESS != retval) {
+            return retval;
+        }
+        graph->edges = (struct amp_internal_task_graph_edge_s*)edges;
+    }
+    
+    graph->edges[graph->edge_count].predecessor = predecessor;
+    graph->edges[graph->edge_count].successor = successor;
+    ++(graph->edge_count);
+    graph->sorted = 0;
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_task_graph_execute(amp_task_graph_t graph,
+                           amp_scheduler_t scheduler)
+{
+    double start_time = 0.0;
+    size_t i = 0;
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != graph);
+    assert(NULL != scheduler);
+    
+    if (0 == graph->node_count) {
+        memset(&graph->statistics, 0, sizeof(graph->statistics));
+        return AMP_SUCCESS;
+    }
+    
+    if (0 == graph->sorted) {
+        retval = amp_internal_task_graph_sort(graph);
+        if (AMP_SUCCESS != retval) {
+            return retval;
+        }
+    }
+    
+    /* amp_scheduler_run publishes the counters to the workers. */
+    for (i = 0; i < graph->node_count; ++i) {
+        amp_atomic_size_store(&graph->nodes[i].pending_predecessor_count,
+                              graph->nodes[i].predecessor_count,
+                              amp_memory_order_relaxed);
+    }
+    
+    graph->scheduler = scheduler;
+    
+    start_time = amp_internal_task_graph_time();
+    retval = amp_scheduler_run(scheduler, 
+                               graph, 
+                               &amp_internal_task_graph_root_func);
+    if (AMP_SUCCESS == retval) {
+        amp_internal_task_graph_measure(graph, 
+                                        amp_internal_task_graph_time() - start_time);
+    }
+    
+    graph->scheduler = AMP_SCHEDULER_UNINITIALIZED;
+    
+    return retval;
+}
+
+
+
+int amp_task_graph_get_statistics(amp_task_graph_t graph,
+                                  struct amp_task_graph_statistics_s* statistics)
+{
+    assert(NULL != graph);
+    assert(NULL != statistics);
+    
+    *statistics = graph->statistics;
+    
+    return AMP_SUCCESS;
+}
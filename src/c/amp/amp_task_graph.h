@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Reusable task dependency graph executed on an amp_scheduler.
+ *
+ * Add a node per task and an edge from every task to each task that needs 
+ * its results, then execute the graph as often as needed, e.g. once per 
+ * frame. Every node keeps an atomic counter of unfinished predecessors. A 
+ * node without predecessors is spawned when the execution starts, every 
+ * other node is spawned by the predecessor that decrements its counter to 
+ * zero. Independent tasks therefore run as soon as their inputs are ready
+ * instead of waiting for the slowest task of a phase as with barriers.
+ *
+ * Adding nodes or edges allocates memory, and the next execution sorts the 
+ * graph once and checks it for cycles. Executing an unchanged graph again 
+ * doesn't allocate.
+ *
+ * Every execution measures the run time of each task. 
+ * amp_task_graph_get_statistics reports the critical path - the chain of 
+ * dependent tasks with the longest summed run time, which bounds how fast
+ * the graph can run on any number of workers - and the parallelism the 
+ * execution achieved.
+ *
+ * Example:
+ * @code
+ * size_t load, simulate, render;
+ * amp_task_graph_add_node(graph, &frame, load_func, &load);
+ * amp_task_graph_add_node(graph, &frame, simulate_func, &simulate);
+ * amp_task_graph_add_node(graph, &frame, render_func, &render);
+ * amp_task_graph_add_edge(graph, load, simulate);
+ * amp_task_graph_add_edge(graph, simulate, render);
+ *
+ * while (running) {
+ *     amp_task_graph_execute(graph, scheduler);
+ * }
+ * @endcode
+ *
+ * @attention Don't modify or execute a graph while it is executing.
+ *
+ * @attention Uses amp_scheduler and is therefore not included by amp.h.
+ */
+
+#ifndef AMP_amp_task_graph_H
+#define AMP_amp_task_graph_H
+
+#include <stddef.h>
+
+#include <amp/amp_memory.h>
+#include <amp/amp_thread.h>
+#include <amp/amp_scheduler.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+    
+#define AMP_TASK_GRAPH_UNINITIALIZED NULL
+    
+    /**
+     * Opaque type representing an amp task graph.
+     */
+    typedef struct amp_task_graph_s *amp_task_graph_t;
+    
+    
+    /**
+     * Measurements of the last execution of a task graph. All times are in
+     * seconds.
+     */
+    struct amp_task_graph_statistics_s {
+        /* Wall clock time from starting to finishing the execution. */
+        double elapsed_time;
+        /* Sum of the run times of all tasks. */
+        double work_time;
+        /* Summed run time of the tasks on the critical path. */
+        double critical_path_time;
+        /* Number of tasks on the critical path. */
+        size_t critical_path_node_count;
+        /* work_time / elapsed_time - the average number of busy workers. */
+        double achieved_parallelism;
+        /* work_time / critical_path_time - the upper bound of the achieved
+         * parallelism for the measured task run times.
+         */
+        double available_parallelism;
+    };
+    
+    
+    /**
+     * Allocates an empty task graph.
+     *
+     * allocator is stored in the graph to allocate memory for nodes and 
+     * edges and must stay valid until the graph is destroyed.
+     *
+     * @return AMP_SUCCESS on successful creation.
+     *         AMP_NOMEM if not enough memory is available.
+     */
+    int amp_task_graph_create(amp_task_graph_t* graph,
+                              amp_allocator_t allocator);
+    
+    /**
+     * Frees the memory of graph.
+     *
+     * allocator must be able to free the memory allocated by the allocator
+     * passed to amp_task_graph_create.
+     *
+     * @return AMP_SUCCESS after freeing the graph.
+     */
+    int amp_task_graph_destroy(amp_task_graph_t* graph,
+                               amp_allocator_t allocator);
+    
+    /**
+     * Adds a node that calls func with context when executed and stores its
+     * id in node. Node ids count up from 0 in the order nodes are added.
+     *
+     * @return AMP_SUCCESS if the node has been added.
+     *         AMP_NOMEM if not enough memory is available. The graph is
+     *         unchanged.
+     */
+    int amp_task_graph_add_node(amp_task_graph_t graph,
+                                void* context,
+                                amp_thread_func_t func,
+                                size_t* node);
+    
+    /**
+     * Adds an edge so that successor only starts after predecessor 
+     * finished. Adding the same edge twice is allowed but wasteful.
+     *
+     * @return AMP_SUCCESS if the edge has been added.
+     *         AMP_NOMEM if not enough memory is available. The graph is
+     *         unchanged.
+     *         AMP_ERROR if predecessor or successor aren't node ids of 
+     *         graph. This is a programming error and mustn't occur in 
+     *         release code.
+     */
+    int amp_task_graph_add_edge(amp_task_graph_t graph,
+                                size_t predecessor,
+                                size_t successor);
+    
+    /**
+     * Runs all tasks of graph on scheduler, respecting the edges, and 
+     * returns after all of them have finished. Must be called from a thread
+     * that isn't a worker of scheduler, see amp_scheduler_run.
+     *
+     * @return AMP_SUCCESS after all tasks ran.
+     *         AMP_NOMEM if the graph changed and not enough memory is 
+     *         available to sort it. No task ran.
+     *         AMP_ERROR if the edges form a cycle. No task ran.
+     *         Other error codes might be returned to signal errors, too. 
+     *         These are programming errors and mustn't occur in release code.
+     */
+    int amp_task_graph_execute(amp_task_graph_t graph,
+                               amp_scheduler_t scheduler);
+    
+    /**
+     * Stores the measurements of the last successful execution of graph in
+     * statistics. All values are zero if the graph hasn't been executed yet
+     * or has no nodes.
+     *
+     * @return AMP_SUCCESS.
+     */
+    int amp_task_graph_get_statistics(amp_task_graph_t graph,
+                                      struct amp_task_graph_statistics_s* statistics);
+    
+    
+    
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* AMP_amp_task_graph_H */
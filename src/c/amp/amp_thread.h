@@ -80,8 +80,107 @@ extern "C" {
      * Opaque thread type.
      */
     typedef struct amp_raw_thread_s *amp_thread_t;
-    
-    
+
+
+
+/**
+ * Number of logical CPUs (indices 0 to AMP_THREAD_AFFINITY_CPU_CAPACITY - 1)
+ * an amp_thread_affinity_s can describe. Changes the size of amp thread
+ * structs, therefore define it identically for amp and all code using it.
+ */
+#if !defined(AMP_THREAD_AFFINITY_CPU_CAPACITY)
+#   define AMP_THREAD_AFFINITY_CPU_CAPACITY 256
+#endif
+
+#define AMP_INTERNAL_THREAD_AFFINITY_WORD_BITS (sizeof(unsigned long) * 8)
+#define AMP_INTERNAL_THREAD_AFFINITY_WORD_COUNT ((AMP_THREAD_AFFINITY_CPU_CAPACITY + AMP_INTERNAL_THREAD_AFFINITY_WORD_BITS - 1) / AMP_INTERNAL_THREAD_AFFINITY_WORD_BITS)
+
+    /**
+     * Set of logical CPUs a thread is allowed to run on.
+     *
+     * An empty set means "no affinity configured" - the thread runs wherever
+     * the operating system schedules it. Treat the fields as opaque and use
+     * the amp_thread_affinity_ functions to manipulate the set.
+     */
+    struct amp_thread_affinity_s {
+        unsigned long cpu_bits[AMP_INTERNAL_THREAD_AFFINITY_WORD_COUNT];
+    };
+
+
+    /**
+     * Removes all CPUs from affinity.
+     */
+    int amp_thread_affinity_clear(struct amp_thread_affinity_s* affinity);
+
+    /**
+     * Adds the logical CPU with index cpu to affinity.
+     *
+     * @return AMP_SUCCESS on success.
+     *         AMP_ERROR if cpu is not smaller than
+     *         AMP_THREAD_AFFINITY_CPU_CAPACITY.
+     */
+    int amp_thread_affinity_add_cpu(struct amp_thread_affinity_s* affinity,
+                                    size_t cpu);
+
+    /**
+     * Removes the logical CPU with index cpu from affinity.
+     *
+     * @return AMP_SUCCESS on success.
+     *         AMP_ERROR if cpu is not smaller than
+     *         AMP_THREAD_AFFINITY_CPU_CAPACITY.
+     */
+    int amp_thread_affinity_remove_cpu(struct amp_thread_affinity_s* affinity,
+                                       size_t cpu);
+
+    /**
+     * Returns nonzero if the logical CPU with index cpu is part of affinity,
+     * otherwise returns 0.
+     */
+    int amp_thread_affinity_contains_cpu(struct amp_thread_affinity_s const* affinity,
+                                         size_t cpu);
+
+    /**
+     * Returns the number of logical CPUs in affinity.
+     */
+    size_t amp_thread_affinity_cpu_count(struct amp_thread_affinity_s const* affinity);
+
+
+
+/**
+ * Stack size value to use the platforms default stack size.
+ */
+#define AMP_THREAD_STACK_DEFAULT_SIZE ((size_t)0)
+
+/**
+ * Guard size value to use the platforms default guard area size.
+ */
+#define AMP_THREAD_STACK_DEFAULT_GUARD_SIZE (~(size_t)0)
+
+    /**
+     * Stack configuration of a thread.
+     *
+     * size is the stack size in bytes or AMP_THREAD_STACK_DEFAULT_SIZE. It
+     * is rounded up to the page size and must not be smaller than the 
+     * platforms minimum stack size (PTHREAD_STACK_MIN for Pthreads).
+     *
+     * guard_size is the size in bytes of the inaccessible area guarding 
+     * against stack overflows or AMP_THREAD_STACK_DEFAULT_GUARD_SIZE. 0 
+     * disables the guard area.
+     *
+     * memory is NULL to let the system allocate the stack or points to
+     * size bytes of caller-owned stack memory which must stay valid until
+     * the thread has been joined. Page alignment is recommended. No guard
+     * area is created for caller-provided stacks, therefore guard_size is 
+     * ignored and the caller needs to protect the memory itself if needed.
+     */
+    struct amp_thread_stack_s {
+        size_t size;
+        size_t guard_size;
+        void* memory;
+    };
+
+
+
     /**
      * Creates and launches a thread.
      *
@@ -124,9 +223,51 @@ extern "C" {
                                      amp_allocator_t allocator,
                                      void* func_context,
                                      amp_thread_func_t func);
-    
+
+    /**
+     * Like amp_thread_create_and_launch but the thread is created with its
+     * CPU affinity set to the CPUs in affinity, so it never runs on other
+     * CPUs - not even for its first instructions.
+     *
+     * If affinity is NULL or empty behaves like amp_thread_create_and_launch.
+     *
+     * @return AMP_SUCCESS on successful thread launch.
+     *         AMP_UNSUPPORTED if the backend can not set the affinity of a
+     *         thread at creation time (Pthreads on non-Linux platforms).
+     *         AMP_ERROR if none of the CPUs in affinity is available to the
+     *         process, or if the system is lacking resources for thread
+     *         creation.
+     *         AMP_NOMEM if the system is lacking memory to create the thread.
+     */
+    int amp_thread_create_and_launch_with_affinity(amp_thread_t* thread,
+                                                   amp_allocator_t allocator,
+                                                   void* func_context,
+                                                   amp_thread_func_t func,
+                                                   struct amp_thread_affinity_s const* affinity);
+
     /**
-     * Waits until the thread ends and frees its resources. 
+     * Like amp_thread_create_and_launch but the thread is created with the
+     * stack described by stack. Use small stacks to run many threads 
+     * without reserving the platforms default stack size for each.
+     *
+     * If stack is NULL behaves like amp_thread_create_and_launch.
+     *
+     * @return AMP_SUCCESS on successful thread launch.
+     *         AMP_UNSUPPORTED if the backend can not create threads with the
+     *         requested stack configuration (Windows threads only support
+     *         setting the stack size).
+     *         AMP_ERROR if the stack configuration is invalid, e.g. too small,
+     *         or if the system is lacking resources for thread creation.
+     *         AMP_NOMEM if the system is lacking memory to create the thread.
+     */
+    int amp_thread_create_and_launch_with_stack(amp_thread_t* thread,
+                                                amp_allocator_t allocator,
+                                                void* func_context,
+                                                amp_thread_func_t func,
+                                                struct amp_thread_stack_s const* stack);
+
+    /**
+     * Waits until the thread ends and frees its resources.
      *
      * If thread hasn't been launched behavior is undefined.
      *
@@ -177,7 +318,32 @@ extern "C" {
      * in use.
      */
     int amp_thread_yield(void);
-    
+
+
+    /**
+     * Restricts the calling thread to the CPUs in affinity. The operating
+     * system migrates the thread if it currently runs on another CPU.
+     *
+     * affinity must not be NULL or empty.
+     *
+     * @return AMP_SUCCESS on success.
+     *         AMP_UNSUPPORTED if the backend can not change thread affinities.
+     *         AMP_ERROR if none of the CPUs in affinity is available to the
+     *         process or if affinity is invalid.
+     */
+    int amp_thread_set_current_affinity(struct amp_thread_affinity_s const* affinity);
+
+    /**
+     * Stores the set of CPUs the calling thread is allowed to run on in
+     * affinity. CPUs with an index not smaller than
+     * AMP_THREAD_AFFINITY_CPU_CAPACITY are not reported.
+     *
+     * @return AMP_SUCCESS on success.
+     *         AMP_UNSUPPORTED if the backend can not query thread affinities.
+     *         AMP_ERROR if affinity is invalid or the query failed.
+     */
+    int amp_thread_get_current_affinity(struct amp_thread_affinity_s* affinity);
+
     
 
 #if defined(__cplusplus)
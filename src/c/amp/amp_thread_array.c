@@ -46,31 +46,147 @@
 #include "amp_thread.h"
 #include "amp_raw_thread.h"
 #include "amp_internal_thread.h"
+#include "amp_mutex.h"
+#include "amp_condition_variable.h"
+#include "amp_raw_mutex.h"
+#include "amp_raw_condition_variable.h"
+
+
+
+/**
+ * Stores the user function and context of a thread while it runs the launch 
+ * trampoline.
+ */
+struct amp_internal_thread_array_launch_record_s {
+    struct amp_thread_array_s* thread_array;
+    size_t index;
+    amp_thread_func_t func;
+    void* func_context;
+};
+
+
+struct amp_internal_thread_array_slot_fields_s {
+    struct amp_raw_thread_s thread;
+    struct amp_internal_thread_array_launch_record_s launch_record;
+};
+
+/**
+ * Rounds size up to a multiple of AMP_CACHE_LINE_SIZE. 
+ *
+ * The compile-time line size is used instead of 
+ * amp_platform_get_cache_line_size because the slot padding is part of the
+ * type, and querying the platform costs system calls on every 
+ * amp_thread_array_create. Define AMP_CACHE_LINE_SIZE when building for a
+ * platform with larger lines - the amp_platform unit tests check that it 
+ * covers the reported line size.
+ */
+#define AMP_INTERNAL_THREAD_ARRAY_ROUND_TO_CACHE_LINE(size) ((((size) + AMP_CACHE_LINE_SIZE - 1) / AMP_CACHE_LINE_SIZE) * AMP_CACHE_LINE_SIZE)
+
+/**
+ * Per-thread record padded to a multiple of the cache line size so writes
+ * to the state of one thread during launch and join don't falsely share a
+ * cache line with its neighbors.
+ */
+union amp_internal_thread_array_slot_u {
+    struct amp_internal_thread_array_slot_fields_s fields;
+    amp_byte_t padding[AMP_INTERNAL_THREAD_ARRAY_ROUND_TO_CACHE_LINE(sizeof(struct amp_internal_thread_array_slot_fields_s))];
+};
 
 
 /** 
- * Internal opaque thread array data structure 
+ * Internal opaque thread array data structure. Lives at the start of a 
+ * single cache line aligned allocation, followed by the thread slots 
+ * starting at the next cache line boundary.
  */
 struct amp_thread_array_s {
-    struct amp_raw_thread_s *threads;
+    union amp_internal_thread_array_slot_u* slots;
     size_t thread_count;
     size_t joinable_count;
     /* struct amp_thread_array_context_s *context;*/
+    
+    /* Coordinates the launched threads with the launching thread for
+     * amp_thread_array_launch_all_with_mode. All fields below are protected
+     * by launch_mutex.
+     */
+    struct amp_raw_mutex_s launch_mutex;
+    struct amp_raw_condition_variable_s launch_reported;
+    struct amp_raw_condition_variable_s start_gate;
+    size_t unreported_count;
+    size_t failed_count;
+    int launch_error;
+    int launch_tree;
+    int start_gated;
+    unsigned int start_generation;
 };
 
 
 
+/**
+ * Initializes the mutex and condition variables of thread_array used to 
+ * coordinate launching.
+ */
+static int amp_internal_thread_array_launch_sync_init(struct amp_thread_array_s* thread_array)
+{
+    int retval = AMP_UNSUPPORTED;
+    int rc = AMP_UNSUPPORTED;
+    
+    retval = amp_raw_mutex_init(&thread_array->launch_mutex);
+    if (AMP_SUCCESS != retval) {
+        return retval;
+    }
+    
+    retval = amp_raw_condition_variable_init(&thread_array->launch_reported);
+    if (AMP_SUCCESS != retval) {
+        rc = amp_raw_mutex_finalize(&thread_array->launch_mutex);
+        assert(AMP_SUCCESS == rc);
+        (void)rc;
+        
+        return retval;
+    }
+    
+    retval = amp_raw_condition_variable_init(&thread_array->start_gate);
+    if (AMP_SUCCESS != retval) {
+        rc = amp_raw_condition_variable_finalize(&thread_array->launch_reported);
+        assert(AMP_SUCCESS == rc);
+        rc = amp_raw_mutex_finalize(&thread_array->launch_mutex);
+        assert(AMP_SUCCESS == rc);
+        (void)rc;
+        
+        return retval;
+    }
+    
+    return AMP_SUCCESS;
+}
+
+
+
+static int amp_internal_thread_array_launch_sync_finalize(struct amp_thread_array_s* thread_array)
+{
+    int retval = amp_raw_condition_variable_finalize(&thread_array->start_gate);
+    
+    if (AMP_SUCCESS == retval) {
+        retval = amp_raw_condition_variable_finalize(&thread_array->launch_reported);
+    }
+    if (AMP_SUCCESS == retval) {
+        retval = amp_raw_mutex_finalize(&thread_array->launch_mutex);
+    }
+    assert(AMP_SUCCESS == retval);
+    
+    return retval;
+}
+
+
+
 int amp_thread_array_create(amp_thread_array_t* thread_array,
                             amp_allocator_t allocator,
                             size_t thread_count)
 {
-    /* TODO: @todo Decide if only to allocate one big area of memory to put
-     *             the group thread structs and the group itself into.
-     */
-    
+    size_t const group_size = AMP_INTERNAL_THREAD_ARRAY_ROUND_TO_CACHE_LINE(sizeof(struct amp_thread_array_s));
+    size_t const slot_size = sizeof(union amp_internal_thread_array_slot_u);
     struct amp_thread_array_s* group = NULL;
-    struct amp_raw_thread_s* threads = NULL;
+    union amp_internal_thread_array_slot_u* slots = NULL;
     size_t i = 0;
+    int retval = AMP_UNSUPPORTED;
 
     assert(NULL != thread_array);
     assert(0 != thread_count);
@@ -85,33 +201,50 @@ int amp_thread_array_create(amp_thread_array_t* thread_array,
     
     *thread_array = NULL;
     
-    group = (struct amp_thread_array_s *)AMP_ALLOC(allocator, sizeof(*group));
+    if (thread_count > (((size_t)-1) - group_size) / slot_size) {
+        return AMP_NOMEM;
+    }
+    
+    /* Group and thread slots share one cache line aligned allocation. */
+    group = (struct amp_thread_array_s*)AMP_ALIGNED_ALLOC(allocator,
+                                                          AMP_CACHE_LINE_SIZE,
+                                                          group_size + thread_count * slot_size);
     if (NULL == group) {
         return AMP_NOMEM;
     }
     
-    /* Allocate memory for the groups threads. */
-    threads = (struct amp_raw_thread_s*)AMP_CALLOC(allocator,
-                                                   thread_count,
-                                                   sizeof(*threads));
-    if (NULL == threads) {
-        int const rv = AMP_DEALLOC(allocator, group);
+    slots = (union amp_internal_thread_array_slot_u*)(((amp_byte_t*)group) + group_size);
+    
+    retval = amp_internal_thread_array_launch_sync_init(group);
+    if (AMP_SUCCESS != retval) {
+        int const rv = AMP_ALIGNED_DEALLOC(allocator, group);
         assert(AMP_SUCCESS == rv);
         (void)rv;
         
-        return AMP_NOMEM;
+        return retval;
     }
     
     for (i = 0; i < thread_count; ++i) {
-        int const rv = amp_internal_thread_init_for_configuration(&threads[i]);
+        int const rv = amp_internal_thread_init_for_configuration(&slots[i].fields.thread);
         assert(AMP_SUCCESS == rv);
         (void)rv;
+        
+        slots[i].fields.launch_record.thread_array = group;
+        slots[i].fields.launch_record.index = i;
+        slots[i].fields.launch_record.func = NULL;
+        slots[i].fields.launch_record.func_context = NULL;
     }
     
     
-    group->threads = threads;
+    group->slots = slots;
     group->thread_count = thread_count;
     group->joinable_count = (size_t)0;
+    group->unreported_count = (size_t)0;
+    group->failed_count = (size_t)0;
+    group->launch_error = AMP_SUCCESS;
+    group->launch_tree = 0;
+    group->start_gated = 0;
+    group->start_generation = 0u;
     
     *thread_array = group;
     
@@ -135,16 +268,17 @@ int amp_thread_array_destroy(amp_thread_array_t* thread_array,
         return AMP_BUSY;
     }
     
-    retval = AMP_DEALLOC(allocator, (*thread_array)->threads);
+    retval = amp_internal_thread_array_launch_sync_finalize(*thread_array);
+    if (AMP_SUCCESS != retval) {
+        return retval;
+    }
+    
+    retval =  AMP_ALIGNED_DEALLOC(allocator, *thread_array);
     if (AMP_SUCCESS == retval) {
-        (*thread_array)->threads = NULL;
-        retval =  AMP_DEALLOC(allocator, *thread_array);
-        if (AMP_SUCCESS == retval) {
-            *thread_array = AMP_THREAD_ARRAY_UNINITIALIZED;
-        } else {
-            assert(0); /* Unable to deallocate - posibly bad dealloc_func */
-            retval = AMP_ERROR;
-        }
+        *thread_array = AMP_THREAD_ARRAY_UNINITIALIZED;
+    } else {
+        assert(0); /* Unable to deallocate - posibly bad dealloc_func */
+        retval = AMP_ERROR;
     }
     
     return retval;
@@ -158,7 +292,7 @@ int amp_thread_array_configure_contexts(amp_thread_array_t thread_array,
                                         void* shared_context)
 {
     size_t thread_count = 0;
-    struct amp_raw_thread_s *threads = NULL;
+    union amp_internal_thread_array_slot_u* slots = NULL;
     size_t range_end = 0;
     size_t i = 0;
 
@@ -182,11 +316,11 @@ int amp_thread_array_configure_contexts(amp_thread_array_t thread_array,
         return AMP_BUSY;
     }
     
-    threads = thread_array->threads;
+    slots = thread_array->slots;
     range_end = range_begin - 1 + range_length;
     
     for (i = range_begin; i <= range_end; ++i) {
-        int const errc = amp_internal_thread_configure_context(&threads[i],
+        int const errc = amp_internal_thread_configure_context(&slots[i].fields.thread,
                                                                shared_context);
         if (AMP_SUCCESS != errc) {
             return errc;
@@ -204,7 +338,7 @@ int amp_thread_array_configure_functions(amp_thread_array_t thread_array,
                                          amp_thread_func_t shared_function)
 {
     size_t thread_count = 0;
-    struct amp_raw_thread_s *threads = NULL;
+    union amp_internal_thread_array_slot_u* slots = NULL;
     size_t range_end = 0;
     size_t i = 0;
 
@@ -230,10 +364,10 @@ int amp_thread_array_configure_functions(amp_thread_array_t thread_array,
         return AMP_BUSY;
     }
     
-    threads = thread_array->threads;
+    slots = thread_array->slots;
     range_end = range_begin - 1 + range_length;
     for (i = range_begin; i <= range_end; ++i) {
-        int const errc = amp_internal_thread_configure_function(&threads[i],
+        int const errc = amp_internal_thread_configure_function(&slots[i].fields.thread,
                                                                 shared_function);
         if (AMP_SUCCESS != errc) {
             return errc;
@@ -252,7 +386,7 @@ int amp_thread_array_configure(amp_thread_array_t thread_array,
                                amp_thread_func_t shared_function)
 {
     size_t thread_count = 0;
-    struct amp_raw_thread_s* threads = NULL;
+    union amp_internal_thread_array_slot_u* slots = NULL;
     size_t range_end = 0;
     size_t i = 0;
 
@@ -278,15 +412,15 @@ int amp_thread_array_configure(amp_thread_array_t thread_array,
         return AMP_BUSY;
     }
     
-    threads = thread_array->threads;
+    slots = thread_array->slots;
     range_end = range_begin - 1 + range_length;
     for (i = range_begin; i <= range_end; ++i) {
         int errc0 = AMP_ERROR;
         int errc1 = AMP_ERROR;
         
-        errc0 = amp_internal_thread_configure_context(&threads[i],
+        errc0 = amp_internal_thread_configure_context(&slots[i].fields.thread,
                                                       shared_context);
-        errc1 = amp_internal_thread_configure_function(&threads[i],
+        errc1 = amp_internal_thread_configure_function(&slots[i].fields.thread,
                                                        shared_function);
         if (AMP_SUCCESS != errc0
             || AMP_SUCCESS != errc1) {
@@ -299,30 +433,140 @@ int amp_thread_array_configure(amp_thread_array_t thread_array,
 }
 
 
+int amp_thread_array_configure_affinity(amp_thread_array_t thread_array,
+                                        size_t range_begin,
+                                        size_t range_length,
+                                        struct amp_thread_affinity_s const* affinity)
+{
+    size_t thread_count = 0;
+    union amp_internal_thread_array_slot_u* slots = NULL;
+    size_t range_end = 0;
+    size_t i = 0;
+    
+    assert(NULL != thread_array);
+    assert(range_begin < thread_array->thread_count);
+    assert(range_length > 0);
+    assert(range_length <= thread_array->thread_count);
+    assert(range_begin <= thread_array->thread_count - range_length);
+    assert(0 == thread_array->joinable_count);
+    
+    thread_count = thread_array->thread_count;
+    
+    if (range_begin >= thread_count
+        || range_length <= 0
+        || range_length > thread_count
+        || range_begin > thread_count - range_length) {
+        
+        return AMP_ERROR;
+    }
+    if (0 != thread_array->joinable_count) {
+        return AMP_BUSY;
+    }
+    
+    slots = thread_array->slots;
+    range_end = range_begin - 1 + range_length;
+    for (i = range_begin; i <= range_end; ++i) {
+        int const errc = amp_internal_thread_configure_affinity(&slots[i].fields.thread,
+                                                                affinity);
+        if (AMP_SUCCESS != errc) {
+            return errc;
+        }
+    }
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_thread_array_configure_stacks(amp_thread_array_t thread_array,
+                                      size_t range_begin,
+                                      size_t range_length,
+                                      struct amp_thread_stack_s const* stack)
+{
+    size_t thread_count = 0;
+    union amp_internal_thread_array_slot_u* slots = NULL;
+    struct amp_thread_stack_s thread_stack;
+    size_t i = 0;
+    
+    assert(NULL != thread_array);
+    assert(range_begin < thread_array->thread_count);
+    assert(range_length > 0);
+    assert(range_length <= thread_array->thread_count);
+    assert(range_begin <= thread_array->thread_count - range_length);
+    assert(0 == thread_array->joinable_count);
+    
+    thread_count = thread_array->thread_count;
+    
+    if (range_begin >= thread_count
+        || range_length <= 0
+        || range_length > thread_count
+        || range_begin > thread_count - range_length) {
+        
+        return AMP_ERROR;
+    }
+    if (0 != thread_array->joinable_count) {
+        return AMP_BUSY;
+    }
+    
+    slots = thread_array->slots;
+    for (i = 0; i < range_length; ++i) {
+        int errc = AMP_ERROR;
+        
+        if (NULL == stack) {
+            errc = amp_internal_thread_configure_stack(&slots[range_begin + i].fields.thread,
+                                                       NULL);
+        } else {
+            thread_stack = *stack;
+            if (NULL != stack->memory) {
+                thread_stack.memory = (amp_byte_t*)stack->memory + i * stack->size;
+            }
+            errc = amp_internal_thread_configure_stack(&slots[range_begin + i].fields.thread,
+                                                       &thread_stack);
+        }
+        if (AMP_SUCCESS != errc) {
+            return errc;
+        }
+    }
+    
+    return AMP_SUCCESS;
+}
+
+
+
 int amp_thread_array_launch_all(struct amp_thread_array_s *thread_array,
                                 size_t* joinable_thread_count)
 {
-    struct amp_raw_thread_s *threads = NULL;
+    union amp_internal_thread_array_slot_u* slots = NULL;
     size_t joinable_count = 0;
     size_t thread_count = 0;
+    size_t i = 0;
     int retval = AMP_SUCCESS;
     
     assert(NULL != thread_array);
     
-    threads = thread_array->threads;
+    slots = thread_array->slots;
     joinable_count = thread_array->joinable_count;
     thread_count = thread_array->thread_count;
     
     while (   (joinable_count < thread_count)
            && (AMP_SUCCESS == retval)) {
         
-        retval = amp_internal_thread_launch_configured(&(threads[joinable_count]));
+        /* A partial tree launch can leave non-launched threads between 
+         * launched ones. 
+         */
+        if (amp_internal_thread_joinable_state == slots[i].fields.thread.state) {
+            ++i;
+            continue;
+        }
+        
+        retval = amp_internal_thread_launch_configured(&slots[i].fields.thread);
         
         if (AMP_SUCCESS != retval) {
             break;
         }
         
         ++joinable_count;
+        ++i;
     }
     
     thread_array->joinable_count = joinable_count;
@@ -335,24 +579,241 @@ int amp_thread_array_launch_all(struct amp_thread_array_s *thread_array,
 }
 
 
+
+/**
+ * Returns the number of threads in the launch tree rooted at index of a tree
+ * containing thread_count threads. The children of index are 2 * index + 1 
+ * and 2 * index + 2.
+ */
+static size_t amp_internal_thread_array_subtree_size(size_t index,
+                                                     size_t thread_count)
+{
+    size_t level_begin = index;
+    size_t level_end = index;
+    size_t size = 0;
+    
+    while (level_begin < thread_count) {
+        size += ((level_end < thread_count) ? level_end : (thread_count - 1)) - level_begin + 1;
+        level_begin = 2 * level_begin + 1;
+        level_end = 2 * level_end + 2;
+    }
+    
+    return size;
+}
+
+
+
+/**
+ * Thread function the threads run while launched by 
+ * amp_thread_array_launch_all_with_mode. In tree mode launches the children
+ * of the thread first, then reports to the launching thread, optionally 
+ * waits for the start gate to open, and finally runs the user function.
+ */
+static void amp_internal_thread_array_launch_trampoline(void* context)
+{
+    struct amp_internal_thread_array_launch_record_s* record = (struct amp_internal_thread_array_launch_record_s*)context;
+    struct amp_thread_array_s* thread_array = record->thread_array;
+    amp_thread_func_t const func = record->func;
+    void* const func_context = record->func_context;
+    size_t const index = record->index;
+    size_t const thread_count = thread_array->thread_count;
+    size_t failed_count = 0;
+    int launch_error = AMP_SUCCESS;
+    int retval = AMP_UNSUPPORTED;
+    size_t child = 0;
+    
+    if (thread_array->launch_tree) {
+        for (child = 2 * index + 1; 
+             (child <= 2 * index + 2) && (child < thread_count); 
+             ++child) {
+            
+            retval = amp_internal_thread_launch_configured(&thread_array->slots[child].fields.thread);
+            if (AMP_SUCCESS != retval) {
+                failed_count += amp_internal_thread_array_subtree_size(child,
+                                                                       thread_count);
+                launch_error = retval;
+            }
+        }
+    }
+    
+    retval = amp_mutex_lock(&thread_array->launch_mutex);
+    assert(AMP_SUCCESS == retval);
+    
+    if ((AMP_SUCCESS != launch_error) 
+        && (AMP_SUCCESS == thread_array->launch_error)) {
+        
+        thread_array->launch_error = launch_error;
+    }
+    thread_array->failed_count += failed_count;
+    thread_array->unreported_count -= 1 + failed_count;
+    if (0 == thread_array->unreported_count) {
+        retval = amp_condition_variable_signal(&thread_array->launch_reported);
+        assert(AMP_SUCCESS == retval);
+    }
+    
+    if (thread_array->start_gated) {
+        unsigned int const generation = thread_array->start_generation;
+        
+        while (generation == thread_array->start_generation) {
+            retval = amp_condition_variable_wait(&thread_array->start_gate,
+                                                 &thread_array->launch_mutex);
+            assert(AMP_SUCCESS == retval);
+        }
+    }
+    
+    retval = amp_mutex_unlock(&thread_array->launch_mutex);
+    assert(AMP_SUCCESS == retval);
+    (void)retval;
+    
+    func(func_context);
+}
+
+
+
+int amp_thread_array_launch_all_with_mode(amp_thread_array_t thread_array,
+                                          amp_thread_array_launch_mode_t mode,
+                                          amp_thread_array_start_t start,
+                                          size_t* joinable_thread_count)
+{
+    union amp_internal_thread_array_slot_u* slots = NULL;
+    size_t thread_count = 0;
+    size_t launched_count = 0;
+    size_t i = 0;
+    int retval = AMP_SUCCESS;
+    int rc = AMP_SUCCESS;
+    
+    assert(NULL != thread_array);
+    assert((amp_thread_array_launch_sequential == mode)
+           || (amp_thread_array_launch_tree == mode));
+    assert((amp_thread_array_start_immediately == start)
+           || (amp_thread_array_start_gated == start));
+    
+    if ((amp_thread_array_launch_sequential == mode)
+        && (amp_thread_array_start_immediately == start)) {
+        
+        return amp_thread_array_launch_all(thread_array, joinable_thread_count);
+    }
+    
+    slots = thread_array->slots;
+    thread_count = thread_array->thread_count;
+    
+    if (0 != thread_array->joinable_count) {
+        return AMP_BUSY;
+    }
+    for (i = 0; i < thread_count; ++i) {
+        if ((amp_internal_thread_prelaunch_state != slots[i].fields.thread.state)
+            || (NULL == slots[i].fields.thread.func)) {
+            
+            return AMP_ERROR;
+        }
+    }
+    
+    /* Threads report back before running their user function, therefore 
+     * nobody reads the records or the launch state concurrently to this
+     * setup.
+     */
+    for (i = 0; i < thread_count; ++i) {
+        struct amp_internal_thread_array_launch_record_s* record = &slots[i].fields.launch_record;
+        
+        record->func = slots[i].fields.thread.func;
+        record->func_context = slots[i].fields.thread.func_context;
+        slots[i].fields.thread.func = amp_internal_thread_array_launch_trampoline;
+        slots[i].fields.thread.func_context = record;
+    }
+    thread_array->unreported_count = thread_count;
+    thread_array->failed_count = 0;
+    thread_array->launch_error = AMP_SUCCESS;
+    thread_array->launch_tree = (amp_thread_array_launch_tree == mode);
+    thread_array->start_gated = (amp_thread_array_start_gated == start);
+    
+    if (amp_thread_array_launch_tree == mode) {
+        retval = amp_internal_thread_launch_configured(&slots[0].fields.thread);
+        launched_count = (AMP_SUCCESS == retval) ? 1 : 0;
+    } else {
+        for (launched_count = 0; launched_count < thread_count; ++launched_count) {
+            retval = amp_internal_thread_launch_configured(&slots[launched_count].fields.thread);
+            if (AMP_SUCCESS != retval) {
+                break;
+            }
+        }
+    }
+    
+    rc = amp_mutex_lock(&thread_array->launch_mutex);
+    assert(AMP_SUCCESS == rc);
+    
+    if (AMP_SUCCESS != retval) {
+        /* Threads that were never launched will never report. */
+        size_t const never_launched_count = (amp_thread_array_launch_tree == mode) 
+            ? thread_count : (thread_count - launched_count);
+        
+        thread_array->failed_count += never_launched_count;
+        thread_array->unreported_count -= never_launched_count;
+    }
+    while (0 != thread_array->unreported_count) {
+        rc = amp_condition_variable_wait(&thread_array->launch_reported,
+                                         &thread_array->launch_mutex);
+        assert(AMP_SUCCESS == rc);
+    }
+    if (AMP_SUCCESS == retval) {
+        retval = thread_array->launch_error;
+    }
+    thread_array->joinable_count = thread_count - thread_array->failed_count;
+    
+    if (thread_array->start_gated) {
+        ++(thread_array->start_generation);
+        rc = amp_condition_variable_broadcast(&thread_array->start_gate);
+        assert(AMP_SUCCESS == rc);
+    }
+    
+    rc = amp_mutex_unlock(&thread_array->launch_mutex);
+    assert(AMP_SUCCESS == rc);
+    (void)rc;
+    
+    /* All launched threads copied their records, restore the user functions
+     * so non-launched threads can be launched with amp_thread_array_launch_all.
+     */
+    for (i = 0; i < thread_count; ++i) {
+        slots[i].fields.thread.func = slots[i].fields.launch_record.func;
+        slots[i].fields.thread.func_context = slots[i].fields.launch_record.func_context;
+    }
+    
+    if (NULL != joinable_thread_count) {
+        *joinable_thread_count = thread_array->joinable_count;
+    }
+    
+    return retval;
+}
+
+
+
 int amp_thread_array_join_all(struct amp_thread_array_s* thread_array,
                               size_t* joinable_thread_count)
 {
-    struct amp_raw_thread_s *threads = NULL;
+    union amp_internal_thread_array_slot_u* slots = NULL;
     size_t joinable_count = 0;
     size_t joined_count = 0;
+    size_t i = 0;
     int retval = AMP_SUCCESS;
     
     assert(NULL != thread_array);
     
-    threads = thread_array->threads;
+    slots = thread_array->slots;
     joinable_count = thread_array->joinable_count;
     joined_count = 0;
+    i = thread_array->thread_count;
     while (   (joined_count < joinable_count)
-           && (AMP_SUCCESS == retval)) {
+           && (AMP_SUCCESS == retval)
+           && (0 < i)) {
+        
+        /* Launching from left to right, joining from right to left. Skip
+         * threads a partial tree launch did not launch.
+         */
+        --i;
+        if (amp_internal_thread_joinable_state != slots[i].fields.thread.state) {
+            continue;
+        }
         
-        /* Launching from left to right, joining from right to left. */
-        retval = amp_raw_thread_join(&(threads[joinable_count - 1 - joined_count]));
+        retval = amp_raw_thread_join(&slots[i].fields.thread);
         
         if (AMP_SUCCESS != retval) {
             break;
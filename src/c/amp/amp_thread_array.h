@@ -68,6 +68,42 @@ extern "C" {
      * Opaque type representing an amp thread array.
      */
     typedef struct amp_thread_array_s *amp_thread_array_t;
+    
+    
+    /**
+     * How amp_thread_array_launch_all_with_mode creates the threads.
+     *
+     * amp_thread_array_launch_sequential lets the calling thread create one 
+     * thread after the other. 
+     *
+     * amp_thread_array_launch_tree lets the calling thread only create the 
+     * first thread. Every launched thread at index i creates the threads at 
+     * index 2 * i + 1 and 2 * i + 2 before running its function, so the 
+     * last thread is created after a logarithmic instead of a linear number 
+     * of thread creations.
+     */
+    enum amp_thread_array_launch_mode {
+        amp_thread_array_launch_sequential = 0,
+        amp_thread_array_launch_tree
+    };
+    typedef enum amp_thread_array_launch_mode amp_thread_array_launch_mode_t;
+    
+    /**
+     * When the launched threads of amp_thread_array_launch_all_with_mode 
+     * start to run their thread functions.
+     *
+     * amp_thread_array_start_immediately runs the thread function as soon as
+     * a thread has been created (and created its children in tree mode).
+     *
+     * amp_thread_array_start_gated holds all launched threads back until 
+     * every thread of the array has been launched or failed to launch and 
+     * then releases them at once.
+     */
+    enum amp_thread_array_start {
+        amp_thread_array_start_immediately = 0,
+        amp_thread_array_start_gated
+    };
+    typedef enum amp_thread_array_start amp_thread_array_start_t;
 
     
     /**
@@ -214,6 +250,72 @@ extern "C" {
                                    void* shared_context,
                                    amp_thread_func_t shared_function);
     
+    /**
+     * Sets the CPU affinity of range_length thread array threads starting at 
+     * index range_begin to affinity. The threads are pinned to these CPUs 
+     * when launched. Pass NULL or an empty affinity to let the operating 
+     * system decide again. Use a range_length of 1 to pin each thread of the
+     * array to its own CPU.
+     *
+     * range_length must not be greater than the size of thread_array.
+     * range_length must not be 0.
+     * All indices from range_begin inside range_length must be inside the 
+     * index range of thread_array.
+     *
+     * Do not call after launching and before joining with a thread array.
+     *
+     * @return AMP_SUCCESS on successful configuration.
+     *         Other error codes might be returned to signal errors, too. These
+     *         are programming errors and must not occur in release code. When
+     *         @em amp is compiled without NDEBUG set it might assert that these
+     *         errors do not happen.
+     *         AMP_ERROR might be returned if the arguments are invalid.
+     *         AMP_BUSY might be returned if the thread array is already 
+     *         launched.
+     *
+     * @attention Launching returns AMP_UNSUPPORTED for threads with a 
+     *            configured affinity if the backend can not pin threads.
+     */
+    int amp_thread_array_configure_affinity(amp_thread_array_t thread_array,
+                                            size_t range_begin,
+                                            size_t range_length,
+                                            struct amp_thread_affinity_s const* affinity);
+    
+    /**
+     * Sets the stack configuration of range_length thread array threads
+     * starting at index range_begin. Pass NULL to restore the platform 
+     * default stacks.
+     *
+     * If stack->memory is not NULL it must point to range_length times 
+     * stack->size bytes of caller-owned memory which must stay valid until
+     * the threads have been joined. The thread at index range_begin + i uses
+     * the i-th stack->size bytes of it, so stacks for many threads can be 
+     * carved out of one mapping.
+     *
+     * range_length must not be greater than the size of thread_array.
+     * range_length must not be 0.
+     * All indices from range_begin inside range_length must be inside the 
+     * index range of thread_array.
+     *
+     * Do not call after launching and before joining with a thread array.
+     *
+     * @return AMP_SUCCESS on successful configuration.
+     *         Other error codes might be returned to signal errors, too. These
+     *         are programming errors and must not occur in release code. When
+     *         @em amp is compiled without NDEBUG set it might assert that these
+     *         errors do not happen.
+     *         AMP_ERROR might be returned if the arguments are invalid.
+     *         AMP_BUSY might be returned if the thread array is already 
+     *         launched.
+     *
+     * @attention Launching returns AMP_UNSUPPORTED or AMP_ERROR for threads
+     *            whose stack configuration the backend can not apply.
+     */
+    int amp_thread_array_configure_stacks(amp_thread_array_t thread_array,
+                                          size_t range_begin,
+                                          size_t range_length,
+                                          struct amp_thread_stack_s const* stack);
+    
     
     /**
      * Launches the contained threads one after the other and stops if
@@ -269,6 +371,44 @@ extern "C" {
     
     
     
+    /**
+     * Launches all threads of the thread array as specified by mode and 
+     * start and returns after all launches have succeeded or failed. The 
+     * number of launched threads is returned in joinable_thread_count if it 
+     * is not NULL.
+     *
+     * With amp_thread_array_launch_sequential and 
+     * amp_thread_array_start_immediately behaves like 
+     * amp_thread_array_launch_all. Otherwise no thread of the array must 
+     * have been launched before.
+     *
+     * If a thread can not be launched in tree mode the threads it should have 
+     * created are not launched either, while all other threads are. These
+     * non-launched threads can be launched later on with 
+     * amp_thread_array_launch_all. With a start gate the launched threads 
+     * are released even if not all threads could be launched - code the 
+     * thread functions as described for amp_thread_array_launch_all to 
+     * handle this.
+     *
+     * @return AMP_SUCCESS if all threads of the thread array have been 
+     *         launched.
+     *         AMP_ERROR or AMP_NOMEM if the system lacks the resources to
+     *         launch all threads. The first error encountered is returned.
+     *         Other error codes might be returned to signal errors, too. These
+     *         are programming errors and must not occur in release code. When
+     *         @em amp is compiled without NDEBUG set it might assert that these
+     *         errors do not happen.
+     *         AMP_BUSY if threads of the array are joinable.
+     *         AMP_ERROR if a thread of the array has been joined or has no
+     *         thread function configured.
+     */
+    int amp_thread_array_launch_all_with_mode(amp_thread_array_t thread_array,
+                                              amp_thread_array_launch_mode_t mode,
+                                              amp_thread_array_start_t start,
+                                              size_t* joinable_thread_count);
+    
+    
+    
     /**
      * Joins with all joinable threads of the thread array.
      *
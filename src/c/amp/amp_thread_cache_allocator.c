@@ -0,0 +1,735 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implements the thread-caching allocator.
+ *
+ * Free blocks are linked through their headers. A thread's cache keeps one
+ * such list per size class. The depot of a size class keeps a stack of 
+ * chains - lists of blocks handed over at once - and the list of slabs of
+ * the class. The first block of a chain stores the link to the next chain
+ * and its block count in its otherwise unused memory.
+ *
+ * The caches of all threads are linked into a registry guarded by a mutex
+ * so the allocator can free them on destruction. The registry is only 
+ * touched when a thread creates or flushes its cache.
+ */
+
+#include "amp_thread_cache_allocator.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "amp_stddef.h"
+#include "amp_return_code.h"
+#include "amp_memory.h"
+#include "amp_mutex.h"
+#include "amp_raw_mutex.h"
+#include "amp_thread_local_slot.h"
+
+
+
+#define AMP_INTERNAL_THREAD_CACHE_ROUND_TO_CACHE_LINE(size) ((((size) + AMP_CACHE_LINE_SIZE - 1) / AMP_CACHE_LINE_SIZE) * AMP_CACHE_LINE_SIZE)
+
+#define AMP_INTERNAL_THREAD_CACHE_ROUND_TO_GRANULARITY(size) ((((size) + AMP_THREAD_CACHE_ALLOCATOR_SIZE_CLASS_GRANULARITY - 1) / AMP_THREAD_CACHE_ALLOCATOR_SIZE_CLASS_GRANULARITY) * AMP_THREAD_CACHE_ALLOCATOR_SIZE_CLASS_GRANULARITY)
+
+#define AMP_INTERNAL_THREAD_CACHE_CLASS_COUNT (AMP_THREAD_CACHE_ALLOCATOR_MAX_BLOCK_SIZE / AMP_THREAD_CACHE_ALLOCATOR_SIZE_CLASS_GRANULARITY)
+
+/* Size class marking allocations forwarded to the source allocator. */
+#define AMP_INTERNAL_THREAD_CACHE_LARGE_CLASS AMP_INTERNAL_THREAD_CACHE_CLASS_COUNT
+
+
+struct amp_internal_thread_cache_block_header_fields_s {
+    size_t class_index;
+    union amp_internal_thread_cache_block_header_u* next;
+};
+
+/*
+ * The header is padded to the size class granularity to keep the memory 
+ * following it aligned.
+ */
+union amp_internal_thread_cache_block_header_u {
+    struct amp_internal_thread_cache_block_header_fields_s fields;
+    amp_byte_t padding[AMP_INTERNAL_THREAD_CACHE_ROUND_TO_GRANULARITY(sizeof(struct amp_internal_thread_cache_block_header_fields_s))];
+};
+
+/*
+ * Stored in the memory of the first block of a chain, fits into the 
+ * smallest size class.
+ */
+struct amp_internal_thread_cache_chain_s {
+    union amp_internal_thread_cache_block_header_u* next_chain;
+    size_t block_count;
+};
+
+
+union amp_internal_thread_cache_slab_header_u {
+    union amp_internal_thread_cache_slab_header_u* next;
+    amp_byte_t padding[AMP_INTERNAL_THREAD_CACHE_ROUND_TO_GRANULARITY(sizeof(void*))];
+};
+
+
+struct amp_internal_thread_cache_depot_fields_s {
+    struct amp_raw_mutex_s mutex;
+    union amp_internal_thread_cache_block_header_u* chains;
+    union amp_internal_thread_cache_slab_header_u* slabs;
+};
+
+/*
+ * Depots are padded to whole cache lines so threads refilling or draining
+ * different size classes don't contend for the same line.
+ */
+union amp_internal_thread_cache_depot_u {
+    struct amp_internal_thread_cache_depot_fields_s fields;
+    amp_byte_t padding[AMP_INTERNAL_THREAD_CACHE_ROUND_TO_CACHE_LINE(sizeof(struct amp_internal_thread_cache_depot_fields_s))];
+};
+
+
+struct amp_internal_thread_cache_magazine_s {
+    union amp_internal_thread_cache_block_header_u* blocks;
+    size_t block_count;
+};
+
+/*
+ * Cache of a single thread, cache line aligned so no other thread's data 
+ * shares its lines.
+ */
+struct amp_internal_thread_cache_s {
+    struct amp_internal_thread_cache_magazine_s magazines[AMP_INTERNAL_THREAD_CACHE_CLASS_COUNT];
+    struct amp_internal_thread_cache_s* previous;
+    struct amp_internal_thread_cache_s* next;
+};
+
+
+/*
+ * Cache line aligned context of a thread-caching allocator.
+ */
+struct amp_internal_thread_cache_allocator_s {
+    union amp_internal_thread_cache_depot_u depots[AMP_INTERNAL_THREAD_CACHE_CLASS_COUNT];
+    struct amp_raw_mutex_s registry_mutex;
+    struct amp_internal_thread_cache_s* thread_caches;
+    amp_thread_local_slot_key_t thread_cache_key;
+    amp_allocator_t source_allocator;
+};
+
+
+
+static size_t amp_internal_thread_cache_block_stride(size_t class_index);
+
+static size_t amp_internal_thread_cache_block_stride(size_t class_index)
+{
+    return sizeof(union amp_internal_thread_cache_block_header_u) 
+        + (class_index + 1) * AMP_THREAD_CACHE_ALLOCATOR_SIZE_CLASS_GRANULARITY;
+}
+
+
+
+static struct amp_internal_thread_cache_chain_s* amp_internal_thread_cache_chain(union amp_internal_thread_cache_block_header_u* first_block);
+
+static struct amp_internal_thread_cache_chain_s* amp_internal_thread_cache_chain(union amp_internal_thread_cache_block_header_u* first_block)
+{
+    return (struct amp_internal_thread_cache_chain_s*)(first_block + 1);
+}
+
+
+
+/**
+ * Hands a chain of block_count blocks starting with first_block over to 
+ * the depot.
+ */
+static void amp_internal_thread_cache_depot_push(union amp_internal_thread_cache_depot_u* depot,
+                                                 union amp_internal_thread_cache_block_header_u* first_block,
+                                                 size_t block_count);
+
+static void amp_internal_thread_cache_depot_push(union amp_internal_thread_cache_depot_u* depot,
+                                                 union amp_internal_thread_cache_block_header_u* first_block,
+                                                 size_t block_count)
+{
+    struct amp_internal_thread_cache_chain_s* chain = amp_internal_thread_cache_chain(first_block);
+    int retval = AMP_UNSUPPORTED;
+    
+    chain->block_count = block_count;
+    
+    retval = amp_mutex_lock(&depot->fields.mutex);
+    assert(AMP_SUCCESS == retval);
+    
+    chain->next_chain = depot->fields.chains;
+    depot->fields.chains = first_block;
+    
+    retval = amp_mutex_unlock(&depot->fields.mutex);
+    assert(AMP_SUCCESS == retval);
+    (void)retval;
+}
+
+
+
+/**
+ * Refills the empty magazine of size class class_index with a chain from 
+ * the depot or, if the depot is empty, with the blocks of a new slab.
+ *
+ * @return AMP_SUCCESS if the magazine has been refilled.
+ *         AMP_NOMEM if no slab can be allocated.
+ */
+static int amp_internal_thread_cache_refill(struct amp_internal_thread_cache_allocator_s* cache_allocator,
+                                            size_t class_index,
+                                            struct amp_internal_thread_cache_magazine_s* magazine);
+
+static int amp_internal_thread_cache_refill(struct amp_internal_thread_cache_allocator_s* cache_allocator,
+                                            size_t class_index,
+                                            struct amp_internal_thread_cache_magazine_s* magazine)
+{
+    union amp_internal_thread_cache_depot_u* depot = &cache_allocator->depots[class_index];
+    union amp_internal_thread_cache_block_header_u* first_block = NULL;
+    union amp_internal_thread_cache_slab_header_u* slab = NULL;
+    size_t const stride = amp_internal_thread_cache_block_stride(class_index);
+    size_t i = 0;
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(0 == magazine->block_count);
+    
+    retval = amp_mutex_lock(&depot->fields.mutex);
+    assert(AMP_SUCCESS == retval);
+    
+    first_block = depot->fields.chains;
+    if (NULL != first_block) {
+        depot->fields.chains = amp_internal_thread_cache_chain(first_block)->next_chain;
+    }
+    
+    retval = amp_mutex_unlock(&depot->fields.mutex);
+    assert(AMP_SUCCESS == retval);
+    
+    if (NULL != first_block) {
+        magazine->blocks = first_block;
+        magazine->block_count = amp_internal_thread_cache_chain(first_block)->block_count;
+        
+        return AMP_SUCCESS;
+    }
+    
+    /* Depot is empty, carve a batch of blocks out of a new slab without 
+     * holding the lock.
+     */
+    slab = (union amp_internal_thread_cache_slab_header_u*)AMP_ALLOC(cache_allocator->source_allocator,
+                                                                     sizeof(*slab) + AMP_THREAD_CACHE_ALLOCATOR_BATCH_SIZE * stride);
+    if (NULL == slab) {
+        return AMP_NOMEM;
+    }
+    
+    first_block = (union amp_internal_thread_cache_block_header_u*)(slab + 1);
+    for (i = 0; i < AMP_THREAD_CACHE_ALLOCATOR_BATCH_SIZE; ++i) {
+        union amp_internal_thread_cache_block_header_u* block = (union amp_internal_thread_cache_block_header_u*)(((amp_byte_t*)first_block) + i * stride);
+        
+        block->fields.class_index = class_index;
+        block->fields.next = (union amp_internal_thread_cache_block_header_u*)(((amp_byte_t*)block) + stride);
+    }
+    ((union amp_internal_thread_cache_block_header_u*)(((amp_byte_t*)first_block) + (AMP_THREAD_CACHE_ALLOCATOR_BATCH_SIZE - 1) * stride))->fields.next = NULL;
+    
+    retval = amp_mutex_lock(&depot->fields.mutex);
+    assert(AMP_SUCCESS == retval);
+    
+    slab->next = depot->fields.slabs;
+    depot->fields.slabs = slab;
+    
+    retval = amp_mutex_unlock(&depot->fields.mutex);
+    assert(AMP_SUCCESS == retval);
+    (void)retval;
+    
+    magazine->blocks = first_block;
+    magazine->block_count = AMP_THREAD_CACHE_ALLOCATOR_BATCH_SIZE;
+    
+    return AMP_SUCCESS;
+}
+
+
+
+/**
+ * Returns the cache of the calling thread, creates it if the thread has 
+ * none yet. Returns NULL if the cache can't be created.
+ */
+static struct amp_internal_thread_cache_s* amp_internal_thread_cache_get(struct amp_internal_thread_cache_allocator_s* cache_allocator);
+
+static struct amp_internal_thread_cache_s* amp_internal_thread_cache_get(struct amp_internal_thread_cache_allocator_s* cache_allocator)
+{
+    struct amp_internal_thread_cache_s* cache = NULL;
+    size_t i = 0;
+    int retval = AMP_UNSUPPORTED;
+    
+    cache = (struct amp_internal_thread_cache_s*)amp_thread_local_slot_value(cache_allocator->thread_cache_key);
+    if (NULL != cache) {
+        return cache;
+    }
+    
+    cache = (struct amp_internal_thread_cache_s*)AMP_ALIGNED_ALLOC(cache_allocator->source_allocator,
+                                                                   AMP_CACHE_LINE_SIZE,
+                                                                   sizeof(*cache));
+    if (NULL == cache) {
+        return NULL;
+    }
+    
+    for (i = 0; i < AMP_INTERNAL_THREAD_CACHE_CLASS_COUNT; ++i) {
+        cache->magazines[i].blocks = NULL;
+        cache->magazines[i].block_count = 0;
+    }
+    cache->previous = NULL;
+    
+    retval = amp_thread_local_slot_set_value(cache_allocator->thread_cache_key,
+                                             cache);
+    if (AMP_SUCCESS != retval) {
+        int const rv = AMP_ALIGNED_DEALLOC(cache_allocator->source_allocator, 
+                                           cache);
+        assert(AMP_SUCCESS == rv);
+        (void)rv;
+        
+        return NULL;
+    }
+    
+    retval = amp_mutex_lock(&cache_allocator->registry_mutex);
+    assert(AMP_SUCCESS == retval);
+    
+    cache->next = cache_allocator->thread_caches;
+    if (NULL != cache->next) {
+        cache->next->previous = cache;
+    }
+    cache_allocator->thread_caches = cache;
+    
+    retval = amp_mutex_unlock(&cache_allocator->registry_mutex);
+    assert(AMP_SUCCESS == retval);
+    (void)retval;
+    
+    return cache;
+}
+
+
+
+/**
+ * Returns the memory of a block with a header marking it as a large 
+ * allocation drawn from the source allocator or NULL if no memory is 
+ * available.
+ */
+static void* amp_internal_thread_cache_alloc_large(struct amp_internal_thread_cache_allocator_s* cache_allocator,
+                                                   size_t bytes_to_allocate,
+                                                   char const* filename,
+                                                   int line);
+
+static void* amp_internal_thread_cache_alloc_large(struct amp_internal_thread_cache_allocator_s* cache_allocator,
+                                                   size_t bytes_to_allocate,
+                                                   char const* filename,
+                                                   int line)
+{
+    amp_allocator_t source_allocator = cache_allocator->source_allocator;
+    union amp_internal_thread_cache_block_header_u* block = NULL;
+    
+    if (bytes_to_allocate > ((size_t)-1) - sizeof(*block)) {
+        return NULL;
+    }
+    
+    block = (union amp_internal_thread_cache_block_header_u*)source_allocator->alloc_func(source_allocator->allocator_context,
+                                                                                         sizeof(*block) + bytes_to_allocate,
+                                                                                         filename,
+                                                                                         line);
+    if (NULL == block) {
+        return NULL;
+    }
+    
+    block->fields.class_index = AMP_INTERNAL_THREAD_CACHE_LARGE_CLASS;
+    
+    return block + 1;
+}
+
+
+
+/**
+ * Finalizes the mutexes of the first depot_count depots and returns the 
+ * slabs of all depots to the source allocator.
+ */
+static int amp_internal_thread_cache_finalize_depots(struct amp_internal_thread_cache_allocator_s* cache_allocator,
+                                                     size_t depot_count);
+
+static int amp_internal_thread_cache_finalize_depots(struct amp_internal_thread_cache_allocator_s* cache_allocator,
+                                                     size_t depot_count)
+{
+    size_t i = 0;
+    int retval = AMP_SUCCESS;
+    
+    for (i = 0; i < depot_count; ++i) {
+        union amp_internal_thread_cache_depot_u* depot = &cache_allocator->depots[i];
+        
+        while (NULL != depot->fields.slabs) {
+            union amp_internal_thread_cache_slab_header_u* slab = depot->fields.slabs;
+            depot->fields.slabs = slab->next;
+            
+            retval = AMP_DEALLOC(cache_allocator->source_allocator, slab);
+            if (AMP_SUCCESS != retval) {
+                return retval;
+            }
+        }
+        depot->fields.chains = NULL;
+        
+        retval = amp_raw_mutex_finalize(&depot->fields.mutex);
+        if (AMP_SUCCESS != retval) {
+            return retval;
+        }
+    }
+    
+    return retval;
+}
+
+
+
+int amp_thread_cache_allocator_create(amp_allocator_t* cache_allocator,
+                                      amp_allocator_t source_allocator)
+{
+    struct amp_internal_thread_cache_allocator_s* tmp = NULL;
+    size_t depot_count = 0;
+    int retval = AMP_UNSUPPORTED;
+    int rc = AMP_UNSUPPORTED;
+    
+    assert(NULL != cache_allocator);
+    assert(NULL != source_allocator);
+    
+    tmp = (struct amp_internal_thread_cache_allocator_s*)AMP_ALIGNED_ALLOC(source_allocator,
+                                                                           AMP_CACHE_LINE_SIZE,
+                                                                           sizeof(*tmp));
+    if (NULL == tmp) {
+        return AMP_NOMEM;
+    }
+    
+    tmp->thread_caches = NULL;
+    tmp->source_allocator = source_allocator;
+    
+    for (depot_count = 0; depot_count < AMP_INTERNAL_THREAD_CACHE_CLASS_COUNT; ++depot_count) {
+        union amp_internal_thread_cache_depot_u* depot = &tmp->depots[depot_count];
+        
+        depot->fields.chains = NULL;
+        depot->fields.slabs = NULL;
+        
+        retval = amp_raw_mutex_init(&depot->fields.mutex);
+        if (AMP_SUCCESS != retval) {
+            rc = amp_internal_thread_cache_finalize_depots(tmp, depot_count);
+            assert(AMP_SUCCESS == rc);
+            rc = AMP_ALIGNED_DEALLOC(source_allocator, tmp);
+            assert(AMP_SUCCESS == rc);
+            
+            return retval;
+        }
+    }
+    
+    retval = amp_raw_mutex_init(&tmp->registry_mutex);
+    if (AMP_SUCCESS != retval) {
+        rc = amp_internal_thread_cache_finalize_depots(tmp, depot_count);
+        assert(AMP_SUCCESS == rc);
+        rc = AMP_ALIGNED_DEALLOC(source_allocator, tmp);
+        assert(AMP_SUCCESS == rc);
+        
+        return retval;
+    }
+    
+    retval = amp_thread_local_slot_create(&tmp->thread_cache_key,
+                                          source_allocator);
+    if (AMP_SUCCESS != retval) {
+        rc = amp_raw_mutex_finalize(&tmp->registry_mutex);
+        assert(AMP_SUCCESS == rc);
+        rc = amp_internal_thread_cache_finalize_depots(tmp, depot_count);
+        assert(AMP_SUCCESS == rc);
+        rc = AMP_ALIGNED_DEALLOC(source_allocator, tmp);
+        assert(AMP_SUCCESS == rc);
+        
+        return retval;
+    }
+    
+    retval = amp_allocator_create(cache_allocator,
+                                  source_allocator,
+                                  tmp,
+                                  amp_thread_cache_alloc,
+                                  amp_thread_cache_calloc,
+                                  amp_thread_cache_dealloc);
+    if (AMP_SUCCESS != retval) {
+        rc = amp_thread_local_slot_destroy(&tmp->thread_cache_key,
+                                           source_allocator);
+        assert(AMP_SUCCESS == rc);
+        rc = amp_raw_mutex_finalize(&tmp->registry_mutex);
+        assert(AMP_SUCCESS == rc);
+        rc = amp_internal_thread_cache_finalize_depots(tmp, depot_count);
+        assert(AMP_SUCCESS == rc);
+        rc = AMP_ALIGNED_DEALLOC(source_allocator, tmp);
+        assert(AMP_SUCCESS == rc);
+        (void)rc;
+    }
+    
+    return retval;
+}
+
+
+
+int amp_thread_cache_allocator_destroy(amp_allocator_t* cache_allocator,
+                                       amp_allocator_t source_allocator)
+{
+    struct amp_internal_thread_cache_allocator_s* tmp = NULL;
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != cache_allocator);
+    assert(NULL != *cache_allocator);
+    assert(NULL != source_allocator);
+    
+    tmp = (struct amp_internal_thread_cache_allocator_s*)(*cache_allocator)->allocator_context;
+    
+    retval = amp_thread_local_slot_destroy(&tmp->thread_cache_key,
+                                           source_allocator);
+    if (AMP_SUCCESS != retval) {
+        return retval;
+    }
+    
+    /* Cached blocks live in the slabs, only the caches need freeing. */
+    while (NULL != tmp->thread_caches) {
+        struct amp_internal_thread_cache_s* cache = tmp->thread_caches;
+        tmp->thread_caches = cache->next;
+        
+        retval = AMP_ALIGNED_DEALLOC(tmp->source_allocator, cache);
+        if (AMP_SUCCESS != retval) {
+            return retval;
+        }
+    }
+    
+    retval = amp_raw_mutex_finalize(&tmp->registry_mutex);
+    if (AMP_SUCCESS != retval) {
+        return retval;
+    }
+    
+    retval = amp_internal_thread_cache_finalize_depots(tmp,
+                                                       AMP_INTERNAL_THREAD_CACHE_CLASS_COUNT);
+    if (AMP_SUCCESS != retval) {
+        return retval;
+    }
+    
+    retval = amp_allocator_destroy(cache_allocator, source_allocator);
+    if (AMP_SUCCESS == retval) {
+        retval = AMP_ALIGNED_DEALLOC(source_allocator, tmp);
+    }
+    
+    return retval;
+}
+
+
+
+int amp_thread_cache_allocator_flush(amp_allocator_t cache_allocator)
+{
+    struct amp_internal_thread_cache_allocator_s* tmp = NULL;
+    struct amp_internal_thread_cache_s* cache = NULL;
+    size_t i = 0;
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != cache_allocator);
+    
+    tmp = (struct amp_internal_thread_cache_allocator_s*)cache_allocator->allocator_context;
+    
+    cache = (struct amp_internal_thread_cache_s*)amp_thread_local_slot_value(tmp->thread_cache_key);
+    if (NULL == cache) {
+        return AMP_SUCCESS;
+    }
+    
+    for (i = 0; i < AMP_INTERNAL_THREAD_CACHE_CLASS_COUNT; ++i) {
+        struct amp_internal_thread_cache_magazine_s* magazine = &cache->magazines[i];
+        
+        if (0 != magazine->block_count) {
+            amp_internal_thread_cache_depot_push(&tmp->depots[i],
+                                                 magazine->blocks,
+                                                 magazine->block_count);
+            magazine->blocks = NULL;
+            magazine->block_count = 0;
+        }
+    }
+    
+    retval = amp_thread_local_slot_set_value(tmp->thread_cache_key, NULL);
+    if (AMP_SUCCESS != retval) {
+        return retval;
+    }
+    
+    retval = amp_mutex_lock(&tmp->registry_mutex);
+    assert(AMP_SUCCESS == retval);
+    
+    if (NULL != cache->previous) {
+        cache->previous->next = cache->next;
+    } else {
+        tmp->thread_caches = cache->next;
+    }
+    if (NULL != cache->next) {
+        cache->next->previous = cache->previous;
+    }
+    
+    retval = amp_mutex_unlock(&tmp->registry_mutex);
+    assert(AMP_SUCCESS == retval);
+    
+    return AMP_ALIGNED_DEALLOC(tmp->source_allocator, cache);
+}
+
+
+
+void* amp_thread_cache_alloc(void* cache_allocator_context,
+                             size_t bytes_to_allocate,
+                             char const* filename,
+                             int line)
+{
+    struct amp_internal_thread_cache_allocator_s* tmp = (struct amp_internal_thread_cache_allocator_s*)cache_allocator_context;
+    struct amp_internal_thread_cache_s* cache = NULL;
+    struct amp_internal_thread_cache_magazine_s* magazine = NULL;
+    union amp_internal_thread_cache_block_header_u* block = NULL;
+    size_t class_index = 0;
+    
+    assert(NULL != tmp);
+    
+    if (AMP_THREAD_CACHE_ALLOCATOR_MAX_BLOCK_SIZE < bytes_to_allocate) {
+        return amp_internal_thread_cache_alloc_large(tmp,
+                                                     bytes_to_allocate,
+                                                     filename,
+                                                     line);
+    }
+    
+    if (0 != bytes_to_allocate) {
+        class_index = (bytes_to_allocate - 1) / AMP_THREAD_CACHE_ALLOCATOR_SIZE_CLASS_GRANULARITY;
+    }
+    
+    cache = amp_internal_thread_cache_get(tmp);
+    if (NULL == cache) {
+        return NULL;
+    }
+    
+    magazine = &cache->magazines[class_index];
+    if ((0 == magazine->block_count)
+        && (AMP_SUCCESS != amp_internal_thread_cache_refill(tmp, class_index, magazine))) {
+        return NULL;
+    }
+    
+    block = magazine->blocks;
+    magazine->blocks = block->fields.next;
+    --(magazine->block_count);
+    
+    return block + 1;
+}
+
+
+
+void* amp_thread_cache_calloc(void* cache_allocator_context,
+                              size_t elem_count,
+                              size_t bytes_per_elem,
+                              char const* filename,
+                              int line)
+{
+    void* memory = NULL;
+    
+    if ((0 != bytes_per_elem) && (elem_count > ((size_t)-1) / bytes_per_elem)) {
+        return NULL;
+    }
+    
+    memory = amp_thread_cache_alloc(cache_allocator_context,
+                                    elem_count * bytes_per_elem,
+                                    filename,
+                                    line);
+    if (NULL != memory) {
+        memset(memory, 0, elem_count * bytes_per_elem);
+    }
+    
+    return memory;
+}
+
+
+
+int amp_thread_cache_dealloc(void* cache_allocator_context,
+                             void* pointer,
+                             char const* filename,
+                             int line)
+{
+    struct amp_internal_thread_cache_allocator_s* tmp = (struct amp_internal_thread_cache_allocator_s*)cache_allocator_context;
+    struct amp_internal_thread_cache_s* cache = NULL;
+    struct amp_internal_thread_cache_magazine_s* magazine = NULL;
+    union amp_internal_thread_cache_block_header_u* block = NULL;
+    union amp_internal_thread_cache_block_header_u* last_drained = NULL;
+    size_t class_index = 0;
+    size_t i = 0;
+    
+    assert(NULL != tmp);
+    
+    if (NULL == pointer) {
+        return AMP_SUCCESS;
+    }
+    
+    block = ((union amp_internal_thread_cache_block_header_u*)pointer) - 1;
+    class_index = block->fields.class_index;
+    
+    if (AMP_INTERNAL_THREAD_CACHE_LARGE_CLASS == class_index) {
+        return tmp->source_allocator->dealloc_func(tmp->source_allocator->allocator_context,
+                                                   block,
+                                                   filename,
+                                                   line);
+    }
+    
+    assert(AMP_INTERNAL_THREAD_CACHE_CLASS_COUNT > class_index);
+    
+    cache = amp_internal_thread_cache_get(tmp);
+    if (NULL == cache) {
+        /* No cache for this thread, hand the block to the depot directly. */
+        block->fields.next = NULL;
+        amp_internal_thread_cache_depot_push(&tmp->depots[class_index],
+                                             block,
+                                             1);
+        
+        return AMP_SUCCESS;
+    }
+    
+    magazine = &cache->magazines[class_index];
+    block->fields.next = magazine->blocks;
+    magazine->blocks = block;
+    ++(magazine->block_count);
+    
+    /* Keep a batch in the cache so alternating alloc and dealloc calls 
+     * don't ping-pong batches with the depot.
+     */
+    if (2 * AMP_THREAD_CACHE_ALLOCATOR_BATCH_SIZE <= magazine->block_count) {
+        last_drained = magazine->blocks;
+        for (i = 1; i < AMP_THREAD_CACHE_ALLOCATOR_BATCH_SIZE; ++i) {
+            last_drained = last_drained->fields.next;
+        }
+        
+        magazine->blocks = last_drained->fields.next;
+        magazine->block_count -= AMP_THREAD_CACHE_ALLOCATOR_BATCH_SIZE;
+        last_drained->fields.next = NULL;
+        
+        amp_internal_thread_cache_depot_push(&tmp->depots[class_index],
+                                             block,
+                                             AMP_THREAD_CACHE_ALLOCATOR_BATCH_SIZE);
+    }
+    
+    return AMP_SUCCESS;
+}
+
+
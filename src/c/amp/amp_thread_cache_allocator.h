@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Thread-caching allocator for small allocations. Every thread allocating
+ * or deallocating via it gets its own cache of free blocks per size class
+ * (a magazine), found via an amp_thread_local_slot. The common allocation 
+ * and deallocation path only touches the calling thread's cache and the 
+ * block itself, no lock and no shared cache line is involved.
+ *
+ * An empty magazine refills with a whole batch of blocks from a depot 
+ * shared by all threads, a magazine holding too many blocks drains a batch
+ * back to the depot. The depot of each size class is guarded by its own 
+ * mutex which is taken once per batch. Blocks for the depot are carved out
+ * of slabs drawn from the source allocator the thread-caching allocator 
+ * has been created with. Slabs are only returned to the source allocator 
+ * when the thread-caching allocator is destroyed.
+ *
+ * Size classes are AMP_THREAD_CACHE_ALLOCATOR_SIZE_CLASS_GRANULARITY bytes
+ * apart and go up to AMP_THREAD_CACHE_ALLOCATOR_MAX_BLOCK_SIZE bytes, 
+ * larger allocations are forwarded to the source allocator.
+ *
+ * Thread-local slots can't clean up after exiting threads, therefore 
+ * every thread must call amp_thread_cache_allocator_flush before it ends 
+ * to return its cached blocks to the depot and free its cache:
+ * @code
+ * void worker_func(void* context)
+ * {
+ *     amp_allocator_t allocator = (amp_allocator_t)context;
+ *     void* data = AMP_ALLOC(allocator, 48);
+ *     ...
+ *     AMP_DEALLOC(allocator, data);
+ *     amp_thread_cache_allocator_flush(allocator);
+ * }
+ * @endcode
+ * The caches of threads that didn't flush are freed when the allocator is
+ * destroyed.
+ */
+
+#ifndef AMP_amp_thread_cache_allocator_H
+#define AMP_amp_thread_cache_allocator_H
+
+#include <stddef.h>
+
+#include <amp/amp_memory.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+    
+    
+    /**
+     * Distance in bytes between the block sizes of neighboring size 
+     * classes.
+     */
+#define AMP_THREAD_CACHE_ALLOCATOR_SIZE_CLASS_GRANULARITY ((size_t)16)
+    
+    /**
+     * Largest allocation served from a size class, larger allocations are
+     * forwarded to the source allocator.
+     */
+#define AMP_THREAD_CACHE_ALLOCATOR_MAX_BLOCK_SIZE ((size_t)256)
+    
+    /**
+     * Number of blocks moved between a thread's cache and the depot at
+     * once. A thread caches up to twice as many blocks per size class.
+     */
+#define AMP_THREAD_CACHE_ALLOCATOR_BATCH_SIZE ((size_t)32)
+    
+    
+    /**
+     * Creates a thread-caching allocator drawing its slabs, thread caches, 
+     * and allocations larger than AMP_THREAD_CACHE_ALLOCATOR_MAX_BLOCK_SIZE
+     * from source_allocator. The allocator itself is allocated via 
+     * source_allocator, too.
+     *
+     * source_allocator must be thread-safe and stay valid until the 
+     * thread-caching allocator has been destroyed.
+     *
+     * @return AMP_SUCCESS on successful creation.
+     *         AMP_NOMEM if not enough memory is available.
+     *         AMP_ERROR if no thread-local slot or mutex can be created.
+     */
+    int amp_thread_cache_allocator_create(amp_allocator_t* cache_allocator,
+                                          amp_allocator_t source_allocator);
+    
+    /**
+     * Destroys cache_allocator, frees the caches of all threads, and 
+     * returns all slabs to the source allocator. source_allocator is used 
+     * to deallocate the allocator itself and must be the allocator passed 
+     * to amp_thread_cache_allocator_create. All memory allocated via 
+     * cache_allocator must have been deallocated before and no thread may 
+     * use it concurrently.
+     *
+     * @return AMP_SUCCESS on successful destruction.
+     *         AMP_ERROR might be returned if an error is detected.
+     */
+    int amp_thread_cache_allocator_destroy(amp_allocator_t* cache_allocator,
+                                           amp_allocator_t source_allocator);
+    
+    /**
+     * Returns all blocks cached by the calling thread to the depot of 
+     * cache_allocator and frees the calling thread's cache. Call it before a
+     * thread that used cache_allocator ends. Using cache_allocator again 
+     * afterwards creates a new cache.
+     *
+     * @return AMP_SUCCESS on success, even if the calling thread has no 
+     *         cache.
+     *         AMP_ERROR might be returned if an error is detected.
+     */
+    int amp_thread_cache_allocator_flush(amp_allocator_t cache_allocator);
+    
+    
+    /**
+     * Allocation function of allocators created by 
+     * amp_thread_cache_allocator_create. Returns NULL if no memory is 
+     * available.
+     *
+     * Thread-safe.
+     */
+    void* amp_thread_cache_alloc(void* cache_allocator_context,
+                                 size_t bytes_to_allocate,
+                                 char const* filename,
+                                 int line);
+    
+    /**
+     * Zeroing array allocation function of allocators created by 
+     * amp_thread_cache_allocator_create. Returns NULL on overflow of 
+     * elem_count * bytes_per_elem or if no memory is available.
+     *
+     * Thread-safe.
+     */
+    void* amp_thread_cache_calloc(void* cache_allocator_context,
+                                  size_t elem_count,
+                                  size_t bytes_per_elem,
+                                  char const* filename,
+                                  int line);
+    
+    /**
+     * Deallocation function of allocators created by 
+     * amp_thread_cache_allocator_create. Blocks of a size class are put 
+     * into the calling thread's cache, even if another thread allocated 
+     * them. Larger allocations are returned to the source allocator.
+     *
+     * Thread-safe.
+     *
+     * @return AMP_SUCCESS on successful deallocation.
+     *         Error codes of the source allocator for allocations larger 
+     *         than AMP_THREAD_CACHE_ALLOCATOR_MAX_BLOCK_SIZE.
+     */
+    int amp_thread_cache_dealloc(void* cache_allocator_context,
+                                 void* pointer,
+                                 char const* filename,
+                                 int line);
+    
+    
+    
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* AMP_amp_thread_cache_allocator_H */
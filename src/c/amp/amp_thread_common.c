@@ -57,11 +57,11 @@ int amp_internal_thread_init_for_configuration(amp_thread_t thread)
     
     assert(NULL != thread);
     
+    thread->state = 0; /* Signal not initialized */
     thread->func = NULL;
     thread->func_context = NULL;
-    thread->reserved0 = 0;
-    thread->reserved1 = 0;
-    thread->state = 0; /* Signal not initialized */
+    (void)amp_internal_thread_configure_stack(thread, NULL);
+    (void)amp_thread_affinity_clear(&thread->affinity);
     
     retval = amp_internal_native_thread_set_invalid(&thread->native_thread_description);
     if (AMP_SUCCESS == retval) {
@@ -127,6 +127,72 @@ int amp_internal_thread_configure_function(amp_thread_t thread,
 
 
 
+int amp_internal_thread_configure_affinity(amp_thread_t thread,
+                                           struct amp_thread_affinity_s const* affinity)
+{
+    assert(NULL != thread);
+    assert(amp_internal_thread_joinable_state != thread->state);
+    
+    if (amp_internal_thread_joinable_state == thread->state) {
+        return AMP_BUSY;
+    }
+    
+    if (NULL == affinity) {
+        return amp_thread_affinity_clear(&thread->affinity);
+    }
+    
+    thread->affinity = *affinity;
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_internal_thread_configure_stack(amp_thread_t thread,
+                                        struct amp_thread_stack_s const* stack)
+{
+    assert(NULL != thread);
+    assert(amp_internal_thread_joinable_state != thread->state);
+    
+    if (amp_internal_thread_joinable_state == thread->state) {
+        return AMP_BUSY;
+    }
+    
+    if (NULL == stack) {
+        thread->stack.size = AMP_THREAD_STACK_DEFAULT_SIZE;
+        thread->stack.guard_size = AMP_THREAD_STACK_DEFAULT_GUARD_SIZE;
+        thread->stack.memory = NULL;
+        
+        return AMP_SUCCESS;
+    }
+    
+    assert((NULL == stack->memory) 
+           || (AMP_THREAD_STACK_DEFAULT_SIZE != stack->size));
+    
+    if ((NULL != stack->memory) 
+        && (AMP_THREAD_STACK_DEFAULT_SIZE == stack->size)) {
+        
+        return AMP_ERROR;
+    }
+    
+    thread->stack = *stack;
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_internal_thread_has_configured_stack(amp_thread_t thread)
+{
+    assert(NULL != thread);
+    
+    return (AMP_THREAD_STACK_DEFAULT_SIZE != thread->stack.size)
+        || (AMP_THREAD_STACK_DEFAULT_GUARD_SIZE != thread->stack.guard_size)
+        || (NULL != thread->stack.memory);
+}
+
+
+
 int amp_internal_thread_context(amp_thread_t thread,
                                 void** context)
 {
@@ -153,6 +219,91 @@ int amp_internal_thread_function(amp_thread_t thread,
 
 
 
+int amp_thread_affinity_clear(struct amp_thread_affinity_s* affinity)
+{
+    size_t i = 0;
+    
+    assert(NULL != affinity);
+    
+    for (i = 0; i < AMP_INTERNAL_THREAD_AFFINITY_WORD_COUNT; ++i) {
+        affinity->cpu_bits[i] = 0ul;
+    }
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_thread_affinity_add_cpu(struct amp_thread_affinity_s* affinity,
+                                size_t cpu)
+{
+    assert(NULL != affinity);
+    
+    if (cpu >= AMP_THREAD_AFFINITY_CPU_CAPACITY) {
+        return AMP_ERROR;
+    }
+    
+    affinity->cpu_bits[cpu / AMP_INTERNAL_THREAD_AFFINITY_WORD_BITS] |= 
+        (1ul << (cpu % AMP_INTERNAL_THREAD_AFFINITY_WORD_BITS));
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_thread_affinity_remove_cpu(struct amp_thread_affinity_s* affinity,
+                                   size_t cpu)
+{
+    assert(NULL != affinity);
+    
+    if (cpu >= AMP_THREAD_AFFINITY_CPU_CAPACITY) {
+        return AMP_ERROR;
+    }
+    
+    affinity->cpu_bits[cpu / AMP_INTERNAL_THREAD_AFFINITY_WORD_BITS] &= 
+        ~(1ul << (cpu % AMP_INTERNAL_THREAD_AFFINITY_WORD_BITS));
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_thread_affinity_contains_cpu(struct amp_thread_affinity_s const* affinity,
+                                     size_t cpu)
+{
+    assert(NULL != affinity);
+    
+    if (cpu >= AMP_THREAD_AFFINITY_CPU_CAPACITY) {
+        return 0;
+    }
+    
+    return 0ul != (affinity->cpu_bits[cpu / AMP_INTERNAL_THREAD_AFFINITY_WORD_BITS]
+                   & (1ul << (cpu % AMP_INTERNAL_THREAD_AFFINITY_WORD_BITS)));
+}
+
+
+
+size_t amp_thread_affinity_cpu_count(struct amp_thread_affinity_s const* affinity)
+{
+    size_t count = 0;
+    size_t i = 0;
+    
+    assert(NULL != affinity);
+    
+    for (i = 0; i < AMP_INTERNAL_THREAD_AFFINITY_WORD_COUNT; ++i) {
+        unsigned long bits = affinity->cpu_bits[i];
+        
+        while (0ul != bits) {
+            bits &= bits - 1ul;
+            ++count;
+        }
+    }
+    
+    return count;
+}
+
+
+
 int amp_raw_thread_launch(amp_thread_t thread, 
                           void* func_context, 
                           amp_thread_func_t func)
@@ -183,10 +334,16 @@ int amp_raw_thread_launch(amp_thread_t thread,
 
 
 
-int amp_thread_create_and_launch(amp_thread_t* thread,
-                                 amp_allocator_t allocator,
-                                 void* func_context,
-                                 amp_thread_func_t func)
+/**
+ * Allocates, configures, and launches a thread. affinity and stack may be 
+ * NULL to use the platform defaults.
+ */
+static int amp_internal_thread_create_and_launch(amp_thread_t* thread,
+                                                 amp_allocator_t allocator,
+                                                 void* func_context,
+                                                 amp_thread_func_t func,
+                                                 struct amp_thread_affinity_s const* affinity,
+                                                 struct amp_thread_stack_s const* stack)
 {
     int retval = AMP_UNSUPPORTED;
     amp_thread_t local_thread = AMP_THREAD_UNINITIALIZED;
@@ -204,9 +361,23 @@ int amp_thread_create_and_launch(amp_thread_t* thread,
         return AMP_NOMEM;
     }
     
-    retval = amp_raw_thread_launch(local_thread,
-                                   func_context,
-                                   func);
+    retval = amp_internal_thread_init_for_configuration(local_thread);
+    if (AMP_SUCCESS == retval) {
+        retval = amp_internal_thread_configure(local_thread,
+                                               func_context,
+                                               func);
+    }
+    if (AMP_SUCCESS == retval) {
+        retval = amp_internal_thread_configure_affinity(local_thread,
+                                                        affinity);
+    }
+    if (AMP_SUCCESS == retval) {
+        retval = amp_internal_thread_configure_stack(local_thread,
+                                                     stack);
+    }
+    if (AMP_SUCCESS == retval) {
+        retval = amp_internal_thread_launch_configured(local_thread);
+    }
     
     if (AMP_SUCCESS == retval) {
         *thread = local_thread;
@@ -221,6 +392,53 @@ int amp_thread_create_and_launch(amp_thread_t* thread,
 
 
 
+int amp_thread_create_and_launch(amp_thread_t* thread,
+                                 amp_allocator_t allocator,
+                                 void* func_context,
+                                 amp_thread_func_t func)
+{
+    return amp_internal_thread_create_and_launch(thread,
+                                                 allocator,
+                                                 func_context,
+                                                 func,
+                                                 NULL,
+                                                 NULL);
+}
+
+
+
+int amp_thread_create_and_launch_with_affinity(amp_thread_t* thread,
+                                               amp_allocator_t allocator,
+                                               void* func_context,
+                                               amp_thread_func_t func,
+                                               struct amp_thread_affinity_s const* affinity)
+{
+    return amp_internal_thread_create_and_launch(thread,
+                                                 allocator,
+                                                 func_context,
+                                                 func,
+                                                 affinity,
+                                                 NULL);
+}
+
+
+
+int amp_thread_create_and_launch_with_stack(amp_thread_t* thread,
+                                            amp_allocator_t allocator,
+                                            void* func_context,
+                                            amp_thread_func_t func,
+                                            struct amp_thread_stack_s const* stack)
+{
+    return amp_internal_thread_create_and_launch(thread,
+                                                 allocator,
+                                                 func_context,
+                                                 func,
+                                                 NULL,
+                                                 stack);
+}
+
+
+
 int amp_thread_join_and_destroy(amp_thread_t* thread,
                                 amp_allocator_t allocator)
 {
@@ -0,0 +1,477 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Implementation of amp thread pool on top of amp_thread_array, amp_mutex 
+ * and amp_condition_variable.
+ *
+ * Jobs are kept in a ring buffer that doubles its capacity when full. One 
+ * mutex protects the queue and the pool state, workers block on the 
+ * job_available condition while the queue is empty and the last finishing
+ * job wakes threads waiting on the all_done condition.
+ */
+
+#include "amp_thread_pool.h"
+
+#include <assert.h>
+#include <stddef.h>
+
+#include "amp_stddef.h"
+#include "amp_return_code.h"
+#include "amp_platform.h"
+#include "amp_thread_array.h"
+#include "amp_mutex.h"
+#include "amp_condition_variable.h"
+#include "amp_raw_mutex.h"
+#include "amp_raw_condition_variable.h"
+
+
+
+/**
+ * Number of jobs the queue can hold before it grows the first time.
+ */
+#define AMP_INTERNAL_THREAD_POOL_INITIAL_QUEUE_CAPACITY ((size_t)64)
+
+
+
+struct amp_internal_thread_pool_job_s {
+    amp_thread_func_t func;
+    void* context;
+};
+
+
+/**
+ * Internal opaque thread pool data structure
+ */
+struct amp_thread_pool_s {
+    struct amp_raw_mutex_s mutex;
+    struct amp_raw_condition_variable_s job_available;
+    struct amp_raw_condition_variable_s all_done;
+    
+    /* Ring buffer of queued jobs, the oldest job is at queue_head. */
+    struct amp_internal_thread_pool_job_s* queue;
+    size_t queue_capacity;
+    size_t queue_head;
+    size_t queue_count;
+    
+    /* Queued jobs plus jobs currently running on workers. */
+    size_t unfinished_job_count;
+    
+    amp_thread_array_t workers;
+    size_t worker_count;
+    
+    amp_allocator_t allocator;
+    int shutting_down;
+    int joined;
+};
+
+
+
+/**
+ * Moves the queued jobs into a ring buffer of twice the capacity.
+ * Called with the pool mutex locked.
+ */
+static int amp_internal_thread_pool_grow_queue(struct amp_thread_pool_s* pool)
+{
+    size_t const new_capacity = 2 * pool->queue_capacity;
+    struct amp_internal_thread_pool_job_s* new_queue = NULL;
+    size_t i = 0;
+    int retval = AMP_UNSUPPORTED;
+    
+    new_queue = (struct amp_internal_thread_pool_job_s*)AMP_ALLOC(pool->allocator,
+                                                                  new_capacity * sizeof(*new_queue));
+    if (NULL == new_queue) {
+        return AMP_NOMEM;
+    }
+    
+    for (i = 0; i < pool->queue_count; ++i) {
+        new_queue[i] = pool->queue[(pool->queue_head + i) % pool->queue_capacity];
+    }
+    
+    retval = AMP_DEALLOC(pool->allocator, pool->queue);
+    assert(AMP_SUCCESS == retval);
+    (void)retval;
+    
+    pool->queue = new_queue;
+    pool->queue_capacity = new_capacity;
+    pool->queue_head = 0;
+    
+    return AMP_SUCCESS;
+}
+
+
+
+static void amp_internal_thread_pool_worker_func(void* context)
+{
+    struct amp_thread_pool_s* pool = (struct amp_thread_pool_s*)context;
+    struct amp_internal_thread_pool_job_s job;
+    int retval = AMP_UNSUPPORTED;
+    
+    retval = amp_mutex_lock(&pool->mutex);
+    assert(AMP_SUCCESS == retval);
+    
+    for (;;) {
+        while ((0 == pool->queue_count) && (0 == pool->shutting_down)) {
+            retval = amp_condition_variable_wait(&pool->job_available,
+                                                 &pool->mutex);
+            assert(AMP_SUCCESS == retval);
+        }
+        
+        if (0 == pool->queue_count) {
+            /* Shutting down and no jobs left. */
+            break;
+        }
+        
+        job = pool->queue[pool->queue_head];
+        pool->queue_head = (pool->queue_head + 1) % pool->queue_capacity;
+        --(pool->queue_count);
+        
+        retval = amp_mutex_unlock(&pool->mutex);
+        assert(AMP_SUCCESS == retval);
+        
+        job.func(job.context);
+        
+        retval = amp_mutex_lock(&pool->mutex);
+        assert(AMP_SUCCESS == retval);
+        
+        --(pool->unfinished_job_count);
+        if (0 == pool->unfinished_job_count) {
+            retval = amp_condition_variable_broadcast(&pool->all_done);
+            assert(AMP_SUCCESS == retval);
+        }
+    }
+    
+    retval = amp_mutex_unlock(&pool->mutex);
+    assert(AMP_SUCCESS == retval);
+    (void)retval;
+}
+
+
+
+static size_t amp_internal_thread_pool_default_worker_count(amp_allocator_t allocator)
+{
+    amp_platform_t platform = NULL;
+    size_t concurrency_level = 0;
+    int retval = amp_platform_create(&platform, allocator);
+    
+    if (AMP_SUCCESS == retval) {
+        retval = amp_platform_get_concurrency_level(platform, 
+                                                    &concurrency_level);
+        if (AMP_SUCCESS != retval) {
+            concurrency_level = 0;
+        }
+        
+        retval = amp_platform_destroy(&platform, allocator);
+        assert(AMP_SUCCESS == retval);
+    }
+    
+    return (0 != concurrency_level) ? concurrency_level : (size_t)1;
+}
+
+
+
+/**
+ * Finalizes the synchronization primitives and frees the memory of a pool
+ * without any running workers.
+ */
+static void amp_internal_thread_pool_free(struct amp_thread_pool_s* pool,
+                                          amp_allocator_t allocator)
+{
+    int retval = AMP_UNSUPPORTED;
+    
+    if (AMP_THREAD_ARRAY_UNINITIALIZED != pool->workers) {
+        retval = amp_thread_array_destroy(&pool->workers, allocator);
+        assert(AMP_SUCCESS == retval);
+    }
+    
+    retval = AMP_DEALLOC(allocator, pool->queue);
+    assert(AMP_SUCCESS == retval);
+    
+    retval = amp_raw_condition_variable_finalize(&pool->all_done);
+    assert(AMP_SUCCESS == retval);
+    
+    retval = amp_raw_condition_variable_finalize(&pool->job_available);
+    assert(AMP_SUCCESS == retval);
+    
+    retval = amp_raw_mutex_finalize(&pool->mutex);
+    assert(AMP_SUCCESS == retval);
+    
+    retval = AMP_DEALLOC(allocator, pool);
+    assert(AMP_SUCCESS == retval);
+    (void)retval;
+}
+
+
+
+int amp_thread_pool_create(amp_thread_pool_t* pool,
+                           amp_allocator_t allocator,
+                           size_t worker_count)
+{
+    struct amp_thread_pool_s* tmp_pool = NULL;
+    size_t joinable_count = 0;
+    int retval = AMP_UNSUPPORTED;
+    int rc = AMP_UNSUPPORTED;
+    
+    assert(NULL != pool);
+    assert(NULL != allocator);
+    
+    if (0 == worker_count) {
+        worker_count = amp_internal_thread_pool_default_worker_count(allocator);
+    }
+    
+    tmp_pool = (struct amp_thread_pool_s*)AMP_ALLOC(allocator, sizeof(*tmp_pool));
+    if (NULL == tmp_pool) {
+        return AMP_NOMEM;
+    }
+    
+    tmp_pool->queue = (struct amp_internal_thread_pool_job_s*)AMP_ALLOC(allocator,
+                                                                        AMP_INTERNAL_THREAD_POOL_INITIAL_QUEUE_CAPACITY * sizeof(*tmp_pool->queue));
+    if (NULL == tmp_pool->queue) {
+        rc = AMP_DEALLOC(allocator, tmp_pool);
+        assert(AMP_SUCCESS == rc);
+        (void)rc;
+        
+        return AMP_NOMEM;
+    }
+    
+    retval = amp_raw_mutex_init(&tmp_pool->mutex);
+    if (AMP_SUCCESS != retval) {
+        rc = AMP_DEALLOC(allocator, tmp_pool->queue);
+        assert(AMP_SUCCESS == rc);
+        rc = AMP_DEALLOC(allocator, tmp_pool);
+        assert(AMP_SUCCESS == rc);
+        
+        return retval;
+    }
+    
+    retval = amp_raw_condition_variable_init(&tmp_pool->job_available);
+    if (AMP_SUCCESS != retval) {
+        rc = amp_raw_mutex_finalize(&tmp_pool->mutex);
+        assert(AMP_SUCCESS == rc);
+        rc = AMP_DEALLOC(allocator, tmp_pool->queue);
+        assert(AMP_SUCCESS == rc);
+        rc = AMP_DEALLOC(allocator, tmp_pool);
+        assert(AMP_SUCCESS == rc);
+        
+        return retval;
+    }
+    
+    retval = amp_raw_condition_variable_init(&tmp_pool->all_done);
+    if (AMP_SUCCESS != retval) {
+        rc = amp_raw_condition_variable_finalize(&tmp_pool->job_available);
+        assert(AMP_SUCCESS == rc);
+        rc = amp_raw_mutex_finalize(&tmp_pool->mutex);
+        assert(AMP_SUCCESS == rc);
+        rc = AMP_DEALLOC(allocator, tmp_pool->queue);
+        assert(AMP_SUCCESS == rc);
+        rc = AMP_DEALLOC(allocator, tmp_pool);
+        assert(AMP_SUCCESS == rc);
+        
+        return retval;
+    }
+    
+    tmp_pool->queue_capacity = AMP_INTERNAL_THREAD_POOL_INITIAL_QUEUE_CAPACITY;
+    tmp_pool->queue_head = 0;
+    tmp_pool->queue_count = 0;
+    tmp_pool->unfinished_job_count = 0;
+    tmp_pool->workers = AMP_THREAD_ARRAY_UNINITIALIZED;
+    tmp_pool->worker_count = worker_count;
+    tmp_pool->allocator = allocator;
+    tmp_pool->shutting_down = 0;
+    tmp_pool->joined = 0;
+    
+    retval = amp_thread_array_create(&tmp_pool->workers,
+                                     allocator,
+                                     worker_count);
+    if (AMP_SUCCESS != retval) {
+        tmp_pool->workers = AMP_THREAD_ARRAY_UNINITIALIZED;
+        amp_internal_thread_pool_free(tmp_pool, allocator);
+        
+        return retval;
+    }
+    
+    retval = amp_thread_array_configure(tmp_pool->workers,
+                                        0,
+                                        worker_count,
+                                        tmp_pool,
+                                        &amp_internal_thread_pool_worker_func);
+    assert(AMP_SUCCESS == retval);
+    
+    retval = amp_thread_array_launch_all(tmp_pool->workers, 
+                                         &joinable_count);
+    if (AMP_SUCCESS != retval) {
+        /* Stop the workers that could be launched. */
+        rc = amp_thread_pool_shutdown(tmp_pool);
+        assert(AMP_SUCCESS == rc);
+        amp_internal_thread_pool_free(tmp_pool, allocator);
+        
+        return retval;
+    }
+    
+    *pool = tmp_pool;
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_thread_pool_destroy(amp_thread_pool_t* pool,
+                            amp_allocator_t allocator)
+{
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != pool);
+    assert(NULL != *pool);
+    assert(NULL != allocator);
+    
+    retval = amp_thread_pool_shutdown(*pool);
+    if (AMP_SUCCESS != retval) {
+        return retval;
+    }
+    
+    amp_internal_thread_pool_free(*pool, allocator);
+    *pool = AMP_THREAD_POOL_UNINITIALIZED;
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_thread_pool_submit(amp_thread_pool_t pool,
+                           void* context,
+                           amp_thread_func_t func)
+{
+    int retval = AMP_UNSUPPORTED;
+    int submit_result = AMP_SUCCESS;
+    
+    assert(NULL != pool);
+    assert(NULL != func);
+    
+    retval = amp_mutex_lock(&pool->mutex);
+    assert(AMP_SUCCESS == retval);
+    {
+        if (0 != pool->shutting_down) {
+            submit_result = AMP_ERROR;
+        } else if (pool->queue_count == pool->queue_capacity) {
+            submit_result = amp_internal_thread_pool_grow_queue(pool);
+        }
+        
+        if (AMP_SUCCESS == submit_result) {
+            size_t const tail = (pool->queue_head + pool->queue_count) % pool->queue_capacity;
+            pool->queue[tail].func = func;
+            pool->queue[tail].context = context;
+            ++(pool->queue_count);
+            ++(pool->unfinished_job_count);
+            
+            retval = amp_condition_variable_signal(&pool->job_available);
+            assert(AMP_SUCCESS == retval);
+        }
+    }
+    retval = amp_mutex_unlock(&pool->mutex);
+    assert(AMP_SUCCESS == retval);
+    (void)retval;
+    
+    return submit_result;
+}
+
+
+
+int amp_thread_pool_wait_all(amp_thread_pool_t pool)
+{
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != pool);
+    
+    retval = amp_mutex_lock(&pool->mutex);
+    assert(AMP_SUCCESS == retval);
+    {
+        while (0 != pool->unfinished_job_count) {
+            retval = amp_condition_variable_wait(&pool->all_done,
+                                                 &pool->mutex);
+            assert(AMP_SUCCESS == retval);
+        }
+    }
+    retval = amp_mutex_unlock(&pool->mutex);
+    assert(AMP_SUCCESS == retval);
+    
+    return retval;
+}
+
+
+
+int amp_thread_pool_shutdown(amp_thread_pool_t pool)
+{
+    int retval = AMP_UNSUPPORTED;
+    int already_joined = 0;
+    
+    assert(NULL != pool);
+    
+    retval = amp_mutex_lock(&pool->mutex);
+    assert(AMP_SUCCESS == retval);
+    {
+        already_joined = pool->joined;
+        pool->shutting_down = 1;
+        
+        retval = amp_condition_variable_broadcast(&pool->job_available);
+        assert(AMP_SUCCESS == retval);
+    }
+    retval = amp_mutex_unlock(&pool->mutex);
+    assert(AMP_SUCCESS == retval);
+    
+    if (0 != already_joined) {
+        return AMP_SUCCESS;
+    }
+    
+    retval = amp_thread_array_join_all(pool->workers, NULL);
+    if (AMP_SUCCESS != retval) {
+        return retval;
+    }
+    
+    pool->joined = 1;
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_thread_pool_get_worker_count(amp_thread_pool_t pool,
+                                     size_t* worker_count)
+{
+    assert(NULL != pool);
+    assert(NULL != worker_count);
+    
+    *worker_count = pool->worker_count;
+    
+    return AMP_SUCCESS;
+}
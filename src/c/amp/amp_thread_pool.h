@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Pool of persistent worker threads that run submitted jobs.
+ *
+ * Launching and joining an amp_thread_array creates and destroys its 
+ * platform threads every time. For short parallel sections creating threads
+ * costs more than the work itself. A thread pool launches its workers once,
+ * keeps them parked while there is nothing to do, and hands them jobs - a 
+ * function and a context - through a queue.
+ *
+ * Jobs are started in submission order but run concurrently on the workers,
+ * so they might finish in any order. Jobs can submit further jobs.
+ *
+ * Call amp_thread_pool_wait_all to wait until all submitted jobs ran, e.g. 
+ * at the end of a parallel section. Call amp_thread_pool_shutdown to run 
+ * the remaining jobs and join the workers, and destroy the pool afterwards.
+ *
+ * @attention Never call amp_thread_pool_wait_all, amp_thread_pool_shutdown,
+ *            or amp_thread_pool_destroy from inside a job running on the 
+ *            same pool - the job would wait for itself and deadlock.
+ *
+ * @attention Never pass an invalid, e.g. non-created thread pool to any of
+ *            the thread pool functions other than amp_thread_pool_create.
+ */
+
+#ifndef AMP_amp_thread_pool_H
+#define AMP_amp_thread_pool_H
+
+#include <stddef.h>
+
+#include <amp/amp_memory.h>
+#include <amp/amp_thread.h>
+
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+    
+#define AMP_THREAD_POOL_UNINITIALIZED NULL
+    
+    /**
+     * Opaque type representing an amp thread pool.
+     */
+    typedef struct amp_thread_pool_s *amp_thread_pool_t;
+    
+    
+    /**
+     * Allocates a thread pool and launches worker_count workers which wait
+     * for jobs. If worker_count is 0 the pool launches as many workers as 
+     * amp_platform_get_concurrency_level reports, or a single worker if the
+     * platform can't be queried.
+     *
+     * allocator is stored in the pool to grow the job queue and must stay 
+     * valid until the pool is destroyed.
+     *
+     * On error no memory is leaked and no worker is left running.
+     *
+     * @return AMP_SUCCESS on successful creation and launch of all workers.
+     *         AMP_NOMEM if not enough memory is available.
+     *         AMP_ERROR if the system lacks the resources to launch the 
+     *         workers.
+     */
+    int amp_thread_pool_create(amp_thread_pool_t* pool,
+                               amp_allocator_t allocator,
+                               size_t worker_count);
+    
+    /**
+     * Shuts the pool down if that hasn't happened yet, see 
+     * amp_thread_pool_shutdown, and frees its memory.
+     *
+     * allocator must be able to free the memory allocated by the allocator
+     * passed to amp_thread_pool_create.
+     *
+     * @return AMP_SUCCESS after the workers have been joined and the memory 
+     *         has been freed.
+     *         Other error codes might be returned to signal errors, too. 
+     *         These are programming errors and mustn't occur in release code.
+     */
+    int amp_thread_pool_destroy(amp_thread_pool_t* pool,
+                                amp_allocator_t allocator);
+    
+    /**
+     * Queues a job which calls func with context on one of the workers.
+     *
+     * Can be called from any thread including jobs running on the pool.
+     *
+     * @return AMP_SUCCESS if the job has been queued.
+     *         AMP_NOMEM if the queue needed to grow but no memory is 
+     *         available. The job isn't queued.
+     *         AMP_ERROR if the pool has been shut down. The job isn't queued.
+     */
+    int amp_thread_pool_submit(amp_thread_pool_t pool,
+                               void* context,
+                               amp_thread_func_t func);
+    
+    /**
+     * Blocks until the queue is empty and no worker runs a job anymore, 
+     * including jobs submitted by jobs while waiting.
+     *
+     * @return AMP_SUCCESS after all submitted jobs ran.
+     *         Other error codes might be returned to signal errors, too. 
+     *         These are programming errors and mustn't occur in release code.
+     */
+    int amp_thread_pool_wait_all(amp_thread_pool_t pool);
+    
+    /**
+     * Stops the pool from accepting new jobs, lets the workers run all
+     * queued jobs and joins them. Calling it on a pool that has already been
+     * shut down does nothing. Only call it from one thread at a time.
+     *
+     * @return AMP_SUCCESS after all workers have been joined.
+     *         Other error codes might be returned to signal errors, too. 
+     *         These are programming errors and mustn't occur in release code.
+     */
+    int amp_thread_pool_shutdown(amp_thread_pool_t pool);
+    
+    /**
+     * Stores the number of workers of pool in worker_count.
+     *
+     * @return AMP_SUCCESS.
+     */
+    int amp_thread_pool_get_worker_count(amp_thread_pool_t pool,
+                                         size_t* worker_count);
+    
+    
+    
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
+
+#endif /* AMP_amp_thread_pool_H */
@@ -49,8 +49,19 @@
  *             behavior. Or let one thread point to the other to organize
  *             truly unique numbers as ids though this will lead to O(n) 
  *             complexity.
+ *
+ * Thread affinities are applied through pthread_attr_setaffinity_np and 
+ * pthread_setaffinity_np on Linux, other Pthreads platforms report 
+ * AMP_UNSUPPORTED. Stack configurations are applied via the POSIX thread
+ * attributes.
  */
 
+/* Needed for the CPU_ macros and the Pthreads affinity functions. Must be 
+ * defined before any system header is included.
+ */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#   define _GNU_SOURCE
+#endif
 
 #include "amp_thread.h"
 
@@ -59,6 +70,8 @@
 #include <stddef.h>
 
 #include <sched.h>
+#include <pthread.h>
+#include <unistd.h>
 
 #include "amp_stddef.h"
 #include "amp_return_code.h"
@@ -109,6 +122,151 @@ int amp_internal_native_thread_set_invalid(struct amp_native_thread_s *native_th
 
 
 
+#if defined(__linux__)
+
+/**
+ * Allocates a dynamically sized CPU set big enough for cpu_capacity CPUs
+ * and returns it. Its size in bytes is stored in *set_size.
+ * Returns NULL if out of memory.
+ */
+static cpu_set_t* amp_internal_cpu_set_create(size_t cpu_capacity,
+                                              size_t* set_size)
+{
+    cpu_set_t* set = CPU_ALLOC(cpu_capacity);
+    
+    if (NULL != set) {
+        *set_size = CPU_ALLOC_SIZE(cpu_capacity);
+        CPU_ZERO_S(*set_size, set);
+    }
+    
+    return set;
+}
+
+
+
+/**
+ * Fills set with the CPUs of affinity.
+ */
+static void amp_internal_cpu_set_from_affinity(cpu_set_t* set,
+                                               size_t set_size,
+                                               struct amp_thread_affinity_s const* affinity)
+{
+    size_t cpu = 0;
+    
+    for (cpu = 0; cpu < AMP_THREAD_AFFINITY_CPU_CAPACITY; ++cpu) {
+        if (amp_thread_affinity_contains_cpu(affinity, cpu)) {
+            CPU_SET_S(cpu, set_size, set);
+        }
+    }
+}
+
+#endif /* defined(__linux__) */
+
+
+
+/**
+ * Sets the configured CPU affinity in attributes.
+ * Returns the Pthreads error code.
+ */
+static int amp_internal_thread_attributes_set_affinity(pthread_attr_t* attributes,
+                                                       struct amp_thread_affinity_s const* affinity)
+{
+#if defined(__linux__)
+    size_t set_size = 0;
+    cpu_set_t* set = amp_internal_cpu_set_create(AMP_THREAD_AFFINITY_CPU_CAPACITY,
+                                                 &set_size);
+    if (NULL == set) {
+        return ENOMEM;
+    }
+    amp_internal_cpu_set_from_affinity(set, set_size, affinity);
+    
+    int const retval = pthread_attr_setaffinity_np(attributes, set_size, set);
+    
+    CPU_FREE(set);
+    
+    return retval;
+#else
+    (void)attributes;
+    (void)affinity;
+    
+    return ENOTSUP;
+#endif
+}
+
+
+
+/**
+ * Sets the configured stack in attributes.
+ * Returns the Pthreads error code.
+ */
+static int amp_internal_thread_attributes_set_stack(pthread_attr_t* attributes,
+                                                    struct amp_thread_stack_s const* stack)
+{
+    int retval = 0;
+    
+    if (NULL != stack->memory) {
+        /* Guard areas are never created for caller-provided stacks. */
+        return pthread_attr_setstack(attributes, stack->memory, stack->size);
+    }
+    
+    if (AMP_THREAD_STACK_DEFAULT_SIZE != stack->size) {
+        size_t const page_size = (size_t)sysconf(_SC_PAGESIZE);
+        size_t const stack_size = ((stack->size + page_size - 1) / page_size) * page_size;
+        
+        retval = pthread_attr_setstacksize(attributes, stack_size);
+    }
+    
+    if ((0 == retval)
+        && (AMP_THREAD_STACK_DEFAULT_GUARD_SIZE != stack->guard_size)) {
+        
+        retval = pthread_attr_setguardsize(attributes, stack->guard_size);
+    }
+    
+    return retval;
+}
+
+
+
+/**
+ * Creates the native thread with the affinity and stack configured for 
+ * thread.
+ * Returns the Pthreads error code.
+ */
+static int amp_internal_native_thread_create_configured(amp_thread_t thread,
+                                                        int has_affinity,
+                                                        int has_stack)
+{
+    pthread_attr_t attributes;
+    
+    int retval = pthread_attr_init(&attributes);
+    if (0 != retval) {
+        return retval;
+    }
+    
+    if (has_stack) {
+        retval = amp_internal_thread_attributes_set_stack(&attributes,
+                                                          &thread->stack);
+    }
+    if ((0 == retval) && has_affinity) {
+        retval = amp_internal_thread_attributes_set_affinity(&attributes,
+                                                             &thread->affinity);
+    }
+    if (0 == retval) {
+        retval = pthread_create(&(thread->native_thread_description.thread), 
+                                &attributes,
+                                amp_internal_native_thread_adapter_func, 
+                                thread);
+    }
+    
+    int const rc = pthread_attr_destroy(&attributes);
+    assert(0 == rc);
+    (void)rc;
+    
+    return retval;
+}
+
+
+
 int amp_internal_thread_launch_configured(amp_thread_t thread)
 {
     assert(NULL != thread);
@@ -121,10 +279,20 @@ int amp_internal_thread_launch_configured(amp_thread_t thread)
         return AMP_ERROR;
     }
     
-    int retval = pthread_create(&(thread->native_thread_description.thread), 
+    int const has_affinity = (0 != amp_thread_affinity_cpu_count(&thread->affinity));
+    int const has_stack = amp_internal_thread_has_configured_stack(thread);
+    int retval = 0;
+    
+    if (has_affinity || has_stack) {
+        retval = amp_internal_native_thread_create_configured(thread,
+                                                              has_affinity,
+                                                              has_stack);
+    } else {
+        retval = pthread_create(&(thread->native_thread_description.thread), 
                                 NULL, /* Default thread creation attribs. */
                                 amp_internal_native_thread_adapter_func, 
                                 thread);
+    }
     if (0 == retval) {
         thread->state = amp_internal_thread_joinable_state;
     } else {
@@ -132,6 +300,19 @@ int amp_internal_thread_launch_configured(amp_thread_t thread)
             case EAGAIN:
                 retval = AMP_ERROR;
                 break;
+            case ENOMEM:
+                retval = AMP_NOMEM;
+                break;
+            case ENOTSUP:
+                retval = AMP_UNSUPPORTED;
+                break;
+            case EINVAL:
+                /* Configured CPUs unavailable or invalid stack, otherwise 
+                 * programming error. 
+                 */
+                assert(has_affinity || has_stack);
+                retval = AMP_ERROR;
+                break;
             default: /* EINVAL, EPERM - programming error */
                 assert(0);
                 retval = AMP_ERROR;
@@ -213,3 +394,93 @@ int amp_thread_yield(void)
 }
 
 
+
+int amp_thread_set_current_affinity(struct amp_thread_affinity_s const* affinity)
+{
+    assert(NULL != affinity);
+    assert(0 != amp_thread_affinity_cpu_count(affinity));
+    
+    if ((NULL == affinity)
+        || (0 == amp_thread_affinity_cpu_count(affinity))) {
+        
+        return AMP_ERROR;
+    }
+    
+#if defined(__linux__)
+    size_t set_size = 0;
+    cpu_set_t* set = amp_internal_cpu_set_create(AMP_THREAD_AFFINITY_CPU_CAPACITY,
+                                                 &set_size);
+    if (NULL == set) {
+        return AMP_NOMEM;
+    }
+    amp_internal_cpu_set_from_affinity(set, set_size, affinity);
+    
+    int retval = pthread_setaffinity_np(pthread_self(), set_size, set);
+    
+    CPU_FREE(set);
+    
+    if (0 != retval) {
+        /* EINVAL - no configured CPU is available to the process. */
+        assert(EINVAL == retval);
+        retval = AMP_ERROR;
+    }
+    
+    return retval;
+#else
+    return AMP_UNSUPPORTED;
+#endif
+}
+
+
+
+int amp_thread_get_current_affinity(struct amp_thread_affinity_s* affinity)
+{
+    assert(NULL != affinity);
+    
+    if (NULL == affinity) {
+        return AMP_ERROR;
+    }
+    
+#if defined(__linux__)
+    /* The kernel rejects sets smaller than its own CPU mask, therefore grow
+     * the set until the query succeeds (Linux supports at most 8192 CPUs).
+     */
+    size_t cpu_capacity = (AMP_THREAD_AFFINITY_CPU_CAPACITY > CPU_SETSIZE) 
+        ? AMP_THREAD_AFFINITY_CPU_CAPACITY : CPU_SETSIZE;
+    int retval = EINVAL;
+    
+    while ((EINVAL == retval) 
+           && (cpu_capacity <= (size_t)65536)) {
+        size_t set_size = 0;
+        cpu_set_t* set = amp_internal_cpu_set_create(cpu_capacity, &set_size);
+        if (NULL == set) {
+            return AMP_NOMEM;
+        }
+        
+        retval = pthread_getaffinity_np(pthread_self(), set_size, set);
+        if (0 == retval) {
+            size_t cpu = 0;
+            
+            (void)amp_thread_affinity_clear(affinity);
+            for (cpu = 0; cpu < AMP_THREAD_AFFINITY_CPU_CAPACITY; ++cpu) {
+                if (CPU_ISSET_S(cpu, set_size, set)) {
+                    (void)amp_thread_affinity_add_cpu(affinity, cpu);
+                }
+            }
+        }
+        
+        CPU_FREE(set);
+        cpu_capacity *= 2;
+    }
+    
+    if (0 != retval) {
+        assert(0); /* Programming error */
+        retval = AMP_ERROR;
+    }
+    
+    return retval;
+#else
+    return AMP_UNSUPPORTED;
+#endif
+}
+
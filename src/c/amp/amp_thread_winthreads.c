@@ -38,6 +38,13 @@
  * amp_internal_thread.h.
  *
  * In VC compile with option /MT
+ *
+ * Thread affinities are limited to the CPUs of the processor group of the
+ * process which can be described by a DWORD_PTR affinity mask.
+ *
+ * Only the stack size of a thread can be configured, it is passed as the
+ * stack reservation size. Guard sizes and caller-provided stacks are not 
+ * supported.
  */
 
 
@@ -45,6 +52,7 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <limits.h>
 #include <stddef.h>
 
 #include <process.h>
@@ -74,6 +82,13 @@ unsigned int __stdcall native_thread_adapter_func(void *thread)
      */
     /* assert(0 != pthread_equal(thread_context->native_thread_description.thread , pthread_self()));*/
     
+    /* Let a thread whose configuration failed while it was suspended exit
+     * through _endthreadex so the CRT frees its per-thread data.
+     */
+    if (0 != thread_context->native_thread_description.launch_cancelled) {
+        return 0;
+    }
+    
     thread_context->func(thread_context->func_context);
     
     /**
@@ -94,6 +109,34 @@ int amp_internal_native_thread_set_invalid(struct amp_native_thread_s *native_th
     
     native_thread->thread_handle = AMP_INTERNAL_INVALID_THREAD_ID;
     native_thread->thread_id = AMP_INTERNAL_INVALID_THREAD_ID;
+    native_thread->launch_cancelled = 0;
+    
+    return AMP_SUCCESS;
+}
+
+
+
+/**
+ * Converts affinity into a Windows affinity mask stored in *mask.
+ * Returns AMP_UNSUPPORTED if affinity contains CPUs that can not be 
+ * represented by the mask.
+ */
+static int amp_internal_affinity_to_mask(struct amp_thread_affinity_s const* affinity,
+                                         DWORD_PTR* mask)
+{
+    size_t const mask_bits = sizeof(DWORD_PTR) * 8;
+    size_t cpu = 0;
+    
+    *mask = 0;
+    
+    for (cpu = 0; cpu < AMP_THREAD_AFFINITY_CPU_CAPACITY; ++cpu) {
+        if (amp_thread_affinity_contains_cpu(affinity, cpu)) {
+            if (cpu >= mask_bits) {
+                return AMP_UNSUPPORTED;
+            }
+            *mask |= ((DWORD_PTR)1) << cpu;
+        }
+    }
     
     return AMP_SUCCESS;
 }
@@ -104,6 +147,8 @@ int amp_internal_thread_launch_configured(amp_thread_t thread)
 {
     unsigned int inter_process_thread_id = 0;
     uintptr_t thread_handle = 0;
+    DWORD_PTR affinity_mask = 0;
+    unsigned int creation_flags = 0;
     int retval = AMP_UNSUPPORTED;
     
     assert(NULL != thread);
@@ -117,14 +162,67 @@ int amp_internal_thread_launch_configured(amp_thread_t thread)
         return EINVAL;
     }
     
-    /* Thread creation for native code. */
+    retval = amp_internal_affinity_to_mask(&thread->affinity, &affinity_mask);
+    if (AMP_SUCCESS != retval) {
+        return retval;
+    }
+    
+    if ((NULL != thread->stack.memory)
+        || (AMP_THREAD_STACK_DEFAULT_GUARD_SIZE != thread->stack.guard_size)
+        || (thread->stack.size > (size_t)UINT_MAX)) {
+        
+        return AMP_UNSUPPORTED;
+    }
+    
+    creation_flags = (0 != affinity_mask) ? CREATE_SUSPENDED : 0;
+    if (AMP_THREAD_STACK_DEFAULT_SIZE != thread->stack.size) {
+        creation_flags |= STACK_SIZE_PARAM_IS_A_RESERVATION;
+    }
+    
+    /* Thread creation for native code. A pinned thread is created suspended
+     * and only resumed after its affinity has been set.
+     */
+    thread->native_thread_description.launch_cancelled = 0;
     errno = 0;
     thread_handle = _beginthreadex(NULL, /* Non-inheritable security attribs. */
-                                   0,  /* Default thread stack size. */
+                                   (unsigned int)thread->stack.size, /* 0 is default size. */
                                    native_thread_adapter_func, 
                                    thread, 
-                                   0, /* Start thread running. */
+                                   creation_flags,
                                    &inter_process_thread_id);
+    if ((0 != thread_handle) 
+        && (0 != affinity_mask)) {
+        
+        if (0 == SetThreadAffinityMask((HANDLE)thread_handle, affinity_mask)) {
+            /* No configured CPU is available. Let the thread exit without
+             * running the user function and wait for it.
+             */
+            DWORD resumed = 0;
+            DWORD waited = 0;
+            BOOL closed = FALSE;
+            
+            thread->native_thread_description.launch_cancelled = 1;
+            
+            resumed = ResumeThread((HANDLE)thread_handle);
+            assert((DWORD)-1 != resumed);
+            waited = WaitForSingleObject((HANDLE)thread_handle, INFINITE);
+            assert(WAIT_OBJECT_0 == waited);
+            closed = CloseHandle((HANDLE)thread_handle);
+            assert(FALSE != closed);
+            (void)resumed;
+            (void)waited;
+            (void)closed;
+            
+            thread->native_thread_description.launch_cancelled = 0;
+            
+            return AMP_ERROR;
+        }
+        
+        if ((DWORD)-1 == ResumeThread((HANDLE)thread_handle)) {
+            assert(0); /* Programming error */
+        }
+    }
+    
     if (0 != thread_handle) {
         /* Thread launched successfully. */
         thread->native_thread_description.thread_handle = (HANDLE) thread_handle;
@@ -266,3 +364,74 @@ int amp_thread_yield(void)
 
 
 
+int amp_thread_set_current_affinity(struct amp_thread_affinity_s const* affinity)
+{
+    DWORD_PTR affinity_mask = 0;
+    int retval = AMP_UNSUPPORTED;
+    
+    assert(NULL != affinity);
+    assert(0 != amp_thread_affinity_cpu_count(affinity));
+    
+    if ((NULL == affinity)
+        || (0 == amp_thread_affinity_cpu_count(affinity))) {
+        
+        return AMP_ERROR;
+    }
+    
+    retval = amp_internal_affinity_to_mask(affinity, &affinity_mask);
+    if (AMP_SUCCESS != retval) {
+        return retval;
+    }
+    
+    if (0 == SetThreadAffinityMask(GetCurrentThread(), affinity_mask)) {
+        return AMP_ERROR;
+    }
+    
+    return AMP_SUCCESS;
+}
+
+
+
+int amp_thread_get_current_affinity(struct amp_thread_affinity_s* affinity)
+{
+    DWORD_PTR process_mask = 0;
+    DWORD_PTR system_mask = 0;
+    DWORD_PTR thread_mask = 0;
+    size_t cpu = 0;
+    
+    assert(NULL != affinity);
+    
+    if (NULL == affinity) {
+        return AMP_ERROR;
+    }
+    
+    /* Windows has no call to query a threads affinity - setting it returns
+     * the previous mask which is restored right away.
+     */
+    if (FALSE == GetProcessAffinityMask(GetCurrentProcess(),
+                                        &process_mask,
+                                        &system_mask)) {
+        return AMP_ERROR;
+    }
+    thread_mask = SetThreadAffinityMask(GetCurrentThread(), process_mask);
+    if (0 == thread_mask) {
+        return AMP_ERROR;
+    }
+    if (0 == SetThreadAffinityMask(GetCurrentThread(), thread_mask)) {
+        assert(0); /* Previous mask must be valid */
+        return AMP_ERROR;
+    }
+    
+    (void)amp_thread_affinity_clear(affinity);
+    for (cpu = 0; 
+         (cpu < sizeof(DWORD_PTR) * 8) && (cpu < AMP_THREAD_AFFINITY_CPU_CAPACITY);
+         ++cpu) {
+        
+        if (0 != (thread_mask & (((DWORD_PTR)1) << cpu))) {
+            (void)amp_thread_affinity_add_cpu(affinity, cpu);
+        }
+    }
+    
+    return AMP_SUCCESS;
+}
+
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Measures how long it takes a group of threads to pass an amp_barrier 
+ * repeatedly.
+ *
+ * Build once per barrier backend to compare them.
+ *
+ * Every backend updates one shared counter per arriving thread - a mutex 
+ * protected count, an atomic count, or the ticket counter of the 
+ * dissemination barrier. The shared counter line measures the time 
+ * thread_count threads need for one atomic increment each on a shared 
+ * counter to show which part of a barrier round this costs.
+ */
+
+
+#include <iostream>
+#include <iomanip>
+#include <cstddef>
+
+#include <amp/amp.h>
+#include <amp/amp_atomic.h>
+
+#include "amp_benchmark.h"
+
+
+
+namespace {
+    
+#if defined(AMP_USE_GENERIC_BROADCAST_BARRIERS)
+    char const* const barrier_backend_name = "generic broadcast";
+#elif defined(AMP_USE_GENERIC_SIGNAL_BARRIERS)
+    char const* const barrier_backend_name = "generic signal";
+#elif defined(AMP_USE_SENSE_REVERSING_BARRIERS)
+    char const* const barrier_backend_name = "sense reversing";
+#elif defined(AMP_USE_DISSEMINATION_BARRIERS)
+    char const* const barrier_backend_name = "dissemination";
+#else
+    char const* const barrier_backend_name = "unknown";
+#endif
+    
+    std::size_t const round_count = 10000;
+    
+    
+    struct barrier_benchmark_context_s {
+        amp_barrier_t barrier;
+        std::size_t round_count;
+    };
+    
+    
+    void barrier_benchmark_thread_func(void* ctxt)
+    {
+        barrier_benchmark_context_s* context = static_cast<barrier_benchmark_context_s*>(ctxt);
+        
+        for (std::size_t i = 0; i < context->round_count; ++i) {
+            int const rc = amp_barrier_wait(context->barrier);
+            if (AMP_SUCCESS != rc && AMP_BARRIER_SERIAL_THREAD != rc) {
+                amp_benchmark::exit_on_error(rc);
+            }
+        }
+    }
+    
+    
+    struct counter_benchmark_context_s {
+        amp_atomic_int_t counter;
+        std::size_t round_count;
+    };
+    
+    
+    void counter_benchmark_thread_func(void* ctxt)
+    {
+        counter_benchmark_context_s* context = static_cast<counter_benchmark_context_s*>(ctxt);
+        
+        for (std::size_t i = 0; i < context->round_count; ++i) {
+            (void)amp_atomic_int_fetch_add(&context->counter, 
+                                           1, 
+                                           amp_memory_order_acq_rel);
+        }
+    }
+    
+    
+    /**
+     * Returns the nanoseconds per round in which each of thread_count 
+     * threads increments a shared counter once.
+     */
+    double measure_shared_counter(std::size_t thread_count)
+    {
+        counter_benchmark_context_s context;
+        context.round_count = round_count;
+        amp_atomic_int_store(&context.counter, 0, amp_memory_order_relaxed);
+        
+        amp_thread_array_t threads = AMP_THREAD_ARRAY_UNINITIALIZED;
+        amp_benchmark::exit_on_error(amp_thread_array_create(&threads,
+                                                             AMP_DEFAULT_ALLOCATOR,
+                                                             thread_count));
+        amp_benchmark::exit_on_error(amp_thread_array_configure(threads,
+                                                                0,
+                                                                thread_count,
+                                                                &context,
+                                                                &counter_benchmark_thread_func));
+        
+        double const start = amp_benchmark::wall_time_seconds();
+        amp_benchmark::exit_on_error(amp_thread_array_launch_all(threads, NULL));
+        amp_benchmark::exit_on_error(amp_thread_array_join_all(threads, NULL));
+        double const stop = amp_benchmark::wall_time_seconds();
+        
+        amp_benchmark::exit_on_error(amp_thread_array_destroy(&threads, 
+                                                              AMP_DEFAULT_ALLOCATOR));
+        
+        return (stop - start) * 1.0e9 / static_cast<double>(round_count);
+    }
+    
+    
+    /**
+     * Returns the nanoseconds per barrier round for thread_count threads.
+     */
+    double measure_rounds(std::size_t thread_count)
+    {
+        barrier_benchmark_context_s context;
+        context.round_count = round_count;
+        
+        amp_benchmark::exit_on_error(amp_barrier_create(&context.barrier,
+                                                        AMP_DEFAULT_ALLOCATOR,
+                                                        static_cast<amp_barrier_count_t>(thread_count)));
+        
+        amp_thread_array_t threads = AMP_THREAD_ARRAY_UNINITIALIZED;
+        amp_benchmark::exit_on_error(amp_thread_array_create(&threads,
+                                                             AMP_DEFAULT_ALLOCATOR,
+                                                             thread_count));
+        amp_benchmark::exit_on_error(amp_thread_array_configure(threads,
+                                                                0,
+                                                                thread_count,
+                                                                &context,
+                                                                &barrier_benchmark_thread_func));
+        
+        double const start = amp_benchmark::wall_time_seconds();
+        amp_benchmark::exit_on_error(amp_thread_array_launch_all(threads, NULL));
+        amp_benchmark::exit_on_error(amp_thread_array_join_all(threads, NULL));
+        double const stop = amp_benchmark::wall_time_seconds();
+        
+        amp_benchmark::exit_on_error(amp_thread_array_destroy(&threads, 
+                                                              AMP_DEFAULT_ALLOCATOR));
+        amp_benchmark::exit_on_error(amp_barrier_destroy(&context.barrier,
+                                                         AMP_DEFAULT_ALLOCATOR));
+        
+        return (stop - start) * 1.0e9 / static_cast<double>(round_count);
+    }
+    
+} // anonymous namespace
+
+
+
+void amp_benchmark::barrier_benchmark(std::size_t max_thread_count)
+{
+    std::cout << "  backend: " << barrier_backend_name << "\n";
+    std::cout << std::fixed << std::setprecision(1);
+    
+    for (std::size_t thread_count = 1; 
+         thread_count <= max_thread_count; 
+         thread_count *= 2) {
+        
+        std::cout << "  " << std::setw(3) << thread_count << " threads: " 
+            << measure_rounds(thread_count) << " ns/round, shared counter: "
+            << measure_shared_counter(thread_count) << " ns/round\n";
+    }
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Shared declarations of the amp benchmark program. Every benchmark is 
+ * implemented in its own source file and registered in 
+ * amp_benchmark_main.cpp.
+ *
+ * Benchmarks measure the backend amp has been compiled with - build the
+ * benchmark program once per backend combination to compare them.
+ */
+
+#ifndef AMP_amp_benchmark_H
+#define AMP_amp_benchmark_H
+
+#include <cstddef>
+
+
+
+namespace amp_benchmark {
+    
+    /**
+     * Returns a monotonically increasing wall clock time in seconds.
+     */
+    double wall_time_seconds();
+    
+    
+    /**
+     * Aborts the benchmark program if error_code isn't AMP_SUCCESS.
+     */
+    void exit_on_error(int error_code);
+    
+    
+    /**
+     * Benchmark function type. max_thread_count is the concurrency level of
+     * the platform and is used to determine the number of threads to measure.
+     */
+    typedef void (*benchmark_func_t)(std::size_t max_thread_count);
+    
+    
+    
+    void mutex_benchmark(std::size_t max_thread_count);
+    void semaphore_benchmark(std::size_t max_thread_count);
+    void barrier_benchmark(std::size_t max_thread_count);
+    void spinlock_benchmark(std::size_t max_thread_count);
+    void thread_pool_benchmark(std::size_t max_thread_count);
+    void scheduler_benchmark(std::size_t max_thread_count);
+    void parallel_for_benchmark(std::size_t max_thread_count);
+    void parallel_reduce_benchmark(std::size_t max_thread_count);
+    void thread_launch_benchmark(std::size_t max_thread_count);
+    
+    
+} // namespace amp_benchmark
+
+
+#endif /* AMP_amp_benchmark_H */
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Runs the amp benchmarks and prints their results to stdout.
+ *
+ * Call without arguments to run all benchmarks or pass the names of the
+ * benchmarks to run.
+ */
+
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+
+#if defined(_WIN32)
+#   define WIN32_LEAN_AND_MEAN
+#   include <windows.h>
+#elif defined(__APPLE__)
+#   include <mach/mach_time.h>
+#else
+#   include <time.h>
+#endif
+
+#include <amp/amp.h>
+
+#include "amp_benchmark.h"
+
+
+
+namespace {
+    
+    struct benchmark_entry_s {
+        char const* name;
+        amp_benchmark::benchmark_func_t func;
+    };
+    
+    
+    benchmark_entry_s const benchmarks[] = {
+        {"mutex", &amp_benchmark::mutex_benchmark},
+        {"semaphore", &amp_benchmark::semaphore_benchmark},
+        {"barrier", &amp_benchmark::barrier_benchmark},
+        {"spinlock", &amp_benchmark::spinlock_benchmark},
+        {"thread_pool", &amp_benchmark::thread_pool_benchmark},
+        {"scheduler", &amp_benchmark::scheduler_benchmark},
+        {"parallel_for", &amp_benchmark::parallel_for_benchmark},
+        {"parallel_reduce", &amp_benchmark::parallel_reduce_benchmark},
+        {"thread_launch", &amp_benchmark::thread_launch_benchmark}
+    };
+    
+    std::size_t const benchmark_count = sizeof(benchmarks) / sizeof(benchmarks[0]);
+    
+    
+    std::size_t query_concurrency_level()
+    {
+        amp_platform_t platform = AMP_PLATFORM_UNINITIALIZED;
+        std::size_t concurrency_level = 0;
+        
+        amp_benchmark::exit_on_error(amp_platform_create(&platform, 
+                                                         AMP_DEFAULT_ALLOCATOR));
+        
+        int const error_code = amp_platform_get_concurrency_level(platform,
+                                                                  &concurrency_level);
+        if (AMP_SUCCESS != error_code
+            || 0 == concurrency_level) {
+            
+            concurrency_level = 2;
+        }
+        
+        amp_benchmark::exit_on_error(amp_platform_destroy(&platform, 
+                                                          AMP_DEFAULT_ALLOCATOR));
+        
+        return concurrency_level;
+    }
+    
+} // anonymous namespace
+
+
+
+double amp_benchmark::wall_time_seconds()
+{
+#if defined(_WIN32)
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    
+    return static_cast<double>(counter.QuadPart) / static_cast<double>(frequency.QuadPart);
+#elif defined(__APPLE__)
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    
+    return static_cast<double>(mach_absolute_time()) * static_cast<double>(timebase.numer) / static_cast<double>(timebase.denom) * 1.0e-9;
+#else
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    
+    return static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_nsec) * 1.0e-9;
+#endif
+}
+
+
+
+void amp_benchmark::exit_on_error(int error_code)
+{
+    if (AMP_SUCCESS != error_code) {
+        std::cerr << "amp_benchmark error: " << std::strerror(error_code) << "\n";
+        std::exit(error_code);
+    }
+}
+
+
+
+int main(int argc, char *argv[])
+{
+    std::size_t const max_thread_count = query_concurrency_level();
+    
+    std::cout << "amp_benchmark (concurrency level " << max_thread_count << ")\n\n";
+    
+    for (std::size_t i = 0; i < benchmark_count; ++i) {
+        
+        bool run = (1 >= argc);
+        for (int arg = 1; arg < argc; ++arg) {
+            if (0 == std::strcmp(argv[arg], benchmarks[i].name)) {
+                run = true;
+            }
+        }
+        
+        if (run) {
+            std::cout << benchmarks[i].name << "\n";
+            benchmarks[i].func(max_thread_count);
+            std::cout << "\n";
+        }
+    }
+    
+    return EXIT_SUCCESS;
+}
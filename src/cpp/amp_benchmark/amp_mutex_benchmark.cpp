@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Measures uncontended and contended amp_mutex lock and unlock throughput.
+ *
+ * Build once with AMP_USE_FUTEX_MUTEXES and once without it to compare the
+ * futex backend with the Pthreads backend.
+ */
+
+
+#include <iostream>
+#include <iomanip>
+#include <cstddef>
+#include <vector>
+
+#include <amp/amp.h>
+
+#include "amp_benchmark.h"
+
+
+
+namespace {
+    
+#if defined(AMP_USE_FUTEX_MUTEXES)
+    char const* const mutex_backend_name = "futex";
+#elif defined(AMP_USE_PTHREADS)
+    char const* const mutex_backend_name = "pthreads";
+#elif defined(AMP_USE_WINTHREADS)
+    char const* const mutex_backend_name = "winthreads";
+#else
+    char const* const mutex_backend_name = "unknown";
+#endif
+    
+    std::size_t const lock_count_per_thread = 1000000;
+    
+    
+    struct mutex_benchmark_context_s {
+        amp_mutex_t mutex;
+        amp_barrier_t start_barrier;
+        std::size_t lock_count;
+        std::size_t counter;
+    };
+    
+    
+    void mutex_benchmark_thread_func(void* ctxt)
+    {
+        mutex_benchmark_context_s* context = static_cast<mutex_benchmark_context_s*>(ctxt);
+        
+        int const rc = amp_barrier_wait(context->start_barrier);
+        if (AMP_SUCCESS != rc && AMP_BARRIER_SERIAL_THREAD != rc) {
+            amp_benchmark::exit_on_error(rc);
+        }
+        
+        for (std::size_t i = 0; i < context->lock_count; ++i) {
+            amp_mutex_lock(context->mutex);
+            {
+                ++(context->counter);
+            }
+            amp_mutex_unlock(context->mutex);
+        }
+    }
+    
+    
+    /**
+     * Returns the nanoseconds per lock and unlock pair when thread_count 
+     * threads hammer the same mutex.
+     */
+    double measure_contended(std::size_t thread_count)
+    {
+        mutex_benchmark_context_s context;
+        context.lock_count = lock_count_per_thread;
+        context.counter = 0;
+        
+        amp_benchmark::exit_on_error(amp_mutex_create(&context.mutex, 
+                                                      AMP_DEFAULT_ALLOCATOR));
+        amp_benchmark::exit_on_error(amp_barrier_create(&context.start_barrier,
+                                                        AMP_DEFAULT_ALLOCATOR,
+                                                        static_cast<amp_barrier_count_t>(thread_count + 1)));
+        
+        amp_thread_array_t threads = AMP_THREAD_ARRAY_UNINITIALIZED;
+        amp_benchmark::exit_on_error(amp_thread_array_create(&threads,
+                                                             AMP_DEFAULT_ALLOCATOR,
+                                                             thread_count));
+        amp_benchmark::exit_on_error(amp_thread_array_configure(threads,
+                                                                0,
+                                                                thread_count,
+                                                                &context,
+                                                                &mutex_benchmark_thread_func));
+        amp_benchmark::exit_on_error(amp_thread_array_launch_all(threads, NULL));
+        
+        int const rc = amp_barrier_wait(context.start_barrier);
+        if (AMP_SUCCESS != rc && AMP_BARRIER_SERIAL_THREAD != rc) {
+            amp_benchmark::exit_on_error(rc);
+        }
+        double const start = amp_benchmark::wall_time_seconds();
+        
+        amp_benchmark::exit_on_error(amp_thread_array_join_all(threads, NULL));
+        
+        double const stop = amp_benchmark::wall_time_seconds();
+        
+        if (context.counter != thread_count * lock_count_per_thread) {
+            std::cerr << "amp_benchmark error: mutex lost increments\n";
+            amp_benchmark::exit_on_error(AMP_ERROR);
+        }
+        
+        amp_benchmark::exit_on_error(amp_thread_array_destroy(&threads, 
+                                                              AMP_DEFAULT_ALLOCATOR));
+        amp_benchmark::exit_on_error(amp_barrier_destroy(&context.start_barrier,
+                                                         AMP_DEFAULT_ALLOCATOR));
+        amp_benchmark::exit_on_error(amp_mutex_destroy(&context.mutex,
+                                                       AMP_DEFAULT_ALLOCATOR));
+        
+        return (stop - start) * 1.0e9 / static_cast<double>(thread_count * lock_count_per_thread);
+    }
+    
+    
+    struct uncontended_context_s {
+        double nanoseconds_per_lock;
+    };
+    
+    
+    void uncontended_thread_func(void* ctxt)
+    {
+        uncontended_context_s* context = static_cast<uncontended_context_s*>(ctxt);
+        
+        amp_mutex_t mutex = AMP_MUTEX_UNINITIALIZED;
+        amp_benchmark::exit_on_error(amp_mutex_create(&mutex, 
+                                                      AMP_DEFAULT_ALLOCATOR));
+        
+        double const start = amp_benchmark::wall_time_seconds();
+        for (std::size_t i = 0; i < lock_count_per_thread; ++i) {
+            amp_mutex_lock(mutex);
+            amp_mutex_unlock(mutex);
+        }
+        double const stop = amp_benchmark::wall_time_seconds();
+        
+        amp_benchmark::exit_on_error(amp_mutex_destroy(&mutex,
+                                                       AMP_DEFAULT_ALLOCATOR));
+        
+        context->nanoseconds_per_lock = (stop - start) * 1.0e9 / static_cast<double>(lock_count_per_thread);
+    }
+    
+    
+    /**
+     * Returns the nanoseconds per lock and unlock pair without any other 
+     * thread touching the mutex.
+     *
+     * Measured on an amp thread and not on the main thread because some 
+     * Pthreads implementations skip atomic instructions as long as a process
+     * is single threaded.
+     */
+    double measure_uncontended()
+    {
+        uncontended_context_s context;
+        context.nanoseconds_per_lock = 0.0;
+        
+        amp_thread_t thread = AMP_THREAD_UNINITIALIZED;
+        amp_benchmark::exit_on_error(amp_thread_create_and_launch(&thread,
+                                                                  AMP_DEFAULT_ALLOCATOR,
+                                                                  &context,
+                                                                  &uncontended_thread_func));
+        amp_benchmark::exit_on_error(amp_thread_join_and_destroy(&thread,
+                                                                 AMP_DEFAULT_ALLOCATOR));
+        
+        return context.nanoseconds_per_lock;
+    }
+    
+} // anonymous namespace
+
+
+
+void amp_benchmark::mutex_benchmark(std::size_t max_thread_count)
+{
+    std::cout << "  backend: " << mutex_backend_name << "\n";
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "  uncontended: " << measure_uncontended() << " ns/lock\n";
+    
+    for (std::size_t thread_count = 1; 
+         thread_count <= 2 * max_thread_count; 
+         thread_count *= 2) {
+        
+        std::cout << "  " << std::setw(3) << thread_count << " threads: " 
+            << measure_contended(thread_count) << " ns/lock\n";
+    }
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Measures amp_parallel_for with the static, dynamic, and guided schedules
+ * on a loop whose per-iteration cost grows with the index, so a static split
+ * hands the last thread most of the work.
+ */
+
+
+#include <iostream>
+#include <iomanip>
+#include <cstddef>
+
+#include <amp/amp.h>
+#include <amp/amp_parallel_for.h>
+
+#include "amp_benchmark.h"
+
+
+
+namespace {
+    
+    std::size_t const iteration_count = 4096;
+    std::size_t const grain = 16;
+    std::size_t const repetition_count = 10;
+    
+    
+    struct skewed_context_s {
+        double* results;
+    };
+    
+    
+    /**
+     * Iteration i costs about i times as much as iteration 1.
+     */
+    void skewed_body(void* ctxt, std::size_t begin, std::size_t end)
+    {
+        skewed_context_s* context = static_cast<skewed_context_s*>(ctxt);
+        
+        for (std::size_t i = begin; i < end; ++i) {
+            double value = static_cast<double>(i);
+            for (std::size_t j = 0; j < i; ++j) {
+                value = value * 0.999999 + 1.0;
+            }
+            context->results[i] = value;
+        }
+    }
+    
+    
+    /**
+     * Returns the milliseconds per loop run with schedule on pool.
+     */
+    double measure(amp_thread_pool_t pool,
+                   amp_parallel_for_schedule_t schedule)
+    {
+        static double results[iteration_count];
+        skewed_context_s context = {results};
+        
+        double const start = amp_benchmark::wall_time_seconds();
+        
+        for (std::size_t i = 0; i < repetition_count; ++i) {
+            amp_benchmark::exit_on_error(amp_parallel_for(pool,
+                                                          0,
+                                                          iteration_count,
+                                                          grain,
+                                                          &skewed_body,
+                                                          &context,
+                                                          schedule));
+        }
+        
+        double const stop = amp_benchmark::wall_time_seconds();
+        
+        return (stop - start) * 1.0e3 / static_cast<double>(repetition_count);
+    }
+    
+} // anonymous namespace
+
+
+
+void amp_benchmark::parallel_for_benchmark(std::size_t max_thread_count)
+{
+    std::cout << "  ms/loop with skewed iteration cost, static vs. dynamic vs. guided\n";
+    std::cout << std::fixed << std::setprecision(2);
+    
+    for (std::size_t thread_count = 1; 
+         thread_count <= max_thread_count; 
+         thread_count *= 2) {
+        
+        // The calling thread works on chunks, too.
+        amp_thread_pool_t pool = AMP_THREAD_POOL_UNINITIALIZED;
+        amp_benchmark::exit_on_error(amp_thread_pool_create(&pool,
+                                                            AMP_DEFAULT_ALLOCATOR,
+                                                            thread_count));
+        
+        std::cout << "  " << std::setw(3) << thread_count << " workers: " 
+            << measure(pool, amp_parallel_for_schedule_static) << " vs. "
+            << measure(pool, amp_parallel_for_schedule_dynamic) << " vs. "
+            << measure(pool, amp_parallel_for_schedule_guided) << "\n";
+        
+        amp_benchmark::exit_on_error(amp_thread_pool_destroy(&pool, 
+                                                             AMP_DEFAULT_ALLOCATOR));
+    }
+}
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Compares amp_parallel_reduce and amp_parallel_scan summing unsigned ints
+ * with a serial loop calling the same combine function through a function 
+ * pointer, for 10^6 to 10^9 elements. Sizes that can't be allocated are skipped. The scans run in 
+ * place so every size needs a single array.
+ */
+
+
+#include <iostream>
+#include <iomanip>
+#include <cstddef>
+#include <cstdlib>
+
+#include <amp/amp.h>
+#include <amp/amp_parallel_reduce.h>
+
+#include "amp_benchmark.h"
+
+
+
+namespace {
+    
+    void add_unsigned(void* /* context */, void* accumulator, void const* value)
+    {
+        *static_cast<unsigned int*>(accumulator) += *static_cast<unsigned int const*>(value);
+    }
+    
+    
+    // Keeps the compiler from inlining the combine function into the serial
+    // loops, which the parallel versions can't do either.
+    amp_parallel_combine_func_t volatile serial_combine = &add_unsigned;
+    
+    
+    void fill(unsigned int* values, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i) {
+            values[i] = static_cast<unsigned int>(i & 0xff);
+        }
+    }
+    
+    
+    double measure_serial_reduce(unsigned int const* values, 
+                                 std::size_t count,
+                                 unsigned int* sum)
+    {
+        double const start = amp_benchmark::wall_time_seconds();
+        
+        amp_parallel_combine_func_t const combine = serial_combine;
+        *sum = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            combine(NULL, sum, &values[i]);
+        }
+        
+        return amp_benchmark::wall_time_seconds() - start;
+    }
+    
+    
+    double measure_serial_scan(unsigned int* values, std::size_t count)
+    {
+        double const start = amp_benchmark::wall_time_seconds();
+        
+        amp_parallel_combine_func_t const combine = serial_combine;
+        unsigned int running = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            combine(NULL, &running, &values[i]);
+            values[i] = running;
+        }
+        
+        return amp_benchmark::wall_time_seconds() - start;
+    }
+    
+    
+    double measure_parallel_reduce(amp_thread_pool_t pool,
+                                   unsigned int const* values,
+                                   std::size_t count,
+                                   unsigned int* sum)
+    {
+        unsigned int const zero = 0;
+        double const start = amp_benchmark::wall_time_seconds();
+        
+        amp_benchmark::exit_on_error(amp_parallel_reduce(pool,
+                                                         AMP_DEFAULT_ALLOCATOR,
+                                                         values,
+                                                         count,
+                                                         sizeof(unsigned int),
+                                                         &zero,
+                                                         &add_unsigned,
+                                                         NULL,
+                                                         sum));
+        
+        return amp_benchmark::wall_time_seconds() - start;
+    }
+    
+    
+    double measure_parallel_scan(amp_thread_pool_t pool,
+                                 unsigned int* values, 
+                                 std::size_t count)
+    {
+        unsigned int const zero = 0;
+        double const start = amp_benchmark::wall_time_seconds();
+        
+        amp_benchmark::exit_on_error(amp_parallel_scan(pool,
+                                                       AMP_DEFAULT_ALLOCATOR,
+                                                       values,
+                                                       values,
+                                                       count,
+                                                       sizeof(unsigned int),
+                                                       &zero,
+                                                       &add_unsigned,
+                                                       NULL,
+                                                       amp_parallel_scan_inclusive));
+        
+        return amp_benchmark::wall_time_seconds() - start;
+    }
+    
+} // anonymous namespace
+
+
+
+void amp_benchmark::parallel_reduce_benchmark(std::size_t max_thread_count)
+{
+    // The calling thread works on blocks, too.
+    amp_thread_pool_t pool = AMP_THREAD_POOL_UNINITIALIZED;
+    amp_benchmark::exit_on_error(amp_thread_pool_create(&pool,
+                                                        AMP_DEFAULT_ALLOCATOR,
+                                                        (1 < max_thread_count) ? max_thread_count - 1 : 1));
+    
+    std::cout << "  ms serial vs. parallel, " << max_thread_count << " threads\n";
+    std::cout << std::fixed << std::setprecision(2);
+    
+    for (std::size_t count = 1000000; count <= 1000000000; count *= 10) {
+        unsigned int* values = static_cast<unsigned int*>(std::malloc(count * sizeof(unsigned int)));
+        if (NULL == values) {
+            std::cout << "  " << std::setw(10) << count << " elements: skipped, not enough memory\n";
+            continue;
+        }
+        
+        unsigned int serial_sum = 0;
+        unsigned int parallel_sum = 0;
+        
+        fill(values, count);
+        double const serial_reduce = measure_serial_reduce(values, count, &serial_sum);
+        double const parallel_reduce = measure_parallel_reduce(pool, values, count, &parallel_sum);
+        
+        double const serial_scan = measure_serial_scan(values, count);
+        fill(values, count);
+        double const parallel_scan = measure_parallel_scan(pool, values, count);
+        
+        if ((serial_sum != parallel_sum) || (serial_sum != values[count - 1])) {
+            std::cerr << "Serial and parallel results differ.\n";
+            std::exit(EXIT_FAILURE);
+        }
+        
+        std::free(values);
+        
+        std::cout << "  " << std::setw(10) << count << " elements: reduce " 
+            << serial_reduce * 1.0e3 << " vs. " << parallel_reduce * 1.0e3 
+            << ", scan " 
+            << serial_scan * 1.0e3 << " vs. " << parallel_scan * 1.0e3 << "\n";
+    }
+    
+    amp_benchmark::exit_on_error(amp_thread_pool_destroy(&pool, 
+                                                         AMP_DEFAULT_ALLOCATOR));
+}
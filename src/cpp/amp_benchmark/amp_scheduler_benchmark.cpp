@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Measures the scaling of amp_scheduler with recursive fork-join programs:
+ * fib spawns one of its two subproblems down to a serial cutoff, nqueens
+ * spawns one task per valid queen placement for the first rows. Prints the
+ * time and the speedup relative to a single worker for each worker count.
+ */
+
+
+#include <iostream>
+#include <iomanip>
+#include <cstddef>
+#include <cstdlib>
+
+#include <amp/amp.h>
+#include <amp/amp_scheduler.h>
+#include <amp/amp_raw_scheduler.h>
+
+#include "amp_benchmark.h"
+
+
+
+namespace {
+    
+    unsigned int const fib_n = 32;
+    unsigned int const fib_serial_cutoff = 16;
+    
+    int const nqueens_n = 11;
+    int const nqueens_spawn_depth = 3;
+    
+    
+    
+    unsigned long serial_fib(unsigned int n)
+    {
+        if (n < 2) {
+            return n;
+        }
+        
+        return serial_fib(n - 1) + serial_fib(n - 2);
+    }
+    
+    
+    struct fib_context_s {
+        amp_scheduler_t scheduler;
+        unsigned int n;
+        unsigned long result;
+    };
+    
+    
+    void fib_task_func(void* ctxt)
+    {
+        fib_context_s* context = static_cast<fib_context_s*>(ctxt);
+        
+        if (context->n < fib_serial_cutoff) {
+            context->result = serial_fib(context->n);
+            return;
+        }
+        
+        fib_context_s child = {context->scheduler, context->n - 1, 0};
+        fib_context_s own = {context->scheduler, context->n - 2, 0};
+        
+        amp_raw_scheduler_group_s group;
+        amp_benchmark::exit_on_error(amp_raw_scheduler_group_init(&group));
+        amp_benchmark::exit_on_error(amp_scheduler_spawn(context->scheduler,
+                                                         &group,
+                                                         &child,
+                                                         &fib_task_func));
+        fib_task_func(&own);
+        amp_benchmark::exit_on_error(amp_scheduler_group_wait(context->scheduler,
+                                                              &group));
+        amp_benchmark::exit_on_error(amp_raw_scheduler_group_finalize(&group));
+        
+        context->result = child.result + own.result;
+    }
+    
+    
+    
+    /**
+     * Counts the solutions for the rows from row on. queens[i] is the column
+     * of the queen in row i.
+     */
+    unsigned long serial_nqueens(int* queens, int row)
+    {
+        if (nqueens_n == row) {
+            return 1;
+        }
+        
+        unsigned long count = 0;
+        for (int column = 0; column < nqueens_n; ++column) {
+            bool valid = true;
+            for (int i = 0; (i < row) && valid; ++i) {
+                int const distance = std::abs(queens[i] - column);
+                valid = (0 != distance) && (distance != row - i);
+            }
+            
+            if (valid) {
+                queens[row] = column;
+                count += serial_nqueens(queens, row + 1);
+            }
+        }
+        
+        return count;
+    }
+    
+    
+    struct nqueens_context_s {
+        amp_scheduler_t scheduler;
+        int queens[nqueens_n];
+        int row;
+        unsigned long result;
+    };
+    
+    
+    void nqueens_task_func(void* ctxt)
+    {
+        nqueens_context_s* context = static_cast<nqueens_context_s*>(ctxt);
+        
+        if (nqueens_spawn_depth <= context->row) {
+            context->result = serial_nqueens(context->queens, context->row);
+            return;
+        }
+        
+        int const row = context->row;
+        nqueens_context_s children[nqueens_n];
+        
+        amp_raw_scheduler_group_s group;
+        amp_benchmark::exit_on_error(amp_raw_scheduler_group_init(&group));
+        
+        for (int column = 0; column < nqueens_n; ++column) {
+            nqueens_context_s& child = children[column];
+            child.scheduler = context->scheduler;
+            child.row = row + 1;
+            child.result = 0;
+            
+            bool valid = true;
+            for (int i = 0; (i < row) && valid; ++i) {
+                child.queens[i] = context->queens[i];
+                int const distance = std::abs(context->queens[i] - column);
+                valid = (0 != distance) && (distance != row - i);
+            }
+            
+            if (valid) {
+                child.queens[row] = column;
+                amp_benchmark::exit_on_error(amp_scheduler_spawn(context->scheduler,
+                                                                 &group,
+                                                                 &child,
+                                                                 &nqueens_task_func));
+            }
+        }
+        
+        amp_benchmark::exit_on_error(amp_scheduler_group_wait(context->scheduler,
+                                                              &group));
+        amp_benchmark::exit_on_error(amp_raw_scheduler_group_finalize(&group));
+        
+        unsigned long count = 0;
+        for (int column = 0; column < nqueens_n; ++column) {
+            count += children[column].result;
+        }
+        context->result = count;
+    }
+    
+    
+    
+    /**
+     * Returns the seconds it takes to run root_func on a scheduler with 
+     * worker_count workers. Context needs a scheduler member for the tasks.
+     */
+    template<typename Context>
+    double measure(std::size_t worker_count,
+                   Context& context,
+                   amp_thread_func_t root_func)
+    {
+        amp_scheduler_t scheduler = AMP_SCHEDULER_UNINITIALIZED;
+        amp_benchmark::exit_on_error(amp_scheduler_create(&scheduler,
+                                                          AMP_DEFAULT_ALLOCATOR,
+                                                          worker_count));
+        context.scheduler = scheduler;
+        
+        double const start = amp_benchmark::wall_time_seconds();
+        amp_benchmark::exit_on_error(amp_scheduler_run(scheduler,
+                                                       &context,
+                                                       root_func));
+        double const stop = amp_benchmark::wall_time_seconds();
+        
+        amp_benchmark::exit_on_error(amp_scheduler_destroy(&scheduler,
+                                                           AMP_DEFAULT_ALLOCATOR));
+        
+        return stop - start;
+    }
+    
+    
+    double measure_fib(std::size_t worker_count)
+    {
+        fib_context_s context = {AMP_SCHEDULER_UNINITIALIZED, fib_n, 0};
+        double const seconds = measure(worker_count, context, &fib_task_func);
+        
+        if (serial_fib(fib_n) != context.result) {
+            std::cerr << "fib computed a wrong result.\n";
+            std::exit(EXIT_FAILURE);
+        }
+        
+        return seconds;
+    }
+    
+    
+    double measure_nqueens(std::size_t worker_count)
+    {
+        nqueens_context_s context;
+        context.row = 0;
+        context.result = 0;
+        double const seconds = measure(worker_count, context, &nqueens_task_func);
+        
+        int queens[nqueens_n];
+        if (serial_nqueens(queens, 0) != context.result) {
+            std::cerr << "nqueens computed a wrong result.\n";
+            std::exit(EXIT_FAILURE);
+        }
+        
+        return seconds;
+    }
+    
+    
+    
+    void print_scaling(char const* name,
+                       double (*measure_func)(std::size_t),
+                       std::size_t max_thread_count)
+    {
+        double const single_worker_seconds = measure_func(1);
+        
+        std::cout << "  " << name << "\n";
+        
+        for (std::size_t worker_count = 1; 
+             worker_count <= max_thread_count; 
+             worker_count *= 2) {
+            
+            double const seconds = (1 == worker_count) ? single_worker_seconds : measure_func(worker_count);
+            
+            std::cout << "  " << std::setw(3) << worker_count << " workers: " 
+                << std::setw(8) << seconds * 1.0e3 << " ms, speedup " 
+                << single_worker_seconds / seconds << "\n";
+        }
+    }
+    
+} // anonymous namespace
+
+
+
+void amp_benchmark::scheduler_benchmark(std::size_t max_thread_count)
+{
+    std::cout << std::fixed << std::setprecision(2);
+    
+    print_scaling("fib", &measure_fib, max_thread_count);
+    print_scaling("nqueens", &measure_nqueens, max_thread_count);
+}
@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Measures amp_semaphore signal and wait throughput, once without any thread
+ * waiting on the semaphore and once with producer threads signaling consumer
+ * threads that wait.
+ *
+ * Build once per semaphore backend, e.g. with and without 
+ * AMP_USE_FUTEX_SEMAPHORES, to compare them.
+ */
+
+
+#include <iostream>
+#include <iomanip>
+#include <cstddef>
+
+#include <amp/amp.h>
+
+#include "amp_benchmark.h"
+
+
+
+namespace {
+    
+#if defined(AMP_USE_POSIX_1003_1B_SEMAPHORES)
+    char const* const semaphore_backend_name = "posix 1003.1b";
+#elif defined(AMP_USE_LIBDISPATCH_SEMAPHORES)
+    char const* const semaphore_backend_name = "libdispatch";
+#elif defined(AMP_USE_FUTEX_SEMAPHORES)
+    char const* const semaphore_backend_name = "futex";
+#elif defined(AMP_USE_PTHREADS)
+    char const* const semaphore_backend_name = "pthreads";
+#elif defined(AMP_USE_WINTHREADS)
+    char const* const semaphore_backend_name = "winthreads";
+#else
+    char const* const semaphore_backend_name = "unknown";
+#endif
+    
+    std::size_t const signal_count = 1000000;
+    
+    
+    struct semaphore_benchmark_context_s {
+        amp_semaphore_t semaphore;
+        std::size_t operation_count;
+    };
+    
+    
+    void signal_thread_func(void* ctxt)
+    {
+        semaphore_benchmark_context_s* context = static_cast<semaphore_benchmark_context_s*>(ctxt);
+        
+        for (std::size_t i = 0; i < context->operation_count; ++i) {
+            amp_semaphore_signal(context->semaphore);
+        }
+    }
+    
+    
+    void wait_thread_func(void* ctxt)
+    {
+        semaphore_benchmark_context_s* context = static_cast<semaphore_benchmark_context_s*>(ctxt);
+        
+        for (std::size_t i = 0; i < context->operation_count; ++i) {
+            amp_semaphore_wait(context->semaphore);
+        }
+    }
+    
+    
+    /**
+     * Returns nanoseconds per signal on a semaphore nobody waits on. The 
+     * semaphore is drained afterwards so it can be destroyed balanced.
+     */
+    double measure_signal_without_waiters()
+    {
+        semaphore_benchmark_context_s context;
+        context.operation_count = signal_count;
+        
+        amp_benchmark::exit_on_error(amp_semaphore_create(&context.semaphore,
+                                                          AMP_DEFAULT_ALLOCATOR,
+                                                          0));
+        
+        // Measure on an amp thread as single threaded processes might skip
+        // atomic instructions.
+        amp_thread_t thread = AMP_THREAD_UNINITIALIZED;
+        double const start = amp_benchmark::wall_time_seconds();
+        amp_benchmark::exit_on_error(amp_thread_create_and_launch(&thread,
+                                                                  AMP_DEFAULT_ALLOCATOR,
+                                                                  &context,
+                                                                  &signal_thread_func));
+        amp_benchmark::exit_on_error(amp_thread_join_and_destroy(&thread,
+                                                                 AMP_DEFAULT_ALLOCATOR));
+        double const stop = amp_benchmark::wall_time_seconds();
+        
+        wait_thread_func(&context);
+        
+        amp_benchmark::exit_on_error(amp_semaphore_destroy(&context.semaphore,
+                                                           AMP_DEFAULT_ALLOCATOR));
+        
+        return (stop - start) * 1.0e9 / static_cast<double>(signal_count);
+    }
+    
+    
+    /**
+     * Returns nanoseconds per signal and wait pair while pair_count producer
+     * threads signal and pair_count consumer threads wait on one semaphore.
+     */
+    double measure_producer_consumer(std::size_t pair_count)
+    {
+        semaphore_benchmark_context_s context;
+        context.operation_count = signal_count / pair_count;
+        
+        amp_benchmark::exit_on_error(amp_semaphore_create(&context.semaphore,
+                                                          AMP_DEFAULT_ALLOCATOR,
+                                                          0));
+        
+        amp_thread_array_t threads = AMP_THREAD_ARRAY_UNINITIALIZED;
+        amp_benchmark::exit_on_error(amp_thread_array_create(&threads,
+                                                             AMP_DEFAULT_ALLOCATOR,
+                                                             2 * pair_count));
+        amp_benchmark::exit_on_error(amp_thread_array_configure(threads,
+                                                                0,
+                                                                pair_count,
+                                                                &context,
+                                                                &wait_thread_func));
+        amp_benchmark::exit_on_error(amp_thread_array_configure(threads,
+                                                                pair_count,
+                                                                pair_count,
+                                                                &context,
+                                                                &signal_thread_func));
+        
+        double const start = amp_benchmark::wall_time_seconds();
+        amp_benchmark::exit_on_error(amp_thread_array_launch_all(threads, NULL));
+        amp_benchmark::exit_on_error(amp_thread_array_join_all(threads, NULL));
+        double const stop = amp_benchmark::wall_time_seconds();
+        
+        amp_benchmark::exit_on_error(amp_thread_array_destroy(&threads, 
+                                                              AMP_DEFAULT_ALLOCATOR));
+        amp_benchmark::exit_on_error(amp_semaphore_destroy(&context.semaphore,
+                                                           AMP_DEFAULT_ALLOCATOR));
+        
+        return (stop - start) * 1.0e9 / static_cast<double>(pair_count * context.operation_count);
+    }
+    
+} // anonymous namespace
+
+
+
+void amp_benchmark::semaphore_benchmark(std::size_t max_thread_count)
+{
+    std::cout << "  backend: " << semaphore_backend_name << "\n";
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "  signal without waiters: " << measure_signal_without_waiters() << " ns/signal\n";
+    
+    for (std::size_t pair_count = 1; 
+         pair_count <= max_thread_count; 
+         pair_count *= 2) {
+        
+        std::cout << "  " << std::setw(3) << pair_count << " producer/consumer pairs: " 
+            << measure_producer_consumer(pair_count) << " ns/signal+wait\n";
+    }
+}
@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Measures uncontended and contended amp_spinlock lock and unlock throughput
+ * side by side with amp_mutex for a critical section that only increments 
+ * a counter.
+ *
+ * Build once per spinlock backend (AMP_USE_TTAS_SPINLOCKS, 
+ * AMP_USE_TICKET_SPINLOCKS, AMP_USE_MCS_SPINLOCKS) to compare them.
+ *
+ * Thread counts stop at the concurrency level - with more threads than 
+ * cores the fair ticket and MCS locks hand the lock to preempted waiters
+ * and a run takes minutes instead of seconds.
+ */
+
+
+#include <iostream>
+#include <iomanip>
+#include <cstddef>
+
+#include <amp/amp.h>
+#include <amp/amp_spinlock.h>
+
+#include "amp_benchmark.h"
+
+
+
+namespace {
+    
+#if defined(AMP_USE_TTAS_SPINLOCKS)
+    char const* const spinlock_backend_name = "ttas";
+#elif defined(AMP_USE_TICKET_SPINLOCKS)
+    char const* const spinlock_backend_name = "ticket";
+#elif defined(AMP_USE_MCS_SPINLOCKS)
+    char const* const spinlock_backend_name = "mcs";
+#else
+    char const* const spinlock_backend_name = "unknown";
+#endif
+    
+    std::size_t const lock_count_per_thread = 1000000;
+    
+    
+    /**
+     * Lock and unlock functions of the measured lock type so spinlocks and 
+     * mutexes share the measurement code.
+     */
+    struct lock_ops_s {
+        int (*create)(void** lock);
+        int (*destroy)(void** lock);
+        int (*lock)(void* lock);
+        int (*unlock)(void* lock);
+    };
+    
+    
+    int spinlock_create(void** lock)
+    {
+        amp_spinlock_t spinlock = AMP_SPINLOCK_UNINITIALIZED;
+        int const rc = amp_spinlock_create(&spinlock, AMP_DEFAULT_ALLOCATOR);
+        *lock = spinlock;
+        return rc;
+    }
+    
+    int spinlock_destroy(void** lock)
+    {
+        amp_spinlock_t spinlock = static_cast<amp_spinlock_t>(*lock);
+        int const rc = amp_spinlock_destroy(&spinlock, AMP_DEFAULT_ALLOCATOR);
+        *lock = spinlock;
+        return rc;
+    }
+    
+    int spinlock_lock(void* lock)
+    {
+        return amp_spinlock_lock(static_cast<amp_spinlock_t>(lock));
+    }
+    
+    int spinlock_unlock(void* lock)
+    {
+        return amp_spinlock_unlock(static_cast<amp_spinlock_t>(lock));
+    }
+    
+    
+    int mutex_create(void** lock)
+    {
+        amp_mutex_t mutex = AMP_MUTEX_UNINITIALIZED;
+        int const rc = amp_mutex_create(&mutex, AMP_DEFAULT_ALLOCATOR);
+        *lock = mutex;
+        return rc;
+    }
+    
+    int mutex_destroy(void** lock)
+    {
+        amp_mutex_t mutex = static_cast<amp_mutex_t>(*lock);
+        int const rc = amp_mutex_destroy(&mutex, AMP_DEFAULT_ALLOCATOR);
+        *lock = mutex;
+        return rc;
+    }
+    
+    int mutex_lock(void* lock)
+    {
+        return amp_mutex_lock(static_cast<amp_mutex_t>(lock));
+    }
+    
+    int mutex_unlock(void* lock)
+    {
+        return amp_mutex_unlock(static_cast<amp_mutex_t>(lock));
+    }
+    
+    
+    lock_ops_s const spinlock_ops = {
+        &spinlock_create, &spinlock_destroy, &spinlock_lock, &spinlock_unlock
+    };
+    
+    lock_ops_s const mutex_ops = {
+        &mutex_create, &mutex_destroy, &mutex_lock, &mutex_unlock
+    };
+    
+    
+    
+    struct lock_benchmark_context_s {
+        lock_ops_s const* ops;
+        void* lock;
+        amp_barrier_t start_barrier;
+        std::size_t counter;
+        double nanoseconds_per_lock;
+    };
+    
+    
+    void lock_benchmark_thread_func(void* ctxt)
+    {
+        lock_benchmark_context_s* context = static_cast<lock_benchmark_context_s*>(ctxt);
+        lock_ops_s const* ops = context->ops;
+        void* lock = context->lock;
+        
+        int const rc = amp_barrier_wait(context->start_barrier);
+        if (AMP_SUCCESS != rc && AMP_BARRIER_SERIAL_THREAD != rc) {
+            amp_benchmark::exit_on_error(rc);
+        }
+        
+        for (std::size_t i = 0; i < lock_count_per_thread; ++i) {
+            ops->lock(lock);
+            {
+                ++(context->counter);
+            }
+            ops->unlock(lock);
+        }
+    }
+    
+    
+    /**
+     * Returns the nanoseconds per lock and unlock pair when thread_count 
+     * threads hammer the same lock.
+     */
+    double measure_contended(lock_ops_s const* ops,
+                             std::size_t thread_count)
+    {
+        lock_benchmark_context_s context;
+        context.ops = ops;
+        context.lock = NULL;
+        context.counter = 0;
+        context.nanoseconds_per_lock = 0.0;
+        
+        amp_benchmark::exit_on_error(ops->create(&context.lock));
+        amp_benchmark::exit_on_error(amp_barrier_create(&context.start_barrier,
+                                                        AMP_DEFAULT_ALLOCATOR,
+                                                        static_cast<amp_barrier_count_t>(thread_count + 1)));
+        
+        amp_thread_array_t threads = AMP_THREAD_ARRAY_UNINITIALIZED;
+        amp_benchmark::exit_on_error(amp_thread_array_create(&threads,
+                                                             AMP_DEFAULT_ALLOCATOR,
+                                                             thread_count));
+        amp_benchmark::exit_on_error(amp_thread_array_configure(threads,
+                                                                0,
+                                                                thread_count,
+                                                                &context,
+                                                                &lock_benchmark_thread_func));
+        amp_benchmark::exit_on_error(amp_thread_array_launch_all(threads, NULL));
+        
+        int const rc = amp_barrier_wait(context.start_barrier);
+        if (AMP_SUCCESS != rc && AMP_BARRIER_SERIAL_THREAD != rc) {
+            amp_benchmark::exit_on_error(rc);
+        }
+        double const start = amp_benchmark::wall_time_seconds();
+        
+        amp_benchmark::exit_on_error(amp_thread_array_join_all(threads, NULL));
+        
+        double const stop = amp_benchmark::wall_time_seconds();
+        
+        if (context.counter != thread_count * lock_count_per_thread) {
+            std::cerr << "amp_benchmark error: lock lost increments\n";
+            amp_benchmark::exit_on_error(AMP_ERROR);
+        }
+        
+        amp_benchmark::exit_on_error(amp_thread_array_destroy(&threads, 
+                                                              AMP_DEFAULT_ALLOCATOR));
+        amp_benchmark::exit_on_error(amp_barrier_destroy(&context.start_barrier,
+                                                         AMP_DEFAULT_ALLOCATOR));
+        amp_benchmark::exit_on_error(ops->destroy(&context.lock));
+        
+        return (stop - start) * 1.0e9 / static_cast<double>(thread_count * lock_count_per_thread);
+    }
+    
+    
+    void uncontended_thread_func(void* ctxt)
+    {
+        lock_benchmark_context_s* context = static_cast<lock_benchmark_context_s*>(ctxt);
+        lock_ops_s const* ops = context->ops;
+        void* lock = context->lock;
+        
+        double const start = amp_benchmark::wall_time_seconds();
+        for (std::size_t i = 0; i < lock_count_per_thread; ++i) {
+            ops->lock(lock);
+            ops->unlock(lock);
+        }
+        double const stop = amp_benchmark::wall_time_seconds();
+        
+        context->nanoseconds_per_lock = (stop - start) * 1.0e9 / static_cast<double>(lock_count_per_thread);
+    }
+    
+    
+    /**
+     * Returns the nanoseconds per lock and unlock pair without any other 
+     * thread touching the lock. Measured on an amp thread, see 
+     * amp_mutex_benchmark.cpp.
+     */
+    double measure_uncontended(lock_ops_s const* ops)
+    {
+        lock_benchmark_context_s context;
+        context.ops = ops;
+        context.lock = NULL;
+        context.counter = 0;
+        context.nanoseconds_per_lock = 0.0;
+        
+        amp_benchmark::exit_on_error(ops->create(&context.lock));
+        
+        amp_thread_t thread = AMP_THREAD_UNINITIALIZED;
+        amp_benchmark::exit_on_error(amp_thread_create_and_launch(&thread,
+                                                                  AMP_DEFAULT_ALLOCATOR,
+                                                                  &context,
+                                                                  &uncontended_thread_func));
+        amp_benchmark::exit_on_error(amp_thread_join_and_destroy(&thread,
+                                                                 AMP_DEFAULT_ALLOCATOR));
+        
+        amp_benchmark::exit_on_error(ops->destroy(&context.lock));
+        
+        return context.nanoseconds_per_lock;
+    }
+    
+} // anonymous namespace
+
+
+
+void amp_benchmark::spinlock_benchmark(std::size_t max_thread_count)
+{
+    std::cout << "  backend: " << spinlock_backend_name << " (ns/lock spinlock vs. mutex)\n";
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "  uncontended: " << measure_uncontended(&spinlock_ops) 
+        << " vs. " << measure_uncontended(&mutex_ops) << "\n";
+    
+    for (std::size_t thread_count = 1; 
+         thread_count <= max_thread_count; 
+         thread_count *= 2) {
+        
+        std::cout << "  " << std::setw(3) << thread_count << " threads: " 
+            << measure_contended(&spinlock_ops, thread_count) << " vs. "
+            << measure_contended(&mutex_ops, thread_count) << "\n";
+    }
+}
@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Measures the start skew of amp_thread_array launches - the time between
+ * the first and the last thread starting to run its function - for the 
+ * sequential and the tree launch mode, with and without a start gate.
+ * Also measures the overhead of creating, launching, joining, and destroying
+ * a thread array of threads that do nothing, and of only creating and 
+ * destroying it which isolates the cost of its memory layout.
+ */
+
+
+#include <iostream>
+#include <iomanip>
+#include <cstddef>
+#include <vector>
+
+#include <amp/amp.h>
+
+#include "amp_benchmark.h"
+
+
+
+namespace {
+    
+    std::size_t const repetition_count = 10;
+    
+    
+    void record_start_time(void* context)
+    {
+        *static_cast<double*>(context) = amp_benchmark::wall_time_seconds();
+    }
+    
+    
+    struct skew_s {
+        double first_to_last;
+        double launch_to_last;
+    };
+    
+    
+    /**
+     * Returns the average microseconds from the first to the last thread 
+     * start and from calling the launch function to the last thread start.
+     */
+    skew_s measure(std::size_t thread_count,
+                   amp_thread_array_launch_mode_t mode,
+                   amp_thread_array_start_t start)
+    {
+        std::vector<double> start_times(thread_count, 0.0);
+        skew_s skew = {0.0, 0.0};
+        
+        for (std::size_t r = 0; r < repetition_count; ++r) {
+            amp_thread_array_t threads = AMP_THREAD_ARRAY_UNINITIALIZED;
+            amp_benchmark::exit_on_error(amp_thread_array_create(&threads,
+                                                                 AMP_DEFAULT_ALLOCATOR,
+                                                                 thread_count));
+            amp_benchmark::exit_on_error(amp_thread_array_configure_functions(threads,
+                                                                              0,
+                                                                              thread_count,
+                                                                              &record_start_time));
+            for (std::size_t i = 0; i < thread_count; ++i) {
+                amp_benchmark::exit_on_error(amp_thread_array_configure_contexts(threads,
+                                                                                 i,
+                                                                                 1,
+                                                                                 &start_times[i]));
+            }
+            
+            double const launch_time = amp_benchmark::wall_time_seconds();
+            amp_benchmark::exit_on_error(amp_thread_array_launch_all_with_mode(threads,
+                                                                               mode,
+                                                                               start,
+                                                                               NULL));
+            amp_benchmark::exit_on_error(amp_thread_array_join_all(threads, NULL));
+            amp_benchmark::exit_on_error(amp_thread_array_destroy(&threads,
+                                                                  AMP_DEFAULT_ALLOCATOR));
+            
+            double first = start_times[0];
+            double last = start_times[0];
+            for (std::size_t i = 1; i < thread_count; ++i) {
+                first = (start_times[i] < first) ? start_times[i] : first;
+                last = (start_times[i] > last) ? start_times[i] : last;
+            }
+            
+            skew.first_to_last += (last - first) * 1.0e6;
+            skew.launch_to_last += (last - launch_time) * 1.0e6;
+        }
+        
+        skew.first_to_last /= static_cast<double>(repetition_count);
+        skew.launch_to_last /= static_cast<double>(repetition_count);
+        
+        return skew;
+    }
+    
+    
+    void do_nothing(void*)
+    {
+        // Nothing to do.
+    }
+    
+    
+    /**
+     * Returns the average microseconds per thread to create, launch, join, 
+     * and destroy a thread array with thread_count threads.
+     */
+    double measure_overhead(std::size_t thread_count)
+    {
+        double const start = amp_benchmark::wall_time_seconds();
+        
+        for (std::size_t r = 0; r < repetition_count; ++r) {
+            amp_thread_array_t threads = AMP_THREAD_ARRAY_UNINITIALIZED;
+            amp_benchmark::exit_on_error(amp_thread_array_create(&threads,
+                                                                 AMP_DEFAULT_ALLOCATOR,
+                                                                 thread_count));
+            amp_benchmark::exit_on_error(amp_thread_array_configure(threads,
+                                                                    0,
+                                                                    thread_count,
+                                                                    NULL,
+                                                                    &do_nothing));
+            amp_benchmark::exit_on_error(amp_thread_array_launch_all(threads, NULL));
+            amp_benchmark::exit_on_error(amp_thread_array_join_all(threads, NULL));
+            amp_benchmark::exit_on_error(amp_thread_array_destroy(&threads,
+                                                                  AMP_DEFAULT_ALLOCATOR));
+        }
+        
+        double const stop = amp_benchmark::wall_time_seconds();
+        
+        return (stop - start) * 1.0e6 / static_cast<double>(repetition_count * thread_count);
+    }
+    
+    
+    /**
+     * Returns the average nanoseconds per thread to create and destroy a 
+     * thread array with thread_count threads without launching them.
+     */
+    double measure_create_and_destroy(std::size_t thread_count)
+    {
+        std::size_t const create_count = 1000;
+        double const start = amp_benchmark::wall_time_seconds();
+        
+        for (std::size_t r = 0; r < create_count; ++r) {
+            amp_thread_array_t threads = AMP_THREAD_ARRAY_UNINITIALIZED;
+            amp_benchmark::exit_on_error(amp_thread_array_create(&threads,
+                                                                 AMP_DEFAULT_ALLOCATOR,
+                                                                 thread_count));
+            amp_benchmark::exit_on_error(amp_thread_array_destroy(&threads,
+                                                                  AMP_DEFAULT_ALLOCATOR));
+        }
+        
+        double const stop = amp_benchmark::wall_time_seconds();
+        
+        return (stop - start) * 1.0e9 / static_cast<double>(create_count * thread_count);
+    }
+    
+    
+    void print(char const* label,
+               skew_s const& skew)
+    {
+        std::cout << "    " << std::setw(18) << std::left << label << std::right
+            << std::setw(10) << skew.first_to_last << " us first to last, "
+            << std::setw(10) << skew.launch_to_last << " us launch to last\n";
+    }
+    
+} // anonymous namespace
+
+
+
+void amp_benchmark::thread_launch_benchmark(std::size_t max_thread_count)
+{
+    std::cout << "  thread start skew of amp_thread_array launch modes\n";
+    std::cout << std::fixed << std::setprecision(1);
+    
+    // Launch skew matters most for many threads, therefore oversubscribe 
+    // machines with few cores.
+    std::size_t const largest_thread_count = (max_thread_count > 256) ? max_thread_count : 256;
+    
+    for (std::size_t thread_count = 16;
+         thread_count <= largest_thread_count;
+         thread_count *= 4) {
+        
+        std::cout << "  " << thread_count << " threads:\n";
+        
+        print("sequential", measure(thread_count,
+                                    amp_thread_array_launch_sequential,
+                                    amp_thread_array_start_immediately));
+        print("sequential gated", measure(thread_count,
+                                          amp_thread_array_launch_sequential,
+                                          amp_thread_array_start_gated));
+        print("tree", measure(thread_count,
+                              amp_thread_array_launch_tree,
+                              amp_thread_array_start_immediately));
+        print("tree gated", measure(thread_count,
+                                    amp_thread_array_launch_tree,
+                                    amp_thread_array_start_gated));
+    }
+    
+    std::cout << "  us per thread to create, launch, join, and destroy a thread array\n";
+    for (std::size_t thread_count = 16;
+         thread_count <= largest_thread_count;
+         thread_count *= 4) {
+        
+        std::cout << "  " << std::setw(4) << thread_count << " threads: " 
+            << measure_overhead(thread_count) << "\n";
+    }
+    
+    std::cout << "  ns per thread to create and destroy a thread array\n";
+    for (std::size_t thread_count = 16;
+         thread_count <= largest_thread_count;
+         thread_count *= 4) {
+        
+        std::cout << "  " << std::setw(4) << thread_count << " threads: " 
+            << measure_create_and_destroy(thread_count) << "\n";
+    }
+}
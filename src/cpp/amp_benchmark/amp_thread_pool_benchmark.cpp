@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Measures the cost of running a parallel section of trivial jobs by 
+ * creating and launching an amp_thread_array per section versus submitting
+ * the jobs to a persistent amp_thread_pool and waiting for them.
+ */
+
+
+#include <iostream>
+#include <iomanip>
+#include <cstddef>
+
+#include <amp/amp.h>
+
+#include "amp_benchmark.h"
+
+
+
+namespace {
+    
+    std::size_t const section_count = 1000;
+    
+    
+    void empty_job_func(void* /* context */)
+    {
+        // Nothing to do - only the cost of getting the job run is measured.
+    }
+    
+    
+    /**
+     * Returns the microseconds per section of thread_count jobs when every
+     * section creates, launches, joins, and destroys a thread array. Joined
+     * thread array threads can't be launched again.
+     */
+    double measure_thread_array(std::size_t thread_count)
+    {
+        double const start = amp_benchmark::wall_time_seconds();
+        
+        for (std::size_t i = 0; i < section_count; ++i) {
+            amp_thread_array_t threads = AMP_THREAD_ARRAY_UNINITIALIZED;
+            amp_benchmark::exit_on_error(amp_thread_array_create(&threads,
+                                                                 AMP_DEFAULT_ALLOCATOR,
+                                                                 thread_count));
+            amp_benchmark::exit_on_error(amp_thread_array_configure(threads,
+                                                                    0,
+                                                                    thread_count,
+                                                                    NULL,
+                                                                    &empty_job_func));
+            amp_benchmark::exit_on_error(amp_thread_array_launch_all(threads, NULL));
+            amp_benchmark::exit_on_error(amp_thread_array_join_all(threads, NULL));
+            amp_benchmark::exit_on_error(amp_thread_array_destroy(&threads, 
+                                                                  AMP_DEFAULT_ALLOCATOR));
+        }
+        
+        double const stop = amp_benchmark::wall_time_seconds();
+        
+        return (stop - start) * 1.0e6 / static_cast<double>(section_count);
+    }
+    
+    
+    /**
+     * Returns the microseconds per section of thread_count jobs submitted to
+     * a thread pool with thread_count workers.
+     */
+    double measure_thread_pool(std::size_t thread_count)
+    {
+        amp_thread_pool_t pool = AMP_THREAD_POOL_UNINITIALIZED;
+        amp_benchmark::exit_on_error(amp_thread_pool_create(&pool,
+                                                            AMP_DEFAULT_ALLOCATOR,
+                                                            thread_count));
+        
+        double const start = amp_benchmark::wall_time_seconds();
+        
+        for (std::size_t i = 0; i < section_count; ++i) {
+            for (std::size_t j = 0; j < thread_count; ++j) {
+                amp_benchmark::exit_on_error(amp_thread_pool_submit(pool,
+                                                                    NULL,
+                                                                    &empty_job_func));
+            }
+            amp_benchmark::exit_on_error(amp_thread_pool_wait_all(pool));
+        }
+        
+        double const stop = amp_benchmark::wall_time_seconds();
+        
+        amp_benchmark::exit_on_error(amp_thread_pool_destroy(&pool, 
+                                                             AMP_DEFAULT_ALLOCATOR));
+        
+        return (stop - start) * 1.0e6 / static_cast<double>(section_count);
+    }
+    
+} // anonymous namespace
+
+
+
+void amp_benchmark::thread_pool_benchmark(std::size_t max_thread_count)
+{
+    std::cout << "  us/section thread array create, launch and join vs. thread pool submit and wait\n";
+    std::cout << std::fixed << std::setprecision(1);
+    
+    for (std::size_t thread_count = 1; 
+         thread_count <= 2 * max_thread_count; 
+         thread_count *= 2) {
+        
+        std::cout << "  " << std::setw(3) << thread_count << " threads: " 
+            << measure_thread_array(thread_count) << " vs. "
+            << measure_thread_pool(thread_count) << "\n";
+    }
+}
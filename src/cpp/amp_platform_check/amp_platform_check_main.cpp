@@ -86,6 +86,76 @@ namespace {
         return out.str();
     }
     
+    
+    std::string cache_type_to_string(amp_platform_cache_type_t type)
+    {
+        switch (type) {
+            case amp_platform_cache_type_data:
+                return "data";
+            case amp_platform_cache_type_instruction:
+                return "instruction";
+            default:
+                return "unified";
+        }
+    }
+    
+    
+    std::string cpu_list_to_string(struct amp_thread_affinity_s const* cpus)
+    {
+        std::ostringstream out;
+        
+        for (std::size_t i = 0; i < AMP_THREAD_AFFINITY_CPU_CAPACITY; ++i) {
+            if (amp_thread_affinity_contains_cpu(cpus, i)) {
+                if (0 != out.tellp()) {
+                    out << ",";
+                }
+                out << i;
+            }
+        }
+        
+        return out.str();
+    }
+    
+    
+    // Prints the caches of hardware thread 0 and which hardware threads 
+    // share them.
+    void print_caches(amp_platform_t platform)
+    {
+        std::size_t cache_count = 0;
+        int error_code = amp_platform_get_hwthread_cache_count(platform,
+                                                                0,
+                                                                &cache_count);
+        exit_on_error_other_than_enosys(error_code);
+        
+        std::cout << "Caches of hwthread 0: " << count_to_string(cache_count) << "\n";
+        
+        for (std::size_t i = 0; i < cache_count; ++i) {
+            struct amp_platform_cache_s cache;
+            error_code = amp_platform_get_hwthread_cache(platform, 0, i, &cache);
+            exit_on_error(error_code);
+            
+            struct amp_thread_affinity_s sharing;
+            error_code = amp_platform_get_hwthread_cache_sharing(platform,
+                                                                 0,
+                                                                 i,
+                                                                 &sharing);
+            exit_on_error_other_than_enosys(error_code);
+            
+            std::cout << "  L" << cache.level 
+                << " " << cache_type_to_string(cache.type)
+                << ": " << count_to_string(cache.size / 1024) << " KiB"
+                << ", line " << count_to_string(cache.line_size) << " bytes"
+                << ", " << count_to_string(cache.associativity) << "-way"
+                << ", shared by hwthreads ";
+            
+            if (AMP_SUCCESS == error_code) {
+                std::cout << cpu_list_to_string(&sharing) << "\n";
+            } else {
+                std::cout << "unsupported\n";
+            }
+        }
+    }
+    
 }
 
 
@@ -105,6 +175,13 @@ int main(int argc, char *argv[])
     std::size_t active_core_count = 0;
     std::size_t hwthread_count = 0;
     std::size_t active_hwthread_count = 0;
+    std::size_t package_count = 0;
+    std::size_t numa_node_count = 0;
+    std::size_t affinity_hwthread_count = 0;
+    std::size_t cpu_quota_us = 0;
+    std::size_t cpu_period_us = 0;
+    std::size_t concurrency_level = 0;
+    std::size_t cache_line_size = 0;
 
     int error_code = AMP_SUCCESS;
     
@@ -121,8 +198,23 @@ int main(int argc, char *argv[])
     error_code = amp_platform_get_active_hwthread_count(platform, &active_hwthread_count);
     exit_on_error_other_than_enosys(error_code);
     
-    int const error_code_destroy = amp_platform_destroy(&platform,AMP_DEFAULT_ALLOCATOR);
-    exit_on_error(error_code_destroy);
+    error_code = amp_platform_get_installed_package_count(platform, &package_count);
+    exit_on_error_other_than_enosys(error_code);
+    
+    error_code = amp_platform_get_cache_line_size(platform, &cache_line_size);
+    exit_on_error_other_than_enosys(error_code);
+    
+    error_code = amp_platform_get_numa_node_count(platform, &numa_node_count);
+    exit_on_error_other_than_enosys(error_code);
+    
+    error_code = amp_platform_get_affinity_hwthread_count(platform, &affinity_hwthread_count);
+    exit_on_error_other_than_enosys(error_code);
+    
+    error_code = amp_platform_get_cpu_quota(platform, &cpu_quota_us, &cpu_period_us);
+    exit_on_error_other_than_enosys(error_code);
+    
+    error_code = amp_platform_get_concurrency_level(platform, &concurrency_level);
+    exit_on_error_other_than_enosys(error_code);
     
     
     std::cout << "amp_platform_check\n";
@@ -133,8 +225,30 @@ int main(int argc, char *argv[])
     std::cout << "Hwthread count: " << count_to_string(active_hwthread_count)
         << "/" << count_to_string(hwthread_count) << " (active/installed)\n";
     
+    std::cout << "Package count : " << count_to_string(package_count) << "\n";
+    
+    std::cout << "NUMA nodes    : " << count_to_string(numa_node_count) << "\n";
+    
+    std::cout << "Affinity      : " << count_to_string(affinity_hwthread_count) << " hwthreads\n";
+    
+    std::cout << "CPU quota     : ";
+    if (0 != cpu_period_us) {
+        std::cout << cpu_quota_us << "/" << cpu_period_us << " us (quota/period)\n";
+    } else {
+        std::cout << "none\n";
+    }
+    
+    std::cout << "Concurrency   : " << count_to_string(concurrency_level) << "\n";
+    
+    std::cout << "Cache line    : " << count_to_string(cache_line_size) << " bytes\n";
+    
+    print_caches(platform);
+    
     std::cout << "\n\n";
     
+    int const error_code_destroy = amp_platform_destroy(&platform,AMP_DEFAULT_ALLOCATOR);
+    exit_on_error(error_code_destroy);
+    
     return EXIT_SUCCESS;
 }
 
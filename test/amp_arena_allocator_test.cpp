@@ -0,0 +1,405 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Unit tests for amp_arena_allocator
+ */
+
+#include <UnitTest++.h>
+
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+
+
+#include <amp/amp_stddef.h>
+#include <amp/amp_return_code.h>
+#include <amp/amp_memory.h>
+#include <amp/amp_arena_allocator.h>
+#include <amp/amp_thread_array.h>
+#include <amp/amp_mutex.h>
+
+
+
+namespace {
+    
+    std::size_t const test_chunk_size = 1024;
+    
+    struct arena_fixture {
+        arena_fixture()
+        :   arena(AMP_ALLOCATOR_UNINITIALIZED)
+        {
+            int const retval = amp_arena_allocator_create(&arena, 
+                                                          AMP_DEFAULT_ALLOCATOR,
+                                                          test_chunk_size,
+                                                          amp_arena_allocator_mode_shared);
+            assert(AMP_SUCCESS == retval);
+            (void)retval;
+        }
+        
+        ~arena_fixture()
+        {
+            int const retval = amp_arena_allocator_destroy(&arena,
+                                                           AMP_DEFAULT_ALLOCATOR);
+            assert(AMP_SUCCESS == retval);
+            (void)retval;
+        }
+        
+        amp_allocator_t arena;
+    };
+    
+} // anonymous namespace
+
+
+
+SUITE(amp_arena_allocator)
+{
+    TEST(create_and_destroy)
+    {
+        amp_arena_allocator_mode_t const modes[] = {
+            amp_arena_allocator_mode_shared,
+            amp_arena_allocator_mode_per_thread
+        };
+        
+        for (std::size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); ++i) {
+            amp_allocator_t allocator = AMP_ALLOCATOR_UNINITIALIZED;
+            
+            int retval = amp_arena_allocator_create(&allocator,
+                                                    AMP_DEFAULT_ALLOCATOR,
+                                                    0,
+                                                    modes[i]);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+            CHECK(AMP_ALLOCATOR_UNINITIALIZED != allocator);
+            
+            retval = amp_arena_allocator_destroy(&allocator, 
+                                                 AMP_DEFAULT_ALLOCATOR);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+            CHECK(AMP_ALLOCATOR_UNINITIALIZED == allocator);
+        }
+    }
+    
+    
+    
+    TEST_FIXTURE(arena_fixture, allocations_are_aligned_and_disjoint)
+    {
+        std::size_t const count = 100;
+        unsigned char* memory[count];
+        
+        for (std::size_t i = 0; i < count; ++i) {
+            memory[i] = (unsigned char*)AMP_ALLOC(arena, i);
+            CHECK(NULL != memory[i]);
+            CHECK_EQUAL(0u, ((std::size_t)memory[i]) % AMP_ARENA_ALLOCATOR_ALIGNMENT);
+            
+            std::memset(memory[i], (int)i, i);
+        }
+        
+        for (std::size_t i = 0; i < count; ++i) {
+            std::size_t mismatch_count = 0;
+            for (std::size_t k = 0; k < i; ++k) {
+                if (i != memory[i][k]) {
+                    ++mismatch_count;
+                }
+            }
+            CHECK_EQUAL(0u, mismatch_count);
+        }
+        
+        CHECK(memory[0] != memory[1]);
+    }
+    
+    
+    
+    TEST_FIXTURE(arena_fixture, dealloc_keeps_memory_valid)
+    {
+        int* first = (int*)AMP_ALLOC(arena, sizeof(int));
+        *first = 42;
+        
+        int const retval = AMP_DEALLOC(arena, first);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        int* second = (int*)AMP_ALLOC(arena, sizeof(int));
+        *second = 23;
+        
+        CHECK(first != second);
+        CHECK_EQUAL(42, *first);
+    }
+    
+    
+    
+    TEST_FIXTURE(arena_fixture, grows_beyond_chunk_size)
+    {
+        unsigned char* small = (unsigned char*)AMP_ALLOC(arena, 100);
+        std::memset(small, 0xab, 100);
+        
+        unsigned char* large = (unsigned char*)AMP_ALLOC(arena, 10 * test_chunk_size);
+        CHECK(NULL != large);
+        std::memset(large, 0xcd, 10 * test_chunk_size);
+        
+        for (std::size_t i = 0; i < 1000; ++i) {
+            void* memory = AMP_ALLOC(arena, 48);
+            CHECK(NULL != memory);
+        }
+        
+        CHECK_EQUAL(0xab, small[99]);
+        CHECK_EQUAL(0xcd, large[10 * test_chunk_size - 1]);
+    }
+    
+    
+    
+    TEST_FIXTURE(arena_fixture, reset_reuses_memory)
+    {
+        void* first = AMP_ALLOC(arena, 64);
+        void* second = AMP_ALLOC(arena, 64);
+        CHECK(first != second);
+        
+        int retval = amp_arena_allocator_reset(arena);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        void* after_reset = AMP_ALLOC(arena, 64);
+        CHECK_EQUAL(first, after_reset);
+        
+        // Reset keeps the largest chunk. Once it has grown large enough 
+        // for the whole working set every round is served from it.
+        void* round_start[4];
+        for (std::size_t round = 0; round < 4; ++round) {
+            round_start[round] = AMP_ALLOC(arena, 64);
+            for (std::size_t i = 0; i < 100; ++i) {
+                void* memory = AMP_ALLOC(arena, 64);
+                assert(NULL != memory);
+                (void)memory;
+            }
+            
+            retval = amp_arena_allocator_reset(arena);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+        }
+        CHECK_EQUAL(round_start[2], round_start[3]);
+    }
+    
+    
+    
+    TEST_FIXTURE(arena_fixture, release_and_allocate_again)
+    {
+        void* memory = AMP_ALLOC(arena, 5000);
+        CHECK(NULL != memory);
+        
+        int retval = amp_arena_allocator_release(arena);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        retval = amp_arena_allocator_release(arena);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        memory = AMP_ALLOC(arena, 16);
+        CHECK(NULL != memory);
+    }
+    
+    
+    
+    TEST_FIXTURE(arena_fixture, calloc_after_reset_is_zeroed)
+    {
+        std::size_t const elem_count = 200;
+        unsigned char* dirty = (unsigned char*)AMP_ALLOC(arena, elem_count * sizeof(int));
+        std::memset(dirty, 0xab, elem_count * sizeof(int));
+        
+        int retval = amp_arena_allocator_reset(arena);
+        assert(AMP_SUCCESS == retval);
+        
+        int* memory = (int*)AMP_CALLOC(arena, elem_count, sizeof(int));
+        CHECK(NULL != memory);
+        
+        std::size_t nonzero_count = 0;
+        for (std::size_t i = 0; i < elem_count; ++i) {
+            if (0 != memory[i]) {
+                ++nonzero_count;
+            }
+        }
+        CHECK_EQUAL(0u, nonzero_count);
+        
+        void* overflowing = AMP_CALLOC(arena, ~(std::size_t)0 / 2, 4);
+        CHECK(NULL == overflowing);
+        
+        overflowing = AMP_ALLOC(arena, ~(std::size_t)0 - 8);
+        CHECK(NULL == overflowing);
+    }
+    
+    
+    
+    TEST_FIXTURE(arena_fixture, backs_amp_primitives)
+    {
+        amp_mutex_t mutex = AMP_MUTEX_UNINITIALIZED;
+        
+        int retval = amp_mutex_create(&mutex, arena);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_mutex_lock(mutex);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        retval = amp_mutex_unlock(mutex);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_mutex_destroy(&mutex, arena);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+    }
+    
+    
+    
+    namespace {
+        
+        std::size_t const arena_iteration_count = 5000;
+        
+        struct arena_context_s {
+            amp_allocator_t arena;
+            unsigned char pattern;
+            unsigned char* blocks[arena_iteration_count];
+            int return_code;
+        };
+        
+        void arena_thread_func(void* ctxt)
+        {
+            struct arena_context_s* context = 
+                static_cast<struct arena_context_s*>(ctxt);
+            
+            for (std::size_t i = 0; i < arena_iteration_count; ++i) {
+                std::size_t const size = 1 + (i * 37) % 200;
+                
+                context->blocks[i] = (unsigned char*)AMP_ALLOC(context->arena, size);
+                if (NULL == context->blocks[i]) {
+                    context->return_code = AMP_NOMEM;
+                    return;
+                }
+                std::memset(context->blocks[i], context->pattern, size);
+            }
+            
+            context->return_code = AMP_SUCCESS;
+        }
+        
+        void run_threads_allocating(amp_allocator_t arena)
+        {
+            std::size_t const thread_count = 4;
+            struct arena_context_s* contexts = new struct arena_context_s[thread_count];
+            
+            amp_thread_array_t threads = AMP_THREAD_ARRAY_UNINITIALIZED;
+            int retval = amp_thread_array_create(&threads,
+                                                 AMP_DEFAULT_ALLOCATOR,
+                                                 thread_count);
+            assert(AMP_SUCCESS == retval);
+            
+            for (std::size_t i = 0; i < thread_count; ++i) {
+                contexts[i].arena = arena;
+                contexts[i].pattern = (unsigned char)(i + 1);
+                contexts[i].return_code = AMP_ERROR;
+                
+                retval = amp_thread_array_configure(threads,
+                                                    i,
+                                                    1,
+                                                    &contexts[i],
+                                                    arena_thread_func);
+                assert(AMP_SUCCESS == retval);
+            }
+            
+            std::size_t joinable_count = 0;
+            retval = amp_thread_array_launch_all(threads, &joinable_count);
+            assert(AMP_SUCCESS == retval);
+            
+            retval = amp_thread_array_join_all(threads, &joinable_count);
+            assert(AMP_SUCCESS == retval);
+            
+            retval = amp_thread_array_destroy(&threads, AMP_DEFAULT_ALLOCATOR);
+            assert(AMP_SUCCESS == retval);
+            
+            // Memory stays valid after the allocating threads ended.
+            for (std::size_t i = 0; i < thread_count; ++i) {
+                CHECK_EQUAL(AMP_SUCCESS, contexts[i].return_code);
+                
+                std::size_t corruption_count = 0;
+                for (std::size_t b = 0; b < arena_iteration_count; ++b) {
+                    std::size_t const size = 1 + (b * 37) % 200;
+                    for (std::size_t k = 0; k < size; ++k) {
+                        if (contexts[i].pattern != contexts[i].blocks[b][k]) {
+                            ++corruption_count;
+                            break;
+                        }
+                    }
+                }
+                CHECK_EQUAL(0u, corruption_count);
+            }
+            
+            delete[] contexts;
+        }
+        
+    } // anonymous namespace
+    
+    
+    
+    TEST(many_threads_allocate_from_shared_arena)
+    {
+        amp_allocator_t arena = AMP_ALLOCATOR_UNINITIALIZED;
+        int retval = amp_arena_allocator_create(&arena,
+                                                AMP_DEFAULT_ALLOCATOR,
+                                                0,
+                                                amp_arena_allocator_mode_shared);
+        assert(AMP_SUCCESS == retval);
+        
+        run_threads_allocating(arena);
+        
+        retval = amp_arena_allocator_reset(arena);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_arena_allocator_destroy(&arena, AMP_DEFAULT_ALLOCATOR);
+        assert(AMP_SUCCESS == retval);
+    }
+    
+    
+    
+    TEST(many_threads_allocate_from_per_thread_arenas)
+    {
+        amp_allocator_t arena = AMP_ALLOCATOR_UNINITIALIZED;
+        int retval = amp_arena_allocator_create(&arena,
+                                                AMP_DEFAULT_ALLOCATOR,
+                                                test_chunk_size,
+                                                amp_arena_allocator_mode_per_thread);
+        assert(AMP_SUCCESS == retval);
+        
+        run_threads_allocating(arena);
+        
+        retval = amp_arena_allocator_reset(arena);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        // A second round reuses the chunks kept by the reset.
+        run_threads_allocating(arena);
+        
+        retval = amp_arena_allocator_destroy(&arena, AMP_DEFAULT_ALLOCATOR);
+        assert(AMP_SUCCESS == retval);
+    }
+    
+    
+    
+} // SUITE(amp_arena_allocator)
@@ -0,0 +1,569 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Unit tests for amp_atomic. The contended tests check that concurrent 
+ * operations behave as if executed one after the other in some order.
+ */
+
+#include <UnitTest++.h>
+
+#include <cassert>
+#include <cstddef>
+#include <algorithm>
+#include <vector>
+
+#include <amp/amp.h>
+#include <amp/amp_atomic.h>
+
+
+
+SUITE(amp_atomic)
+{
+    TEST(int_operations)
+    {
+        amp_atomic_int_t atomic;
+        amp_atomic_int_store(&atomic, 42, amp_memory_order_relaxed);
+        CHECK_EQUAL(42, amp_atomic_int_load(&atomic, amp_memory_order_acquire));
+        
+        CHECK_EQUAL(42, amp_atomic_int_exchange(&atomic, 7, amp_memory_order_acq_rel));
+        CHECK_EQUAL(7, amp_atomic_int_fetch_add(&atomic, 3, amp_memory_order_seq_cst));
+        CHECK_EQUAL(10, amp_atomic_int_fetch_sub(&atomic, 4, amp_memory_order_release));
+        CHECK_EQUAL(6, amp_atomic_int_load(&atomic, amp_memory_order_seq_cst));
+        
+        int expected = 5;
+        CHECK_EQUAL(0, amp_atomic_int_compare_exchange(&atomic, 
+                                                       &expected, 
+                                                       9, 
+                                                       amp_memory_order_acq_rel, 
+                                                       amp_memory_order_acquire));
+        CHECK_EQUAL(6, expected);
+        CHECK(0 != amp_atomic_int_compare_exchange(&atomic, 
+                                                   &expected, 
+                                                   9, 
+                                                   amp_memory_order_release, 
+                                                   amp_memory_order_seq_cst));
+        CHECK_EQUAL(9, amp_atomic_int_load(&atomic, amp_memory_order_relaxed));
+    }
+    
+    
+    
+    TEST(size_operations)
+    {
+        amp_atomic_size_t atomic;
+        amp_atomic_size_store(&atomic, 0, amp_memory_order_relaxed);
+        
+        CHECK_EQUAL(static_cast<std::size_t>(0), amp_atomic_size_fetch_sub(&atomic, 1, amp_memory_order_acq_rel));
+        CHECK_EQUAL(~static_cast<std::size_t>(0), amp_atomic_size_load(&atomic, amp_memory_order_acquire));
+        CHECK_EQUAL(~static_cast<std::size_t>(0), amp_atomic_size_fetch_add(&atomic, 2, amp_memory_order_relaxed));
+        CHECK_EQUAL(static_cast<std::size_t>(1), amp_atomic_size_exchange(&atomic, 5, amp_memory_order_seq_cst));
+        
+        std::size_t expected = 5;
+        CHECK(0 != amp_atomic_size_compare_exchange(&atomic, 
+                                                    &expected, 
+                                                    6, 
+                                                    amp_memory_order_acquire, 
+                                                    amp_memory_order_relaxed));
+        CHECK_EQUAL(static_cast<std::size_t>(6), amp_atomic_size_load(&atomic, amp_memory_order_relaxed));
+    }
+    
+    
+    
+    TEST(ptr_operations)
+    {
+        int values[2] = {0, 1};
+        
+        amp_atomic_ptr_t atomic;
+        amp_atomic_ptr_store(&atomic, NULL, amp_memory_order_relaxed);
+        CHECK(NULL == amp_atomic_ptr_load(&atomic, amp_memory_order_acquire));
+        
+        CHECK(NULL == amp_atomic_ptr_exchange(&atomic, &values[0], amp_memory_order_acq_rel));
+        
+        void* expected = &values[1];
+        CHECK_EQUAL(0, amp_atomic_ptr_compare_exchange(&atomic, 
+                                                       &expected, 
+                                                       NULL, 
+                                                       amp_memory_order_seq_cst, 
+                                                       amp_memory_order_seq_cst));
+        CHECK(&values[0] == expected);
+        CHECK(0 != amp_atomic_ptr_compare_exchange(&atomic, 
+                                                   &expected, 
+                                                   &values[1], 
+                                                   amp_memory_order_release, 
+                                                   amp_memory_order_relaxed));
+        CHECK(&values[1] == amp_atomic_ptr_load(&atomic, amp_memory_order_acquire));
+        
+        amp_atomic_thread_fence(amp_memory_order_seq_cst);
+        amp_atomic_cpu_relax();
+    }
+    
+    
+    
+    namespace {
+        
+        std::size_t const contended_thread_count = 8;
+        std::size_t const contended_iteration_count = 10000;
+        
+        struct contended_counter_s {
+            amp_atomic_int_t counter;
+            std::vector<std::vector<int> > observed_values;
+        };
+        
+        struct contended_thread_context_s {
+            struct contended_counter_s* shared;
+            std::size_t index;
+        };
+        
+        
+        void fetch_add_thread_func(void* ctxt);
+        void fetch_add_thread_func(void* ctxt)
+        {
+            struct contended_thread_context_s* context = static_cast<struct contended_thread_context_s*>(ctxt);
+            std::vector<int>& observed = context->shared->observed_values[context->index];
+            
+            for (std::size_t i = 0; i < contended_iteration_count; ++i) {
+                observed.push_back(amp_atomic_int_fetch_add(&context->shared->counter, 
+                                                            1, 
+                                                            amp_memory_order_relaxed));
+            }
+        }
+        
+        
+        void compare_exchange_thread_func(void* ctxt);
+        void compare_exchange_thread_func(void* ctxt)
+        {
+            struct contended_thread_context_s* context = static_cast<struct contended_thread_context_s*>(ctxt);
+            std::vector<int>& observed = context->shared->observed_values[context->index];
+            
+            for (std::size_t i = 0; i < contended_iteration_count; ++i) {
+                int value = amp_atomic_int_load(&context->shared->counter, 
+                                                amp_memory_order_relaxed);
+                while (!amp_atomic_int_compare_exchange(&context->shared->counter, 
+                                                        &value, 
+                                                        value + 1, 
+                                                        amp_memory_order_relaxed, 
+                                                        amp_memory_order_relaxed)) {
+                    // value has been updated, retry.
+                }
+                observed.push_back(value);
+            }
+        }
+        
+        
+        // Runs thread_func on contended_thread_count threads and checks that
+        // every counter value has been observed by exactly one thread and 
+        // that each thread observed increasing values.
+        bool run_contended_counter(amp_thread_func_t thread_func);
+        bool run_contended_counter(amp_thread_func_t thread_func)
+        {
+            struct contended_counter_s shared;
+            amp_atomic_int_store(&shared.counter, 0, amp_memory_order_relaxed);
+            shared.observed_values.resize(contended_thread_count);
+            
+            std::vector<struct contended_thread_context_s> contexts(contended_thread_count);
+            
+            amp_thread_array_t threads = AMP_THREAD_ARRAY_UNINITIALIZED;
+            int retval = amp_thread_array_create(&threads,
+                                                 AMP_DEFAULT_ALLOCATOR,
+                                                 contended_thread_count);
+            assert(AMP_SUCCESS == retval);
+            
+            for (std::size_t i = 0; i < contended_thread_count; ++i) {
+                contexts[i].shared = &shared;
+                contexts[i].index = i;
+                shared.observed_values[i].reserve(contended_iteration_count);
+                
+                retval = amp_thread_array_configure(threads,
+                                                    i,
+                                                    1,
+                                                    &contexts[i],
+                                                    thread_func);
+                assert(AMP_SUCCESS == retval);
+            }
+            
+            std::size_t joinable_count = 0;
+            retval = amp_thread_array_launch_all(threads, &joinable_count);
+            assert(AMP_SUCCESS == retval);
+            
+            retval = amp_thread_array_join_all(threads, &joinable_count);
+            assert(AMP_SUCCESS == retval);
+            
+            retval = amp_thread_array_destroy(&threads, AMP_DEFAULT_ALLOCATOR);
+            assert(AMP_SUCCESS == retval);
+            (void)retval;
+            
+            std::size_t const total_count = contended_thread_count * contended_iteration_count;
+            std::vector<int> all_values;
+            all_values.reserve(total_count);
+            
+            for (std::size_t i = 0; i < contended_thread_count; ++i) {
+                std::vector<int> const& observed = shared.observed_values[i];
+                
+                for (std::size_t k = 1; k < observed.size(); ++k) {
+                    if (observed[k - 1] >= observed[k]) {
+                        return false;
+                    }
+                }
+                
+                all_values.insert(all_values.end(), observed.begin(), observed.end());
+            }
+            
+            if ((total_count != all_values.size()) 
+                || (static_cast<int>(total_count) != amp_atomic_int_load(&shared.counter, amp_memory_order_relaxed))) {
+                return false;
+            }
+            
+            std::sort(all_values.begin(), all_values.end());
+            for (std::size_t i = 0; i < total_count; ++i) {
+                if (static_cast<int>(i) != all_values[i]) {
+                    return false;
+                }
+            }
+            
+            return true;
+        }
+        
+    } // anonymous namespace
+    
+    
+    
+    TEST(contended_fetch_add_is_linearizable)
+    {
+        CHECK(run_contended_counter(&fetch_add_thread_func));
+    }
+    
+    
+    
+    TEST(contended_compare_exchange_is_linearizable)
+    {
+        CHECK(run_contended_counter(&compare_exchange_thread_func));
+    }
+    
+    
+    
+    namespace {
+        
+        struct spin_lock_data_s {
+            amp_atomic_int_t lock;
+            std::size_t unprotected_counter;
+        };
+        
+        void spin_lock_thread_func(void* ctxt);
+        void spin_lock_thread_func(void* ctxt)
+        {
+            struct spin_lock_data_s* data = static_cast<struct spin_lock_data_s*>(ctxt);
+            
+            for (std::size_t i = 0; i < contended_iteration_count; ++i) {
+                
+                while (0 != amp_atomic_int_exchange(&data->lock, 1, amp_memory_order_acquire)) {
+                    // The lock holder might be preempted - don't spin away
+                    // the time slice.
+                    amp_thread_yield();
+                }
+                
+                ++(data->unprotected_counter);
+                
+                amp_atomic_int_store(&data->lock, 0, amp_memory_order_release);
+            }
+        }
+        
+    } // anonymous namespace
+    
+    
+    TEST(acquire_release_exchange_protects_plain_data)
+    {
+        struct spin_lock_data_s data;
+        amp_atomic_int_store(&data.lock, 0, amp_memory_order_relaxed);
+        data.unprotected_counter = 0;
+        
+        amp_thread_array_t threads = AMP_THREAD_ARRAY_UNINITIALIZED;
+        int retval = amp_thread_array_create(&threads,
+                                             AMP_DEFAULT_ALLOCATOR,
+                                             contended_thread_count);
+        assert(AMP_SUCCESS == retval);
+        
+        retval = amp_thread_array_configure(threads,
+                                            0,
+                                            contended_thread_count,
+                                            &data,
+                                            &spin_lock_thread_func);
+        assert(AMP_SUCCESS == retval);
+        
+        std::size_t joinable_count = 0;
+        retval = amp_thread_array_launch_all(threads, &joinable_count);
+        assert(AMP_SUCCESS == retval);
+        
+        retval = amp_thread_array_join_all(threads, &joinable_count);
+        assert(AMP_SUCCESS == retval);
+        
+        retval = amp_thread_array_destroy(&threads, AMP_DEFAULT_ALLOCATOR);
+        assert(AMP_SUCCESS == retval);
+        
+        CHECK_EQUAL(contended_thread_count * contended_iteration_count, 
+                    data.unprotected_counter);
+        CHECK_EQUAL(0, amp_atomic_int_load(&data.lock, amp_memory_order_relaxed));
+    }
+    
+    
+    
+    namespace {
+        
+        struct message_passing_s {
+            amp_atomic_ptr_t mailbox;
+            amp_atomic_size_t received_count;
+            std::vector<std::size_t> payloads;
+        };
+        
+        void message_consumer_thread_func(void* ctxt);
+        void message_consumer_thread_func(void* ctxt)
+        {
+            struct message_passing_s* data = static_cast<struct message_passing_s*>(ctxt);
+            
+            for (std::size_t i = 0; i < data->payloads.size(); ++i) {
+                
+                void* message = NULL;
+                while (NULL == (message = amp_atomic_ptr_exchange(&data->mailbox, NULL, amp_memory_order_acquire))) {
+                    amp_thread_yield();
+                }
+                
+                // The payload written before publishing must be visible.
+                if (*static_cast<std::size_t*>(message) == i) {
+                    amp_atomic_size_fetch_add(&data->received_count, 1, amp_memory_order_relaxed);
+                }
+            }
+        }
+        
+    } // anonymous namespace
+    
+    
+    TEST(release_acquire_publishes_plain_data)
+    {
+        struct message_passing_s data;
+        amp_atomic_ptr_store(&data.mailbox, NULL, amp_memory_order_relaxed);
+        amp_atomic_size_store(&data.received_count, 0, amp_memory_order_relaxed);
+        data.payloads.resize(contended_iteration_count, ~static_cast<std::size_t>(0));
+        
+        amp_thread_t consumer = AMP_THREAD_UNINITIALIZED;
+        int retval = amp_thread_create_and_launch(&consumer,
+                                                  AMP_DEFAULT_ALLOCATOR,
+                                                  &data,
+                                                  &message_consumer_thread_func);
+        assert(AMP_SUCCESS == retval);
+        
+        for (std::size_t i = 0; i < data.payloads.size(); ++i) {
+            
+            // Wait for the consumer to take the previous message.
+            while (NULL != amp_atomic_ptr_load(&data.mailbox, amp_memory_order_acquire)) {
+                amp_thread_yield();
+            }
+            
+            data.payloads[i] = i;
+            amp_atomic_ptr_store(&data.mailbox, &data.payloads[i], amp_memory_order_release);
+        }
+        
+        retval = amp_thread_join_and_destroy(&consumer, AMP_DEFAULT_ALLOCATOR);
+        assert(AMP_SUCCESS == retval);
+        
+        CHECK_EQUAL(data.payloads.size(), 
+                    amp_atomic_size_load(&data.received_count, amp_memory_order_relaxed));
+    }
+    
+    
+    
+    namespace {
+        
+        std::size_t const fenced_field_count = 4;
+        
+        struct fenced_message_s {
+            std::size_t fields[fenced_field_count];
+            amp_atomic_size_t sequence;
+            amp_atomic_size_t acknowledged;
+            std::size_t stale_count;
+        };
+        
+        void fenced_consumer_thread_func(void* ctxt);
+        void fenced_consumer_thread_func(void* ctxt)
+        {
+            struct fenced_message_s* data = static_cast<struct fenced_message_s*>(ctxt);
+            
+            for (std::size_t i = 1; i <= contended_iteration_count; ++i) {
+                
+                while (i != amp_atomic_size_load(&data->sequence, amp_memory_order_relaxed)) {
+                    amp_thread_yield();
+                }
+                amp_atomic_thread_fence(amp_memory_order_acquire);
+                
+                // All fields written before the release fence must be 
+                // visible after the acquire fence.
+                for (std::size_t field = 0; field < fenced_field_count; ++field) {
+                    if (i != data->fields[field]) {
+                        ++(data->stale_count);
+                    }
+                }
+                
+                amp_atomic_size_store(&data->acknowledged, i, amp_memory_order_release);
+            }
+        }
+        
+    } // anonymous namespace
+    
+    
+    TEST(release_and_acquire_fences_publish_plain_data)
+    {
+        struct fenced_message_s data;
+        for (std::size_t field = 0; field < fenced_field_count; ++field) {
+            data.fields[field] = 0;
+        }
+        amp_atomic_size_store(&data.sequence, 0, amp_memory_order_relaxed);
+        amp_atomic_size_store(&data.acknowledged, 0, amp_memory_order_relaxed);
+        data.stale_count = 0;
+        
+        amp_thread_t consumer = AMP_THREAD_UNINITIALIZED;
+        int retval = amp_thread_create_and_launch(&consumer,
+                                                  AMP_DEFAULT_ALLOCATOR,
+                                                  &data,
+                                                  &fenced_consumer_thread_func);
+        assert(AMP_SUCCESS == retval);
+        
+        for (std::size_t i = 1; i <= contended_iteration_count; ++i) {
+            
+            for (std::size_t field = 0; field < fenced_field_count; ++field) {
+                data.fields[field] = i;
+            }
+            amp_atomic_thread_fence(amp_memory_order_release);
+            amp_atomic_size_store(&data.sequence, i, amp_memory_order_relaxed);
+            
+            // Don't overwrite the fields before the consumer checked them.
+            while (i != amp_atomic_size_load(&data.acknowledged, amp_memory_order_acquire)) {
+                amp_thread_yield();
+            }
+        }
+        
+        retval = amp_thread_join_and_destroy(&consumer, AMP_DEFAULT_ALLOCATOR);
+        assert(AMP_SUCCESS == retval);
+        
+        CHECK_EQUAL(0u, data.stale_count);
+    }
+    
+    
+    
+    namespace {
+        
+        struct store_buffering_s {
+            amp_atomic_size_t flags[2];
+            amp_atomic_size_t arrived_count;
+            std::vector<std::size_t> observed[2];
+        };
+        
+        struct store_buffering_thread_context_s {
+            struct store_buffering_s* shared;
+            std::size_t index;
+        };
+        
+        void store_buffering_thread_func(void* ctxt);
+        void store_buffering_thread_func(void* ctxt)
+        {
+            struct store_buffering_thread_context_s* context = static_cast<struct store_buffering_thread_context_s*>(ctxt);
+            struct store_buffering_s* shared = context->shared;
+            std::size_t const own = context->index;
+            std::size_t const other = 1 - own;
+            
+            for (std::size_t i = 1; i <= contended_iteration_count; ++i) {
+                
+                // Start each round together with the other thread.
+                amp_atomic_size_fetch_add(&shared->arrived_count, 1, amp_memory_order_acq_rel);
+                while (2 * i > amp_atomic_size_load(&shared->arrived_count, amp_memory_order_acquire)) {
+                    amp_thread_yield();
+                }
+                
+                amp_atomic_size_store(&shared->flags[own], i, amp_memory_order_seq_cst);
+                shared->observed[own][i - 1] = amp_atomic_size_load(&shared->flags[other], amp_memory_order_seq_cst);
+            }
+        }
+        
+    } // anonymous namespace
+    
+    
+    TEST(seq_cst_stores_are_not_reordered_with_later_loads)
+    {
+        struct store_buffering_s shared;
+        amp_atomic_size_store(&shared.flags[0], 0, amp_memory_order_relaxed);
+        amp_atomic_size_store(&shared.flags[1], 0, amp_memory_order_relaxed);
+        amp_atomic_size_store(&shared.arrived_count, 0, amp_memory_order_relaxed);
+        shared.observed[0].resize(contended_iteration_count, 0);
+        shared.observed[1].resize(contended_iteration_count, 0);
+        
+        struct store_buffering_thread_context_s contexts[2];
+        
+        amp_thread_array_t threads = AMP_THREAD_ARRAY_UNINITIALIZED;
+        int retval = amp_thread_array_create(&threads,
+                                             AMP_DEFAULT_ALLOCATOR,
+                                             2);
+        assert(AMP_SUCCESS == retval);
+        
+        for (std::size_t i = 0; i < 2; ++i) {
+            contexts[i].shared = &shared;
+            contexts[i].index = i;
+            
+            retval = amp_thread_array_configure(threads,
+                                                i,
+                                                1,
+                                                &contexts[i],
+                                                &store_buffering_thread_func);
+            assert(AMP_SUCCESS == retval);
+        }
+        
+        std::size_t joinable_count = 0;
+        retval = amp_thread_array_launch_all(threads, &joinable_count);
+        assert(AMP_SUCCESS == retval);
+        
+        retval = amp_thread_array_join_all(threads, &joinable_count);
+        assert(AMP_SUCCESS == retval);
+        
+        retval = amp_thread_array_destroy(&threads, AMP_DEFAULT_ALLOCATOR);
+        assert(AMP_SUCCESS == retval);
+        
+        // In every round at least one thread must see the store of the 
+        // other thread.
+        std::size_t both_stale_count = 0;
+        for (std::size_t i = 1; i <= contended_iteration_count; ++i) {
+            if ((i > shared.observed[0][i - 1]) && (i > shared.observed[1][i - 1])) {
+                ++both_stale_count;
+            }
+        }
+        
+        CHECK_EQUAL(0u, both_stale_count);
+    }
+    
+} // SUITE(amp_atomic)
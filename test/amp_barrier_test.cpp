@@ -445,4 +445,120 @@ SUITE(amp_barrier)
     }
     
     
+    
+    namespace {
+        
+        std::size_t const lockstep_round_count = 200;
+        
+        struct lockstep_shared {
+            amp_barrier_t barrier;
+            amp_mutex_t mutex;
+            std::size_t thread_count;
+            std::vector<std::size_t> arrival_counts;
+            std::vector<std::size_t> serial_counts;
+            std::size_t error_count;
+        };
+        
+        void lockstep_thread_func(void* ctxt);
+        void lockstep_thread_func(void* ctxt)
+        {
+            struct lockstep_shared* shared = static_cast<struct lockstep_shared*>(ctxt);
+            
+            for (std::size_t round = 0; round < lockstep_round_count; ++round) {
+                
+                int rc = amp_mutex_lock(shared->mutex);
+                assert(AMP_SUCCESS == rc);
+                ++(shared->arrival_counts[round]);
+                rc = amp_mutex_unlock(shared->mutex);
+                assert(AMP_SUCCESS == rc);
+                
+                int const wait_rc = amp_barrier_wait(shared->barrier);
+                
+                rc = amp_mutex_lock(shared->mutex);
+                assert(AMP_SUCCESS == rc);
+                if (AMP_BARRIER_SERIAL_THREAD == wait_rc) {
+                    ++(shared->serial_counts[round]);
+                } else if (AMP_SUCCESS != wait_rc) {
+                    ++(shared->error_count);
+                }
+                
+                // All threads must have arrived in this round but none 
+                // can have arrived in the next round before this thread.
+                if (shared->thread_count != shared->arrival_counts[round]) {
+                    ++(shared->error_count);
+                }
+                if ((round + 1 < lockstep_round_count) 
+                    && (shared->thread_count <= shared->arrival_counts[round + 1])) {
+                    ++(shared->error_count);
+                }
+                rc = amp_mutex_unlock(shared->mutex);
+                assert(AMP_SUCCESS == rc);
+            }
+        }
+        
+    } // anonymous namespace
+    
+    
+    TEST(many_rounds_keep_threads_in_lockstep)
+    {
+        // An odd thread count that isn't a power of two.
+        std::size_t const thread_count = 7;
+        
+        struct lockstep_shared shared;
+        shared.barrier = AMP_BARRIER_UNINITIALIZED;
+        shared.mutex = AMP_MUTEX_UNINITIALIZED;
+        shared.thread_count = thread_count;
+        shared.arrival_counts.resize(lockstep_round_count, 0);
+        shared.serial_counts.resize(lockstep_round_count, 0);
+        shared.error_count = 0;
+        
+        int retval = amp_barrier_create(&shared.barrier,
+                                        AMP_DEFAULT_ALLOCATOR,
+                                        static_cast<amp_barrier_count_t>(thread_count));
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_mutex_create(&shared.mutex, AMP_DEFAULT_ALLOCATOR);
+        assert(AMP_SUCCESS == retval);
+        
+        amp_thread_array_t threads = AMP_THREAD_ARRAY_UNINITIALIZED;
+        retval = amp_thread_array_create(&threads,
+                                         AMP_DEFAULT_ALLOCATOR,
+                                         thread_count);
+        assert(AMP_SUCCESS == retval);
+        
+        retval = amp_thread_array_configure(threads,
+                                            0,
+                                            thread_count,
+                                            &shared,
+                                            &lockstep_thread_func);
+        assert(AMP_SUCCESS == retval);
+        
+        std::size_t joinable_count = 0;
+        retval = amp_thread_array_launch_all(threads, &joinable_count);
+        assert(AMP_SUCCESS == retval);
+        assert(thread_count == joinable_count);
+        
+        retval = amp_thread_array_join_all(threads, &joinable_count);
+        assert(AMP_SUCCESS == retval);
+        assert(0 == joinable_count);
+        
+        retval = amp_thread_array_destroy(&threads,
+                                          AMP_DEFAULT_ALLOCATOR);
+        assert(AMP_SUCCESS == retval);
+        
+        retval = amp_mutex_destroy(&shared.mutex, AMP_DEFAULT_ALLOCATOR);
+        assert(AMP_SUCCESS == retval);
+        
+        retval = amp_barrier_destroy(&shared.barrier,
+                                     AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        CHECK_EQUAL(0u, shared.error_count);
+        for (std::size_t round = 0; round < lockstep_round_count; ++round) {
+            CHECK_EQUAL(thread_count, shared.arrival_counts[round]);
+            CHECK_EQUAL(1u, shared.serial_counts[round]);
+        }
+    }
+    
+    
 } // SUITE(amp_raw_barrier)
@@ -0,0 +1,346 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Unit tests for amp_promise and amp_future.
+ */
+
+
+#include <UnitTest++.h>
+
+#include <cassert>
+#include <cstddef>
+
+#include <amp/amp_stddef.h>
+#include <amp/amp_return_code.h>
+#include <amp/amp_thread.h>
+#include <amp/amp_thread_array.h>
+#include <amp/amp_thread_pool.h>
+#include <amp/amp_future.h>
+#include <amp/amp_raw_future.h>
+
+
+
+SUITE(amp_future)
+{
+    
+    TEST(create_and_destroy)
+    {
+        amp_promise_t promise = AMP_PROMISE_UNINITIALIZED;
+        
+        int retval = amp_promise_create(&promise, AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_promise_destroy(&promise, AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        CHECK(AMP_PROMISE_UNINITIALIZED == promise);
+    }
+    
+    
+    
+    TEST(try_get_returns_value_only_after_set)
+    {
+        struct amp_raw_future_s raw_future;
+        int retval = amp_raw_future_init(&raw_future);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        amp_future_t future = AMP_FUTURE_UNINITIALIZED;
+        retval = amp_promise_get_future(&raw_future, &future);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        int result = 42;
+        void* value = &retval;
+        retval = amp_future_try_get(future, &value);
+        CHECK_EQUAL(AMP_BUSY, retval);
+        
+        retval = amp_promise_set_value(&raw_future, &result);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_future_try_get(future, &value);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        CHECK(&result == value);
+        
+        // Waiting on a ready future returns immediately.
+        value = NULL;
+        retval = amp_future_wait(future, &value);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        CHECK(&result == value);
+        
+        retval = amp_raw_future_finalize(&raw_future);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+    }
+    
+    
+    
+    TEST(second_set_value_is_rejected)
+    {
+        amp_promise_t promise = AMP_PROMISE_UNINITIALIZED;
+        int retval = amp_promise_create(&promise, AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        int first = 1;
+        int second = 2;
+        retval = amp_promise_set_value(promise, &first);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        retval = amp_promise_set_value(promise, &second);
+        CHECK_EQUAL(AMP_BUSY, retval);
+        
+        amp_future_t future = AMP_FUTURE_UNINITIALIZED;
+        retval = amp_promise_get_future(promise, &future);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        void* value = NULL;
+        retval = amp_future_try_get(future, &value);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        CHECK(&first == value);
+        
+        retval = amp_promise_destroy(&promise, AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+    }
+    
+    
+    
+    namespace 
+    {
+        struct waiting_thread_context_s {
+            amp_future_t future;
+            void* value;
+            int return_code;
+        };
+        
+        void wait_for_future_func(void* ctxt)
+        {
+            waiting_thread_context_s* context = 
+                static_cast<waiting_thread_context_s*>(ctxt);
+            
+            context->return_code = amp_future_wait(context->future, 
+                                                   &context->value);
+        }
+        
+        
+        struct square_job_s {
+            struct amp_raw_future_s result_future;
+            int input;
+            int result;
+        };
+        
+        void square_job_func(void* ctxt)
+        {
+            square_job_s* job = static_cast<square_job_s*>(ctxt);
+            
+            job->result = job->input * job->input;
+            
+            int const retval = amp_promise_set_value(&job->result_future, 
+                                                     &job->result);
+            assert(AMP_SUCCESS == retval);
+            (void)retval;
+        }
+        
+        
+        struct set_job_s {
+            amp_promise_t promise;
+            int result;
+        };
+        
+        void set_job_func(void* ctxt)
+        {
+            set_job_s* job = static_cast<set_job_s*>(ctxt);
+            
+            int const retval = amp_promise_set_value(job->promise, 
+                                                     &job->result);
+            assert(AMP_SUCCESS == retval);
+            (void)retval;
+        }
+        
+    } // anonymous namespace
+    
+    
+    
+    TEST(set_value_wakes_all_waiting_threads)
+    {
+        std::size_t const thread_count = 4;
+        
+        amp_promise_t promise = AMP_PROMISE_UNINITIALIZED;
+        int retval = amp_promise_create(&promise, AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        amp_future_t future = AMP_FUTURE_UNINITIALIZED;
+        retval = amp_promise_get_future(promise, &future);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        waiting_thread_context_s contexts[thread_count];
+        
+        amp_thread_array_t threads = AMP_THREAD_ARRAY_UNINITIALIZED;
+        retval = amp_thread_array_create(&threads,
+                                         AMP_DEFAULT_ALLOCATOR,
+                                         thread_count);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        for (std::size_t i = 0; i < thread_count; ++i) {
+            contexts[i].future = future;
+            contexts[i].value = NULL;
+            contexts[i].return_code = AMP_UNSUPPORTED;
+            
+            retval = amp_thread_array_configure(threads,
+                                                i,
+                                                1,
+                                                &contexts[i],
+                                                &wait_for_future_func);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+        }
+        
+        retval = amp_thread_array_launch_all(threads, NULL);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        // Give the threads a chance to block before setting the value.
+        for (std::size_t i = 0; i < 100; ++i) {
+            retval = amp_thread_yield();
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+        }
+        
+        int result = 7;
+        retval = amp_promise_set_value(promise, &result);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_thread_array_join_all(threads, NULL);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        for (std::size_t i = 0; i < thread_count; ++i) {
+            CHECK_EQUAL(AMP_SUCCESS, contexts[i].return_code);
+            CHECK(&result == contexts[i].value);
+        }
+        
+        retval = amp_thread_array_destroy(&threads, AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_promise_destroy(&promise, AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+    }
+    
+    
+    
+    TEST(when_all_waits_for_results_of_pooled_jobs)
+    {
+        std::size_t const job_count = 100;
+        square_job_s jobs[job_count];
+        amp_future_t futures[job_count];
+        
+        amp_thread_pool_t pool = AMP_THREAD_POOL_UNINITIALIZED;
+        int retval = amp_thread_pool_create(&pool,
+                                            AMP_DEFAULT_ALLOCATOR,
+                                            3);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        for (std::size_t i = 0; i < job_count; ++i) {
+            retval = amp_raw_future_init(&jobs[i].result_future);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+            jobs[i].input = static_cast<int>(i);
+            jobs[i].result = 0;
+            
+            retval = amp_promise_get_future(&jobs[i].result_future, 
+                                            &futures[i]);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+        }
+        
+        for (std::size_t i = 0; i < job_count; ++i) {
+            retval = amp_thread_pool_submit(pool, &jobs[i], &square_job_func);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+        }
+        
+        retval = amp_future_when_all(futures, job_count);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        for (std::size_t i = 0; i < job_count; ++i) {
+            void* value = NULL;
+            retval = amp_future_try_get(futures[i], &value);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+            CHECK_EQUAL(static_cast<int>(i * i), *static_cast<int*>(value));
+        }
+        
+        for (std::size_t i = 0; i < job_count; ++i) {
+            retval = amp_raw_future_finalize(&jobs[i].result_future);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+        }
+        
+        retval = amp_thread_pool_destroy(&pool, AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+    }
+    
+    
+    
+    
+    TEST(promise_can_be_destroyed_right_after_getting_its_value)
+    {
+        std::size_t const round_count = 1000;
+        
+        amp_thread_pool_t pool = AMP_THREAD_POOL_UNINITIALIZED;
+        int retval = amp_thread_pool_create(&pool,
+                                            AMP_DEFAULT_ALLOCATOR,
+                                            2);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        for (std::size_t i = 0; i < round_count; ++i) {
+            set_job_s job;
+            job.promise = AMP_PROMISE_UNINITIALIZED;
+            job.result = static_cast<int>(i);
+            
+            retval = amp_promise_create(&job.promise, AMP_DEFAULT_ALLOCATOR);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+            
+            amp_future_t future = AMP_FUTURE_UNINITIALIZED;
+            retval = amp_promise_get_future(job.promise, &future);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+            
+            retval = amp_thread_pool_submit(pool, &job, &set_job_func);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+            
+            // The job might still be inside of set_value when the 
+            // promise is destroyed.
+            void* value = NULL;
+            retval = amp_future_wait(future, &value);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+            CHECK(&job.result == value);
+            
+            retval = amp_promise_destroy(&job.promise, AMP_DEFAULT_ALLOCATOR);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+        }
+        
+        retval = amp_thread_pool_destroy(&pool, AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+    }
+    
+    
+} // SUITE(amp_future)
+
+
@@ -0,0 +1,277 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Unit tests for amp_memory
+ */
+
+#include <UnitTest++.h>
+
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+
+
+#include <amp/amp_stddef.h>
+#include <amp/amp_return_code.h>
+#include <amp/amp_memory.h>
+#include <amp/amp_mutex.h>
+
+
+
+namespace {
+    
+    struct counting_allocator_context_s {
+        std::size_t alloc_count;
+        std::size_t dealloc_count;
+    };
+    
+    
+    void* counting_alloc(void* allocator_context,
+                         std::size_t bytes_to_allocate,
+                         char const* filename,
+                         int line)
+    {
+        struct counting_allocator_context_s* context = 
+            static_cast<struct counting_allocator_context_s*>(allocator_context);
+        
+        ++(context->alloc_count);
+        
+        return amp_default_alloc(AMP_DEFAULT_ALLOCATOR_CONTEXT, 
+                                 bytes_to_allocate,
+                                 filename,
+                                 line);
+    }
+    
+    
+    void* counting_calloc(void* allocator_context,
+                          std::size_t elem_count,
+                          std::size_t bytes_per_elem,
+                          char const* filename,
+                          int line)
+    {
+        struct counting_allocator_context_s* context = 
+            static_cast<struct counting_allocator_context_s*>(allocator_context);
+        
+        ++(context->alloc_count);
+        
+        return amp_default_calloc(AMP_DEFAULT_ALLOCATOR_CONTEXT, 
+                                  elem_count,
+                                  bytes_per_elem,
+                                  filename,
+                                  line);
+    }
+    
+    
+    int counting_dealloc(void* allocator_context,
+                         void* pointer,
+                         char const* filename,
+                         int line)
+    {
+        struct counting_allocator_context_s* context = 
+            static_cast<struct counting_allocator_context_s*>(allocator_context);
+        
+        ++(context->dealloc_count);
+        
+        return amp_default_dealloc(AMP_DEFAULT_ALLOCATOR_CONTEXT, 
+                                   pointer,
+                                   filename,
+                                   line);
+    }
+    
+    
+    struct counting_allocator_fixture {
+        counting_allocator_fixture()
+        :   allocator(AMP_ALLOCATOR_UNINITIALIZED)
+        {
+            context.alloc_count = 0;
+            context.dealloc_count = 0;
+            
+            int const retval = amp_allocator_create(&allocator,
+                                                    AMP_DEFAULT_ALLOCATOR,
+                                                    &context,
+                                                    counting_alloc,
+                                                    counting_calloc,
+                                                    counting_dealloc);
+            assert(AMP_SUCCESS == retval);
+            (void)retval;
+        }
+        
+        ~counting_allocator_fixture()
+        {
+            int const retval = amp_allocator_destroy(&allocator,
+                                                     AMP_DEFAULT_ALLOCATOR);
+            assert(AMP_SUCCESS == retval);
+            (void)retval;
+        }
+        
+        struct counting_allocator_context_s context;
+        amp_allocator_t allocator;
+    };
+    
+    
+    std::size_t const alignments[] = {1, 2, 8, 16, 64, 128, 4096};
+    
+} // anonymous namespace
+
+
+
+SUITE(amp_memory)
+{
+    TEST(default_calloc_is_zeroed)
+    {
+        std::size_t const elem_count = 1000;
+        int* memory = (int*)AMP_CALLOC(AMP_DEFAULT_ALLOCATOR, 
+                                       elem_count, 
+                                       sizeof(int));
+        CHECK(NULL != memory);
+        
+        std::size_t nonzero_count = 0;
+        for (std::size_t i = 0; i < elem_count; ++i) {
+            if (0 != memory[i]) {
+                ++nonzero_count;
+            }
+        }
+        CHECK_EQUAL(0u, nonzero_count);
+        
+        int const retval = AMP_DEALLOC(AMP_DEFAULT_ALLOCATOR, memory);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+    }
+    
+    
+    
+    TEST(default_aligned_alloc_is_aligned)
+    {
+        for (std::size_t i = 0; i < sizeof(alignments) / sizeof(alignments[0]); ++i) {
+            std::size_t const size = 3 * alignments[i] + 5;
+            unsigned char* memory = (unsigned char*)AMP_ALIGNED_ALLOC(AMP_DEFAULT_ALLOCATOR,
+                                                                      alignments[i],
+                                                                      size);
+            CHECK(NULL != memory);
+            CHECK_EQUAL(0u, ((std::size_t)memory) % alignments[i]);
+            
+            std::memset(memory, 0xab, size);
+            
+            int const retval = AMP_ALIGNED_DEALLOC(AMP_DEFAULT_ALLOCATOR, 
+                                                   memory);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+        }
+    }
+    
+    
+    
+    TEST_FIXTURE(counting_allocator_fixture, emulated_aligned_alloc_is_aligned)
+    {
+        for (std::size_t i = 0; i < sizeof(alignments) / sizeof(alignments[0]); ++i) {
+            std::size_t const size = 3 * alignments[i] + 5;
+            unsigned char* memory = (unsigned char*)AMP_ALIGNED_ALLOC(allocator,
+                                                                      alignments[i],
+                                                                      size);
+            CHECK(NULL != memory);
+            CHECK_EQUAL(0u, ((std::size_t)memory) % alignments[i]);
+            
+            std::memset(memory, 0xab, size);
+            
+            int const retval = AMP_ALIGNED_DEALLOC(allocator, memory);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+        }
+        
+        std::size_t const alignment_count = sizeof(alignments) / sizeof(alignments[0]);
+        CHECK_EQUAL(alignment_count, context.alloc_count);
+        CHECK_EQUAL(alignment_count, context.dealloc_count);
+        
+        int const retval = AMP_ALIGNED_DEALLOC(allocator, NULL);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        void* overflowing = AMP_ALIGNED_ALLOC(allocator, 64, ~(std::size_t)0 - 8);
+        CHECK(NULL == overflowing);
+    }
+    
+    
+    
+    TEST_FIXTURE(counting_allocator_fixture, set_aligned_funcs_replaces_emulation)
+    {
+        int retval = amp_allocator_set_aligned_funcs(allocator,
+                                                     amp_default_aligned_alloc,
+                                                     amp_default_aligned_dealloc);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        void* memory = AMP_ALIGNED_ALLOC(allocator, 
+                                         AMP_CACHE_LINE_SIZE, 
+                                         AMP_CACHE_LINE_SIZE);
+        CHECK(NULL != memory);
+        CHECK_EQUAL(0u, ((std::size_t)memory) % AMP_CACHE_LINE_SIZE);
+        
+        retval = AMP_ALIGNED_DEALLOC(allocator, memory);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        CHECK_EQUAL(0u, context.alloc_count);
+        CHECK_EQUAL(0u, context.dealloc_count);
+        
+        retval = amp_allocator_set_aligned_funcs(allocator, NULL, NULL);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        memory = AMP_ALIGNED_ALLOC(allocator, 
+                                   AMP_CACHE_LINE_SIZE, 
+                                   AMP_CACHE_LINE_SIZE);
+        retval = AMP_ALIGNED_DEALLOC(allocator, memory);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        CHECK_EQUAL(1u, context.alloc_count);
+        CHECK_EQUAL(1u, context.dealloc_count);
+    }
+    
+    
+    
+    TEST_FIXTURE(counting_allocator_fixture, primitives_are_created_and_destroyed_via_allocator)
+    {
+        amp_mutex_t mutex = AMP_MUTEX_UNINITIALIZED;
+        
+        int retval = amp_mutex_create(&mutex, allocator);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        CHECK_EQUAL(1u, context.alloc_count);
+        
+#if defined(AMP_PAD_PRIMITIVES_TO_CACHE_LINE)
+        CHECK_EQUAL(0u, ((std::size_t)mutex) % AMP_CACHE_LINE_SIZE);
+#endif
+        
+        retval = amp_mutex_destroy(&mutex, allocator);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        CHECK_EQUAL(1u, context.dealloc_count);
+    }
+    
+    
+    
+} // SUITE(amp_memory)
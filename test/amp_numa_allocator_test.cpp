@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Unit tests for amp_numa_allocator
+ */
+
+#include <UnitTest++.h>
+
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+
+
+#include <amp/amp_stddef.h>
+#include <amp/amp_return_code.h>
+#include <amp/amp_memory.h>
+#include <amp/amp_numa_allocator.h>
+#include <amp/amp_arena_allocator.h>
+
+
+
+SUITE(amp_numa_allocator)
+{
+    TEST(create_and_destroy)
+    {
+        amp_allocator_t allocator = AMP_ALLOCATOR_UNINITIALIZED;
+        
+        int retval = amp_numa_allocator_create(&allocator,
+                                               AMP_DEFAULT_ALLOCATOR,
+                                               0);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        CHECK(AMP_ALLOCATOR_UNINITIALIZED != allocator);
+        
+        retval = amp_numa_allocator_destroy(&allocator, AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        CHECK(AMP_ALLOCATOR_UNINITIALIZED == allocator);
+    }
+    
+    
+    
+    TEST(create_for_unsupported_node_fails)
+    {
+        amp_allocator_t allocator = AMP_ALLOCATOR_UNINITIALIZED;
+        
+        int const retval = amp_numa_allocator_create(&allocator,
+                                                     AMP_DEFAULT_ALLOCATOR,
+                                                     ~(std::size_t)0);
+        CHECK_EQUAL(AMP_ERROR, retval);
+    }
+    
+    
+    
+    TEST(alloc_on_node_zero_is_writable)
+    {
+        amp_allocator_t allocator = AMP_ALLOCATOR_UNINITIALIZED;
+        int retval = amp_numa_allocator_create(&allocator,
+                                               AMP_DEFAULT_ALLOCATOR,
+                                               0);
+        assert(AMP_SUCCESS == retval);
+        
+        std::size_t const sizes[] = {1, 100, 4096, 3 * 4096 + 17, 1024 * 1024};
+        
+        for (std::size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+            unsigned char* memory = (unsigned char*)AMP_ALLOC(allocator, 
+                                                              sizes[i]);
+            CHECK(NULL != memory);
+            
+            if (NULL != memory) {
+                std::memset(memory, 0xab, sizes[i]);
+                CHECK_EQUAL(0xab, memory[sizes[i] - 1]);
+                
+                retval = AMP_DEALLOC(allocator, memory);
+                CHECK_EQUAL(AMP_SUCCESS, retval);
+            }
+        }
+        
+        retval = amp_numa_allocator_destroy(&allocator, AMP_DEFAULT_ALLOCATOR);
+        assert(AMP_SUCCESS == retval);
+    }
+    
+    
+    
+    TEST(calloc_on_node_zero_is_zeroed)
+    {
+        amp_allocator_t allocator = AMP_ALLOCATOR_UNINITIALIZED;
+        int retval = amp_numa_allocator_create(&allocator,
+                                               AMP_DEFAULT_ALLOCATOR,
+                                               0);
+        assert(AMP_SUCCESS == retval);
+        
+        std::size_t const elem_count = 10000;
+        int* memory = (int*)AMP_CALLOC(allocator, elem_count, sizeof(int));
+        CHECK(NULL != memory);
+        
+        if (NULL != memory) {
+            std::size_t nonzero_count = 0;
+            for (std::size_t i = 0; i < elem_count; ++i) {
+                if (0 != memory[i]) {
+                    ++nonzero_count;
+                }
+            }
+            CHECK_EQUAL(0u, nonzero_count);
+            
+            retval = AMP_DEALLOC(allocator, memory);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+        }
+        
+        void* overflowing = AMP_CALLOC(allocator, 
+                                       ~(std::size_t)0 / 2, 
+                                       4);
+        CHECK(NULL == overflowing);
+        
+        retval = amp_numa_allocator_destroy(&allocator, AMP_DEFAULT_ALLOCATOR);
+        assert(AMP_SUCCESS == retval);
+    }
+    
+    
+    
+    
+    
+    TEST(sources_an_arena_allocator_for_small_objects)
+    {
+        amp_allocator_t node_allocator = AMP_ALLOCATOR_UNINITIALIZED;
+        int retval = amp_numa_allocator_create(&node_allocator,
+                                               AMP_DEFAULT_ALLOCATOR,
+                                               0);
+        assert(AMP_SUCCESS == retval);
+        
+        amp_allocator_t arena = AMP_ALLOCATOR_UNINITIALIZED;
+        retval = amp_arena_allocator_create(&arena,
+                                            node_allocator,
+                                            64 * 1024,
+                                            amp_arena_allocator_mode_shared);
+        assert(AMP_SUCCESS == retval);
+        
+        std::size_t const object_count = 10000;
+        std::size_t written_count = 0;
+        for (std::size_t i = 0; i < object_count; ++i) {
+            std::size_t* object = (std::size_t*)AMP_ALLOC(arena, 
+                                                          4 * sizeof(std::size_t));
+            if (NULL != object) {
+                object[3] = i;
+                ++written_count;
+            }
+        }
+        CHECK_EQUAL(object_count, written_count);
+        
+        retval = amp_arena_allocator_destroy(&arena, node_allocator);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_numa_allocator_destroy(&node_allocator, AMP_DEFAULT_ALLOCATOR);
+        assert(AMP_SUCCESS == retval);
+    }
+    
+} // SUITE(amp_numa_allocator)
+
+
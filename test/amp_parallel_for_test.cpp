@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Unit tests for amp_parallel_for.
+ */
+
+
+#include <UnitTest++.h>
+
+#include <cstddef>
+#include <vector>
+
+#include <amp/amp_stddef.h>
+#include <amp/amp_return_code.h>
+#include <amp/amp_thread_pool.h>
+#include <amp/amp_parallel_for.h>
+
+
+
+SUITE(amp_parallel_for)
+{
+    
+    namespace 
+    {
+        amp_parallel_for_schedule_t const schedules[] = {
+            amp_parallel_for_schedule_static,
+            amp_parallel_for_schedule_dynamic,
+            amp_parallel_for_schedule_guided
+        };
+        std::size_t const schedule_count = sizeof(schedules) / sizeof(schedules[0]);
+        
+        
+        struct visit_context_s {
+            std::size_t range_begin;
+            std::size_t grain;
+            std::size_t range_end;
+            std::vector<int> visit_counts;
+            // Set if a chunk other than the one ending the range was smaller
+            // than grain.
+            bool small_chunk_found;
+        };
+        
+        // Chunks are disjoint, so every index is only written by one thread.
+        void visit_body(void* ctxt, std::size_t begin, std::size_t end)
+        {
+            visit_context_s* context = static_cast<visit_context_s*>(ctxt);
+            
+            if ((end - begin < context->grain) && (end != context->range_end)) {
+                context->small_chunk_found = true;
+            }
+            
+            for (std::size_t i = begin; i < end; ++i) {
+                ++(context->visit_counts[i - context->range_begin]);
+            }
+        }
+        
+        
+        // Runs a loop over the range and checks that every index has been
+        // visited exactly once.
+        void check_all_visited_once(amp_thread_pool_t pool,
+                                    std::size_t range_begin,
+                                    std::size_t range_end,
+                                    std::size_t grain,
+                                    amp_parallel_for_schedule_t schedule)
+        {
+            visit_context_s context;
+            context.range_begin = range_begin;
+            context.range_end = range_end;
+            context.grain = grain;
+            context.visit_counts.assign(range_end - range_begin, 0);
+            context.small_chunk_found = false;
+            
+            int const retval = amp_parallel_for(pool,
+                                                range_begin,
+                                                range_end,
+                                                grain,
+                                                &visit_body,
+                                                &context,
+                                                schedule);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+            CHECK(!context.small_chunk_found);
+            
+            for (std::size_t i = 0; i < range_end - range_begin; ++i) {
+                CHECK_EQUAL(1, context.visit_counts[i]);
+            }
+        }
+        
+    } // anonymous namespace
+    
+    
+    
+    TEST(all_schedules_visit_every_index_once)
+    {
+        amp_thread_pool_t pool = AMP_THREAD_POOL_UNINITIALIZED;
+        int retval = amp_thread_pool_create(&pool,
+                                            AMP_DEFAULT_ALLOCATOR,
+                                            4);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        std::size_t const grains[] = {0, 1, 3, 64, 5000};
+        std::size_t const grain_count = sizeof(grains) / sizeof(grains[0]);
+        
+        for (std::size_t s = 0; s < schedule_count; ++s) {
+            for (std::size_t g = 0; g < grain_count; ++g) {
+                check_all_visited_once(pool, 0, 1000, grains[g], schedules[s]);
+                check_all_visited_once(pool, 17, 18, grains[g], schedules[s]);
+                check_all_visited_once(pool, 100, 10007, grains[g], schedules[s]);
+            }
+        }
+        
+        retval = amp_thread_pool_destroy(&pool,
+                                         AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+    }
+    
+    
+    
+    TEST(empty_range_does_not_call_body)
+    {
+        amp_thread_pool_t pool = AMP_THREAD_POOL_UNINITIALIZED;
+        int retval = amp_thread_pool_create(&pool,
+                                            AMP_DEFAULT_ALLOCATOR,
+                                            2);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        for (std::size_t s = 0; s < schedule_count; ++s) {
+            visit_context_s context;
+            context.range_begin = 5;
+            context.range_end = 5;
+            context.grain = 1;
+            context.small_chunk_found = false;
+            
+            // The body would access the empty visit_counts if called.
+            retval = amp_parallel_for(pool,
+                                      5,
+                                      5,
+                                      1,
+                                      &visit_body,
+                                      &context,
+                                      schedules[s]);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+        }
+        
+        retval = amp_thread_pool_destroy(&pool,
+                                         AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+    }
+    
+    
+    
+    TEST(calling_thread_completes_loop_on_shut_down_pool)
+    {
+        amp_thread_pool_t pool = AMP_THREAD_POOL_UNINITIALIZED;
+        int retval = amp_thread_pool_create(&pool,
+                                            AMP_DEFAULT_ALLOCATOR,
+                                            3);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_thread_pool_shutdown(pool);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        for (std::size_t s = 0; s < schedule_count; ++s) {
+            check_all_visited_once(pool, 0, 1000, 10, schedules[s]);
+        }
+        
+        retval = amp_thread_pool_destroy(&pool,
+                                         AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+    }
+    
+    
+} // SUITE(amp_parallel_for)
+
+
@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Unit tests for amp_parallel_reduce and amp_parallel_scan.
+ */
+
+
+#include <UnitTest++.h>
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+#include <amp/amp_stddef.h>
+#include <amp/amp_return_code.h>
+#include <amp/amp_thread_pool.h>
+#include <amp/amp_parallel_reduce.h>
+
+
+
+SUITE(amp_parallel_reduce)
+{
+    
+    namespace 
+    {
+        // Crosses the block boundaries of the default minimal block size.
+        std::size_t const element_counts[] = {0, 1, 7, 4095, 4097, 30001};
+        std::size_t const element_count_count = sizeof(element_counts) / sizeof(element_counts[0]);
+        
+        
+        void add_unsigned(void* /* context */, void* accumulator, void const* value)
+        {
+            *static_cast<unsigned int*>(accumulator) += *static_cast<unsigned int const*>(value);
+        }
+        
+        
+        void min_int(void* /* context */, void* accumulator, void const* value)
+        {
+            int* acc = static_cast<int*>(accumulator);
+            int const v = *static_cast<int const*>(value);
+            
+            if (v < *acc) {
+                *acc = v;
+            }
+        }
+        
+        
+        // 2x2 matrix product modulo 2^32 - associative but not commutative
+        // so combining in the wrong order changes the result.
+        struct matrix_s {
+            unsigned int m[4];
+        };
+        
+        void multiply_matrices(void* /* context */, void* accumulator, void const* value)
+        {
+            matrix_s* a = static_cast<matrix_s*>(accumulator);
+            matrix_s const* b = static_cast<matrix_s const*>(value);
+            matrix_s const c = *a;
+            
+            a->m[0] = c.m[0] * b->m[0] + c.m[1] * b->m[2];
+            a->m[1] = c.m[0] * b->m[1] + c.m[1] * b->m[3];
+            a->m[2] = c.m[2] * b->m[0] + c.m[3] * b->m[2];
+            a->m[3] = c.m[2] * b->m[1] + c.m[3] * b->m[3];
+        }
+        
+        matrix_s const identity_matrix = {{1, 0, 0, 1}};
+        
+        matrix_s make_matrix(std::size_t i)
+        {
+            matrix_s const matrix = {{
+                static_cast<unsigned int>(i % 7 + 1), 
+                static_cast<unsigned int>(i % 3), 
+                static_cast<unsigned int>(i % 5), 
+                1
+            }};
+            return matrix;
+        }
+        
+        bool equal_matrices(matrix_s const& a, matrix_s const& b)
+        {
+            return (a.m[0] == b.m[0]) && (a.m[1] == b.m[1]) 
+                && (a.m[2] == b.m[2]) && (a.m[3] == b.m[3]);
+        }
+        
+        
+        
+        class pool_fixture {
+        public:
+            pool_fixture()
+            :   pool(AMP_THREAD_POOL_UNINITIALIZED)
+            {
+                int const retval = amp_thread_pool_create(&pool,
+                                                          AMP_DEFAULT_ALLOCATOR,
+                                                          3);
+                assert(AMP_SUCCESS == retval);
+                (void)retval;
+            }
+            
+            ~pool_fixture()
+            {
+                int const retval = amp_thread_pool_destroy(&pool,
+                                                           AMP_DEFAULT_ALLOCATOR);
+                assert(AMP_SUCCESS == retval);
+                (void)retval;
+            }
+            
+            amp_thread_pool_t pool;
+        };
+        
+    } // anonymous namespace
+    
+    
+    
+    TEST_FIXTURE(pool_fixture, reduce_sums_and_finds_minimum)
+    {
+        for (std::size_t c = 0; c < element_count_count; ++c) {
+            std::size_t const count = element_counts[c];
+            std::vector<unsigned int> values(count + 1);
+            std::vector<int> signed_values(count + 1);
+            unsigned int expected_sum = 0;
+            int expected_min = 1000;
+            
+            for (std::size_t i = 0; i < count; ++i) {
+                values[i] = static_cast<unsigned int>(i * 31 % 101);
+                signed_values[i] = static_cast<int>(i * 17 % 997) - 500;
+                expected_sum += values[i];
+                if (signed_values[i] < expected_min) {
+                    expected_min = signed_values[i];
+                }
+            }
+            
+            unsigned int const zero = 0;
+            unsigned int sum = 1;
+            int retval = amp_parallel_reduce(pool,
+                                             AMP_DEFAULT_ALLOCATOR,
+                                             &values[0],
+                                             count,
+                                             sizeof(unsigned int),
+                                             &zero,
+                                             &add_unsigned,
+                                             NULL,
+                                             &sum);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+            CHECK_EQUAL(expected_sum, sum);
+            
+            int const min_identity = 1000;
+            int min = 0;
+            retval = amp_parallel_reduce(pool,
+                                         AMP_DEFAULT_ALLOCATOR,
+                                         &signed_values[0],
+                                         count,
+                                         sizeof(int),
+                                         &min_identity,
+                                         &min_int,
+                                         NULL,
+                                         &min);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+            CHECK_EQUAL(expected_min, min);
+        }
+    }
+    
+    
+    
+    TEST_FIXTURE(pool_fixture, reduce_keeps_element_order)
+    {
+        for (std::size_t c = 0; c < element_count_count; ++c) {
+            std::size_t const count = element_counts[c];
+            std::vector<matrix_s> matrices(count + 1);
+            matrix_s expected = identity_matrix;
+            
+            for (std::size_t i = 0; i < count; ++i) {
+                matrices[i] = make_matrix(i);
+                multiply_matrices(NULL, &expected, &matrices[i]);
+            }
+            
+            matrix_s product = make_matrix(3);
+            int const retval = amp_parallel_reduce(pool,
+                                                   AMP_DEFAULT_ALLOCATOR,
+                                                   &matrices[0],
+                                                   count,
+                                                   sizeof(matrix_s),
+                                                   &identity_matrix,
+                                                   &multiply_matrices,
+                                                   NULL,
+                                                   &product);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+            CHECK(equal_matrices(expected, product));
+        }
+    }
+    
+    
+    
+    TEST_FIXTURE(pool_fixture, inclusive_and_exclusive_scans)
+    {
+        amp_parallel_scan_kind_t const kinds[] = {
+            amp_parallel_scan_inclusive,
+            amp_parallel_scan_exclusive
+        };
+        
+        for (std::size_t k = 0; k < 2; ++k) {
+            for (std::size_t c = 0; c < element_count_count; ++c) {
+                std::size_t const count = element_counts[c];
+                std::vector<matrix_s> input(count + 1);
+                std::vector<matrix_s> output(count + 1);
+                std::vector<matrix_s> expected(count + 1);
+                matrix_s running = identity_matrix;
+                
+                for (std::size_t i = 0; i < count; ++i) {
+                    input[i] = make_matrix(i);
+                    if (amp_parallel_scan_exclusive == kinds[k]) {
+                        expected[i] = running;
+                        multiply_matrices(NULL, &running, &input[i]);
+                    } else {
+                        multiply_matrices(NULL, &running, &input[i]);
+                        expected[i] = running;
+                    }
+                }
+                
+                int retval = amp_parallel_scan(pool,
+                                               AMP_DEFAULT_ALLOCATOR,
+                                               &input[0],
+                                               &output[0],
+                                               count,
+                                               sizeof(matrix_s),
+                                               &identity_matrix,
+                                               &multiply_matrices,
+                                               NULL,
+                                               kinds[k]);
+                CHECK_EQUAL(AMP_SUCCESS, retval);
+                
+                // In place.
+                retval = amp_parallel_scan(pool,
+                                           AMP_DEFAULT_ALLOCATOR,
+                                           &input[0],
+                                           &input[0],
+                                           count,
+                                           sizeof(matrix_s),
+                                           &identity_matrix,
+                                           &multiply_matrices,
+                                           NULL,
+                                           kinds[k]);
+                CHECK_EQUAL(AMP_SUCCESS, retval);
+                
+                for (std::size_t i = 0; i < count; ++i) {
+                    CHECK(equal_matrices(expected[i], output[i]));
+                    CHECK(equal_matrices(expected[i], input[i]));
+                }
+            }
+        }
+    }
+    
+    
+} // SUITE(amp_parallel_reduce)
+
+
@@ -41,12 +41,23 @@
 
 #include <cassert>
 #include <cstddef>
+#include <cstdio>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#   include <stdlib.h>
+#   include <unistd.h>
+#   include <sys/stat.h>
+#endif
 
 
 #include <amp/amp_stddef.h>
 #include <amp/amp_return_code.h>
 #include <amp/amp_memory.h>
 #include <amp/amp_platform.h>
+#include <amp/amp_thread.h>
 
 
 
@@ -162,6 +173,160 @@ namespace {
     
     
     
+#if defined(__linux__)
+    
+    /**
+     * Builds a fake /sys tree in a temporary directory describing 2 packages
+     * with 2 cores each and 2 hardware threads per core. Hardware thread i
+     * lives on package (i % 4) / 2 and core i % 2, its sibling is 
+     * (i + 4) % 8. Hardware threads 3 and 7 (the second core of package 1)
+     * are offline. Each hardware thread has a level 1 data and instruction
+     * cache and a level 2 cache shared with its sibling, and a level 3 cache
+     * shared by its package. Each package is a NUMA node.
+     *
+     * Tests add cgroup files via make_directory and write_file.
+     */
+    class amp_platform_sysfs_fixture {
+    public:
+        
+        amp_platform_sysfs_fixture()
+        :   root()
+        ,   created_paths()
+        ,   platform(AMP_PLATFORM_UNINITIALIZED)
+        {
+            char root_template[] = "/tmp/amp_platform_sysfs_XXXXXX";
+            char const* const root_path = mkdtemp(root_template);
+            assert(NULL != root_path);
+            root = root_path;
+            
+            make_directory("/sys/devices/system/cpu");
+            write_file("/sys/devices/system/cpu/present", "0-7\n");
+            write_file("/sys/devices/system/cpu/online", "0-2,4-6\n");
+            
+            for (unsigned int i = 0; i < 8; ++i) {
+                char cpu_path[64];
+                char value[32];
+                std::string topology_path;
+                
+                std::sprintf(cpu_path, "/sys/devices/system/cpu/cpu%u", i);
+                topology_path = std::string(cpu_path) + "/topology";
+                make_directory(cpu_path);
+                make_directory(topology_path);
+                
+                std::sprintf(value, "%u\n", (i % 4) / 2);
+                write_file(topology_path + "/physical_package_id", value);
+                std::sprintf(value, "%u\n", i % 2);
+                write_file(topology_path + "/core_id", value);
+                std::sprintf(value, "%u,%u\n", i % 4, i % 4 + 4);
+                write_file(topology_path + "/thread_siblings_list", value);
+                
+                std::string const cache_path = std::string(cpu_path) + "/cache";
+                make_directory(cache_path);
+                write_cache(cache_path + "/index0", "1", "Data", "32K", "8", value);
+                write_cache(cache_path + "/index1", "1", "Instruction", "32K", "8", value);
+                write_cache(cache_path + "/index2", "2", "Unified", "1024K", "16", value);
+                write_cache(cache_path + "/index3", "3", "Unified", "8M", "16", 
+                            (i % 4) < 2 ? "0-1,4-5\n" : "2-3,6-7\n");
+            }
+            
+            make_directory("/sys/devices/system/node");
+            write_file("/sys/devices/system/node/online", "0-1\n");
+            make_directory("/sys/devices/system/node/node0");
+            write_file("/sys/devices/system/node/node0/cpulist", "0-1,4-5\n");
+            write_file("/sys/devices/system/node/node0/distance", "10 21\n");
+            make_directory("/sys/devices/system/node/node1");
+            write_file("/sys/devices/system/node/node1/cpulist", "2-3,6-7\n");
+            write_file("/sys/devices/system/node/node1/distance", "21 10\n");
+            
+            int const error_code = amp_platform_create_with_filesystem_root(&platform,
+                                                                            AMP_DEFAULT_ALLOCATOR,
+                                                                            root.c_str());
+            assert(AMP_SUCCESS == error_code);
+            (void)error_code;
+        }
+        
+        
+        virtual ~amp_platform_sysfs_fixture()
+        {
+            int const error_code = amp_platform_destroy(&platform,
+                                                        AMP_DEFAULT_ALLOCATOR);
+            assert(AMP_SUCCESS == error_code);
+            (void)error_code;
+            
+            while (!created_paths.empty()) {
+                (void)std::remove(created_paths.back().c_str());
+                created_paths.pop_back();
+            }
+            (void)rmdir(root.c_str());
+        }
+        
+        
+        // Creates relative_path and all missing parent directories.
+        void make_directory(std::string const& relative_path)
+        {
+            std::string::size_type separator = 0;
+            
+            do {
+                separator = relative_path.find('/', separator + 1);
+                
+                std::string const path = root + relative_path.substr(0, separator);
+                struct stat status;
+                
+                if (0 != stat(path.c_str(), &status)) {
+                    int const error_code = mkdir(path.c_str(), 0700);
+                    assert(0 == error_code);
+                    (void)error_code;
+                    
+                    created_paths.push_back(path);
+                }
+            } while (std::string::npos != separator);
+        }
+        
+        
+        void write_file(std::string const& relative_path,
+                        char const* contents)
+        {
+            std::string const path = root + relative_path;
+            std::FILE* file = std::fopen(path.c_str(), "w");
+            assert(NULL != file);
+            
+            created_paths.push_back(path);
+            
+            (void)std::fputs(contents, file);
+            (void)std::fclose(file);
+        }
+        
+        
+        void write_cache(std::string const& index_path,
+                         char const* level,
+                         char const* type,
+                         char const* size,
+                         char const* ways,
+                         char const* shared_cpu_list)
+        {
+            make_directory(index_path);
+            write_file(index_path + "/level", level);
+            write_file(index_path + "/type", type);
+            write_file(index_path + "/size", size);
+            write_file(index_path + "/coherency_line_size", "64\n");
+            write_file(index_path + "/ways_of_associativity", ways);
+            write_file(index_path + "/shared_cpu_list", shared_cpu_list);
+        }
+        
+        
+        std::string root;
+        std::vector<std::string> created_paths;
+        amp_platform_t platform;
+        
+    private:
+        amp_platform_sysfs_fixture(amp_platform_sysfs_fixture const&); // =0
+        amp_platform_sysfs_fixture& operator=(amp_platform_sysfs_fixture const&); // =0
+    };
+    
+#endif // defined(__linux__)
+    
+    
+    
 } // anonymous namespace
 
 
@@ -325,15 +490,426 @@ SUITE(amp_platform)
                                                      &active_core_count);
         assert(AMP_SUCCESS == retcode || AMP_UNSUPPORTED == retcode);
         
-        size_t const max_count = std::max(std::max(installed_hwthread_count, active_hwthread_count), 
-                                          std::max(installed_core_count, active_core_count));
+        size_t expected_level = std::max(std::max(installed_hwthread_count, active_hwthread_count), 
+                                         std::max(installed_core_count, active_core_count));
+        
+        size_t affinity_count = 0;
+        retcode = amp_platform_get_affinity_hwthread_count(platform,
+                                                           &affinity_count);
+        assert(AMP_SUCCESS == retcode || AMP_UNSUPPORTED == retcode);
+        if (AMP_SUCCESS == retcode) {
+            expected_level = std::min(expected_level, affinity_count);
+        }
+        
+        size_t quota_us = 0;
+        size_t period_us = 0;
+        retcode = amp_platform_get_cpu_quota(platform, &quota_us, &period_us);
+        assert(AMP_SUCCESS == retcode || AMP_UNSUPPORTED == retcode);
+        if (AMP_SUCCESS == retcode) {
+            size_t const quota_count = std::max((quota_us + period_us - 1) / period_us,
+                                                (size_t)1);
+            expected_level = std::min(expected_level, quota_count);
+        }
         
         size_t concurrency_level = 0;
         retcode = amp_platform_get_concurrency_level(platform, 
                                                      &concurrency_level);
         assert(AMP_SUCCESS == retcode || AMP_UNSUPPORTED == retcode);
         
-        CHECK_EQUAL(max_count, concurrency_level);
+        CHECK_EQUAL(expected_level, concurrency_level);
+    }
+    
+    
+    
+    TEST_FIXTURE(amp_platform_test_fixture, hwthread_zero_is_its_own_sibling_if_supported)
+    {
+        struct amp_thread_affinity_s siblings;
+        int retcode = amp_thread_affinity_clear(&siblings);
+        assert(AMP_SUCCESS == retcode);
+        
+        retcode = amp_platform_get_hwthread_siblings(platform, 0, &siblings);
+        
+        if (AMP_SUCCESS == retcode) {
+            CHECK(amp_thread_affinity_contains_cpu(&siblings, 0));
+        } else {
+            CHECK_EQUAL(AMP_UNSUPPORTED, retcode);
+        }
+    }
+    
+    
+    
+    TEST_FIXTURE(amp_platform_test_fixture, cache_line_size_is_power_of_two_if_supported)
+    {
+        size_t line_size = 0;
+        int const retcode = amp_platform_get_cache_line_size(platform, 
+                                                             &line_size);
+        
+        if (AMP_SUCCESS == retcode) {
+            CHECK(0u != line_size);
+            CHECK_EQUAL(0u, line_size & (line_size - 1));
+        } else {
+            CHECK_EQUAL(AMP_UNSUPPORTED, retcode);
+        }
+    }
+    
+    
+    
+    TEST_FIXTURE(amp_platform_test_fixture, compile_time_cache_line_size_covers_reported_line_size)
+    {
+        size_t line_size = 0;
+        int const retcode = amp_platform_get_cache_line_size(platform, 
+                                                             &line_size);
+        
+        // Padding to AMP_CACHE_LINE_SIZE only separates data on different
+        // cache lines if it is a multiple of the actual line size.
+        if (AMP_SUCCESS == retcode) {
+            CHECK(0u != line_size);
+            CHECK_EQUAL(0u, static_cast<size_t>(AMP_CACHE_LINE_SIZE) % line_size);
+        } else {
+            CHECK_EQUAL(AMP_UNSUPPORTED, retcode);
+        }
+    }
+    
+    
+    
+    TEST(missing_filesystem_root_has_no_package_count)
+    {
+        amp_platform_t platform = AMP_PLATFORM_UNINITIALIZED;
+        int retcode = amp_platform_create_with_filesystem_root(&platform,
+                                                               AMP_DEFAULT_ALLOCATOR,
+                                                               "/amp_nonexistent_sysfs_root");
+        assert(AMP_SUCCESS == retcode);
+        
+        size_t package_count = 42;
+        retcode = amp_platform_get_installed_package_count(platform, 
+                                                           &package_count);
+        CHECK_EQUAL(AMP_UNSUPPORTED, retcode);
+        CHECK_EQUAL(42u, package_count);
+        
+        retcode = amp_platform_destroy(&platform, AMP_DEFAULT_ALLOCATOR);
+        assert(AMP_SUCCESS == retcode);
+    }
+    
+    
+    
+#if defined(__linux__)
+    
+    TEST_FIXTURE(amp_platform_sysfs_fixture, sysfs_counts)
+    {
+        size_t count = 0;
+        int retcode = amp_platform_get_installed_package_count(platform,
+                                                               &count);
+        if (AMP_UNSUPPORTED == retcode) {
+            // Backend doesn't read sysfs.
+            return;
+        }
+        CHECK_EQUAL(AMP_SUCCESS, retcode);
+        CHECK_EQUAL(2u, count);
+        
+        retcode = amp_platform_get_installed_hwthread_count(platform, &count);
+        CHECK_EQUAL(AMP_SUCCESS, retcode);
+        CHECK_EQUAL(8u, count);
+        
+        retcode = amp_platform_get_active_hwthread_count(platform, &count);
+        CHECK_EQUAL(AMP_SUCCESS, retcode);
+        CHECK_EQUAL(6u, count);
+        
+        retcode = amp_platform_get_installed_core_count(platform, &count);
+        CHECK_EQUAL(AMP_SUCCESS, retcode);
+        CHECK_EQUAL(4u, count);
+        
+        retcode = amp_platform_get_active_core_count(platform, &count);
+        CHECK_EQUAL(AMP_SUCCESS, retcode);
+        CHECK_EQUAL(3u, count);
+        
+        // The fixture has no cgroup quota but the affinity mask of the test
+        // process limits the level.
+        size_t affinity_count = 8;
+        retcode = amp_platform_get_affinity_hwthread_count(platform, 
+                                                           &affinity_count);
+        CHECK_EQUAL(AMP_SUCCESS, retcode);
+        
+        retcode = amp_platform_get_concurrency_level(platform, &count);
+        CHECK_EQUAL(AMP_SUCCESS, retcode);
+        CHECK_EQUAL(std::min(affinity_count, (size_t)8), count);
+    }
+    
+    
+    
+    TEST_FIXTURE(amp_platform_sysfs_fixture, sysfs_hwthread_topology_and_siblings)
+    {
+        size_t package_id = 42;
+        size_t core_id = 42;
+        int retcode = amp_platform_get_hwthread_topology(platform,
+                                                         6,
+                                                         &package_id,
+                                                         &core_id);
+        if (AMP_UNSUPPORTED == retcode) {
+            // Backend doesn't read sysfs.
+            return;
+        }
+        CHECK_EQUAL(AMP_SUCCESS, retcode);
+        CHECK_EQUAL(1u, package_id);
+        CHECK_EQUAL(0u, core_id);
+        
+        retcode = amp_platform_get_hwthread_topology(platform,
+                                                     8,
+                                                     &package_id,
+                                                     &core_id);
+        CHECK_EQUAL(AMP_ERROR, retcode);
+        
+        struct amp_thread_affinity_s siblings;
+        retcode = amp_platform_get_hwthread_siblings(platform, 1, &siblings);
+        CHECK_EQUAL(AMP_SUCCESS, retcode);
+        CHECK_EQUAL(2u, amp_thread_affinity_cpu_count(&siblings));
+        CHECK(amp_thread_affinity_contains_cpu(&siblings, 1));
+        CHECK(amp_thread_affinity_contains_cpu(&siblings, 5));
+        
+        retcode = amp_platform_get_hwthread_siblings(platform, 8, &siblings);
+        CHECK_EQUAL(AMP_ERROR, retcode);
+    }
+    
+    TEST_FIXTURE(amp_platform_sysfs_fixture, sysfs_caches)
+    {
+        size_t count = 0;
+        int retcode = amp_platform_get_hwthread_cache_count(platform,
+                                                            6,
+                                                            &count);
+        if (AMP_UNSUPPORTED == retcode) {
+            // Backend doesn't read sysfs.
+            return;
+        }
+        CHECK_EQUAL(AMP_SUCCESS, retcode);
+        CHECK_EQUAL(4u, count);
+        
+        retcode = amp_platform_get_cache_line_size(platform, &count);
+        CHECK_EQUAL(AMP_SUCCESS, retcode);
+        CHECK_EQUAL(64u, count);
+        
+        struct amp_platform_cache_s cache;
+        retcode = amp_platform_get_hwthread_cache(platform, 6, 1, &cache);
+        CHECK_EQUAL(AMP_SUCCESS, retcode);
+        CHECK_EQUAL(1u, cache.level);
+        CHECK_EQUAL(amp_platform_cache_type_instruction, cache.type);
+        CHECK_EQUAL(32u * 1024u, cache.size);
+        
+        retcode = amp_platform_get_hwthread_cache(platform, 6, 3, &cache);
+        CHECK_EQUAL(AMP_SUCCESS, retcode);
+        CHECK_EQUAL(3u, cache.level);
+        CHECK_EQUAL(amp_platform_cache_type_unified, cache.type);
+        CHECK_EQUAL(8u * 1024u * 1024u, cache.size);
+        CHECK_EQUAL(64u, cache.line_size);
+        CHECK_EQUAL(16u, cache.associativity);
+        
+        retcode = amp_platform_get_hwthread_cache(platform, 6, 4, &cache);
+        CHECK_EQUAL(AMP_ERROR, retcode);
+        
+        struct amp_thread_affinity_s sharing;
+        retcode = amp_platform_get_hwthread_cache_sharing(platform, 6, 3, &sharing);
+        CHECK_EQUAL(AMP_SUCCESS, retcode);
+        CHECK_EQUAL(4u, amp_thread_affinity_cpu_count(&sharing));
+        CHECK(amp_thread_affinity_contains_cpu(&sharing, 2));
+        CHECK(amp_thread_affinity_contains_cpu(&sharing, 3));
+        CHECK(amp_thread_affinity_contains_cpu(&sharing, 6));
+        CHECK(amp_thread_affinity_contains_cpu(&sharing, 7));
+    }
+    
+    TEST_FIXTURE(amp_platform_sysfs_fixture, sysfs_numa_nodes)
+    {
+        size_t node_count = 0;
+        int retcode = amp_platform_get_numa_node_count(platform, &node_count);
+        if (AMP_UNSUPPORTED == retcode) {
+            // Backend doesn't read sysfs.
+            return;
+        }
+        CHECK_EQUAL(AMP_SUCCESS, retcode);
+        CHECK_EQUAL(2u, node_count);
+        
+        struct amp_thread_affinity_s hwthreads;
+        retcode = amp_platform_get_numa_node_hwthreads(platform, 1, &hwthreads);
+        CHECK_EQUAL(AMP_SUCCESS, retcode);
+        CHECK_EQUAL(4u, amp_thread_affinity_cpu_count(&hwthreads));
+        CHECK(amp_thread_affinity_contains_cpu(&hwthreads, 2));
+        CHECK(amp_thread_affinity_contains_cpu(&hwthreads, 7));
+        
+        retcode = amp_platform_get_numa_node_hwthreads(platform, 2, &hwthreads);
+        CHECK_EQUAL(AMP_ERROR, retcode);
+        
+        size_t distance = 0;
+        retcode = amp_platform_get_numa_node_distance(platform, 0, 0, &distance);
+        CHECK_EQUAL(AMP_SUCCESS, retcode);
+        CHECK_EQUAL(10u, distance);
+        
+        retcode = amp_platform_get_numa_node_distance(platform, 1, 0, &distance);
+        CHECK_EQUAL(AMP_SUCCESS, retcode);
+        CHECK_EQUAL(21u, distance);
+        
+        retcode = amp_platform_get_numa_node_distance(platform, 0, 2, &distance);
+        CHECK_EQUAL(AMP_ERROR, retcode);
+        
+        size_t node = 42;
+        retcode = amp_platform_get_hwthread_numa_node(platform, 6, &node);
+        CHECK_EQUAL(AMP_SUCCESS, retcode);
+        CHECK_EQUAL(1u, node);
+        
+        retcode = amp_platform_get_hwthread_numa_node(platform, 8, &node);
+        CHECK_EQUAL(AMP_ERROR, retcode);
+    }
+    
+    TEST_FIXTURE(amp_platform_sysfs_fixture, cgroup_without_quota_is_unsupported)
+    {
+        make_directory("/proc/self");
+        write_file("/proc/self/cgroup", "0::/\n");
+        make_directory("/sys/fs/cgroup");
+        write_file("/sys/fs/cgroup/cpu.max", "max 100000\n");
+        
+        size_t quota_us = 42;
+        size_t period_us = 42;
+        int const retcode = amp_platform_get_cpu_quota(platform, 
+                                                       &quota_us, 
+                                                       &period_us);
+        CHECK_EQUAL(AMP_UNSUPPORTED, retcode);
+        CHECK_EQUAL(42u, quota_us);
+        CHECK_EQUAL(42u, period_us);
+    }
+    
+    
+    
+    TEST_FIXTURE(amp_platform_sysfs_fixture, cgroup_v2_quota_caps_concurrency_level)
+    {
+        make_directory("/proc/self");
+        write_file("/proc/self/cgroup", "0::/\n");
+        make_directory("/sys/fs/cgroup");
+        write_file("/sys/fs/cgroup/cpu.max", "150000 100000\n");
+        
+        size_t quota_us = 0;
+        size_t period_us = 0;
+        int retcode = amp_platform_get_cpu_quota(platform, 
+                                                 &quota_us, 
+                                                 &period_us);
+        if (AMP_UNSUPPORTED == retcode) {
+            // Backend doesn't read cgroups.
+            return;
+        }
+        CHECK_EQUAL(AMP_SUCCESS, retcode);
+        CHECK_EQUAL(150000u, quota_us);
+        CHECK_EQUAL(100000u, period_us);
+        
+        size_t level = 0;
+        retcode = amp_platform_get_concurrency_level(platform, &level);
+        CHECK_EQUAL(AMP_SUCCESS, retcode);
+        CHECK(1u <= level);
+        CHECK(2u >= level);
+    }
+    
+    
+    
+    TEST_FIXTURE(amp_platform_sysfs_fixture, cgroup_v2_quota_of_ancestor_limits_nested_cgroup)
+    {
+        make_directory("/proc/self");
+        write_file("/proc/self/cgroup", "0::/kubepods/pod1/container\n");
+        make_directory("/sys/fs/cgroup/kubepods/pod1/container");
+        write_file("/sys/fs/cgroup/kubepods/cpu.max", "800000 100000\n");
+        write_file("/sys/fs/cgroup/kubepods/pod1/cpu.max", "400000 100000\n");
+        write_file("/sys/fs/cgroup/kubepods/pod1/container/cpu.max", "max 100000\n");
+        
+        size_t quota_us = 0;
+        size_t period_us = 0;
+        int const retcode = amp_platform_get_cpu_quota(platform, 
+                                                       &quota_us, 
+                                                       &period_us);
+        if (AMP_UNSUPPORTED == retcode) {
+            // Backend doesn't read cgroups.
+            return;
+        }
+        CHECK_EQUAL(AMP_SUCCESS, retcode);
+        CHECK_EQUAL(400000u, quota_us);
+        CHECK_EQUAL(100000u, period_us);
+    }
+    
+    
+    
+    TEST_FIXTURE(amp_platform_sysfs_fixture, cgroup_v1_quota)
+    {
+        make_directory("/proc/self");
+        write_file("/proc/self/cgroup", 
+                   "5:memory:/docker/abc\n"
+                   "4:cpu,cpuacct:/docker/abc\n");
+        make_directory("/sys/fs/cgroup/cpu,cpuacct/docker/abc");
+        write_file("/sys/fs/cgroup/cpu,cpuacct/docker/abc/cpu.cfs_quota_us", "50000\n");
+        write_file("/sys/fs/cgroup/cpu,cpuacct/docker/abc/cpu.cfs_period_us", "100000\n");
+        write_file("/sys/fs/cgroup/cpu,cpuacct/cpu.cfs_quota_us", "-1\n");
+        write_file("/sys/fs/cgroup/cpu,cpuacct/cpu.cfs_period_us", "100000\n");
+        
+        size_t quota_us = 0;
+        size_t period_us = 0;
+        int retcode = amp_platform_get_cpu_quota(platform, 
+                                                 &quota_us, 
+                                                 &period_us);
+        if (AMP_UNSUPPORTED == retcode) {
+            // Backend doesn't read cgroups.
+            return;
+        }
+        CHECK_EQUAL(AMP_SUCCESS, retcode);
+        CHECK_EQUAL(50000u, quota_us);
+        CHECK_EQUAL(100000u, period_us);
+        
+        // Half a hardware thread still allows one thread.
+        size_t level = 0;
+        retcode = amp_platform_get_concurrency_level(platform, &level);
+        CHECK_EQUAL(AMP_SUCCESS, retcode);
+        CHECK_EQUAL(1u, level);
+    }
+    
+    
+    
+    TEST_FIXTURE(amp_platform_sysfs_fixture, cgroup_v1_container_mounted_at_mount_point)
+    {
+        // Without cgroup namespaces the container's cgroup path isn't 
+        // visible, its cgroup is mounted at the mount point instead.
+        make_directory("/proc/self");
+        write_file("/proc/self/cgroup", "4:cpuacct,cpu:/docker/abc\n");
+        make_directory("/sys/fs/cgroup/cpu");
+        write_file("/sys/fs/cgroup/cpu/cpu.cfs_quota_us", "300000\n");
+        write_file("/sys/fs/cgroup/cpu/cpu.cfs_period_us", "100000\n");
+        
+        size_t quota_us = 0;
+        size_t period_us = 0;
+        int const retcode = amp_platform_get_cpu_quota(platform, 
+                                                       &quota_us, 
+                                                       &period_us);
+        if (AMP_UNSUPPORTED == retcode) {
+            // Backend doesn't read cgroups.
+            return;
+        }
+        CHECK_EQUAL(AMP_SUCCESS, retcode);
+        CHECK_EQUAL(300000u, quota_us);
+        CHECK_EQUAL(100000u, period_us);
+    }
+    
+#endif // defined(__linux__)
+    
+    
+    
+    TEST_FIXTURE(amp_platform_test_fixture, affinity_hwthread_count_lesser_or_equal_than_installed_hwthread_count_if_both_supported)
+    {
+        size_t affinity_count = 0;
+        int const affinity_retcode = amp_platform_get_affinity_hwthread_count(platform,
+                                                                              &affinity_count);
+        assert(AMP_SUCCESS == affinity_retcode || AMP_UNSUPPORTED == affinity_retcode);
+        
+        size_t installed_count = 0;
+        int const installed_retcode = amp_platform_get_installed_hwthread_count(platform,
+                                                                                &installed_count);
+        assert(AMP_SUCCESS == installed_retcode || AMP_UNSUPPORTED == installed_retcode);
+        
+        if (AMP_SUCCESS == affinity_retcode) {
+            CHECK(0u < affinity_count);
+            
+            if (AMP_SUCCESS == installed_retcode) {
+                CHECK(affinity_count <= installed_count);
+            }
+        }
     }
     
     
@@ -367,6 +943,12 @@ SUITE(amp_platform)
         assert(AMP_SUCCESS == error_code || AMP_UNSUPPORTED == error_code);
         error_code = amp_platform_get_active_hwthread_count(platform, &dummy_count);
         assert(AMP_SUCCESS == error_code || AMP_UNSUPPORTED == error_code);
+        error_code = amp_platform_get_installed_package_count(platform, &dummy_count);
+        assert(AMP_SUCCESS == error_code || AMP_UNSUPPORTED == error_code);
+        error_code = amp_platform_get_hwthread_cache_count(platform, 0, &dummy_count);
+        assert(AMP_SUCCESS == error_code || AMP_UNSUPPORTED == error_code);
+        error_code = amp_platform_get_numa_node_count(platform, &dummy_count);
+        assert(AMP_SUCCESS == error_code || AMP_UNSUPPORTED == error_code);
         
         error_code = amp_platform_destroy(&platform,
                                           allocator);
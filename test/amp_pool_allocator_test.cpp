@@ -0,0 +1,355 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Unit tests for amp_pool_allocator
+ */
+
+#include <UnitTest++.h>
+
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+
+
+#include <amp/amp_stddef.h>
+#include <amp/amp_return_code.h>
+#include <amp/amp_memory.h>
+#include <amp/amp_pool_allocator.h>
+#include <amp/amp_thread_array.h>
+#include <amp/amp_mutex.h>
+#include <amp/amp_condition_variable.h>
+#include <amp/amp_semaphore.h>
+#include <amp/amp_barrier.h>
+
+
+
+namespace {
+    
+    struct pool_fixture {
+        pool_fixture()
+        :   pool(AMP_ALLOCATOR_UNINITIALIZED)
+        {
+            int const retval = amp_pool_allocator_create(&pool, 
+                                                         AMP_DEFAULT_ALLOCATOR);
+            assert(AMP_SUCCESS == retval);
+            (void)retval;
+        }
+        
+        ~pool_fixture()
+        {
+            int const retval = amp_pool_allocator_destroy(&pool,
+                                                          AMP_DEFAULT_ALLOCATOR);
+            assert(AMP_SUCCESS == retval);
+            (void)retval;
+        }
+        
+        amp_allocator_t pool;
+    };
+    
+} // anonymous namespace
+
+
+
+SUITE(amp_pool_allocator)
+{
+    TEST(create_and_destroy)
+    {
+        amp_allocator_t allocator = AMP_ALLOCATOR_UNINITIALIZED;
+        
+        int retval = amp_pool_allocator_create(&allocator,
+                                               AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        CHECK(AMP_ALLOCATOR_UNINITIALIZED != allocator);
+        
+        retval = amp_pool_allocator_destroy(&allocator, AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        CHECK(AMP_ALLOCATOR_UNINITIALIZED == allocator);
+    }
+    
+    
+    
+    TEST_FIXTURE(pool_fixture, alloc_all_sizes_is_writable_and_aligned)
+    {
+        std::size_t const max_size = AMP_POOL_ALLOCATOR_MAX_BLOCK_SIZE + 100;
+        unsigned char* memory[max_size + 1];
+        
+        for (std::size_t size = 0; size <= max_size; ++size) {
+            memory[size] = (unsigned char*)AMP_ALLOC(pool, size);
+            CHECK(NULL != memory[size]);
+            CHECK_EQUAL(0u, ((std::size_t)memory[size]) % AMP_POOL_ALLOCATOR_SIZE_CLASS_GRANULARITY);
+            
+            std::memset(memory[size], (int)(size & 0xff), size);
+        }
+        
+        for (std::size_t size = 0; size <= max_size; ++size) {
+            std::size_t mismatch_count = 0;
+            for (std::size_t i = 0; i < size; ++i) {
+                if ((size & 0xff) != memory[size][i]) {
+                    ++mismatch_count;
+                }
+            }
+            CHECK_EQUAL(0u, mismatch_count);
+            
+            int const retval = AMP_DEALLOC(pool, memory[size]);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+        }
+    }
+    
+    
+    
+    TEST_FIXTURE(pool_fixture, dealloc_null_succeeds)
+    {
+        int const retval = AMP_DEALLOC(pool, NULL);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+    }
+    
+    
+    
+    TEST_FIXTURE(pool_fixture, deallocated_block_is_reused_for_same_size_class)
+    {
+        void* first = AMP_ALLOC(pool, 40);
+        void* second = AMP_ALLOC(pool, 40);
+        CHECK(first != second);
+        
+        int retval = AMP_DEALLOC(pool, first);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        void* third = AMP_ALLOC(pool, 33);
+        CHECK_EQUAL(first, third);
+        
+        retval = AMP_DEALLOC(pool, second);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        retval = AMP_DEALLOC(pool, third);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+    }
+    
+    
+    
+    TEST_FIXTURE(pool_fixture, grows_beyond_first_slabs)
+    {
+        std::size_t const block_count = 5000;
+        void** blocks = new void*[block_count];
+        
+        for (std::size_t i = 0; i < block_count; ++i) {
+            blocks[i] = AMP_ALLOC(pool, sizeof(void*));
+            CHECK(NULL != blocks[i]);
+            *((void**)blocks[i]) = blocks + i;
+        }
+        
+        std::size_t mismatch_count = 0;
+        for (std::size_t i = 0; i < block_count; ++i) {
+            if (*((void**)blocks[i]) != blocks + i) {
+                ++mismatch_count;
+            }
+            int const retval = AMP_DEALLOC(pool, blocks[i]);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+        }
+        CHECK_EQUAL(0u, mismatch_count);
+        
+        delete[] blocks;
+    }
+    
+    
+    
+    TEST_FIXTURE(pool_fixture, calloc_is_zeroed)
+    {
+        std::size_t const sizes[] = {1, 3, 17, 64, 1000};
+        
+        for (std::size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+            // Dirty a block of the size class first to detect missing 
+            // zeroing on reuse.
+            unsigned char* dirty = (unsigned char*)AMP_ALLOC(pool, sizes[s] * sizeof(int));
+            std::memset(dirty, 0xab, sizes[s] * sizeof(int));
+            int retval = AMP_DEALLOC(pool, dirty);
+            assert(AMP_SUCCESS == retval);
+            
+            int* memory = (int*)AMP_CALLOC(pool, sizes[s], sizeof(int));
+            CHECK(NULL != memory);
+            
+            std::size_t nonzero_count = 0;
+            for (std::size_t i = 0; i < sizes[s]; ++i) {
+                if (0 != memory[i]) {
+                    ++nonzero_count;
+                }
+            }
+            CHECK_EQUAL(0u, nonzero_count);
+            
+            retval = AMP_DEALLOC(pool, memory);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+        }
+        
+        void* overflowing = AMP_CALLOC(pool, ~(std::size_t)0 / 2, 4);
+        CHECK(NULL == overflowing);
+    }
+    
+    
+    
+    TEST_FIXTURE(pool_fixture, backs_amp_primitives)
+    {
+        amp_mutex_t mutex = AMP_MUTEX_UNINITIALIZED;
+        amp_condition_variable_t cond = AMP_CONDITION_VARIABLE_UNINITIALIZED;
+        amp_semaphore_t sema = AMP_SEMAPHORE_UNINITIALIZED;
+        amp_barrier_t barrier = AMP_BARRIER_UNINITIALIZED;
+        
+        int retval = amp_mutex_create(&mutex, pool);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        retval = amp_condition_variable_create(&cond, pool);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        retval = amp_semaphore_create(&sema, pool, 1);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        retval = amp_barrier_create(&barrier, pool, 1);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_mutex_lock(mutex);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        retval = amp_mutex_unlock(mutex);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        retval = amp_semaphore_wait(sema);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        retval = amp_barrier_wait(barrier);
+        CHECK(AMP_SUCCESS == retval || AMP_BARRIER_SERIAL_THREAD == retval);
+        
+        retval = amp_barrier_destroy(&barrier, pool);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        retval = amp_semaphore_destroy(&sema, pool);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        retval = amp_condition_variable_destroy(&cond, pool);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        retval = amp_mutex_destroy(&mutex, pool);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+    }
+    
+    
+    
+    namespace {
+        
+        std::size_t const stress_iteration_count = 2000;
+        std::size_t const stress_batch_size = 32;
+        
+        struct stress_context_s {
+            amp_allocator_t pool;
+            unsigned char pattern;
+            std::size_t corruption_count;
+            int return_code;
+        };
+        
+        void stress_thread_func(void* ctxt)
+        {
+            struct stress_context_s* context = 
+                static_cast<struct stress_context_s*>(ctxt);
+            unsigned char* blocks[stress_batch_size];
+            
+            for (std::size_t i = 0; i < stress_iteration_count; ++i) {
+                for (std::size_t b = 0; b < stress_batch_size; ++b) {
+                    std::size_t const size = 1 + (b * 23) % AMP_POOL_ALLOCATOR_MAX_BLOCK_SIZE;
+                    
+                    blocks[b] = (unsigned char*)AMP_ALLOC(context->pool, size);
+                    if (NULL == blocks[b]) {
+                        context->return_code = AMP_NOMEM;
+                        return;
+                    }
+                    std::memset(blocks[b], context->pattern, size);
+                }
+                
+                for (std::size_t b = 0; b < stress_batch_size; ++b) {
+                    std::size_t const size = 1 + (b * 23) % AMP_POOL_ALLOCATOR_MAX_BLOCK_SIZE;
+                    
+                    // A block handed out twice is overwritten by another
+                    // thread's pattern.
+                    for (std::size_t k = 0; k < size; ++k) {
+                        if (context->pattern != blocks[b][k]) {
+                            ++(context->corruption_count);
+                            break;
+                        }
+                    }
+                    
+                    int const retval = AMP_DEALLOC(context->pool, blocks[b]);
+                    if (AMP_SUCCESS != retval) {
+                        context->return_code = retval;
+                        return;
+                    }
+                }
+            }
+        }
+        
+    } // anonymous namespace
+    
+    
+    
+    TEST_FIXTURE(pool_fixture, many_threads_alloc_and_dealloc_concurrently)
+    {
+        std::size_t const thread_count = 8;
+        struct stress_context_s contexts[thread_count];
+        
+        amp_thread_array_t threads = AMP_THREAD_ARRAY_UNINITIALIZED;
+        int retval = amp_thread_array_create(&threads,
+                                             AMP_DEFAULT_ALLOCATOR,
+                                             thread_count);
+        assert(AMP_SUCCESS == retval);
+        
+        for (std::size_t i = 0; i < thread_count; ++i) {
+            contexts[i].pool = pool;
+            contexts[i].pattern = (unsigned char)(i + 1);
+            contexts[i].corruption_count = 0;
+            contexts[i].return_code = AMP_SUCCESS;
+            
+            retval = amp_thread_array_configure(threads,
+                                                i,
+                                                1,
+                                                &contexts[i],
+                                                stress_thread_func);
+            assert(AMP_SUCCESS == retval);
+        }
+        
+        std::size_t joinable_count = 0;
+        retval = amp_thread_array_launch_all(threads, &joinable_count);
+        assert(AMP_SUCCESS == retval);
+        
+        retval = amp_thread_array_join_all(threads, &joinable_count);
+        assert(AMP_SUCCESS == retval);
+        
+        retval = amp_thread_array_destroy(&threads, AMP_DEFAULT_ALLOCATOR);
+        assert(AMP_SUCCESS == retval);
+        
+        for (std::size_t i = 0; i < thread_count; ++i) {
+            CHECK_EQUAL(AMP_SUCCESS, contexts[i].return_code);
+            CHECK_EQUAL(0u, contexts[i].corruption_count);
+        }
+    }
+    
+    
+    
+} // SUITE(amp_pool_allocator)
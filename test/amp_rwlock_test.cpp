@@ -0,0 +1,649 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Unit tests for amp_rwlock.
+ */
+
+
+#include <UnitTest++.h>
+
+#include <assert.h>
+#include <stddef.h>
+
+#include <amp/amp_stddef.h>
+#include <amp/amp_return_code.h>
+#include <amp/amp_thread.h>
+#include <amp/amp_thread_array.h>
+#include <amp/amp_mutex.h>
+#include <amp/amp_barrier.h>
+#include <amp/amp_rwlock.h>
+
+
+SUITE(amp_rwlock)
+{
+    
+    TEST(single_thread_init_lock_unlock_finalize)
+    {
+        amp_rwlock_t rwlock;
+        
+        int retval = amp_rwlock_create(&rwlock,
+                                       AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        {
+            int const milliseconds = 50;
+            UNITTEST_TIME_CONSTRAINT(milliseconds);
+            
+            retval = amp_rwlock_read_lock(rwlock);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+            {
+                // Critical section. Nothing to do.
+            }
+            retval = amp_rwlock_read_unlock(rwlock);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+            
+            retval = amp_rwlock_write_lock(rwlock);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+            {
+                // Critical section. Nothing to do.
+            }
+            retval = amp_rwlock_write_unlock(rwlock);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+        }
+        
+        retval = amp_rwlock_destroy(&rwlock,
+                                    AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+    }
+    
+    
+    
+    TEST(single_thread_init_trylock_unlock_finalize)
+    {
+        amp_rwlock_t rwlock;
+        
+        int retval = amp_rwlock_create(&rwlock,
+                                       AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        {
+            int const milliseconds = 50;
+            UNITTEST_TIME_CONSTRAINT(milliseconds);
+            
+            retval = amp_rwlock_read_trylock(rwlock);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+            {
+                // A read locked rwlock can't be write locked.
+                CHECK_EQUAL(AMP_BUSY, amp_rwlock_write_trylock(rwlock));
+            }
+            retval = amp_rwlock_read_unlock(rwlock);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+            
+            retval = amp_rwlock_write_trylock(rwlock);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+            {
+                // A write locked rwlock can't be locked again.
+                CHECK_EQUAL(AMP_BUSY, amp_rwlock_read_trylock(rwlock));
+                CHECK_EQUAL(AMP_BUSY, amp_rwlock_write_trylock(rwlock));
+            }
+            retval = amp_rwlock_write_unlock(rwlock);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+        }
+        
+        retval = amp_rwlock_destroy(&rwlock,
+                                    AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+    }
+    
+    
+    
+    namespace 
+    {
+        typedef int check_flag_t;
+        
+        check_flag_t const CHECK_FLAG_UNSET = 0;
+        check_flag_t const CHECK_FLAG_SET = 775;
+        
+        
+        struct rwlock_and_check_flags_s {
+            amp_rwlock_t rwlock;
+            check_flag_t read_check_flag;
+            check_flag_t write_check_flag;
+        };
+        
+        
+        void unsuccessful_trylock_thread_func(void *ctxt)
+        {
+            struct rwlock_and_check_flags_s *context = 
+                static_cast<struct rwlock_and_check_flags_s*>(ctxt);
+            
+            // Should be unable to get either lock.
+            int retval = amp_rwlock_read_trylock(context->rwlock);
+            if (AMP_BUSY == retval) {
+                context->read_check_flag = CHECK_FLAG_SET;
+            }
+            
+            retval = amp_rwlock_write_trylock(context->rwlock);
+            if (AMP_BUSY == retval) {
+                context->write_check_flag = CHECK_FLAG_SET;
+            }
+        }
+        
+        
+        void shared_read_trylock_thread_func(void *ctxt)
+        {
+            struct rwlock_and_check_flags_s *context = 
+                static_cast<struct rwlock_and_check_flags_s*>(ctxt);
+            
+            // Should share the read lock but be unable to get the write lock.
+            int retval = amp_rwlock_read_trylock(context->rwlock);
+            if (AMP_SUCCESS == retval) {
+                retval = amp_rwlock_read_unlock(context->rwlock);
+                if (AMP_SUCCESS == retval) {
+                    context->read_check_flag = CHECK_FLAG_SET;
+                }
+            }
+            
+            retval = amp_rwlock_write_trylock(context->rwlock);
+            if (AMP_BUSY == retval) {
+                context->write_check_flag = CHECK_FLAG_SET;
+            }
+        }
+        
+        
+        void run_in_other_thread(struct rwlock_and_check_flags_s* context,
+                                 amp_thread_func_t func)
+        {
+            amp_thread_t thread = AMP_THREAD_UNINITIALIZED;
+            int retval = amp_thread_create_and_launch(&thread,
+                                                      AMP_DEFAULT_ALLOCATOR,
+                                                      context, 
+                                                      func);
+            assert(AMP_SUCCESS == retval);
+            
+            retval = amp_thread_join_and_destroy(&thread,
+                                                 AMP_DEFAULT_ALLOCATOR);
+            assert(AMP_SUCCESS == retval);
+            (void)retval;
+        }
+        
+        
+    } // anonymous namespace
+    
+    TEST(two_threads_one_write_locks_one_trylocks)
+    {
+        struct rwlock_and_check_flags_s rwlock_and_flags;
+        rwlock_and_flags.read_check_flag = CHECK_FLAG_UNSET;
+        rwlock_and_flags.write_check_flag = CHECK_FLAG_UNSET;
+        
+        int retval = amp_rwlock_create(&rwlock_and_flags.rwlock,
+                                       AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_rwlock_write_lock(rwlock_and_flags.rwlock);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        run_in_other_thread(&rwlock_and_flags, 
+                            &unsuccessful_trylock_thread_func);
+        
+        CHECK_EQUAL(CHECK_FLAG_SET, rwlock_and_flags.read_check_flag);
+        CHECK_EQUAL(CHECK_FLAG_SET, rwlock_and_flags.write_check_flag);
+        
+        retval = amp_rwlock_write_unlock(rwlock_and_flags.rwlock);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_rwlock_destroy(&rwlock_and_flags.rwlock,
+                                    AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+    }
+    
+    
+    
+    TEST(two_threads_one_read_locks_one_trylocks)
+    {
+        struct rwlock_and_check_flags_s rwlock_and_flags;
+        rwlock_and_flags.read_check_flag = CHECK_FLAG_UNSET;
+        rwlock_and_flags.write_check_flag = CHECK_FLAG_UNSET;
+        
+        int retval = amp_rwlock_create(&rwlock_and_flags.rwlock,
+                                       AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_rwlock_read_lock(rwlock_and_flags.rwlock);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        run_in_other_thread(&rwlock_and_flags, 
+                            &shared_read_trylock_thread_func);
+        
+        CHECK_EQUAL(CHECK_FLAG_SET, rwlock_and_flags.read_check_flag);
+        CHECK_EQUAL(CHECK_FLAG_SET, rwlock_and_flags.write_check_flag);
+        
+        retval = amp_rwlock_read_unlock(rwlock_and_flags.rwlock);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_rwlock_destroy(&rwlock_and_flags.rwlock,
+                                    AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+    }
+    
+    
+    
+    namespace 
+    {
+        
+        struct staggered_data_s {
+            amp_rwlock_t *rwlock_p;
+            size_t *lock_counter_p;
+            
+            size_t count_at_lock;
+            int return_code;
+            check_flag_t check_flag;
+        };
+        
+        // Write locks the rwlock and when it can enter the critical section
+        // increments the protected counter and stores the resulting count in
+        // its context and sets the check flag.
+        void staggered_locking_thread_func(void *ctxt)
+        {
+            struct staggered_data_s *context = 
+                static_cast<struct staggered_data_s*>(ctxt);
+            
+            context->return_code = AMP_SUCCESS;
+            
+            int retval = amp_rwlock_write_lock(*context->rwlock_p);
+            if (AMP_SUCCESS != retval) {
+                context->return_code = retval;
+                return;
+            }
+            {
+                // Critical section.
+                context->count_at_lock = ++(*(context->lock_counter_p));
+            }
+            retval = amp_rwlock_write_unlock(*context->rwlock_p);
+            if (AMP_SUCCESS != retval) {
+                context->return_code = retval;
+                return;
+            }
+            
+            context->check_flag = CHECK_FLAG_SET;
+        }
+        
+        
+    } // anonymous namespace
+    
+    
+    
+    TEST(staggered_locking)
+    {
+        // Create and read lock a rwlock. Launch a number of threads that all
+        // write lock and wait on the rwlock.
+        // Unlock the rwlock and join with all threads.
+        // Check that all threads successfully entered the rwlock-protected
+        // critical section and that every thread saw another counter.
+        
+        amp_rwlock_t rwlock;
+        int retval = amp_rwlock_create(&rwlock,
+                                       AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_rwlock_read_lock(rwlock);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        
+        size_t const thread_count = 20;
+        struct staggered_data_s thread_contexts[thread_count];
+        
+        size_t lock_counter = 0;
+        
+        
+        amp_thread_array_t threads = AMP_THREAD_ARRAY_UNINITIALIZED;
+        retval = amp_thread_array_create(&threads,
+                                         AMP_DEFAULT_ALLOCATOR,
+                                         thread_count);
+        assert(AMP_SUCCESS == retval);
+        
+        for (size_t i = 0; i < thread_count; ++i) {
+            
+            thread_contexts[i].rwlock_p = &rwlock;
+            thread_contexts[i].lock_counter_p = &lock_counter;
+            thread_contexts[i].count_at_lock = 0;
+            thread_contexts[i].return_code = AMP_SUCCESS;
+            thread_contexts[i].check_flag = CHECK_FLAG_UNSET;
+            
+            int const retv = amp_thread_array_configure(threads,
+                                                        i, 
+                                                        1,
+                                                        &thread_contexts[i],
+                                                        staggered_locking_thread_func);
+            assert(AMP_SUCCESS == retv);
+            (void)retv;
+        }
+        
+        size_t joinable_count = 0;
+        retval = amp_thread_array_launch_all(threads,
+                                             &joinable_count);
+        assert(AMP_SUCCESS == retval);
+        assert(thread_count == joinable_count);
+        
+        
+        // Unlock the rwlock to allow staggered access to the critical 
+        // section by the threads (that might already be blocked while 
+        // trying to lock it).
+        retval = amp_rwlock_read_unlock(rwlock);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        
+        retval = amp_thread_array_join_all(threads,
+                                           &joinable_count);
+        assert(AMP_SUCCESS == retval);
+        assert(0 == joinable_count);
+        
+        retval = amp_thread_array_destroy(&threads,
+                                          AMP_DEFAULT_ALLOCATOR);
+        assert(AMP_SUCCESS == retval);
+        
+        
+        // Check that all threads increased the lock counter.
+        CHECK_EQUAL(lock_counter, thread_count);
+        
+        // Every count from 1 to thread_count must have been seen by exactly
+        // one thread.
+        check_flag_t check_count_at_lock_array[thread_count + 1];
+        for (size_t i = 0; i < thread_count + 1; ++i) {
+            check_count_at_lock_array[i] = CHECK_FLAG_UNSET;
+        }
+        
+        for (size_t i = 0; i < thread_count; ++i) {
+            CHECK(0 != thread_contexts[i].count_at_lock);
+            CHECK_EQUAL(AMP_SUCCESS, thread_contexts[i].return_code);
+            CHECK_EQUAL(CHECK_FLAG_SET, thread_contexts[i].check_flag);
+            if (CHECK_FLAG_SET == thread_contexts[i].check_flag) {
+                size_t index = thread_contexts[i].count_at_lock;
+                check_count_at_lock_array[index] = CHECK_FLAG_SET;
+            }
+        }
+        
+        for (size_t i = 1; i < thread_count + 1; ++i) {
+            CHECK_EQUAL(CHECK_FLAG_SET, check_count_at_lock_array[i]);
+        }
+        
+        
+        retval = amp_rwlock_destroy(&rwlock,
+                                    AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+    }
+    
+    
+    
+    namespace 
+    {
+        
+        struct concurrent_readers_data_s {
+            amp_rwlock_t rwlock;
+            amp_barrier_t barrier;
+            int return_code;
+        };
+        
+        // Every reader waits for all others inside the read critical section
+        // which only returns if all readers hold the read lock at once.
+        void concurrent_reader_thread_func(void *ctxt)
+        {
+            struct concurrent_readers_data_s *data = 
+                static_cast<struct concurrent_readers_data_s*>(ctxt);
+            
+            int retval = amp_rwlock_read_lock(data->rwlock);
+            if (AMP_SUCCESS != retval) {
+                data->return_code = retval;
+                return;
+            }
+            {
+                retval = amp_barrier_wait(data->barrier);
+                if ((AMP_SUCCESS != retval) 
+                    && (AMP_BARRIER_SERIAL_THREAD != retval)) {
+                    data->return_code = retval;
+                }
+            }
+            retval = amp_rwlock_read_unlock(data->rwlock);
+            if (AMP_SUCCESS != retval) {
+                data->return_code = retval;
+            }
+        }
+        
+    } // anonymous namespace
+    
+    
+    
+    TEST(readers_hold_the_read_lock_concurrently)
+    {
+        size_t const thread_count = 8;
+        
+        struct concurrent_readers_data_s data;
+        data.return_code = AMP_SUCCESS;
+        
+        int retval = amp_rwlock_create(&data.rwlock,
+                                       AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_barrier_create(&data.barrier,
+                                    AMP_DEFAULT_ALLOCATOR,
+                                    static_cast<amp_barrier_count_t>(thread_count));
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        amp_thread_array_t threads = AMP_THREAD_ARRAY_UNINITIALIZED;
+        retval = amp_thread_array_create(&threads,
+                                         AMP_DEFAULT_ALLOCATOR,
+                                         thread_count);
+        assert(AMP_SUCCESS == retval);
+        
+        retval = amp_thread_array_configure(threads,
+                                            0, 
+                                            thread_count,
+                                            &data,
+                                            concurrent_reader_thread_func);
+        assert(AMP_SUCCESS == retval);
+        
+        size_t joinable_count = 0;
+        retval = amp_thread_array_launch_all(threads,
+                                             &joinable_count);
+        assert(AMP_SUCCESS == retval);
+        
+        retval = amp_thread_array_join_all(threads,
+                                           &joinable_count);
+        assert(AMP_SUCCESS == retval);
+        
+        retval = amp_thread_array_destroy(&threads,
+                                          AMP_DEFAULT_ALLOCATOR);
+        assert(AMP_SUCCESS == retval);
+        
+        CHECK_EQUAL(AMP_SUCCESS, data.return_code);
+        
+        retval = amp_barrier_destroy(&data.barrier,
+                                     AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_rwlock_destroy(&data.rwlock,
+                                    AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+    }
+    
+    
+    
+    namespace 
+    {
+        
+        size_t const contended_iteration_count = 5000;
+        size_t const contended_write_period = 8;
+        
+        struct contended_data_s {
+            amp_rwlock_t rwlock;
+            amp_mutex_t error_mutex;
+            size_t first_counter;
+            size_t second_counter;
+            size_t torn_read_count;
+            int return_code;
+        };
+        
+        // Mostly reads two counters that writers always change together and
+        // counts reads seeing them differ. Every contended_write_period 
+        // iterations increments both counters under the write lock.
+        void contended_locking_thread_func(void *ctxt)
+        {
+            struct contended_data_s *data = 
+                static_cast<struct contended_data_s*>(ctxt);
+            
+            size_t torn_read_count = 0;
+            int retval = AMP_SUCCESS;
+            
+            for (size_t i = 0; i < contended_iteration_count; ++i) {
+                
+                if (0 == (i % contended_write_period)) {
+                    retval = amp_rwlock_write_lock(data->rwlock);
+                    if (AMP_SUCCESS != retval) {
+                        break;
+                    }
+                    {
+                        ++(data->first_counter);
+                        amp_thread_yield();
+                        ++(data->second_counter);
+                    }
+                    retval = amp_rwlock_write_unlock(data->rwlock);
+                } else {
+                    // Mix trylock into the lock calls to stress the paths 
+                    // stepping back from a busy lock.
+                    if (0 == (i % 3)) {
+                        while (AMP_BUSY == (retval = amp_rwlock_read_trylock(data->rwlock))) {
+                            amp_thread_yield();
+                        }
+                    } else {
+                        retval = amp_rwlock_read_lock(data->rwlock);
+                    }
+                    if (AMP_SUCCESS != retval) {
+                        break;
+                    }
+                    {
+                        if (data->first_counter != data->second_counter) {
+                            ++torn_read_count;
+                        }
+                    }
+                    retval = amp_rwlock_read_unlock(data->rwlock);
+                }
+                
+                if (AMP_SUCCESS != retval) {
+                    break;
+                }
+            }
+            
+            int const rc = amp_mutex_lock(data->error_mutex);
+            assert(AMP_SUCCESS == rc);
+            {
+                data->torn_read_count += torn_read_count;
+                if (AMP_SUCCESS != retval) {
+                    data->return_code = retval;
+                }
+            }
+            int const urc = amp_mutex_unlock(data->error_mutex);
+            assert(AMP_SUCCESS == urc);
+            (void)rc;
+            (void)urc;
+        }
+        
+    } // anonymous namespace
+    
+    
+    
+    TEST(many_threads_read_and_write_repeatedly)
+    {
+        size_t const thread_count = 8;
+        
+        struct contended_data_s data;
+        data.first_counter = 0;
+        data.second_counter = 0;
+        data.torn_read_count = 0;
+        data.return_code = AMP_SUCCESS;
+        
+        int retval = amp_rwlock_create(&data.rwlock,
+                                       AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_mutex_create(&data.error_mutex,
+                                  AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        amp_thread_array_t threads = AMP_THREAD_ARRAY_UNINITIALIZED;
+        retval = amp_thread_array_create(&threads,
+                                         AMP_DEFAULT_ALLOCATOR,
+                                         thread_count);
+        assert(AMP_SUCCESS == retval);
+        
+        retval = amp_thread_array_configure(threads,
+                                            0, 
+                                            thread_count,
+                                            &data,
+                                            contended_locking_thread_func);
+        assert(AMP_SUCCESS == retval);
+        
+        size_t joinable_count = 0;
+        retval = amp_thread_array_launch_all(threads,
+                                             &joinable_count);
+        assert(AMP_SUCCESS == retval);
+        
+        retval = amp_thread_array_join_all(threads,
+                                           &joinable_count);
+        assert(AMP_SUCCESS == retval);
+        
+        retval = amp_thread_array_destroy(&threads,
+                                          AMP_DEFAULT_ALLOCATOR);
+        assert(AMP_SUCCESS == retval);
+        
+        size_t const write_count_per_thread = 
+            (contended_iteration_count + contended_write_period - 1) / contended_write_period;
+        
+        CHECK_EQUAL(AMP_SUCCESS, data.return_code);
+        CHECK_EQUAL(static_cast<size_t>(0), data.torn_read_count);
+        CHECK_EQUAL(thread_count * write_count_per_thread, data.first_counter);
+        CHECK_EQUAL(data.first_counter, data.second_counter);
+        
+        retval = amp_mutex_destroy(&data.error_mutex,
+                                   AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_rwlock_destroy(&data.rwlock,
+                                    AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+    }
+    
+    
+    
+} // SUITE(amp_rwlock)
@@ -0,0 +1,404 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Unit tests for amp_scheduler.
+ */
+
+
+#include <UnitTest++.h>
+
+#include <assert.h>
+#include <stddef.h>
+
+#include <amp/amp_stddef.h>
+#include <amp/amp_return_code.h>
+#include <amp/amp_thread.h>
+#include <amp/amp_thread_array.h>
+#include <amp/amp_scheduler.h>
+#include <amp/amp_raw_scheduler.h>
+
+
+
+SUITE(amp_scheduler)
+{
+    
+    TEST(create_with_default_worker_count_and_destroy)
+    {
+        amp_scheduler_t scheduler = AMP_SCHEDULER_UNINITIALIZED;
+        
+        int retval = amp_scheduler_create(&scheduler,
+                                          AMP_DEFAULT_ALLOCATOR,
+                                          0);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        size_t worker_count = 0;
+        retval = amp_scheduler_get_worker_count(scheduler, &worker_count);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        CHECK(0 != worker_count);
+        
+        retval = amp_scheduler_destroy(&scheduler,
+                                       AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        CHECK(AMP_SCHEDULER_UNINITIALIZED == scheduler);
+    }
+    
+    
+    
+    namespace 
+    {
+        typedef int check_flag_t;
+        
+        check_flag_t const CHECK_FLAG_UNSET = 0;
+        check_flag_t const CHECK_FLAG_SET = 775;
+        
+        
+        void set_flag_task_func(void* ctxt)
+        {
+            check_flag_t* flag = static_cast<check_flag_t*>(ctxt);
+            
+            *flag = CHECK_FLAG_SET;
+        }
+        
+        
+        
+        struct spawn_context_s {
+            amp_scheduler_t scheduler;
+            size_t flag_count;
+            check_flag_t* flags;
+            int return_code;
+        };
+        
+        // Root task spawning one task per flag into a single group.
+        void spawn_set_flags_func(void* ctxt)
+        {
+            struct spawn_context_s* context = 
+                static_cast<struct spawn_context_s*>(ctxt);
+            
+            struct amp_raw_scheduler_group_s group;
+            int retval = amp_raw_scheduler_group_init(&group);
+            
+            for (size_t i = 0; (i < context->flag_count) && (AMP_SUCCESS == retval); ++i) {
+                retval = amp_scheduler_spawn(context->scheduler,
+                                             &group,
+                                             &context->flags[i],
+                                             &set_flag_task_func);
+            }
+            
+            int const wait_retval = amp_scheduler_group_wait(context->scheduler,
+                                                             &group);
+            if (AMP_SUCCESS == retval) {
+                retval = wait_retval;
+            }
+            
+            int const finalize_retval = amp_raw_scheduler_group_finalize(&group);
+            if (AMP_SUCCESS == retval) {
+                retval = finalize_retval;
+            }
+            
+            context->return_code = retval;
+        }
+        
+        
+        
+        struct fib_context_s {
+            amp_scheduler_t scheduler;
+            unsigned int n;
+            unsigned long result;
+        };
+        
+        unsigned long serial_fib(unsigned int n)
+        {
+            if (n < 2) {
+                return n;
+            }
+            
+            return serial_fib(n - 1) + serial_fib(n - 2);
+        }
+        
+        // Spawns all the way down to exercise deque growth and stealing.
+        void fib_task_func(void* ctxt)
+        {
+            struct fib_context_s* context = 
+                static_cast<struct fib_context_s*>(ctxt);
+            
+            if (context->n < 2) {
+                context->result = context->n;
+                return;
+            }
+            
+            struct fib_context_s child_context;
+            child_context.scheduler = context->scheduler;
+            child_context.n = context->n - 1;
+            child_context.result = 0;
+            
+            struct fib_context_s own_context;
+            own_context.scheduler = context->scheduler;
+            own_context.n = context->n - 2;
+            own_context.result = 0;
+            
+            struct amp_raw_scheduler_group_s group;
+            int retval = amp_raw_scheduler_group_init(&group);
+            assert(AMP_SUCCESS == retval);
+            
+            retval = amp_scheduler_spawn(context->scheduler,
+                                         &group,
+                                         &child_context,
+                                         &fib_task_func);
+            assert(AMP_SUCCESS == retval);
+            
+            fib_task_func(&own_context);
+            
+            retval = amp_scheduler_group_wait(context->scheduler, &group);
+            assert(AMP_SUCCESS == retval);
+            
+            retval = amp_raw_scheduler_group_finalize(&group);
+            assert(AMP_SUCCESS == retval);
+            (void)retval;
+            
+            context->result = child_context.result + own_context.result;
+        }
+        
+        
+        
+        struct external_thread_context_s {
+            amp_scheduler_t scheduler;
+            struct fib_context_s fib;
+            int return_code;
+        };
+        
+        void run_fib_from_external_thread_func(void* ctxt)
+        {
+            struct external_thread_context_s* context = 
+                static_cast<struct external_thread_context_s*>(ctxt);
+            
+            context->return_code = amp_scheduler_run(context->scheduler,
+                                                     &context->fib,
+                                                     &fib_task_func);
+        }
+        
+    } // anonymous namespace
+    
+    
+    
+    TEST(run_returns_after_root_task_finished)
+    {
+        amp_scheduler_t scheduler = AMP_SCHEDULER_UNINITIALIZED;
+        int retval = amp_scheduler_create(&scheduler,
+                                          AMP_DEFAULT_ALLOCATOR,
+                                          2);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        check_flag_t flag = CHECK_FLAG_UNSET;
+        retval = amp_scheduler_run(scheduler,
+                                   &flag,
+                                   &set_flag_task_func);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        CHECK_EQUAL(CHECK_FLAG_SET, flag);
+        
+        retval = amp_scheduler_destroy(&scheduler,
+                                       AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+    }
+    
+    
+    
+    TEST(group_wait_returns_after_all_spawned_tasks_finished)
+    {
+        // More tasks than a deque initially holds to check growing.
+        size_t const flag_count = 1000;
+        check_flag_t flags[flag_count];
+        for (size_t i = 0; i < flag_count; ++i) {
+            flags[i] = CHECK_FLAG_UNSET;
+        }
+        
+        amp_scheduler_t scheduler = AMP_SCHEDULER_UNINITIALIZED;
+        int retval = amp_scheduler_create(&scheduler,
+                                          AMP_DEFAULT_ALLOCATOR,
+                                          4);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        struct spawn_context_s context;
+        context.scheduler = scheduler;
+        context.flag_count = flag_count;
+        context.flags = flags;
+        context.return_code = AMP_UNSUPPORTED;
+        
+        retval = amp_scheduler_run(scheduler,
+                                   &context,
+                                   &spawn_set_flags_func);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        CHECK_EQUAL(AMP_SUCCESS, context.return_code);
+        
+        for (size_t i = 0; i < flag_count; ++i) {
+            CHECK_EQUAL(CHECK_FLAG_SET, flags[i]);
+        }
+        
+        retval = amp_scheduler_destroy(&scheduler,
+                                       AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+    }
+    
+    
+    
+    TEST(nested_groups_compute_fib)
+    {
+        amp_scheduler_t scheduler = AMP_SCHEDULER_UNINITIALIZED;
+        int retval = amp_scheduler_create(&scheduler,
+                                          AMP_DEFAULT_ALLOCATOR,
+                                          4);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        struct fib_context_s context;
+        context.scheduler = scheduler;
+        context.n = 20;
+        context.result = 0;
+        
+        retval = amp_scheduler_run(scheduler,
+                                   &context,
+                                   &fib_task_func);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        CHECK_EQUAL(serial_fib(20), context.result);
+        
+        retval = amp_scheduler_destroy(&scheduler,
+                                       AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+    }
+    
+    
+    
+    TEST(concurrent_runs_from_external_threads)
+    {
+        size_t const thread_count = 4;
+        
+        amp_scheduler_t scheduler = AMP_SCHEDULER_UNINITIALIZED;
+        int retval = amp_scheduler_create(&scheduler,
+                                          AMP_DEFAULT_ALLOCATOR,
+                                          3);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        struct external_thread_context_s contexts[thread_count];
+        
+        amp_thread_array_t threads = AMP_THREAD_ARRAY_UNINITIALIZED;
+        retval = amp_thread_array_create(&threads,
+                                         AMP_DEFAULT_ALLOCATOR,
+                                         thread_count);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        for (size_t i = 0; i < thread_count; ++i) {
+            contexts[i].scheduler = scheduler;
+            contexts[i].fib.scheduler = scheduler;
+            contexts[i].fib.n = 12 + static_cast<unsigned int>(i);
+            contexts[i].fib.result = 0;
+            contexts[i].return_code = AMP_UNSUPPORTED;
+            
+            retval = amp_thread_array_configure(threads,
+                                                i,
+                                                1,
+                                                &contexts[i],
+                                                &run_fib_from_external_thread_func);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+        }
+        
+        size_t joinable_count = 0;
+        retval = amp_thread_array_launch_all(threads, &joinable_count);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_thread_array_join_all(threads, &joinable_count);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        for (size_t i = 0; i < thread_count; ++i) {
+            CHECK_EQUAL(AMP_SUCCESS, contexts[i].return_code);
+            CHECK_EQUAL(serial_fib(contexts[i].fib.n), contexts[i].fib.result);
+        }
+        
+        retval = amp_thread_array_destroy(&threads, AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_scheduler_destroy(&scheduler,
+                                       AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+    }
+    
+    
+    
+    TEST(spawn_and_group_wait_from_non_worker_thread_fail)
+    {
+        amp_scheduler_t scheduler = AMP_SCHEDULER_UNINITIALIZED;
+        int retval = amp_scheduler_create(&scheduler,
+                                          AMP_DEFAULT_ALLOCATOR,
+                                          1);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        check_flag_t flag = CHECK_FLAG_UNSET;
+        struct amp_raw_scheduler_group_s group;
+        retval = amp_raw_scheduler_group_init(&group);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_scheduler_spawn(scheduler,
+                                     &group,
+                                     &flag,
+                                     &set_flag_task_func);
+        CHECK_EQUAL(AMP_ERROR, retval);
+        
+        retval = amp_scheduler_group_wait(scheduler, &group);
+        CHECK_EQUAL(AMP_ERROR, retval);
+        
+        retval = amp_raw_scheduler_group_finalize(&group);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        CHECK_EQUAL(CHECK_FLAG_UNSET, flag);
+        
+        retval = amp_scheduler_destroy(&scheduler,
+                                       AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+    }
+    
+    
+    
+    TEST(group_create_and_destroy)
+    {
+        amp_scheduler_group_t group = AMP_SCHEDULER_GROUP_UNINITIALIZED;
+        
+        int retval = amp_scheduler_group_create(&group, AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_scheduler_group_destroy(&group, AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        CHECK(AMP_SCHEDULER_GROUP_UNINITIALIZED == group);
+    }
+    
+    
+} // SUITE(amp_scheduler)
+
+
@@ -47,6 +47,7 @@
 #include <amp/amp_memory.h>
 #include <amp/amp_thread.h>
 #include <amp/amp_thread_array.h>
+#include <amp/amp_mutex.h>
 #include <amp/amp_semaphore.h>
 
 
@@ -318,4 +319,125 @@ SUITE(amp_semaphore)
         CHECK_EQUAL(AMP_SUCCESS, retval);
     }
     
+    
+    namespace
+    {
+        struct bounded_holders_s {
+            amp_semaphore_t sem;
+            amp_mutex_t holder_mutex;
+            std::size_t holder_count;
+            std::size_t max_holder_count;
+            std::size_t iteration_count;
+            int return_code;
+        };
+        
+        void bounded_holders_thread_func(void *context)
+        {
+            struct bounded_holders_s *data = static_cast<struct bounded_holders_s*>(context);
+            
+            for (std::size_t i = 0; i < data->iteration_count; ++i) {
+                
+                int retcode = amp_semaphore_wait(data->sem);
+                if (AMP_SUCCESS != retcode) {
+                    data->return_code = retcode;
+                    return;
+                }
+                
+                retcode = amp_mutex_lock(data->holder_mutex);
+                assert(AMP_SUCCESS == retcode);
+                {
+                    ++(data->holder_count);
+                    if (data->holder_count > data->max_holder_count) {
+                        data->max_holder_count = data->holder_count;
+                    }
+                }
+                retcode = amp_mutex_unlock(data->holder_mutex);
+                assert(AMP_SUCCESS == retcode);
+                
+                (void)amp_thread_yield();
+                
+                retcode = amp_mutex_lock(data->holder_mutex);
+                assert(AMP_SUCCESS == retcode);
+                {
+                    --(data->holder_count);
+                }
+                retcode = amp_mutex_unlock(data->holder_mutex);
+                assert(AMP_SUCCESS == retcode);
+                
+                retcode = amp_semaphore_signal(data->sem);
+                if (AMP_SUCCESS != retcode) {
+                    data->return_code = retcode;
+                    return;
+                }
+            }
+        }
+        
+    } // anonymous namespace
+    
+    TEST(many_threads_wait_and_signal_never_exceed_count)
+    {
+        // Many threads repeatedly wait on and signal a semaphore created with
+        // a count smaller than the thread count. At no time more threads than
+        // the init count must have passed the semaphore without signaling it
+        // again. Stresses the blocking and waking paths of the backends.
+        
+        amp_semaphore_counter_t const init_count = 2;
+        std::size_t const thread_count = 8;
+        
+        struct bounded_holders_s data;
+        data.holder_count = 0;
+        data.max_holder_count = 0;
+        data.iteration_count = 1000;
+        data.return_code = AMP_SUCCESS;
+        
+        int retval = amp_semaphore_create(&data.sem,
+                                          AMP_DEFAULT_ALLOCATOR,
+                                          init_count);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_mutex_create(&data.holder_mutex,
+                                  AMP_DEFAULT_ALLOCATOR);
+        assert(AMP_SUCCESS == retval);
+        
+        amp_thread_array_t threads = AMP_THREAD_ARRAY_UNINITIALIZED;
+        retval = amp_thread_array_create(&threads,
+                                         AMP_DEFAULT_ALLOCATOR,
+                                         thread_count);
+        assert(AMP_SUCCESS == retval);
+        
+        retval = amp_thread_array_configure(threads,
+                                            0,
+                                            thread_count,
+                                            &data,
+                                            &bounded_holders_thread_func);
+        assert(AMP_SUCCESS == retval);
+        
+        std::size_t joinable_count = 0;
+        retval = amp_thread_array_launch_all(threads,
+                                             &joinable_count);
+        assert(AMP_SUCCESS == retval);
+        assert(thread_count == joinable_count);
+        
+        retval = amp_thread_array_join_all(threads,
+                                           &joinable_count);
+        assert(AMP_SUCCESS == retval);
+        assert(0 == joinable_count);
+        
+        retval = amp_thread_array_destroy(&threads,
+                                          AMP_DEFAULT_ALLOCATOR);
+        assert(AMP_SUCCESS == retval);
+        
+        CHECK_EQUAL(AMP_SUCCESS, data.return_code);
+        CHECK_EQUAL(static_cast<std::size_t>(0), data.holder_count);
+        CHECK(static_cast<std::size_t>(init_count) >= data.max_holder_count);
+        
+        retval = amp_mutex_destroy(&data.holder_mutex,
+                                   AMP_DEFAULT_ALLOCATOR);
+        assert(AMP_SUCCESS == retval);
+        
+        retval = amp_semaphore_destroy(&data.sem,
+                                       AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+    }
+    
 } // SUITE(amp_raw_semaphore)
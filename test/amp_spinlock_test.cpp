@@ -0,0 +1,423 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Unit tests for amp_spinlock.
+ */
+
+
+#include <UnitTest++.h>
+
+#include <assert.h>
+#include <stddef.h>
+
+#include <amp/amp_stddef.h>
+#include <amp/amp_return_code.h>
+#include <amp/amp_thread.h>
+#include <amp/amp_thread_array.h>
+#include <amp/amp_spinlock.h>
+
+
+SUITE(amp_spinlock)
+{
+    
+    TEST(single_thread_init_lock_unlock_finalize)
+    {
+        amp_spinlock_t spinlock;
+        
+        int retval = amp_spinlock_create(&spinlock,
+                                         AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        {
+            int const milliseconds = 50;
+            UNITTEST_TIME_CONSTRAINT(milliseconds);
+            
+            retval = amp_spinlock_lock(spinlock);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+            {
+                // Critical section. Nothing to do.
+            }
+            retval = amp_spinlock_unlock(spinlock);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+        }
+        
+        retval = amp_spinlock_destroy(&spinlock,
+                                      AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+    }
+    
+    
+    
+    TEST(single_thread_init_trylock_unlock_finalize)
+    {
+        amp_spinlock_t spinlock;
+        
+        int retval = amp_spinlock_create(&spinlock,
+                                         AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        {
+            int const milliseconds = 50;
+            UNITTEST_TIME_CONSTRAINT(milliseconds);
+            
+            retval = amp_spinlock_trylock(spinlock);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+            {
+                // A locked spinlock can't be locked again.
+                CHECK_EQUAL(AMP_BUSY, amp_spinlock_trylock(spinlock));
+            }
+            retval = amp_spinlock_unlock(spinlock);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+        }
+        
+        retval = amp_spinlock_destroy(&spinlock,
+                                      AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+    }
+    
+    
+    
+    namespace 
+    {
+        typedef int check_flag_t;
+        
+        check_flag_t const CHECK_FLAG_UNSET = 0;
+        check_flag_t const CHECK_FLAG_SET = 775;
+        
+        
+        struct spinlock_and_one_check_flag_s {
+            amp_spinlock_t spinlock;
+            check_flag_t check_flag;
+        };
+        
+        
+        void unsuccessful_trylock_thread_func(void *ctxt)
+        {
+            struct spinlock_and_one_check_flag_s *context = 
+                static_cast<struct spinlock_and_one_check_flag_s*>(ctxt);
+            
+            // Should be unable to get the lock.
+            int retval = amp_spinlock_trylock(context->spinlock);
+            if (AMP_BUSY == retval) {
+                context->check_flag = CHECK_FLAG_SET;
+            }
+        }
+        
+        
+    } // anonymous namespace
+    
+    TEST(two_threads_one_locks_one_trylocks)
+    {
+        struct spinlock_and_one_check_flag_s spinlock_and_flag;
+        spinlock_and_flag.check_flag = CHECK_FLAG_UNSET;
+        
+        int retval = amp_spinlock_create(&spinlock_and_flag.spinlock,
+                                         AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_spinlock_lock(spinlock_and_flag.spinlock);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        
+        amp_thread_t thread = AMP_THREAD_UNINITIALIZED;
+        retval = amp_thread_create_and_launch(&thread,
+                                              AMP_DEFAULT_ALLOCATOR,
+                                              &spinlock_and_flag, 
+                                              &unsuccessful_trylock_thread_func);
+        assert(AMP_SUCCESS == retval);
+        
+        retval = amp_thread_join_and_destroy(&thread,
+                                             AMP_DEFAULT_ALLOCATOR);
+        assert(AMP_SUCCESS == retval);
+        
+        CHECK_EQUAL(CHECK_FLAG_SET, spinlock_and_flag.check_flag);
+        
+        
+        retval = amp_spinlock_unlock(spinlock_and_flag.spinlock);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        
+        retval = amp_spinlock_destroy(&spinlock_and_flag.spinlock,
+                                      AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+    }
+    
+    
+    
+    namespace 
+    {
+        
+        struct staggered_data_s {
+            amp_spinlock_t *spinlock_p;
+            size_t *lock_counter_p;
+            
+            size_t count_at_lock;
+            int return_code;
+            check_flag_t check_flag;
+        };
+        
+        // Locks the spinlock and when it can enter the critical section
+        // increments the protected counter and stores the resulting count in
+        // its context and sets the check flag.
+        void staggered_locking_thread_func(void *ctxt)
+        {
+            struct staggered_data_s *context = 
+                static_cast<struct staggered_data_s*>(ctxt);
+            
+            context->return_code = AMP_SUCCESS;
+            
+            int retval = amp_spinlock_lock(*context->spinlock_p);
+            if (AMP_SUCCESS != retval) {
+                context->return_code = retval;
+                return;
+            }
+            {
+                // Critical section.
+                context->count_at_lock = ++(*(context->lock_counter_p));
+            }
+            retval = amp_spinlock_unlock(*context->spinlock_p);
+            if (AMP_SUCCESS != retval) {
+                context->return_code = retval;
+                return;
+            }
+            
+            context->check_flag = CHECK_FLAG_SET;
+        }
+        
+        
+    } // anonymous namespace
+    
+    
+    
+    TEST(staggered_locking)
+    {
+        // Create and lock a spinlock. Launch a number of threads that all
+        // lock and wait on the spinlock.
+        // Unlock the spinlock and join with all threads.
+        // Check that all threads successfully entered the spinlock-protected
+        // critical section and that every thread saw another counter.
+        
+        amp_spinlock_t spinlock;
+        int retval = amp_spinlock_create(&spinlock,
+                                         AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_spinlock_lock(spinlock);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        
+        size_t const thread_count = 20;
+        struct staggered_data_s thread_contexts[thread_count];
+        
+        size_t lock_counter = 0;
+        
+        
+        amp_thread_array_t threads = AMP_THREAD_ARRAY_UNINITIALIZED;
+        retval = amp_thread_array_create(&threads,
+                                         AMP_DEFAULT_ALLOCATOR,
+                                         thread_count);
+        assert(AMP_SUCCESS == retval);
+        
+        for (size_t i = 0; i < thread_count; ++i) {
+            
+            thread_contexts[i].spinlock_p = &spinlock;
+            thread_contexts[i].lock_counter_p = &lock_counter;
+            thread_contexts[i].count_at_lock = 0;
+            thread_contexts[i].return_code = AMP_SUCCESS;
+            thread_contexts[i].check_flag = CHECK_FLAG_UNSET;
+            
+            int const retv = amp_thread_array_configure(threads,
+                                                        i, 
+                                                        1,
+                                                        &thread_contexts[i],
+                                                        staggered_locking_thread_func);
+            assert(AMP_SUCCESS == retv);
+            (void)retv;
+        }
+        
+        size_t joinable_count = 0;
+        retval = amp_thread_array_launch_all(threads,
+                                             &joinable_count);
+        assert(AMP_SUCCESS == retval);
+        assert(thread_count == joinable_count);
+        
+        
+        // Unlock the spinlock to allow staggered access to the critical 
+        // section by the threads (that might already spin to lock it).
+        retval = amp_spinlock_unlock(spinlock);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        
+        retval = amp_thread_array_join_all(threads,
+                                           &joinable_count);
+        assert(AMP_SUCCESS == retval);
+        assert(0 == joinable_count);
+        
+        retval = amp_thread_array_destroy(&threads,
+                                          AMP_DEFAULT_ALLOCATOR);
+        assert(AMP_SUCCESS == retval);
+        
+        
+        // Check that all threads increased the lock counter.
+        CHECK_EQUAL(lock_counter, thread_count);
+        
+        // Every count from 1 to thread_count must have been seen by exactly
+        // one thread.
+        check_flag_t check_count_at_lock_array[thread_count + 1];
+        for (size_t i = 0; i < thread_count + 1; ++i) {
+            check_count_at_lock_array[i] = CHECK_FLAG_UNSET;
+        }
+        
+        for (size_t i = 0; i < thread_count; ++i) {
+            CHECK(0 != thread_contexts[i].count_at_lock);
+            CHECK_EQUAL(AMP_SUCCESS, thread_contexts[i].return_code);
+            CHECK_EQUAL(CHECK_FLAG_SET, thread_contexts[i].check_flag);
+            if (CHECK_FLAG_SET == thread_contexts[i].check_flag) {
+                size_t index = thread_contexts[i].count_at_lock;
+                check_count_at_lock_array[index] = CHECK_FLAG_SET;
+            }
+        }
+        
+        for (size_t i = 1; i < thread_count + 1; ++i) {
+            CHECK_EQUAL(CHECK_FLAG_SET, check_count_at_lock_array[i]);
+        }
+        
+        
+        retval = amp_spinlock_destroy(&spinlock,
+                                      AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+    }
+    
+    
+    
+    namespace 
+    {
+        
+        size_t const contended_iteration_count = 5000;
+        
+        struct contended_data_s {
+            amp_spinlock_t spinlock;
+            size_t unprotected_counter;
+            int return_code;
+        };
+        
+        void contended_locking_thread_func(void *ctxt)
+        {
+            struct contended_data_s *data = 
+                static_cast<struct contended_data_s*>(ctxt);
+            
+            for (size_t i = 0; i < contended_iteration_count; ++i) {
+                
+                int retval = AMP_SUCCESS;
+                
+                // Mix trylock into the lock calls to stress the paths 
+                // entering the lock without waiting.
+                if (0 == (i % 7)) {
+                    while (AMP_BUSY == (retval = amp_spinlock_trylock(data->spinlock))) {
+                        amp_thread_yield();
+                    }
+                } else {
+                    retval = amp_spinlock_lock(data->spinlock);
+                }
+                
+                if (AMP_SUCCESS != retval) {
+                    data->return_code = retval;
+                    return;
+                }
+                
+                ++(data->unprotected_counter);
+                
+                retval = amp_spinlock_unlock(data->spinlock);
+                if (AMP_SUCCESS != retval) {
+                    data->return_code = retval;
+                    return;
+                }
+            }
+        }
+        
+    } // anonymous namespace
+    
+    
+    
+    TEST(many_threads_lock_and_unlock_repeatedly)
+    {
+        size_t const thread_count = 8;
+        
+        struct contended_data_s data;
+        data.unprotected_counter = 0;
+        data.return_code = AMP_SUCCESS;
+        
+        int retval = amp_spinlock_create(&data.spinlock,
+                                         AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        amp_thread_array_t threads = AMP_THREAD_ARRAY_UNINITIALIZED;
+        retval = amp_thread_array_create(&threads,
+                                         AMP_DEFAULT_ALLOCATOR,
+                                         thread_count);
+        assert(AMP_SUCCESS == retval);
+        
+        retval = amp_thread_array_configure(threads,
+                                            0, 
+                                            thread_count,
+                                            &data,
+                                            contended_locking_thread_func);
+        assert(AMP_SUCCESS == retval);
+        
+        size_t joinable_count = 0;
+        retval = amp_thread_array_launch_all(threads,
+                                             &joinable_count);
+        assert(AMP_SUCCESS == retval);
+        
+        retval = amp_thread_array_join_all(threads,
+                                           &joinable_count);
+        assert(AMP_SUCCESS == retval);
+        
+        retval = amp_thread_array_destroy(&threads,
+                                          AMP_DEFAULT_ALLOCATOR);
+        assert(AMP_SUCCESS == retval);
+        
+        CHECK_EQUAL(AMP_SUCCESS, data.return_code);
+        CHECK_EQUAL(thread_count * contended_iteration_count, 
+                    data.unprotected_counter);
+        
+        retval = amp_spinlock_destroy(&data.spinlock,
+                                      AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+    }
+    
+    
+    
+} // SUITE(amp_spinlock)
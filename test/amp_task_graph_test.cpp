@@ -0,0 +1,303 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Unit tests for amp_task_graph.
+ */
+
+
+#include <UnitTest++.h>
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+#include <amp/amp_stddef.h>
+#include <amp/amp_return_code.h>
+#include <amp/amp_atomic.h>
+#include <amp/amp_scheduler.h>
+#include <amp/amp_task_graph.h>
+
+
+
+SUITE(amp_task_graph)
+{
+    
+    namespace 
+    {
+        // Nodes draw a ticket from a shared counter when they run, so the
+        // tickets show the order in which nodes ran.
+        struct ticket_counter_s {
+            amp_atomic_size_t next_ticket;
+        };
+        
+        struct ticket_node_s {
+            ticket_counter_s* counter;
+            std::size_t ticket;
+            std::size_t run_count;
+        };
+        
+        void draw_ticket_func(void* ctxt)
+        {
+            ticket_node_s* node = static_cast<ticket_node_s*>(ctxt);
+            
+            node->ticket = amp_atomic_size_fetch_add(&node->counter->next_ticket,
+                                                     1,
+                                                     amp_memory_order_relaxed);
+            ++(node->run_count);
+        }
+        
+        
+        
+        class scheduler_graph_fixture {
+        public:
+            scheduler_graph_fixture()
+            :   scheduler(AMP_SCHEDULER_UNINITIALIZED),
+                graph(AMP_TASK_GRAPH_UNINITIALIZED)
+            {
+                int retval = amp_scheduler_create(&scheduler,
+                                                  AMP_DEFAULT_ALLOCATOR,
+                                                  4);
+                assert(AMP_SUCCESS == retval);
+                
+                retval = amp_task_graph_create(&graph,
+                                               AMP_DEFAULT_ALLOCATOR);
+                assert(AMP_SUCCESS == retval);
+                (void)retval;
+                
+                amp_atomic_size_store(&counter.next_ticket, 
+                                      0, 
+                                      amp_memory_order_relaxed);
+            }
+            
+            ~scheduler_graph_fixture()
+            {
+                int retval = amp_task_graph_destroy(&graph,
+                                                    AMP_DEFAULT_ALLOCATOR);
+                assert(AMP_SUCCESS == retval);
+                
+                retval = amp_scheduler_destroy(&scheduler,
+                                               AMP_DEFAULT_ALLOCATOR);
+                assert(AMP_SUCCESS == retval);
+                (void)retval;
+            }
+            
+            // Adds node_count ticket nodes, node i gets id i.
+            void add_nodes(std::size_t node_count)
+            {
+                nodes.resize(node_count);
+                
+                for (std::size_t i = 0; i < node_count; ++i) {
+                    nodes[i].counter = &counter;
+                    nodes[i].ticket = 0;
+                    nodes[i].run_count = 0;
+                    
+                    std::size_t id = 0;
+                    int const retval = amp_task_graph_add_node(graph,
+                                                               &nodes[i],
+                                                               &draw_ticket_func,
+                                                               &id);
+                    CHECK_EQUAL(AMP_SUCCESS, retval);
+                    CHECK_EQUAL(i, id);
+                }
+            }
+            
+            amp_scheduler_t scheduler;
+            amp_task_graph_t graph;
+            ticket_counter_s counter;
+            std::vector<ticket_node_s> nodes;
+        };
+        
+    } // anonymous namespace
+    
+    
+    
+    TEST(create_and_destroy)
+    {
+        amp_task_graph_t graph = AMP_TASK_GRAPH_UNINITIALIZED;
+        
+        int retval = amp_task_graph_create(&graph, AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_task_graph_destroy(&graph, AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        CHECK(AMP_TASK_GRAPH_UNINITIALIZED == graph);
+    }
+    
+    
+    
+    TEST_FIXTURE(scheduler_graph_fixture, chain_runs_in_order_and_is_critical_path)
+    {
+        std::size_t const node_count = 5;
+        add_nodes(node_count);
+        
+        // Add the edges backwards so the id order doesn't help.
+        for (std::size_t i = node_count - 1; i > 0; --i) {
+            int const retval = amp_task_graph_add_edge(graph, i - 1, i);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+        }
+        
+        int retval = amp_task_graph_execute(graph, scheduler);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        for (std::size_t i = 0; i < node_count; ++i) {
+            CHECK_EQUAL(1u, nodes[i].run_count);
+            CHECK_EQUAL(i, nodes[i].ticket);
+        }
+        
+        struct amp_task_graph_statistics_s statistics;
+        retval = amp_task_graph_get_statistics(graph, &statistics);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        CHECK_EQUAL(node_count, statistics.critical_path_node_count);
+        CHECK(statistics.critical_path_time <= statistics.work_time);
+        CHECK(statistics.work_time <= statistics.elapsed_time);
+    }
+    
+    
+    
+    TEST_FIXTURE(scheduler_graph_fixture, wide_graph_respects_edges_across_executions)
+    {
+        // Layered graph of about 200 nodes with edges from every node to 
+        // three nodes of the next layer.
+        std::size_t const layer_count = 10;
+        std::size_t const layer_width = 20;
+        std::size_t const node_count = layer_count * layer_width;
+        add_nodes(node_count);
+        
+        std::vector<std::size_t> predecessors;
+        std::vector<std::size_t> successors;
+        for (std::size_t layer = 0; layer + 1 < layer_count; ++layer) {
+            for (std::size_t i = 0; i < layer_width; ++i) {
+                for (std::size_t k = 0; k < 3; ++k) {
+                    std::size_t const predecessor = layer * layer_width + i;
+                    std::size_t const successor = (layer + 1) * layer_width + (i * 7 + k * 5) % layer_width;
+                    
+                    int const retval = amp_task_graph_add_edge(graph, 
+                                                               predecessor,
+                                                               successor);
+                    CHECK_EQUAL(AMP_SUCCESS, retval);
+                    predecessors.push_back(predecessor);
+                    successors.push_back(successor);
+                }
+            }
+        }
+        
+        std::size_t const execution_count = 20;
+        for (std::size_t execution = 0; execution < execution_count; ++execution) {
+            int const retval = amp_task_graph_execute(graph, scheduler);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+            
+            for (std::size_t e = 0; e < predecessors.size(); ++e) {
+                CHECK(nodes[predecessors[e]].ticket < nodes[successors[e]].ticket);
+            }
+        }
+        
+        for (std::size_t i = 0; i < node_count; ++i) {
+            CHECK_EQUAL(execution_count, nodes[i].run_count);
+        }
+        
+        struct amp_task_graph_statistics_s statistics;
+        int const retval = amp_task_graph_get_statistics(graph, &statistics);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        CHECK_EQUAL(layer_count, statistics.critical_path_node_count);
+        CHECK(0.0 <= statistics.achieved_parallelism);
+        CHECK(1.0 <= statistics.available_parallelism);
+    }
+    
+    
+    
+    TEST_FIXTURE(scheduler_graph_fixture, cycle_is_rejected_without_running_tasks)
+    {
+        add_nodes(3);
+        
+        int retval = amp_task_graph_add_edge(graph, 0, 1);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        retval = amp_task_graph_add_edge(graph, 1, 2);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        retval = amp_task_graph_add_edge(graph, 2, 1);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_task_graph_execute(graph, scheduler);
+        CHECK_EQUAL(AMP_ERROR, retval);
+        
+        for (std::size_t i = 0; i < 3; ++i) {
+            CHECK_EQUAL(0u, nodes[i].run_count);
+        }
+    }
+    
+    
+    
+    TEST_FIXTURE(scheduler_graph_fixture, nodes_added_after_execution_run_next_time)
+    {
+        // The graph keeps pointers to the node contexts.
+        std::size_t const new_node_count = 40;
+        nodes.reserve(new_node_count);
+        add_nodes(2);
+        
+        int retval = amp_task_graph_execute(graph, scheduler);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        // Grow the graph past its initial capacity.
+        std::size_t const old_node_count = nodes.size();
+        for (std::size_t i = old_node_count; i < new_node_count; ++i) {
+            nodes.push_back(ticket_node_s());
+            nodes[i].counter = &counter;
+            nodes[i].ticket = 0;
+            nodes[i].run_count = 0;
+            
+            std::size_t id = 0;
+            retval = amp_task_graph_add_node(graph,
+                                             &nodes[i],
+                                             &draw_ticket_func,
+                                             &id);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+            
+            retval = amp_task_graph_add_edge(graph, id - 1, id);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+        }
+        
+        retval = amp_task_graph_execute(graph, scheduler);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        for (std::size_t i = old_node_count; i < new_node_count; ++i) {
+            CHECK_EQUAL(1u, nodes[i].run_count);
+            CHECK(nodes[i - 1].ticket < nodes[i].ticket);
+        }
+        CHECK_EQUAL(2u, nodes[0].run_count);
+    }
+    
+    
+} // SUITE(amp_task_graph)
+
+
@@ -485,6 +485,310 @@ SUITE(amp_thread_array)
     
     
     
+    namespace {
+        
+        struct affinity_query_context {
+            int retval;
+            amp_thread_affinity_s affinity;
+        };
+        
+        void query_affinity_thread_func(void* context)
+        {
+            affinity_query_context* ctxt = static_cast<affinity_query_context*>(context);
+            ctxt->retval = amp_thread_get_current_affinity(&ctxt->affinity);
+        }
+        
+        void write_fortytwo_thread_func(void* context)
+        {
+            *static_cast<int*>(context) = 42;
+        }
+        
+        void record_stack_address_thread_func(void* context)
+        {
+            char local = 0;
+            *static_cast<char const**>(context) = &local;
+        }
+        
+    } // anonymous namespace
+    
+    
+    TEST(configure_affinity_per_index)
+    {
+        amp_thread_affinity_s process_affinity;
+        int retval = amp_thread_get_current_affinity(&process_affinity);
+        if (AMP_UNSUPPORTED == retval) {
+            return;
+        }
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        std::vector<size_t> cpus;
+        for (size_t cpu = 0; cpu < AMP_THREAD_AFFINITY_CPU_CAPACITY; ++cpu) {
+            if (amp_thread_affinity_contains_cpu(&process_affinity, cpu)) {
+                cpus.push_back(cpu);
+            }
+        }
+        CHECK(!cpus.empty());
+        
+        size_t const thread_count = 8;
+        std::vector<affinity_query_context> contexts(thread_count);
+        
+        amp_thread_array_t thread_array = AMP_THREAD_ARRAY_UNINITIALIZED;
+        retval = amp_thread_array_create(&thread_array,
+                                         AMP_DEFAULT_ALLOCATOR,
+                                         thread_count);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_thread_array_configure_functions(thread_array,
+                                                      0,
+                                                      thread_count,
+                                                      &query_affinity_thread_func);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        for (size_t i = 0; i < thread_count; ++i) {
+            contexts[i].retval = AMP_ERROR;
+            
+            amp_thread_affinity_s pinned;
+            amp_thread_affinity_clear(&pinned);
+            amp_thread_affinity_add_cpu(&pinned, cpus[i % cpus.size()]);
+            
+            retval = amp_thread_array_configure_contexts(thread_array,
+                                                         i,
+                                                         1,
+                                                         &contexts[i]);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+            retval = amp_thread_array_configure_affinity(thread_array,
+                                                         i,
+                                                         1,
+                                                         &pinned);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+        }
+        
+        size_t launched_count = 0;
+        retval = amp_thread_array_launch_all(thread_array, &launched_count);
+        if (AMP_UNSUPPORTED != retval) {
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+            CHECK_EQUAL(thread_count, launched_count);
+        }
+        
+        size_t joinable_count = 0;
+        retval = amp_thread_array_join_all(thread_array, &joinable_count);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_thread_array_destroy(&thread_array,
+                                          AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        for (size_t i = 0; i < launched_count; ++i) {
+            CHECK_EQUAL(AMP_SUCCESS, contexts[i].retval);
+            CHECK_EQUAL(static_cast<size_t>(1), amp_thread_affinity_cpu_count(&contexts[i].affinity));
+            CHECK(amp_thread_affinity_contains_cpu(&contexts[i].affinity, cpus[i % cpus.size()]));
+        }
+    }
+    
+    
+    
+    TEST(configure_stacks_from_pooled_memory)
+    {
+        size_t const thread_count = 8;
+        size_t const stack_size = 128 * 1024;
+        std::vector<char> stack_memory(thread_count * stack_size);
+        std::vector<char const*> stack_addresses(thread_count, static_cast<char const*>(NULL));
+        
+        amp_thread_array_t thread_array = AMP_THREAD_ARRAY_UNINITIALIZED;
+        int retval = amp_thread_array_create(&thread_array,
+                                             AMP_DEFAULT_ALLOCATOR,
+                                             thread_count);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_thread_array_configure_functions(thread_array,
+                                                      0,
+                                                      thread_count,
+                                                      &record_stack_address_thread_func);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        for (size_t i = 0; i < thread_count; ++i) {
+            retval = amp_thread_array_configure_contexts(thread_array,
+                                                         i,
+                                                         1,
+                                                         &stack_addresses[i]);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+        }
+        
+        amp_thread_stack_s stack;
+        stack.size = stack_size;
+        stack.guard_size = AMP_THREAD_STACK_DEFAULT_GUARD_SIZE;
+        stack.memory = &stack_memory[0];
+        retval = amp_thread_array_configure_stacks(thread_array,
+                                                   0,
+                                                   thread_count,
+                                                   &stack);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        size_t launched_count = 0;
+        retval = amp_thread_array_launch_all(thread_array, &launched_count);
+        if (AMP_UNSUPPORTED != retval) {
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+            CHECK_EQUAL(thread_count, launched_count);
+        }
+        
+        size_t joinable_count = 0;
+        retval = amp_thread_array_join_all(thread_array, &joinable_count);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_thread_array_destroy(&thread_array,
+                                          AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        for (size_t i = 0; i < launched_count; ++i) {
+            char const* const slice = &stack_memory[0] + i * stack_size;
+            CHECK(stack_addresses[i] >= slice);
+            CHECK(stack_addresses[i] < slice + stack_size);
+        }
+    }
+    
+    
+    
+    TEST(launch_all_with_mode)
+    {
+        size_t const thread_count = 37;
+        
+        amp_thread_array_launch_mode_t const modes[] = {
+            amp_thread_array_launch_sequential,
+            amp_thread_array_launch_sequential,
+            amp_thread_array_launch_tree,
+            amp_thread_array_launch_tree
+        };
+        amp_thread_array_start_t const starts[] = {
+            amp_thread_array_start_immediately,
+            amp_thread_array_start_gated,
+            amp_thread_array_start_immediately,
+            amp_thread_array_start_gated
+        };
+        
+        for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); ++m) {
+            std::vector<int> values(thread_count, 0);
+            
+            amp_thread_array_t thread_array = AMP_THREAD_ARRAY_UNINITIALIZED;
+            int retval = amp_thread_array_create(&thread_array,
+                                                 AMP_DEFAULT_ALLOCATOR,
+                                                 thread_count);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+            
+            retval = amp_thread_array_configure_functions(thread_array,
+                                                          0,
+                                                          thread_count,
+                                                          &write_fortytwo_thread_func);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+            for (size_t i = 0; i < thread_count; ++i) {
+                retval = amp_thread_array_configure_contexts(thread_array,
+                                                             i,
+                                                             1,
+                                                             &values[i]);
+                CHECK_EQUAL(AMP_SUCCESS, retval);
+            }
+            
+            size_t joinable_count = 0;
+            retval = amp_thread_array_launch_all_with_mode(thread_array,
+                                                           modes[m],
+                                                           starts[m],
+                                                           &joinable_count);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+            CHECK_EQUAL(thread_count, joinable_count);
+            
+            // Relaunching launched threads is refused.
+            retval = amp_thread_array_launch_all_with_mode(thread_array,
+                                                           amp_thread_array_launch_tree,
+                                                           amp_thread_array_start_gated,
+                                                           NULL);
+            CHECK_EQUAL(AMP_BUSY, retval);
+            
+            retval = amp_thread_array_join_all(thread_array, &joinable_count);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+            CHECK_EQUAL(static_cast<size_t>(0), joinable_count);
+            
+            retval = amp_thread_array_destroy(&thread_array,
+                                              AMP_DEFAULT_ALLOCATOR);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+            
+            for (size_t i = 0; i < thread_count; ++i) {
+                CHECK_EQUAL(42, values[i]);
+            }
+        }
+    }
+    
+    
+    
+    TEST(partial_tree_launch_leaves_failed_subtree_unlaunched)
+    {
+        // Pinning to an unavailable CPU makes launching a thread fail.
+        amp_thread_affinity_s process_affinity;
+        int retval = amp_thread_get_current_affinity(&process_affinity);
+        size_t const unavailable_cpu = AMP_THREAD_AFFINITY_CPU_CAPACITY - 1;
+        if ((AMP_SUCCESS != retval)
+            || amp_thread_affinity_contains_cpu(&process_affinity, unavailable_cpu)) {
+            return;
+        }
+        
+        amp_thread_affinity_s unavailable;
+        amp_thread_affinity_clear(&unavailable);
+        amp_thread_affinity_add_cpu(&unavailable, unavailable_cpu);
+        
+        size_t const thread_count = 10;
+        std::vector<int> values(thread_count, 0);
+        
+        amp_thread_array_t thread_array = AMP_THREAD_ARRAY_UNINITIALIZED;
+        retval = amp_thread_array_create(&thread_array,
+                                         AMP_DEFAULT_ALLOCATOR,
+                                         thread_count);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_thread_array_configure_functions(thread_array,
+                                                      0,
+                                                      thread_count,
+                                                      &write_fortytwo_thread_func);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        for (size_t i = 0; i < thread_count; ++i) {
+            retval = amp_thread_array_configure_contexts(thread_array,
+                                                         i,
+                                                         1,
+                                                         &values[i]);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+        }
+        
+        // Thread 1 roots the launch subtree 1, 3, 4, 7, 8, 9.
+        retval = amp_thread_array_configure_affinity(thread_array,
+                                                     1,
+                                                     1,
+                                                     &unavailable);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        size_t joinable_count = 0;
+        retval = amp_thread_array_launch_all_with_mode(thread_array,
+                                                       amp_thread_array_launch_tree,
+                                                       amp_thread_array_start_gated,
+                                                       &joinable_count);
+        CHECK_EQUAL(AMP_ERROR, retval);
+        CHECK_EQUAL(static_cast<size_t>(4), joinable_count);
+        
+        // Sequential launching skips the launched threads and stops at the
+        // first non-launchable one again.
+        retval = amp_thread_array_launch_all(thread_array, &joinable_count);
+        CHECK_EQUAL(AMP_ERROR, retval);
+        CHECK_EQUAL(static_cast<size_t>(4), joinable_count);
+        
+        retval = amp_thread_array_join_all(thread_array, &joinable_count);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        CHECK_EQUAL(static_cast<size_t>(0), joinable_count);
+        
+        retval = amp_thread_array_destroy(&thread_array,
+                                          AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        int const expected_values[thread_count] = {42, 0, 42, 0, 0, 42, 42, 0, 0, 0};
+        for (size_t i = 0; i < thread_count; ++i) {
+            CHECK_EQUAL(expected_values[i], values[i]);
+        }
+    }
+    
+    
+    
 } // SUITE(amp_thread_array)
-
-
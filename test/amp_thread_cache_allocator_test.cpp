@@ -0,0 +1,436 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Unit tests for amp_thread_cache_allocator
+ */
+
+#include <UnitTest++.h>
+
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+
+
+#include <amp/amp_stddef.h>
+#include <amp/amp_return_code.h>
+#include <amp/amp_memory.h>
+#include <amp/amp_thread_cache_allocator.h>
+#include <amp/amp_thread.h>
+
+
+
+namespace {
+    
+    std::size_t const batch_size = AMP_THREAD_CACHE_ALLOCATOR_BATCH_SIZE;
+    std::size_t const block_size = 48;
+    
+    
+    // Counts the allocations reaching the source allocator. Aligned 
+    // allocations (the allocator and the thread caches) bypass the counters.
+    // Threads using the source only run while the test thread waits to join
+    // them, therefore the counters need no synchronization.
+    struct counting_source_context_s {
+        std::size_t alloc_count;
+        std::size_t dealloc_count;
+    };
+    
+    
+    void* counting_alloc(void* allocator_context,
+                         std::size_t bytes_to_allocate,
+                         char const* filename,
+                         int line)
+    {
+        struct counting_source_context_s* context = 
+            static_cast<struct counting_source_context_s*>(allocator_context);
+        
+        ++(context->alloc_count);
+        
+        return amp_default_alloc(AMP_DEFAULT_ALLOCATOR_CONTEXT, 
+                                 bytes_to_allocate,
+                                 filename,
+                                 line);
+    }
+    
+    
+    void* counting_calloc(void* allocator_context,
+                          std::size_t elem_count,
+                          std::size_t bytes_per_elem,
+                          char const* filename,
+                          int line)
+    {
+        struct counting_source_context_s* context = 
+            static_cast<struct counting_source_context_s*>(allocator_context);
+        
+        ++(context->alloc_count);
+        
+        return amp_default_calloc(AMP_DEFAULT_ALLOCATOR_CONTEXT, 
+                                  elem_count,
+                                  bytes_per_elem,
+                                  filename,
+                                  line);
+    }
+    
+    
+    int counting_dealloc(void* allocator_context,
+                         void* pointer,
+                         char const* filename,
+                         int line)
+    {
+        struct counting_source_context_s* context = 
+            static_cast<struct counting_source_context_s*>(allocator_context);
+        
+        ++(context->dealloc_count);
+        
+        return amp_default_dealloc(AMP_DEFAULT_ALLOCATOR_CONTEXT, 
+                                   pointer,
+                                   filename,
+                                   line);
+    }
+    
+    
+    struct thread_cache_fixture {
+        thread_cache_fixture()
+        :   creation_alloc_count(0)
+        ,   source(AMP_ALLOCATOR_UNINITIALIZED)
+        ,   allocator(AMP_ALLOCATOR_UNINITIALIZED)
+        {
+            context.alloc_count = 0;
+            context.dealloc_count = 0;
+            
+            int retval = amp_allocator_create(&source,
+                                              AMP_DEFAULT_ALLOCATOR,
+                                              &context,
+                                              counting_alloc,
+                                              counting_calloc,
+                                              counting_dealloc);
+            assert(AMP_SUCCESS == retval);
+            
+            retval = amp_allocator_set_aligned_funcs(source,
+                                                     amp_default_aligned_alloc,
+                                                     amp_default_aligned_dealloc);
+            assert(AMP_SUCCESS == retval);
+            
+            retval = amp_thread_cache_allocator_create(&allocator, source);
+            assert(AMP_SUCCESS == retval);
+            (void)retval;
+            
+            creation_alloc_count = context.alloc_count;
+        }
+        
+        ~thread_cache_fixture()
+        {
+            int retval = AMP_SUCCESS;
+            
+            if (AMP_ALLOCATOR_UNINITIALIZED != allocator) {
+                retval = amp_thread_cache_allocator_destroy(&allocator, source);
+                assert(AMP_SUCCESS == retval);
+            }
+            
+            retval = amp_allocator_destroy(&source, AMP_DEFAULT_ALLOCATOR);
+            assert(AMP_SUCCESS == retval);
+            (void)retval;
+        }
+        
+        // Number of slabs and large allocations drawn from the source.
+        std::size_t source_alloc_count() const
+        {
+            return context.alloc_count - creation_alloc_count;
+        }
+        
+        struct counting_source_context_s context;
+        std::size_t creation_alloc_count;
+        amp_allocator_t source;
+        amp_allocator_t allocator;
+    };
+    
+    
+    
+    // Allocates block_count blocks in another thread which doesn't flush 
+    // so the rest of its magazine stays out of the depot. The allocator 
+    // frees the unflushed cache when it is destroyed.
+    struct alloc_context_s {
+        amp_allocator_t allocator;
+        std::size_t block_count;
+        void* blocks[batch_size + 1];
+    };
+    
+    
+    void alloc_thread_func(void* ctxt)
+    {
+        struct alloc_context_s* context = 
+            static_cast<struct alloc_context_s*>(ctxt);
+        
+        for (std::size_t i = 0; i < context->block_count; ++i) {
+            context->blocks[i] = AMP_ALLOC(context->allocator, block_size);
+        }
+    }
+    
+    
+    void alloc_in_other_thread(struct alloc_context_s* context,
+                               amp_allocator_t allocator,
+                               std::size_t block_count)
+    {
+        assert(block_count <= sizeof(context->blocks) / sizeof(context->blocks[0]));
+        
+        context->allocator = allocator;
+        context->block_count = block_count;
+        
+        amp_thread_t thread = AMP_THREAD_UNINITIALIZED;
+        int retval = amp_thread_create_and_launch(&thread,
+                                                  AMP_DEFAULT_ALLOCATOR,
+                                                  context,
+                                                  alloc_thread_func);
+        assert(AMP_SUCCESS == retval);
+        
+        retval = amp_thread_join_and_destroy(&thread, AMP_DEFAULT_ALLOCATOR);
+        assert(AMP_SUCCESS == retval);
+        (void)retval;
+    }
+    
+    
+    
+    std::size_t count_contained(void* const* blocks,
+                                std::size_t block_count,
+                                void* const* candidates,
+                                std::size_t candidate_count)
+    {
+        std::size_t contained_count = 0;
+        
+        for (std::size_t i = 0; i < block_count; ++i) {
+            if (candidates + candidate_count != std::find(candidates, 
+                                                          candidates + candidate_count,
+                                                          blocks[i])) {
+                ++contained_count;
+            }
+        }
+        
+        return contained_count;
+    }
+    
+    
+    void dealloc_all(amp_allocator_t allocator,
+                     void* const* blocks,
+                     std::size_t block_count)
+    {
+        for (std::size_t i = 0; i < block_count; ++i) {
+            int const retval = AMP_DEALLOC(allocator, blocks[i]);
+            assert(AMP_SUCCESS == retval);
+            (void)retval;
+        }
+    }
+    
+} // anonymous namespace
+
+
+
+SUITE(amp_thread_cache_allocator)
+{
+    TEST_FIXTURE(thread_cache_fixture, magazine_drains_one_batch_at_twice_the_batch_size)
+    {
+        void* blocks[2 * batch_size];
+        
+        for (std::size_t i = 0; i < 2 * batch_size; ++i) {
+            blocks[i] = AMP_ALLOC(allocator, block_size);
+            CHECK(NULL != blocks[i]);
+        }
+        CHECK_EQUAL(2u, source_alloc_count());
+        
+        dealloc_all(allocator, blocks, 2 * batch_size - 1);
+        
+        // One block short of the threshold nothing has been drained, the 
+        // other thread needs a new slab.
+        struct alloc_context_s below_threshold;
+        alloc_in_other_thread(&below_threshold, allocator, 1);
+        CHECK_EQUAL(3u, source_alloc_count());
+        CHECK_EQUAL(0u, count_contained(below_threshold.blocks, 1,
+                                        blocks, 2 * batch_size));
+        
+        // Reaching the threshold drains the batch deallocated last.
+        dealloc_all(allocator, blocks + 2 * batch_size - 1, 1);
+        
+        struct alloc_context_s at_threshold;
+        alloc_in_other_thread(&at_threshold, allocator, batch_size + 1);
+        CHECK_EQUAL(batch_size, count_contained(at_threshold.blocks, batch_size,
+                                                blocks + batch_size, batch_size));
+        CHECK_EQUAL(4u, source_alloc_count());
+        
+        // The other batch is still cached by this thread.
+        void* cached[batch_size];
+        for (std::size_t i = 0; i < batch_size; ++i) {
+            cached[i] = AMP_ALLOC(allocator, block_size);
+        }
+        CHECK_EQUAL(batch_size, count_contained(cached, batch_size,
+                                                blocks, batch_size));
+        CHECK_EQUAL(4u, source_alloc_count());
+        
+        dealloc_all(allocator, cached, batch_size);
+        dealloc_all(allocator, at_threshold.blocks, batch_size + 1);
+        dealloc_all(allocator, below_threshold.blocks, 1);
+    }
+    
+    
+    
+    TEST_FIXTURE(thread_cache_fixture, refill_takes_whole_depot_chain_before_new_slab)
+    {
+        void* blocks[batch_size];
+        
+        for (std::size_t i = 0; i < batch_size; ++i) {
+            blocks[i] = AMP_ALLOC(allocator, block_size);
+        }
+        CHECK_EQUAL(1u, source_alloc_count());
+        
+        // Each flush hands the deallocated blocks to the depot as one chain.
+        dealloc_all(allocator, blocks, 3);
+        int retval = amp_thread_cache_allocator_flush(allocator);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        dealloc_all(allocator, blocks + 3, 5);
+        retval = amp_thread_cache_allocator_flush(allocator);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        // The refill takes the chain of five pushed last as a whole...
+        void* from_chain[5];
+        from_chain[0] = AMP_ALLOC(allocator, block_size);
+        CHECK_EQUAL(1u, count_contained(from_chain, 1, blocks + 3, 5));
+        
+        // ...leaving only the chain of three for another thread.
+        struct alloc_context_s other;
+        alloc_in_other_thread(&other, allocator, 1);
+        CHECK_EQUAL(1u, count_contained(other.blocks, 1, blocks, 3));
+        
+        for (std::size_t i = 1; i < 5; ++i) {
+            from_chain[i] = AMP_ALLOC(allocator, block_size);
+        }
+        CHECK_EQUAL(5u, count_contained(from_chain, 5, blocks + 3, 5));
+        CHECK_EQUAL(1u, source_alloc_count());
+        
+        // Only an empty depot leads to a new slab.
+        void* from_slab = AMP_ALLOC(allocator, block_size);
+        CHECK_EQUAL(2u, source_alloc_count());
+        
+        dealloc_all(allocator, &from_slab, 1);
+        dealloc_all(allocator, from_chain, 5);
+        dealloc_all(allocator, other.blocks, 1);
+        dealloc_all(allocator, blocks + 8, batch_size - 8);
+    }
+    
+    
+    
+    TEST_FIXTURE(thread_cache_fixture, freed_blocks_stay_with_thread_until_flush)
+    {
+        void* blocks[4];
+        
+        for (std::size_t i = 0; i < 4; ++i) {
+            blocks[i] = AMP_ALLOC(allocator, block_size);
+        }
+        dealloc_all(allocator, blocks, 4);
+        CHECK_EQUAL(1u, source_alloc_count());
+        
+        struct alloc_context_s before_flush;
+        alloc_in_other_thread(&before_flush, allocator, 1);
+        CHECK_EQUAL(0u, count_contained(before_flush.blocks, 1, blocks, 4));
+        CHECK_EQUAL(2u, source_alloc_count());
+        
+        int const retval = amp_thread_cache_allocator_flush(allocator);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        struct alloc_context_s after_flush;
+        alloc_in_other_thread(&after_flush, allocator, batch_size);
+        CHECK_EQUAL(4u, count_contained(blocks, 4, after_flush.blocks, batch_size));
+        CHECK_EQUAL(2u, source_alloc_count());
+        
+        dealloc_all(allocator, after_flush.blocks, batch_size);
+        dealloc_all(allocator, before_flush.blocks, 1);
+    }
+    
+    
+    
+    TEST_FIXTURE(thread_cache_fixture, large_allocations_bypass_the_caches)
+    {
+        void* small = AMP_ALLOC(allocator, AMP_THREAD_CACHE_ALLOCATOR_MAX_BLOCK_SIZE);
+        CHECK(NULL != small);
+        CHECK_EQUAL(1u, source_alloc_count());
+        
+        void* large = AMP_ALLOC(allocator, AMP_THREAD_CACHE_ALLOCATOR_MAX_BLOCK_SIZE + 1);
+        CHECK(NULL != large);
+        CHECK_EQUAL(2u, source_alloc_count());
+        
+        int retval = AMP_DEALLOC(allocator, large);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        CHECK_EQUAL(1u, context.dealloc_count);
+        
+        retval = AMP_DEALLOC(allocator, small);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        CHECK_EQUAL(1u, context.dealloc_count);
+    }
+    
+    
+    
+    TEST_FIXTURE(thread_cache_fixture, flush_without_cache_succeeds)
+    {
+        int retval = amp_thread_cache_allocator_flush(allocator);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        void* memory = AMP_ALLOC(allocator, 8);
+        retval = AMP_DEALLOC(allocator, memory);
+        assert(AMP_SUCCESS == retval);
+        
+        retval = amp_thread_cache_allocator_flush(allocator);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        retval = amp_thread_cache_allocator_flush(allocator);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+    }
+    
+    
+    
+    TEST_FIXTURE(thread_cache_fixture, destroy_returns_all_slabs_to_source)
+    {
+        struct alloc_context_s other;
+        alloc_in_other_thread(&other, allocator, batch_size + 1);
+        dealloc_all(allocator, other.blocks, batch_size + 1);
+        
+        void* large = AMP_ALLOC(allocator, AMP_THREAD_CACHE_ALLOCATOR_MAX_BLOCK_SIZE + 1);
+        dealloc_all(allocator, &large, 1);
+        CHECK_EQUAL(3u, source_alloc_count());
+        
+        int const retval = amp_thread_cache_allocator_destroy(&allocator, source);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        CHECK_EQUAL(context.alloc_count, context.dealloc_count);
+    }
+    
+    
+    
+} // SUITE(amp_thread_cache_allocator)
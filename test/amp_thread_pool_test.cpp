@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2009-2010, Bjoern Knafla
+ * http://www.bjoernknafla.com/
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are 
+ * met:
+ *
+ *   * Redistributions of source code must retain the above copyright 
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright 
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Bjoern Knafla 
+ *     Parallelization + AI + Gamedev Consulting nor the names of its 
+ *     contributors may be used to endorse or promote products derived from 
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *
+ * Unit tests for amp_thread_pool.
+ */
+
+
+#include <UnitTest++.h>
+
+#include <assert.h>
+#include <stddef.h>
+
+#include <amp/amp_stddef.h>
+#include <amp/amp_return_code.h>
+#include <amp/amp_thread.h>
+#include <amp/amp_thread_pool.h>
+
+
+
+SUITE(amp_thread_pool)
+{
+    
+    TEST(create_with_default_worker_count_and_destroy)
+    {
+        amp_thread_pool_t pool = AMP_THREAD_POOL_UNINITIALIZED;
+        
+        int retval = amp_thread_pool_create(&pool,
+                                            AMP_DEFAULT_ALLOCATOR,
+                                            0);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        size_t worker_count = 0;
+        retval = amp_thread_pool_get_worker_count(pool, &worker_count);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        CHECK(0 != worker_count);
+        
+        retval = amp_thread_pool_destroy(&pool,
+                                         AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        CHECK(AMP_THREAD_POOL_UNINITIALIZED == pool);
+    }
+    
+    
+    
+    namespace 
+    {
+        typedef int check_flag_t;
+        
+        check_flag_t const CHECK_FLAG_UNSET = 0;
+        check_flag_t const CHECK_FLAG_SET = 775;
+        
+        
+        void set_flag_job_func(void* ctxt)
+        {
+            check_flag_t* flag = static_cast<check_flag_t*>(ctxt);
+            
+            *flag = CHECK_FLAG_SET;
+        }
+        
+        
+        
+        struct nested_job_context_s {
+            amp_thread_pool_t pool;
+            size_t remaining_depth;
+            check_flag_t* flags;
+        };
+        
+        // Sets its flag and submits a job for the next flag until 
+        // remaining_depth reaches zero.
+        void nested_submit_job_func(void* ctxt)
+        {
+            struct nested_job_context_s* context = 
+                static_cast<struct nested_job_context_s*>(ctxt);
+            
+            context->flags[context->remaining_depth] = CHECK_FLAG_SET;
+            
+            if (0 != context->remaining_depth) {
+                --(context->remaining_depth);
+                
+                int const retval = amp_thread_pool_submit(context->pool,
+                                                          context,
+                                                          &nested_submit_job_func);
+                assert(AMP_SUCCESS == retval);
+                (void)retval;
+            }
+        }
+        
+    } // anonymous namespace
+    
+    
+    
+    TEST(submitted_jobs_all_run_before_wait_all_returns)
+    {
+        // Submit more jobs than the initial queue capacity, twice, to 
+        // check that the queue grows and that the pool can be reused after
+        // waiting.
+        size_t const job_count = 1000;
+        check_flag_t flags[job_count];
+        
+        amp_thread_pool_t pool = AMP_THREAD_POOL_UNINITIALIZED;
+        int retval = amp_thread_pool_create(&pool,
+                                            AMP_DEFAULT_ALLOCATOR,
+                                            4);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        for (size_t round = 0; round < 2; ++round) {
+            
+            for (size_t i = 0; i < job_count; ++i) {
+                flags[i] = CHECK_FLAG_UNSET;
+            }
+            
+            for (size_t i = 0; i < job_count; ++i) {
+                retval = amp_thread_pool_submit(pool,
+                                                &flags[i],
+                                                &set_flag_job_func);
+                CHECK_EQUAL(AMP_SUCCESS, retval);
+            }
+            
+            retval = amp_thread_pool_wait_all(pool);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+            
+            for (size_t i = 0; i < job_count; ++i) {
+                CHECK_EQUAL(CHECK_FLAG_SET, flags[i]);
+            }
+        }
+        
+        retval = amp_thread_pool_destroy(&pool,
+                                         AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+    }
+    
+    
+    
+    TEST(wait_all_waits_for_jobs_submitted_by_jobs)
+    {
+        size_t const depth = 100;
+        check_flag_t flags[depth + 1];
+        for (size_t i = 0; i < depth + 1; ++i) {
+            flags[i] = CHECK_FLAG_UNSET;
+        }
+        
+        amp_thread_pool_t pool = AMP_THREAD_POOL_UNINITIALIZED;
+        int retval = amp_thread_pool_create(&pool,
+                                            AMP_DEFAULT_ALLOCATOR,
+                                            3);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        struct nested_job_context_s context;
+        context.pool = pool;
+        context.remaining_depth = depth;
+        context.flags = flags;
+        
+        retval = amp_thread_pool_submit(pool,
+                                        &context,
+                                        &nested_submit_job_func);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_thread_pool_wait_all(pool);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        for (size_t i = 0; i < depth + 1; ++i) {
+            CHECK_EQUAL(CHECK_FLAG_SET, flags[i]);
+        }
+        
+        retval = amp_thread_pool_destroy(&pool,
+                                         AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+    }
+    
+    
+    
+    TEST(shutdown_runs_queued_jobs_and_rejects_new_ones)
+    {
+        size_t const job_count = 200;
+        check_flag_t flags[job_count];
+        for (size_t i = 0; i < job_count; ++i) {
+            flags[i] = CHECK_FLAG_UNSET;
+        }
+        
+        amp_thread_pool_t pool = AMP_THREAD_POOL_UNINITIALIZED;
+        int retval = amp_thread_pool_create(&pool,
+                                            AMP_DEFAULT_ALLOCATOR,
+                                            2);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        for (size_t i = 0; i < job_count; ++i) {
+            retval = amp_thread_pool_submit(pool,
+                                            &flags[i],
+                                            &set_flag_job_func);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+        }
+        
+        retval = amp_thread_pool_shutdown(pool);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        for (size_t i = 0; i < job_count; ++i) {
+            CHECK_EQUAL(CHECK_FLAG_SET, flags[i]);
+        }
+        
+        check_flag_t late_flag = CHECK_FLAG_UNSET;
+        retval = amp_thread_pool_submit(pool,
+                                        &late_flag,
+                                        &set_flag_job_func);
+        CHECK_EQUAL(AMP_ERROR, retval);
+        
+        // Shutting down twice is fine.
+        retval = amp_thread_pool_shutdown(pool);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_thread_pool_destroy(&pool,
+                                         AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        CHECK_EQUAL(CHECK_FLAG_UNSET, late_flag);
+    }
+    
+    
+    
+} // SUITE(amp_thread_pool)
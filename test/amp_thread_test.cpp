@@ -42,6 +42,7 @@
 
 // Include std::size_t
 #include <cstddef>
+#include <vector>
 
 // Include AMP_SUCCESS
 #include <amp/amp_stddef.h>
@@ -61,6 +62,46 @@ namespace
         *value_to_set = launch_run_join_success_value;
     }
     
+    
+    struct affinity_query_context {
+        int retval;
+        amp_thread_affinity_s affinity;
+    };
+    
+    void query_affinity_thread_func(void *context)
+    {
+        affinity_query_context* ctxt = static_cast<affinity_query_context*>(context);
+        ctxt->retval = amp_thread_get_current_affinity(&ctxt->affinity);
+    }
+    
+    
+    void pin_and_query_affinity_thread_func(void *context)
+    {
+        affinity_query_context* ctxt = static_cast<affinity_query_context*>(context);
+        ctxt->retval = amp_thread_set_current_affinity(&ctxt->affinity);
+        if (AMP_SUCCESS == ctxt->retval) {
+            ctxt->retval = amp_thread_get_current_affinity(&ctxt->affinity);
+        }
+    }
+    
+    
+    void record_stack_address_thread_func(void *context)
+    {
+        char local = 0;
+        *static_cast<char const**>(context) = &local;
+    }
+    
+    
+    std::size_t first_cpu(amp_thread_affinity_s const& affinity)
+    {
+        std::size_t cpu = 0;
+        while (!amp_thread_affinity_contains_cpu(&affinity, cpu)) {
+            ++cpu;
+        }
+        
+        return cpu;
+    }
+    
 } // anonymous namespace
 
 
@@ -93,5 +134,169 @@ SUITE(amp_thread)
         
     }
     
+    
+    
+    TEST(affinity_set_operations)
+    {
+        amp_thread_affinity_s affinity;
+        int retval = amp_thread_affinity_clear(&affinity);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        CHECK_EQUAL(std::size_t(0), amp_thread_affinity_cpu_count(&affinity));
+        
+        retval = amp_thread_affinity_add_cpu(&affinity, 0);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        retval = amp_thread_affinity_add_cpu(&affinity, AMP_THREAD_AFFINITY_CPU_CAPACITY - 1);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        retval = amp_thread_affinity_add_cpu(&affinity, AMP_THREAD_AFFINITY_CPU_CAPACITY);
+        CHECK_EQUAL(AMP_ERROR, retval);
+        
+        CHECK_EQUAL(std::size_t(2), amp_thread_affinity_cpu_count(&affinity));
+        CHECK(amp_thread_affinity_contains_cpu(&affinity, 0));
+        CHECK(!amp_thread_affinity_contains_cpu(&affinity, 1));
+        CHECK(amp_thread_affinity_contains_cpu(&affinity, AMP_THREAD_AFFINITY_CPU_CAPACITY - 1));
+        CHECK(!amp_thread_affinity_contains_cpu(&affinity, AMP_THREAD_AFFINITY_CPU_CAPACITY));
+        
+        retval = amp_thread_affinity_remove_cpu(&affinity, 0);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        CHECK(!amp_thread_affinity_contains_cpu(&affinity, 0));
+        CHECK_EQUAL(std::size_t(1), amp_thread_affinity_cpu_count(&affinity));
+    }
+    
+    
+    
+    TEST(launch_with_affinity_pins_thread)
+    {
+        amp_thread_affinity_s process_affinity;
+        int retval = amp_thread_get_current_affinity(&process_affinity);
+        if (AMP_UNSUPPORTED == retval) {
+            return;
+        }
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        CHECK(0 != amp_thread_affinity_cpu_count(&process_affinity));
+        
+        std::size_t const cpu = first_cpu(process_affinity);
+        amp_thread_affinity_s pinned;
+        amp_thread_affinity_clear(&pinned);
+        amp_thread_affinity_add_cpu(&pinned, cpu);
+        
+        affinity_query_context context;
+        context.retval = AMP_ERROR;
+        amp_thread_affinity_clear(&context.affinity);
+        
+        amp_thread_t thread = AMP_THREAD_UNINITIALIZED;
+        retval = amp_thread_create_and_launch_with_affinity(&thread,
+                                                            AMP_DEFAULT_ALLOCATOR,
+                                                            &context,
+                                                            &query_affinity_thread_func,
+                                                            &pinned);
+        if (AMP_UNSUPPORTED == retval) {
+            return;
+        }
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_thread_join_and_destroy(&thread, AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        CHECK_EQUAL(AMP_SUCCESS, context.retval);
+        CHECK_EQUAL(std::size_t(1), amp_thread_affinity_cpu_count(&context.affinity));
+        CHECK(amp_thread_affinity_contains_cpu(&context.affinity, cpu));
+    }
+    
+    
+    
+    TEST(set_current_affinity)
+    {
+        amp_thread_affinity_s process_affinity;
+        int retval = amp_thread_get_current_affinity(&process_affinity);
+        if (AMP_UNSUPPORTED == retval) {
+            return;
+        }
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        // Pin a helper thread to not change the affinity of the test runner.
+        affinity_query_context context;
+        context.retval = AMP_ERROR;
+        amp_thread_affinity_clear(&context.affinity);
+        amp_thread_affinity_add_cpu(&context.affinity, first_cpu(process_affinity));
+        
+        amp_thread_t thread = AMP_THREAD_UNINITIALIZED;
+        retval = amp_thread_create_and_launch(&thread,
+                                              AMP_DEFAULT_ALLOCATOR,
+                                              &context,
+                                              &pin_and_query_affinity_thread_func);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_thread_join_and_destroy(&thread, AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        CHECK_EQUAL(AMP_SUCCESS, context.retval);
+        CHECK_EQUAL(std::size_t(1), amp_thread_affinity_cpu_count(&context.affinity));
+        CHECK(amp_thread_affinity_contains_cpu(&context.affinity, first_cpu(process_affinity)));
+    }
+    
+    
+    
+    TEST(launch_with_small_stack)
+    {
+        std::size_t const thread_count = 64;
+        
+        amp_thread_stack_s stack;
+        stack.size = 64 * 1024;
+        stack.guard_size = AMP_THREAD_STACK_DEFAULT_GUARD_SIZE;
+        stack.memory = NULL;
+        
+        amp_thread_t threads[thread_count];
+        int values_to_set[thread_count] = {0};
+        
+        for (std::size_t i = 0; i < thread_count; ++i) {
+            int retval = amp_thread_create_and_launch_with_stack(&threads[i],
+                                                                 AMP_DEFAULT_ALLOCATOR,
+                                                                 &values_to_set[i], 
+                                                                 &launch_run_join_thread_func,
+                                                                 &stack);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+        }
+        
+        for (std::size_t i = 0; i < thread_count; ++i) {
+            int retval = amp_thread_join_and_destroy(&threads[i],
+                                                     AMP_DEFAULT_ALLOCATOR);
+            CHECK_EQUAL(AMP_SUCCESS, retval);
+        }
+        
+        for (std::size_t i = 0; i < thread_count; ++i) {
+            CHECK_EQUAL(launch_run_join_success_value, values_to_set[i]);
+        }
+    }
+    
+    
+    
+    TEST(launch_with_caller_provided_stack)
+    {
+        std::size_t const stack_size = 256 * 1024;
+        std::vector<char> stack_memory(stack_size);
+        
+        amp_thread_stack_s stack;
+        stack.size = stack_size;
+        stack.guard_size = AMP_THREAD_STACK_DEFAULT_GUARD_SIZE;
+        stack.memory = &stack_memory[0];
+        
+        char const* stack_address = NULL;
+        amp_thread_t thread = AMP_THREAD_UNINITIALIZED;
+        int retval = amp_thread_create_and_launch_with_stack(&thread,
+                                                             AMP_DEFAULT_ALLOCATOR,
+                                                             &stack_address,
+                                                             &record_stack_address_thread_func,
+                                                             &stack);
+        if (AMP_UNSUPPORTED == retval) {
+            return;
+        }
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        retval = amp_thread_join_and_destroy(&thread, AMP_DEFAULT_ALLOCATOR);
+        CHECK_EQUAL(AMP_SUCCESS, retval);
+        
+        CHECK(stack_address >= &stack_memory[0]);
+        CHECK(stack_address < &stack_memory[0] + stack_size);
+    }
+    
 }
-